@@ -190,6 +190,17 @@ extern "C" {
 #define STATUS_INVALID_IMAGE_PREFIX_LENGTH                       STATUS_CLIENT_BASE + 0x0000008d
 #define STATUS_INVALID_IMAGE_METADATA_KEY_LENGTH                 STATUS_CLIENT_BASE + 0x0000008e
 #define STATUS_INVALID_IMAGE_METADATA_VALUE_LENGTH               STATUS_CLIENT_BASE + 0x0000008f
+#define STATUS_STREAM_DATA_SEGMENTS_OUTSTANDING                  STATUS_CLIENT_BASE + 0x00000090
+#define STATUS_STREAM_DATA_SEGMENTS_NOT_OUTSTANDING              STATUS_CLIENT_BASE + 0x00000091
+#define STATUS_FRAME_BUFFER_ALREADY_ACQUIRED                     STATUS_CLIENT_BASE + 0x00000092
+#define STATUS_FRAME_BUFFER_NOT_ACQUIRED                         STATUS_CLIENT_BASE + 0x00000093
+#define STATUS_INVALID_STORE_ARENA_COUNT                         STATUS_CLIENT_BASE + 0x00000094
+#define STATUS_INVALID_PUT_FRAME_RING_SIZE                       STATUS_CLIENT_BASE + 0x00000095
+#define STATUS_PUT_FRAME_RING_FULL                               STATUS_CLIENT_BASE + 0x00000096
+#define STATUS_PUT_FRAME_RING_CLOSED                             STATUS_CLIENT_BASE + 0x00000097
+#define STATUS_INVALID_PUT_FRAME_WORKER_COUNT                    STATUS_CLIENT_BASE + 0x00000098
+#define STATUS_PUT_FRAME_RING_CONCURRENT_PRODUCER                STATUS_CLIENT_BASE + 0x00000099
+#define STATUS_INVALID_PUT_FRAME_RING_BUFFER_SIZE                STATUS_CLIENT_BASE + 0x0000009a
 
 #define IS_RECOVERABLE_ERROR(error)                                                                                                                  \
     ((error) == STATUS_SERVICE_CALL_RESOURCE_NOT_FOUND_ERROR || (error) == STATUS_SERVICE_CALL_RESOURCE_IN_USE_ERROR ||                              \
@@ -259,6 +270,31 @@ extern "C" {
  */
 #define MAX_STORAGE_ALLOCATION_SIZE (10LLU * 1024 * 1024 * 1024)
 
+/**
+ * Max number of the arenas the content store can be partitioned into
+ */
+#define MAX_STORE_ARENA_COUNT 64
+
+/**
+ * Max number of the frames the async putFrame ingestion ring of a stream can hold
+ */
+#define MAX_PUT_FRAME_RING_SIZE 65536
+
+/**
+ * Max size of the buffer the async putFrame ingestion ring of a stream copies the frame bits into
+ */
+#define MAX_PUT_FRAME_RING_BUFFER_SIZE (1024 * 1024 * 1024)
+
+/**
+ * Max number of the workers packaging the frames put in the async mode
+ */
+#define MAX_PUT_FRAME_WORKER_COUNT 64
+
+/**
+ * Number of the workers packaging the frames put in the async mode if not specified
+ */
+#define DEFAULT_PUT_FRAME_WORKER_COUNT 1
+
 /**
  * Max number of fragment metadatas in the segment
  */
@@ -284,6 +320,11 @@ extern "C" {
  */
 #define MAX_EVENT_CUSTOM_PAIRS 10
 
+/**
+ * Max number of the stream data segments returned by a single call
+ */
+#define MAX_STREAM_DATA_SEGMENT_COUNT 64
+
 /**
  * Max length of the fragment sequence number
  */
@@ -464,16 +505,16 @@ extern "C" {
  */
 #define DEVICE_INFO_CURRENT_VERSION           1
 #define CALLBACKS_CURRENT_VERSION             0
-#define STREAM_INFO_CURRENT_VERSION           3
+#define STREAM_INFO_CURRENT_VERSION           5
 #define SEGMENT_INFO_CURRENT_VERSION          0
-#define STORAGE_INFO_CURRENT_VERSION          0
+#define STORAGE_INFO_CURRENT_VERSION          1
 #define AUTH_INFO_CURRENT_VERSION             0
 #define SERVICE_CALL_CONTEXT_CURRENT_VERSION  1
 #define STREAM_DESCRIPTION_CURRENT_VERSION    1
 #define FRAGMENT_ACK_CURRENT_VERSION          0
-#define STREAM_METRICS_CURRENT_VERSION        3
+#define STREAM_METRICS_CURRENT_VERSION        4
 #define CLIENT_METRICS_CURRENT_VERSION        2
-#define CLIENT_INFO_CURRENT_VERSION           3
+#define CLIENT_INFO_CURRENT_VERSION           4
 #define STREAM_EVENT_METADATA_CURRENT_VERSION 0
 
 /**
@@ -609,6 +650,12 @@ typedef enum {
 
     // In-memory storage type with all allocations from the content store
     DEVICE_STORAGE_TYPE_IN_MEM_CONTENT_STORE_ALLOC,
+
+    // In-memory storage type backed by a FIFO ring buffer matching the content view lifecycle
+    DEVICE_STORAGE_TYPE_IN_MEM_RING_BUFFER,
+
+    // File based storage type with the content persisted in the file tier re-attached to the streams after the restart
+    DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE,
 } DEVICE_STORAGE_TYPE;
 
 /**
@@ -1081,6 +1128,20 @@ struct __StreamCaps {
     // ------------------------------ V2 compat -----------------------
     // Enable / Disable stream creation if describe call fails
     BOOL allowStreamCreation;
+
+    // ------------------------------ V3 compat -----------------------
+    // Duration in 100ns of the window within which the consecutive frames of an audio track
+    // are laced into a single MKV block. 0 disables the lacing.
+    // The pending lace is put once the duration elapses without the following frames arriving.
+    // NOTE: A frame of another track puts the pending lace as the blocks are stored in the timestamp
+    // order. With the frame ordering interleaving the audio and video by the timestamps a lace only
+    // spans the audio frames between two consecutive video frames.
+    UINT64 audioLacingDuration;
+
+    // ------------------------------ V4 compat -----------------------
+    // Size in bytes of the content store extent reserved for each fragment. The packaged frames
+    // of the fragment are appended into the extent. 0 stores every frame in its own allocation.
+    UINT32 fragmentExtentSize;
 };
 
 typedef struct __StreamCaps* PStreamCaps;
@@ -1136,6 +1197,15 @@ struct __StorageInfo {
 
     // File location in case of the file based storage
     CHAR rootDirectory[MAX_PATH_LEN + 1];
+
+    // ------------------------------ V0 compat --------------------------
+
+    // Number of the arenas the content store is partitioned into. Each arena gets an equal share
+    // of the storage size and its own lock and the streams are spread over the arenas so the
+    // streams in different arenas don't contend when storing and retrieving the frames.
+    // The value of 0 or 1 keeps a single content store shared by all the streams.
+    // NOTE: Only the in-memory and the ring buffer storage types can be partitioned.
+    UINT32 storeArenaCount;
 };
 
 typedef struct __StorageInfo* PStorageInfo;
@@ -1204,6 +1274,21 @@ typedef struct __ClientInfo {
     UINT64 serviceCallCompletionTimeout;
     UINT64 serviceCallConnectionTimeout;
 
+    // ------------------------------ V3 compat --------------------------
+
+    // Number of the frames the async ingestion ring of each stream holds. Power of two.
+    // 0 = putKinesisVideoFrame packages the frames synchronously on the caller thread.
+    UINT32 putFrameRingSize;
+
+    // Size in bytes of the buffer preallocated for the frame bits copied into the async ingestion ring of each stream.
+    // Rounded up to a power of two. 0 = sized from the ring size and the average frame size of the stream.
+    UINT64 putFrameRingBufferSize;
+
+    // Number of the workers packaging the frames of the different streams in parallel in the async mode.
+    // The frames of a stream are always packaged in order by the same worker.
+    // 0 = DEFAULT_PUT_FRAME_WORKER_COUNT
+    UINT32 putFrameWorkerCount;
+
 } ClientInfo, *PClientInfo;
 
 /**
@@ -1372,6 +1457,14 @@ struct __StreamMetrics {
 
     // V3 metrics following
     UINT32 streamApiCallRetryCount;
+
+    // V4 metrics following
+
+    // Number of times the async putFrame ingestion ring reached its high-water mark
+    UINT64 putFrameRingHighWaterMarks;
+
+    // Number of frames rejected as the async putFrame ingestion ring was full
+    UINT64 putFrameRingFullRejections;
 };
 
 typedef struct __StreamMetrics* PStreamMetrics;
@@ -1528,6 +1621,20 @@ struct __StreamEventMetadata {
 
 typedef struct __StreamEventMetadata* PStreamEventMetadata;
 
+/**
+ * Segment of the stream data returned without copying
+ */
+typedef struct __StreamDataSegment StreamDataSegment;
+struct __StreamDataSegment {
+    // Pointer to the data which remains valid until the segments are released
+    PBYTE pData;
+
+    // Size of the data in bytes
+    UINT32 size;
+};
+
+typedef struct __StreamDataSegment* PStreamDataSegment;
+
 ////////////////////////////////////////////////////
 // General callbacks definitions
 ////////////////////////////////////////////////////
@@ -2126,13 +2233,78 @@ PUBLIC_API STATUS stopKinesisVideoStreamSync(STREAM_HANDLE);
 /**
  * Puts a frame into the stream
  *
+ * If the client is configured with the putFrameRingSize the frame is copied into the ingestion ring
+ * of the stream and the call returns without blocking. The client worker the stream is affined to
+ * packages the frame later and reports the frames failing to be packaged as dropped.
+ *
+ * NOTE: In the async mode only one thread per stream should be putting the frames.
+ *
  * @param 1 STREAM_HANDLE - the stream handle.
  * @param 2 PFrame - the frame to process.
  *
- * @return Status of the function call.
+ * @return Status of the function call. In the async mode STATUS_PUT_FRAME_RING_FULL is returned
+ * if the ring has no space for the frame, STATUS_PUT_FRAME_RING_CLOSED if the stream has been stopped
+ * and STATUS_PUT_FRAME_RING_CONCURRENT_PRODUCER if another thread is putting a frame into the stream.
  */
 PUBLIC_API STATUS putKinesisVideoFrame(STREAM_HANDLE, PFrame);
 
+/**
+ * Puts a batch of frames into the stream.
+ *
+ * The frames are packaged with the current time sampled, the pressures evaluated and the data
+ * available notification fired once for the entire batch. The batch is processed to the end
+ * even if some of the frames fail.
+ *
+ * NOTE: The streams with non pass-through frame ordering put the frames one by one.
+ *
+ * @param 1 STREAM_HANDLE - the stream handle.
+ * @param 2 PFrame - the array of the frames to process.
+ * @param 3 UINT32 - the number of the frames in the array.
+ * @param 4 PSTATUS - OUT OPT - array of the frame count size to receive the status of each frame.
+ *
+ * @return Status of the function call - the status of the first failed frame if any.
+ */
+PUBLIC_API STATUS putKinesisVideoFrames(STREAM_HANDLE, PFrame, UINT32, PSTATUS);
+
+/**
+ * Acquires a buffer in the content store for the encoder to produce the frame payload into.
+ * The storage for the MKV packaging is reserved in front of the returned buffer so the frame
+ * is not copied when it's committed with commitKinesisVideoFrame.
+ *
+ * NOTE: Only one frame buffer per stream can be acquired at a time.
+ * NOTE: The stream should be using the pass-through frame ordering and no Annex-B NALs adaptation.
+ *
+ * @param 1 STREAM_HANDLE - the stream handle.
+ * @param 2 PFrame - the frame descriptor with the flags, timestamps and the track id of the frame to be produced.
+ *      The frame size specifies the max payload size or 0 to use the largest frame size seen by the stream.
+ * @param 3 PBYTE* - OUT - the buffer to produce the frame payload into.
+ * @param 4 PUINT32 - OUT - the size of the buffer.
+ *
+ * @return Status of the function call.
+ */
+PUBLIC_API STATUS acquireKinesisVideoFrameBuffer(STREAM_HANDLE, PFrame, PBYTE*, PUINT32);
+
+/**
+ * Puts the frame produced into the acquired buffer into the stream.
+ * The frame data should point to the acquired buffer and the size should be the actual payload size.
+ * The acquired buffer is released whether the frame is put or not unless the frame is not pointing to it.
+ *
+ * @param 1 STREAM_HANDLE - the stream handle.
+ * @param 2 PFrame - the frame to process.
+ *
+ * @return Status of the function call.
+ */
+PUBLIC_API STATUS commitKinesisVideoFrame(STREAM_HANDLE, PFrame);
+
+/**
+ * Releases the acquired frame buffer without putting the frame into the stream.
+ *
+ * @param 1 STREAM_HANDLE - the stream handle.
+ *
+ * @return Status of the function call.
+ */
+PUBLIC_API STATUS discardKinesisVideoFrameBuffer(STREAM_HANDLE);
+
 /**
  * Gets the data for the stream.
  *
@@ -2150,6 +2322,36 @@ PUBLIC_API STATUS putKinesisVideoFrame(STREAM_HANDLE, PFrame);
  */
 PUBLIC_API STATUS getKinesisVideoStreamData(STREAM_HANDLE, UPLOAD_HANDLE, PBYTE, UINT32, PUINT32);
 
+/**
+ * Gets the data for the stream as a list of segments pointing to the stored data without copying.
+ * The segments can be passed to writev/sendmsg directly.
+ *
+ * NOTE: The returned data is consumed the same way as with getKinesisVideoStreamData and the status
+ * codes are the same. The segments remain valid and the storage backing them remains pinned until
+ * releaseKinesisVideoStreamDataSegments is called which needs to happen whenever a non-zero segment count is returned.
+ * No more stream data can be retrieved until then.
+ *
+ * @param 1 STREAM_HANDLE - the stream handle.
+ * @param 2 UPLOAD_HANDLE - Client stream upload handle.
+ * @param 3 UINT32 - Max number of bytes the segments should cover.
+ * @param 4 PStreamDataSegment - Array of segments to fill in.
+ * @param 5 UINT32 - Number of segments in the array. Up-to MAX_STREAM_DATA_SEGMENT_COUNT will be filled in.
+ * @param 6 PUINT32 - Actual number of segments filled.
+ * @param 7 PUINT32 - Overall size of the data in the segments.
+ *
+ * @return Status of the function call.
+ */
+PUBLIC_API STATUS getKinesisVideoStreamDataSegments(STREAM_HANDLE, UPLOAD_HANDLE, UINT32, PStreamDataSegment, UINT32, PUINT32, PUINT32);
+
+/**
+ * Releases the segments returned by getKinesisVideoStreamDataSegments and un-pins the storage backing them.
+ *
+ * @param 1 STREAM_HANDLE - the stream handle.
+ *
+ * @return Status of the function call.
+ */
+PUBLIC_API STATUS releaseKinesisVideoStreamDataSegments(STREAM_HANDLE);
+
 /**
  * Inserts a "metadata" - a key/value string pair into the stream.
  *
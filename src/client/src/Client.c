@@ -33,11 +33,6 @@ STATUS checkIntermittentProducerCallback(UINT32 timerId, UINT64 currentTime, UIN
     UNUSED_PARAM(timerId);
     STATUS retStatus = STATUS_SUCCESS;
     PKinesisVideoClient pKinesisVideoClient = (PKinesisVideoClient) customData;
-    UINT32 i;
-    BOOL frameOrderCoordinatorLocked = FALSE;
-    PKinesisVideoStream pCurrStream = NULL;
-    PFrameOrderCoordinator pFrameOrderCoordinator = NULL;
-    Frame eofr = EOFR_FRAME_INITIALIZER;
 
     CHK(pKinesisVideoClient, STATUS_NULL_ARG);
 
@@ -50,45 +45,97 @@ STATUS checkIntermittentProducerCallback(UINT32 timerId, UINT64 currentTime, UIN
     pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
 
     if (STATUS_SUCCEEDED(retStatus)) {
-        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.putFrameLock);
-        // Lock the client streams list lock
-        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-
+        // Only check the streams whose deadlines have expired pinning them one at a time
         currentTime = GETTIME();
-        for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
-            if (NULL != pKinesisVideoClient->streams[i]) {
-                pCurrStream = pKinesisVideoClient->streams[i];
-                pFrameOrderCoordinator = pCurrStream->pFrameOrderCoordinator;
-                if (pCurrStream->streamInfo.streamCaps.frameOrderingMode != FRAME_ORDER_MODE_PASS_THROUGH) {
-                    // In the case that frameOrderingMode = FRAME_ORDER_MODE_PASS_THROUGH, pFrameOrderCoordinator is NULL
-                    // so we will segfault, so the check for the frameOrderingMode is important
-                    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pFrameOrderCoordinator->lock);
-                    frameOrderCoordinatorLocked = TRUE;
-                }
-                // Lock the Stream
-                pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.lock);
-                // Check if last PutFrame is older than max timeout, if so, send EoFR, if not, do nothing
-                // Ignoring currentTime it COULD be smaller than pCurrStream->lastPutFrametimestamp
-                // Due to this method entering but waiting on stream lock from putFrame call
-                if (!pCurrStream->streamStopped && IS_VALID_TIMESTAMP(pCurrStream->lastPutFrameTimestamp) &&
-                    currentTime > pCurrStream->lastPutFrameTimestamp &&
-                    (currentTime - pCurrStream->lastPutFrameTimestamp) > INTERMITTENT_PRODUCER_MAX_TIMEOUT) {
-                    if (!STATUS_SUCCEEDED(retStatus = putKinesisVideoFrame(TO_STREAM_HANDLE(pCurrStream), &eofr))) {
-                        DLOGW("Failed to submit auto eofr with 0x%08x, for stream: %s", retStatus, pCurrStream->streamInfo.name);
-                    }
-                }
+        retStatus = expireEofrTimers(pKinesisVideoClient, currentTime, checkIntermittentProducerStream, currentTime);
+    }
 
-                // Unlock the Stream
-                pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.lock);
-                if (frameOrderCoordinatorLocked) {
-                    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pFrameOrderCoordinator->lock);
-                }
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Puts the automatic EoFR into the stream if the producer has been idle for too long.
+ * Re-arms the deadline of the stream otherwise.
+ *
+ * @param pCurrStream - the stream whose deadline has expired
+ * @param currentTime - the current time when the check started
+ * @return
+ */
+STATUS checkIntermittentProducerStream(PKinesisVideoStream pCurrStream, UINT64 currentTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = pCurrStream->pKinesisVideoClient;
+    PFrameOrderCoordinator pFrameOrderCoordinator = pCurrStream->pFrameOrderCoordinator;
+    BOOL frameOrderCoordinatorLocked = FALSE;
+    Frame eofr = EOFR_FRAME_INITIALIZER;
+
+    // Acquire the putFrame lock of the stream as the EoFR is put while holding the stream lock
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.putFrameLock);
+    if (pCurrStream->streamInfo.streamCaps.frameOrderingMode != FRAME_ORDER_MODE_PASS_THROUGH) {
+        // In the case that frameOrderingMode = FRAME_ORDER_MODE_PASS_THROUGH, pFrameOrderCoordinator is NULL
+        // so we will segfault, so the check for the frameOrderingMode is important
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pFrameOrderCoordinator->lock);
+        frameOrderCoordinatorLocked = TRUE;
+    }
+    // Lock the Stream
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.lock);
+    // Check if last PutFrame is older than max timeout, if so, send EoFR, if not, re-arm the deadline
+    // Ignoring currentTime it COULD be smaller than pCurrStream->lastPutFrametimestamp
+    // Due to this method entering but waiting on stream lock from putFrame call
+    // The frames pending in the async ingestion ring have not been put yet so the stream is not idle
+    if (!pCurrStream->streamStopped && IS_VALID_TIMESTAMP(pCurrStream->lastPutFrameTimestamp)) {
+        if (currentTime > pCurrStream->lastPutFrameTimestamp &&
+            (currentTime - pCurrStream->lastPutFrameTimestamp) > INTERMITTENT_PRODUCER_MAX_TIMEOUT && putFrameRingIsEmpty(pCurrStream)) {
+            // The EoFR bypasses the async ingestion ring as the application is the only producer of the ring
+            retStatus = pCurrStream->pPutFrameRing == NULL ? putKinesisVideoFrame(TO_STREAM_HANDLE(pCurrStream), &eofr)
+                                                           : frameOrderCoordinatorPutFrame(pCurrStream, &eofr);
+            if (!STATUS_SUCCEEDED(retStatus)) {
+                DLOGW("Failed to submit auto eofr with 0x%08x, for stream: %s", retStatus, pCurrStream->streamInfo.name);
             }
         }
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.putFrameLock);
+
+        // The stream which has got the frames since it was armed or failed to get the EoFR is re-armed.
+        // The deadline which has already passed is checked again on the next tick.
+        if (IS_VALID_TIMESTAMP(pCurrStream->lastPutFrameTimestamp)) {
+            armEofrTimer(pCurrStream, pCurrStream->lastPutFrameTimestamp + INTERMITTENT_PRODUCER_MAX_TIMEOUT);
+        }
     }
 
+    // Unlock the Stream
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.lock);
+    if (frameOrderCoordinatorLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pFrameOrderCoordinator->lock);
+    }
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.putFrameLock);
+
+    // The failure to put the EoFR into one stream should not stop the visit
+    return STATUS_SUCCESS;
+}
+
+/**
+ *
+ * @param timerId - timerId for timer
+ * @param currentTime - the current time when the call back was fired
+ * @param customData - pKinesisVideoClient, contains the streams and the content store
+ * @return
+ */
+STATUS storageTieringCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    ENTERS();
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = (PKinesisVideoClient) customData;
+
+    CHK(pKinesisVideoClient, STATUS_NULL_ARG);
+
+    CHK_STATUS(streamTableVisit(pKinesisVideoClient, 0, 1, storageTieringStream, 0));
+
 CleanUp:
     CHK_LOG_ERR(retStatus);
 
@@ -96,6 +143,86 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Demotes the sent content of the stream to the file storage tier and writes out its journal
+ *
+ * @param pCurrStream - the stream to demote the content of
+ * @param customData - unused
+ * @return
+ */
+STATUS storageTieringStream(PKinesisVideoStream pCurrStream, UINT64 customData)
+{
+    UNUSED_PARAM(customData);
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = pCurrStream->pKinesisVideoClient;
+
+    // Lock the stream and then its store arena as the content store is accessed
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.lock);
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->pStoreArena->lock);
+
+    if (STATUS_FAILED(retStatus = demoteSentViewItems(pCurrStream, STORAGE_TIERING_MEMORY_WATERMARK))) {
+        DLOGW("Failed to demote the sent content with 0x%08x, for stream: %s", retStatus, pCurrStream->streamInfo.name);
+    }
+
+    // Write the journal records changed since the last fragment boundary
+    if (STATUS_FAILED(retStatus = flushStreamJournal(pCurrStream->pJournal))) {
+        DLOGW("Failed to write the journal with 0x%08x, for stream: %s", retStatus, pCurrStream->streamInfo.name);
+    }
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->pStoreArena->lock);
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pCurrStream->base.lock);
+
+    // The failure to demote the content of one stream should not stop the visit
+    return STATUS_SUCCESS;
+}
+
+/**
+ *
+ * @param timerId - timerId for timer
+ * @param currentTime - the current time when the call back was fired
+ * @param customData - pKinesisVideoClient, contains the lace deadlines of the streams
+ * @return - STATUS_TIMER_QUEUE_STOP_SCHEDULING once no stream is lacing the audio
+ */
+STATUS laceFlushCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = (PKinesisVideoClient) customData;
+
+    CHK(pKinesisVideoClient, STATUS_NULL_ARG);
+
+    // The laces are timed with the client time. Only the streams whose deadlines have expired are visited.
+    currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+    retStatus = expireLaceTimers(pKinesisVideoClient, timerId, currentTime, laceFlushStream, currentTime);
+
+CleanUp:
+    if (retStatus != STATUS_TIMER_QUEUE_STOP_SCHEDULING) {
+        CHK_LOG_ERR(retStatus);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Puts the partial audio lace of the stream whose deadline has expired if the lacing duration has elapsed since it's been started
+ *
+ * @param pCurrStream - the stream to put the lace of
+ * @param currentTime - the current time when the check started
+ * @return
+ */
+STATUS laceFlushStream(PKinesisVideoStream pCurrStream, UINT64 currentTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    if (!pCurrStream->streamStopped && STATUS_FAILED(retStatus = flushExpiredLacedFrames(pCurrStream, currentTime))) {
+        DLOGW("Failed to put the audio lace with 0x%08x, for stream: %s", retStatus, pCurrStream->streamInfo.name);
+    }
+
+    // The failure to put the lace of one stream should not stop the visit
+    return STATUS_SUCCESS;
+}
+
 STATUS setupDefaultKvsRetryStrategyParameters(PKinesisVideoClient pKinesisVideoClient)
 {
     ENTERS();
@@ -171,7 +298,7 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
     PKinesisVideoClient pKinesisVideoClient = NULL;
     PStateMachine pStateMachine = NULL;
     BOOL tearDownOnError = TRUE;
-    UINT32 allocationSize, heapFlags, tagsSize;
+    UINT32 allocationSize, heapFlags, tagsSize, storeArenaCount, i;
 
     // Check the input params
     CHK(pDeviceInfo != NULL && pClientHandle != NULL, STATUS_NULL_ARG);
@@ -191,9 +318,10 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
     // Get the max tags structure size
     CHK_STATUS(packageTags(pDeviceInfo->tagCount, pDeviceInfo->tags, 0, NULL, &tagsSize));
 
-    // Allocate the main struct with an array of stream pointers following the structure and the array of tags following it
+    // Allocate the main struct with the stream table slots following the structure and the array of tags following it.
+    // The slots are aligned to the slot size so an extra slot is allocated.
     // NOTE: The calloc will Zero the fields
-    allocationSize = SIZEOF(KinesisVideoClient) + pDeviceInfo->streamCount * SIZEOF(PKinesisVideoStream) + tagsSize;
+    allocationSize = SIZEOF(KinesisVideoClient) + (pDeviceInfo->streamCount + 1) * SIZEOF(StreamTableSlot) + tagsSize;
     pKinesisVideoClient = (PKinesisVideoClient) MEMCALLOC(1, allocationSize);
     CHK(pKinesisVideoClient != NULL, STATUS_NOT_ENOUGH_MEMORY);
 
@@ -219,8 +347,8 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
     // Set the client to not-ready
     pKinesisVideoClient->clientReady = FALSE;
 
-    // Set the streams pointer right after the struct
-    pKinesisVideoClient->streams = (PKinesisVideoStream*) (pKinesisVideoClient + 1);
+    // Set the stream table slots right after the struct
+    pKinesisVideoClient->streamTable.slots = (PStreamTableSlot) ROUND_UP((SIZE_T) (pKinesisVideoClient + 1), STREAM_TABLE_SLOT_SIZE);
 
     // Copy the structures in their entirety
     MEMCPY(&pKinesisVideoClient->clientCallbacks, pClientCallbacks, SIZEOF(ClientCallbacks));
@@ -249,12 +377,44 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
 #endif
 
     // Create the storage
-    heapFlags = pKinesisVideoClient->deviceInfo.storageInfo.storageType == DEVICE_STORAGE_TYPE_IN_MEM ||
-            pKinesisVideoClient->deviceInfo.storageInfo.storageType == DEVICE_STORAGE_TYPE_IN_MEM_CONTENT_STORE_ALLOC
-        ? MEMORY_BASED_HEAP_FLAGS
-        : FILE_BASED_HEAP_FLAGS;
-    CHK_STATUS(heapInitialize(pKinesisVideoClient->deviceInfo.storageInfo.storageSize, pKinesisVideoClient->deviceInfo.storageInfo.spillRatio,
-                              heapFlags, pKinesisVideoClient->deviceInfo.storageInfo.rootDirectory, &pKinesisVideoClient->pHeap));
+    switch (pKinesisVideoClient->deviceInfo.storageInfo.storageType) {
+        case DEVICE_STORAGE_TYPE_IN_MEM:
+        case DEVICE_STORAGE_TYPE_IN_MEM_CONTENT_STORE_ALLOC:
+            heapFlags = MEMORY_BASED_HEAP_FLAGS;
+            break;
+        case DEVICE_STORAGE_TYPE_IN_MEM_RING_BUFFER:
+            heapFlags = RING_BUFFER_HEAP_FLAGS;
+            break;
+        case DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE:
+            heapFlags = PERSISTENT_FILE_BASED_HEAP_FLAGS;
+            break;
+        default:
+            heapFlags = FILE_BASED_HEAP_FLAGS;
+    }
+
+    // Partition the content store into arenas with an equal share of the storage each if requested.
+    // The file based storage is not partitioned as the heaps would share the root directory and the
+    // content store allocator needs a single heap.
+    storeArenaCount = MAX(pKinesisVideoClient->deviceInfo.storageInfo.storeArenaCount, 1);
+    if (storeArenaCount > 1 && pKinesisVideoClient->deviceInfo.storageInfo.storageType != DEVICE_STORAGE_TYPE_IN_MEM &&
+        pKinesisVideoClient->deviceInfo.storageInfo.storageType != DEVICE_STORAGE_TYPE_IN_MEM_RING_BUFFER) {
+        DLOGW("Content store of the storage type %u can't be partitioned into arenas", pKinesisVideoClient->deviceInfo.storageInfo.storageType);
+        storeArenaCount = 1;
+    }
+
+    for (i = 0; i < storeArenaCount; i++) {
+        pKinesisVideoClient->storeArenas[i].storageSize = pKinesisVideoClient->deviceInfo.storageInfo.storageSize / storeArenaCount;
+        CHK_STATUS(heapInitialize(pKinesisVideoClient->storeArenas[i].storageSize, pKinesisVideoClient->deviceInfo.storageInfo.spillRatio, heapFlags,
+                                  pKinesisVideoClient->deviceInfo.storageInfo.rootDirectory, &pKinesisVideoClient->storeArenas[i].pHeap));
+        pKinesisVideoClient->storeArenaCount++;
+    }
+
+    pKinesisVideoClient->pHeap = pKinesisVideoClient->storeArenas[0].pHeap;
+
+    // The content of the previous run is only re-attached to by the stream journals
+    if (pKinesisVideoClient->deviceInfo.storageInfo.storageType == DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE) {
+        CHK_STATUS(releaseUnjournaledContent(pKinesisVideoClient));
+    }
 
     // Using content store allocator if needed
     // IMPORTANT! This will not be multi-client-safe
@@ -267,8 +427,8 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
 
     CHK(IS_VALID_CVAR_VALUE(pKinesisVideoClient->base.ready), STATUS_NOT_ENOUGH_MEMORY);
 
-    // Set the tags pointer to point after the array of streams
-    pKinesisVideoClient->deviceInfo.tags = (PTag) ((PKinesisVideoStream*) (pKinesisVideoClient + 1) + pDeviceInfo->streamCount);
+    // Set the tags pointer to point after the stream table slots
+    pKinesisVideoClient->deviceInfo.tags = (PTag) (pKinesisVideoClient->streamTable.slots + pDeviceInfo->streamCount);
 
     // Package the tags after the structure
     CHK_STATUS(packageTags(pDeviceInfo->tagCount, pDeviceInfo->tags, tagsSize, pKinesisVideoClient->deviceInfo.tags, NULL));
@@ -277,13 +437,18 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
     // Create the client lock
     pKinesisVideoClient->base.lock = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, TRUE);
 
+    // The client lock guards the content store unless it's partitioned into arenas with their own locks
+    for (i = 0; i < pKinesisVideoClient->storeArenaCount; i++) {
+        pKinesisVideoClient->storeArenas[i].lock = pKinesisVideoClient->storeArenaCount == 1
+            ? pKinesisVideoClient->base.lock
+            : pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, TRUE);
+    }
+
     // Create lock for streams list
     pKinesisVideoClient->base.streamListLock =
         pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, TRUE);
 
-    // Create the putFrame lock
-    pKinesisVideoClient->base.putFrameLock =
-        pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, TRUE);
+    CHK_STATUS(createStreamTable(pKinesisVideoClient));
 
     // Create the state machine and step it
     CHK_STATUS(createStateMachineWithName(CLIENT_STATE_MACHINE_STATES, CLIENT_STATE_MACHINE_STATE_COUNT, TO_CUSTOM_DATA(pKinesisVideoClient),
@@ -295,6 +460,8 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
         if (!IS_VALID_TIMER_QUEUE_HANDLE(pKinesisVideoClient->timerQueueHandle)) {
             // Create timer queue
             CHK_STATUS(timerQueueCreate(&pKinesisVideoClient->timerQueueHandle));
+            // The streams arm their deadlines in the wheel advanced by the timer
+            CHK_STATUS(createEofrTimerWheel(pKinesisVideoClient));
             // Store callback in client so we can override in tests
             pKinesisVideoClient->timerCallbackFunc = checkIntermittentProducerCallback;
             CHK_STATUS(timerQueueAddTimer(pKinesisVideoClient->timerQueueHandle, INTERMITTENT_PRODUCER_TIMER_START_DELAY,
@@ -303,6 +470,22 @@ STATUS createKinesisVideoClient(PDeviceInfo pDeviceInfo, PClientCallbacks pClien
         }
     }
 
+    // Keep the send frontier in memory by demoting the sent content to the file storage tier in the background
+    if (pKinesisVideoClient->deviceInfo.storageInfo.storageType == DEVICE_STORAGE_TYPE_HYBRID_FILE ||
+        pKinesisVideoClient->deviceInfo.storageInfo.storageType == DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE) {
+        if (!IS_VALID_TIMER_QUEUE_HANDLE(pKinesisVideoClient->timerQueueHandle)) {
+            CHK_STATUS(timerQueueCreate(&pKinesisVideoClient->timerQueueHandle));
+        }
+
+        CHK_STATUS(timerQueueAddTimer(pKinesisVideoClient->timerQueueHandle, STORAGE_TIERING_TIMER_START_DELAY, STORAGE_TIERING_PERIOD,
+                                      storageTieringCallback, (UINT64) pKinesisVideoClient, &pKinesisVideoClient->tieringTimerId));
+    }
+
+    // Package the frames handed over by the async putKinesisVideoFrame on the client workers
+    if (pKinesisVideoClient->deviceInfo.clientInfo.putFrameRingSize != 0) {
+        CHK_STATUS(createPutFrameWorkers(pKinesisVideoClient));
+    }
+
     // Set the call result to unknown to start
     pKinesisVideoClient->base.result = SERVICE_CALL_RESULT_NOT_SET;
 
@@ -435,11 +618,11 @@ STATUS getKinesisVideoMetrics(CLIENT_HANDLE clientHandle, PClientMetrics pKinesi
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    UINT64 heapSize;
-    UINT32 i, viewAllocationSize;
-    UINT32 totalClientRetryCount = 0;
+    UINT64 heapSize = 0, arenaHeapSize;
+    UINT32 i;
+    ClientMetricsAccumulator accumulator;
     PKinesisVideoClient pKinesisVideoClient = FROM_CLIENT_HANDLE(clientHandle);
-    BOOL releaseClientSemaphore = FALSE, locked = FALSE;
+    BOOL releaseClientSemaphore = FALSE;
 
     DLOGV("Get the memory metrics size.");
 
@@ -450,7 +633,10 @@ STATUS getKinesisVideoMetrics(CLIENT_HANDLE clientHandle, PClientMetrics pKinesi
     CHK_STATUS(semaphoreAcquire(pKinesisVideoClient->base.shutdownSemaphore, INFINITE_TIME_VALUE));
     releaseClientSemaphore = TRUE;
 
-    CHK_STATUS(heapGetSize(pKinesisVideoClient->pHeap, &heapSize));
+    for (i = 0; i < pKinesisVideoClient->storeArenaCount; i++) {
+        CHK_STATUS(heapGetSize(pKinesisVideoClient->storeArenas[i].pHeap, &arenaHeapSize));
+        heapSize += arenaHeapSize;
+    }
 
     pKinesisVideoMetrics->contentStoreSize = pKinesisVideoClient->deviceInfo.storageInfo.storageSize;
     pKinesisVideoMetrics->contentStoreAllocatedSize = heapSize;
@@ -462,43 +648,16 @@ STATUS getKinesisVideoMetrics(CLIENT_HANDLE clientHandle, PClientMetrics pKinesi
     pKinesisVideoMetrics->totalFrameRate = 0;
     pKinesisVideoMetrics->totalElementaryFrameRate = 0;
 
-    // Lock the client streams list lock because we're iterating over
-    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-    locked = TRUE;
+    // Visit the streams pinning them one at a time instead of holding the streams list lock
+    accumulator.pClientMetrics = pKinesisVideoMetrics;
+    accumulator.totalClientRetryCount = 0;
+    CHK_STATUS(streamTableVisit(pKinesisVideoClient, 0, 1, accumulateStreamMetrics, (UINT64) &accumulator));
 
-    for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
-        if (NULL != pKinesisVideoClient->streams[i]) {
-            CHK_STATUS(contentViewGetAllocationSize(pKinesisVideoClient->streams[i]->pView, &viewAllocationSize));
-            switch (pKinesisVideoMetrics->version) {
-                case 2:
-                    totalClientRetryCount += pKinesisVideoClient->streams[i]->diagnostics.streamApiCallRetryCount;
-                    // explicit fall through since V2 would include V1 and V0 metrics as well
-                case 1:
-                    pKinesisVideoMetrics->totalElementaryFrameRate += pKinesisVideoClient->streams[i]->diagnostics.elementaryFrameRate;
-                    // explicit fall through since V1 would include V0 metrics as well
-                case 0:
-                    pKinesisVideoMetrics->totalContentViewsSize += viewAllocationSize;
-                    pKinesisVideoMetrics->totalFrameRate += (UINT64) pKinesisVideoClient->streams[i]->diagnostics.currentFrameRate;
-                    pKinesisVideoMetrics->totalTransferRate += pKinesisVideoClient->streams[i]->diagnostics.currentTransferRate;
-                    break;
-                default:
-                    DLOGW("Invalid client struct version. Nothing to populate");
-            }
-        }
-    }
-
-    pKinesisVideoMetrics->clientAvgApiCallRetryCount = (DOUBLE) totalClientRetryCount / (DOUBLE) pKinesisVideoClient->deviceInfo.streamCount;
-
-    // Unlock client streams list lock after iteration.
-    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-    locked = FALSE;
+    pKinesisVideoMetrics->clientAvgApiCallRetryCount =
+        (DOUBLE) accumulator.totalClientRetryCount / (DOUBLE) pKinesisVideoClient->deviceInfo.streamCount;
 
 CleanUp:
 
-    if (locked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-    }
-
     if (releaseClientSemaphore) {
         semaphoreRelease(pKinesisVideoClient->base.shutdownSemaphore);
     }
@@ -508,6 +667,38 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Adds the metrics of the stream to the client metrics
+ */
+STATUS accumulateStreamMetrics(PKinesisVideoStream pKinesisVideoStream, UINT64 customData)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PClientMetricsAccumulator pAccumulator = (PClientMetricsAccumulator) customData;
+    PClientMetrics pKinesisVideoMetrics = pAccumulator->pClientMetrics;
+    UINT32 viewAllocationSize;
+
+    CHK_STATUS(contentViewGetAllocationSize(pKinesisVideoStream->pView, &viewAllocationSize));
+    switch (pKinesisVideoMetrics->version) {
+        case 2:
+            pAccumulator->totalClientRetryCount += pKinesisVideoStream->diagnostics.streamApiCallRetryCount;
+            // explicit fall through since V2 would include V1 and V0 metrics as well
+        case 1:
+            pKinesisVideoMetrics->totalElementaryFrameRate += pKinesisVideoStream->diagnostics.elementaryFrameRate;
+            // explicit fall through since V1 would include V0 metrics as well
+        case 0:
+            pKinesisVideoMetrics->totalContentViewsSize += viewAllocationSize;
+            pKinesisVideoMetrics->totalFrameRate += (UINT64) pKinesisVideoStream->diagnostics.currentFrameRate;
+            pKinesisVideoMetrics->totalTransferRate += pKinesisVideoStream->diagnostics.currentTransferRate;
+            break;
+        default:
+            DLOGW("Invalid client struct version. Nothing to populate");
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
 /**
  * Gets the stream diagnostics info
  */
@@ -555,8 +746,7 @@ STATUS stopKinesisVideoStreams(CLIENT_HANDLE clientHandle)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    UINT32 i;
-    BOOL releaseClientSemaphore = FALSE, streamsListLock = FALSE;
+    BOOL releaseClientSemaphore = FALSE;
     PKinesisVideoClient pKinesisVideoClient = FROM_CLIENT_HANDLE(clientHandle);
 
     DLOGI("Stopping Kinesis Video Streams.");
@@ -567,21 +757,8 @@ STATUS stopKinesisVideoStreams(CLIENT_HANDLE clientHandle)
     CHK_STATUS(semaphoreAcquire(pKinesisVideoClient->base.shutdownSemaphore, INFINITE_TIME_VALUE));
     releaseClientSemaphore = TRUE;
 
-    // Must lock streams list lock due to iteration
-    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-    streamsListLock = TRUE;
-
-    // Iterate over the streams and stop them
-    for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
-        if (NULL != pKinesisVideoClient->streams[i]) {
-            // We will bail out if the stream stopping fails
-            CHK_STATUS(stopKinesisVideoStream(TO_STREAM_HANDLE(pKinesisVideoClient->streams[i])));
-        }
-    }
-
-    // unlock streams list lock after iteration
-    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-    streamsListLock = FALSE;
+    // Iterate over the streams and stop them. We will bail out if the stream stopping fails.
+    CHK_STATUS(streamTableVisit(pKinesisVideoClient, 0, 1, stopStreamVisitor, 0));
 
 CleanUp:
 
@@ -589,10 +766,6 @@ CleanUp:
         semaphoreRelease(pKinesisVideoClient->base.shutdownSemaphore);
     }
 
-    if (streamsListLock) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
-    }
-
     CHK_LOG_ERR(retStatus);
     LEAVES();
     return retStatus;
@@ -885,8 +1058,14 @@ STATUS putKinesisVideoFrame(STREAM_HANDLE streamHandle, PFrame pFrame)
           pKinesisVideoStream->streamInfo.name, pFrame->presentationTs, pFrame->decodingTs, pFrame->duration, pFrame->size, pFrame->trackId,
           CHECK_FRAME_FLAG_KEY_FRAME(pFrame->flags));
 
+    // Hand the frame over to the client worker in the async mode
+    if (pKinesisVideoStream->pPutFrameRing != NULL) {
+        CHK_STATUS(putFrameRingEnqueue(pKinesisVideoStream, pFrame));
+        CHK(FALSE, retStatus);
+    }
+
     // Acquire putFrame Lock
-    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.putFrameLock);
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
     putFrameLocked = TRUE;
 
     // Process and store the result
@@ -895,7 +1074,10 @@ STATUS putKinesisVideoFrame(STREAM_HANDLE streamHandle, PFrame pFrame)
 CleanUp:
 
     if (putFrameLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.putFrameLock);
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+
+        // The lace flush timer is scheduled with the putFrame lock released
+        CHK_LOG_ERR(scheduleLaceFlushTimer(pKinesisVideoClient));
     }
 
     if (STATUS_FAILED(retStatus) && pFrame != NULL) {
@@ -927,6 +1109,218 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Puts a batch of frames into the Kinesis Video stream
+ */
+STATUS putKinesisVideoFrames(STREAM_HANDLE streamHandle, PFrame pFrames, UINT32 frameCount, PSTATUS pFrameStatuses)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PKinesisVideoStream pKinesisVideoStream = FROM_STREAM_HANDLE(streamHandle);
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    BOOL releaseClientSemaphore = FALSE, releaseStreamSemaphore = FALSE;
+    BOOL putFrameLocked = FALSE;
+    UINT32 i;
+
+    DLOGS("Putting a batch of frames into an Kinesis Video stream.");
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL && pFrames != NULL, STATUS_NULL_ARG);
+    CHK(frameCount != 0, STATUS_INVALID_ARG);
+
+    // Set the client after we've verified it's not null
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    // Shutdown sequencer
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseClientSemaphore = TRUE;
+
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseStreamSemaphore = TRUE;
+
+    // The frames are handed over to the client worker individually in the async mode
+    if (pKinesisVideoStream->pPutFrameRing != NULL) {
+        for (i = 0; i < frameCount; i++) {
+            status = putFrameRingEnqueue(pKinesisVideoStream, &pFrames[i]);
+
+            if (pFrameStatuses != NULL) {
+                pFrameStatuses[i] = status;
+            }
+
+            if (STATUS_FAILED(status) && STATUS_SUCCEEDED(retStatus)) {
+                retStatus = status;
+            }
+        }
+
+        CHK(FALSE, retStatus);
+    }
+
+    // Acquire putFrame Lock
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+    putFrameLocked = TRUE;
+
+    if (pKinesisVideoStream->streamInfo.streamCaps.frameOrderingMode == FRAME_ORDER_MODE_PASS_THROUGH) {
+        retStatus = putFrames(pKinesisVideoStream, pFrames, frameCount, pFrameStatuses);
+    } else {
+        // The frame order coordinator queues the frames individually
+        for (i = 0; i < frameCount; i++) {
+            status = frameOrderCoordinatorPutFrame(pKinesisVideoStream, &pFrames[i]);
+
+            if (pFrameStatuses != NULL) {
+                pFrameStatuses[i] = status;
+            }
+
+            if (STATUS_FAILED(status) && STATUS_SUCCEEDED(retStatus)) {
+                retStatus = status;
+            }
+        }
+    }
+
+CleanUp:
+
+    if (putFrameLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+
+        // The lace flush timer is scheduled with the putFrame lock released
+        CHK_LOG_ERR(scheduleLaceFlushTimer(pKinesisVideoClient));
+    }
+
+    if (STATUS_FAILED(retStatus) && pKinesisVideoStream != NULL) {
+        DLOGW("[%s] Failed to submit the batch of %u frames to Kinesis Video client. status: 0x%08x", pKinesisVideoStream->streamInfo.name, frameCount,
+              retStatus);
+    } else {
+        CHK_LOG_ERR(retStatus);
+    }
+
+    if (releaseStreamSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->base.shutdownSemaphore);
+    }
+
+    if (releaseClientSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Acquires a buffer in the content store for the frame payload to be produced into
+ */
+STATUS acquireKinesisVideoFrameBuffer(STREAM_HANDLE streamHandle, PFrame pFrame, PBYTE* ppBuffer, PUINT32 pBufferSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL releaseClientSemaphore = FALSE, releaseStreamSemaphore = FALSE;
+    PKinesisVideoStream pKinesisVideoStream = FROM_STREAM_HANDLE(streamHandle);
+
+    DLOGS("Acquiring a frame buffer from an Kinesis Video stream.");
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    // Shutdown sequencer
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseClientSemaphore = TRUE;
+
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseStreamSemaphore = TRUE;
+
+    CHK_STATUS(acquireFrameBuffer(pKinesisVideoStream, pFrame, ppBuffer, pBufferSize));
+
+CleanUp:
+
+    if (releaseStreamSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->base.shutdownSemaphore);
+    }
+
+    if (releaseClientSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore);
+    }
+
+    CHK_LOG_ERR(retStatus);
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Puts the frame produced into the acquired frame buffer into the stream
+ */
+STATUS commitKinesisVideoFrame(STREAM_HANDLE streamHandle, PFrame pFrame)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoStream pKinesisVideoStream = FROM_STREAM_HANDLE(streamHandle);
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    BOOL releaseClientSemaphore = FALSE, releaseStreamSemaphore = FALSE;
+    BOOL putFrameLocked = FALSE;
+
+    DLOGS("Committing frame into an Kinesis Video stream.");
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL && pFrame != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    // Shutdown sequencer
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseClientSemaphore = TRUE;
+
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseStreamSemaphore = TRUE;
+
+    // Keep the order with the frames handed over to the async ingestion ring
+    CHK_STATUS(putFrameRingDrain(pKinesisVideoStream, MAX_UINT32, TRUE, NULL));
+
+    // Acquire putFrame Lock
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+    putFrameLocked = TRUE;
+
+    // The frame ordering is pass-through for the acquired buffers
+    CHK_STATUS(commitFrameBuffer(pKinesisVideoStream, pFrame));
+
+CleanUp:
+
+    if (putFrameLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+    }
+
+    if (STATUS_FAILED(retStatus) && pFrame != NULL && pKinesisVideoStream != NULL) {
+        DLOGW("[%s] Failed to commit frame to Kinesis Video client. "
+              "status: 0x%08x decoding timestamp: %" PRIu64 " presentation timestamp: %" PRIu64,
+              pKinesisVideoStream->streamInfo.name, retStatus, pFrame->decodingTs, pFrame->presentationTs);
+    } else {
+        CHK_LOG_ERR(retStatus);
+    }
+
+    if (releaseStreamSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->base.shutdownSemaphore);
+    }
+
+    if (releaseClientSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Releases the acquired frame buffer without putting the frame
+ */
+STATUS discardKinesisVideoFrameBuffer(STREAM_HANDLE streamHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoStream pKinesisVideoStream = FROM_STREAM_HANDLE(streamHandle);
+
+    DLOGS("Discarding the frame buffer of an Kinesis Video stream.");
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(discardFrameBuffer(pKinesisVideoStream));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+    LEAVES();
+    return retStatus;
+}
+
 /**
  * Puts a metadata (key/value pair) into the Kinesis Video stream.
  */
@@ -1142,6 +1536,72 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Gets the stream data segments for a given stream without copying
+ * @return Status of the operation
+ */
+STATUS getKinesisVideoStreamDataSegments(STREAM_HANDLE streamHandle, UPLOAD_HANDLE uploadHandle, UINT32 maxSize, PStreamDataSegment pSegments,
+                                         UINT32 segmentCount, PUINT32 pFilledSegmentCount, PUINT32 pFilledSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL releaseClientSemaphore = FALSE, releaseStreamSemaphore = FALSE;
+    PKinesisVideoStream pKinesisVideoStream = FROM_STREAM_HANDLE(streamHandle);
+
+    DLOGS("Getting data segments from an Kinesis Video stream.");
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    // Shutdown sequencer
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseClientSemaphore = TRUE;
+
+    CHK_STATUS(semaphoreAcquire(pKinesisVideoStream->base.shutdownSemaphore, INFINITE_TIME_VALUE));
+    releaseStreamSemaphore = TRUE;
+
+    // Process and store the result
+    CHK_STATUS(getStreamDataSegments(pKinesisVideoStream, uploadHandle, maxSize, pSegments, segmentCount, pFilledSegmentCount, pFilledSize));
+
+CleanUp:
+
+    if (releaseStreamSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->base.shutdownSemaphore);
+    }
+
+    if (releaseClientSemaphore) {
+        semaphoreRelease(pKinesisVideoStream->pKinesisVideoClient->base.shutdownSemaphore);
+    }
+
+    if (retStatus != STATUS_SUCCESS && retStatus != STATUS_AWAITING_PERSISTED_ACK && retStatus != STATUS_END_OF_STREAM &&
+        retStatus != STATUS_UPLOAD_HANDLE_ABORTED && retStatus != STATUS_NO_MORE_DATA_AVAILABLE) {
+        CHK_LOG_ERR(retStatus);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Releases the stream data segments previously returned for a given stream
+ * @return Status of the operation
+ */
+STATUS releaseKinesisVideoStreamDataSegments(STREAM_HANDLE streamHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoStream pKinesisVideoStream = FROM_STREAM_HANDLE(streamHandle);
+
+    DLOGS("Releasing data segments of an Kinesis Video stream.");
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(releaseStreamDataSegments(pKinesisVideoStream));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+    LEAVES();
+    return retStatus;
+}
+
 /**
  * Kinesis Video stream get streamInfo from STREAM_HANDLE
  */
@@ -1605,6 +2065,16 @@ CleanUp:
 // Internal functions
 //////////////////////////////////////////////////////////
 
+/**
+ * Stops the stream visited by stopKinesisVideoStreams
+ */
+STATUS stopStreamVisitor(PKinesisVideoStream pKinesisVideoStream, UINT64 customData)
+{
+    UNUSED_PARAM(customData);
+
+    return stopKinesisVideoStream(TO_STREAM_HANDLE(pKinesisVideoStream));
+}
+
 /**
  * Frees the client object
  */
@@ -1627,9 +2097,9 @@ STATUS freeKinesisVideoClientInternal(PKinesisVideoClient pKinesisVideoClient, S
 
     // Call stream shutdowns first
     for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
-        if (NULL != pKinesisVideoClient->streams[i]) {
+        if (NULL != pKinesisVideoClient->streamTable.slots[i].pKinesisVideoStream) {
             // Call is idempotent so NULL is OK
-            shutdownStream(pKinesisVideoClient->streams[i], FALSE);
+            shutdownStream(pKinesisVideoClient->streamTable.slots[i].pKinesisVideoStream, FALSE);
         }
     }
 
@@ -1653,6 +2123,9 @@ STATUS freeKinesisVideoClientInternal(PKinesisVideoClient pKinesisVideoClient, S
         timerQueueShutdown(pKinesisVideoClient->timerQueueHandle);
     }
 
+    // The put frame workers visit the streams too
+    freePutFrameWorkers(pKinesisVideoClient);
+
     // Lock the streamListLock for iteration
     if (IS_VALID_MUTEX_VALUE(pKinesisVideoClient->base.streamListLock)) {
         pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.streamListLock);
@@ -1661,9 +2134,9 @@ STATUS freeKinesisVideoClientInternal(PKinesisVideoClient pKinesisVideoClient, S
 
     // Release the underlying objects
     for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
-        if (NULL != pKinesisVideoClient->streams[i]) {
+        if (NULL != pKinesisVideoClient->streamTable.slots[i].pKinesisVideoStream) {
             // Call is idempotent so NULL is OK
-            retStatus = freeStream(pKinesisVideoClient->streams[i]);
+            retStatus = freeStream(pKinesisVideoClient->streamTable.slots[i].pKinesisVideoStream);
             freeStreamStatus = STATUS_FAILED(retStatus) ? retStatus : freeStreamStatus;
         }
     }
@@ -1675,6 +2148,11 @@ STATUS freeKinesisVideoClientInternal(PKinesisVideoClient pKinesisVideoClient, S
         locked = FALSE;
     }
 
+    // Free the shard locks, the EoFR timer wheel and the lace deadlines after the streams are gone
+    freeStreamTable(pKinesisVideoClient);
+    freeEofrTimerWheel(pKinesisVideoClient);
+    freeLaceTimers(pKinesisVideoClient);
+
     // Release the state machine
     freeStateMachineStatus = freeStateMachine(pKinesisVideoClient->base.pStateMachine);
 
@@ -1694,8 +2172,13 @@ STATUS freeKinesisVideoClientInternal(PKinesisVideoClient pKinesisVideoClient, S
         pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
     }
 
-    if (IS_VALID_MUTEX_VALUE(pKinesisVideoClient->base.putFrameLock)) {
-        pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.putFrameLock);
+    // The arenas of a partitioned content store have their own locks
+    for (i = 0; i < pKinesisVideoClient->storeArenaCount; i++) {
+        if (IS_VALID_MUTEX_VALUE(pKinesisVideoClient->storeArenas[i].lock) &&
+            pKinesisVideoClient->storeArenas[i].lock != pKinesisVideoClient->base.lock) {
+            pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                             pKinesisVideoClient->storeArenas[i].lock);
+        }
     }
 
     if (IS_VALID_SEMAPHORE_HANDLE(pKinesisVideoClient->base.shutdownSemaphore)) {
@@ -1720,10 +2203,11 @@ STATUS freeKinesisVideoClientInternal(PKinesisVideoClient pKinesisVideoClient, S
     // Free retry strategy
     freeClientRetryStrategy(pKinesisVideoClient);
 
-    // Release the heap
-    if (pKinesisVideoClient->pHeap) {
-        heapDebugCheckAllocator(pKinesisVideoClient->pHeap, TRUE);
-        freeHeapStatus = heapRelease(pKinesisVideoClient->pHeap);
+    // Release the heaps of the arenas
+    for (i = 0; i < pKinesisVideoClient->storeArenaCount; i++) {
+        heapDebugCheckAllocator(pKinesisVideoClient->storeArenas[i].pHeap, TRUE);
+        retStatus = heapRelease(pKinesisVideoClient->storeArenas[i].pHeap);
+        freeHeapStatus = STATUS_FAILED(retStatus) ? retStatus : freeHeapStatus;
     }
 
     DLOGD("Total allocated memory %" PRIu64, pKinesisVideoClient->totalAllocationSize);
@@ -1792,14 +2276,24 @@ VOID viewItemRemoved(PContentView pContentView, UINT64 customData, PViewItem pVi
 CleanUp:
 
     if (pKinesisVideoClient != NULL) {
-        // Lock the client
-        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+        // Lock the store arena of the stream
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
         // Remove the item from the storage
-        heapFree(pKinesisVideoClient->pHeap, pViewItem->handle);
-        pViewItem->handle = INVALID_ALLOCATION_HANDLE_VALUE;
+        if (IS_VALID_ALLOCATION_HANDLE(pViewItem->handle)) {
+            journalRemoveViewItem(pKinesisVideoStream->pJournal, pViewItem);
+
+            // The allocations in use by the stream data segments are freed when the segments are released
+            if (CHECK_ITEM_FRAGMENT_EXTENT(pViewItem->flags)) {
+                releaseFragmentExtent(pKinesisVideoStream, pViewItem->handle);
+            } else {
+                freeStoreAllocation(pKinesisVideoStream, pViewItem->handle);
+            }
 
-        // Unlock the client
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+            pViewItem->handle = INVALID_ALLOCATION_HANDLE_VALUE;
+        }
+
+        // Unlock the store arena
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
 
         if (streamLocked) {
             // Unlock the stream lock
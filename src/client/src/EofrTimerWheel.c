@@ -0,0 +1,193 @@
+/**
+ * Kinesis Video intermittent producer EoFR timer wheel
+ */
+#define LOG_CLASS "EofrTimerWheel"
+
+#include "Include_i.h"
+
+/**
+ * Unlinks the armed stream from its bucket. The wheel lock should be held.
+ */
+static VOID unlinkEofrTimer(PEofrTimerWheel pEofrTimerWheel, PKinesisVideoStream pKinesisVideoStream)
+{
+    if (pKinesisVideoStream->pPrevEofrTimer == NULL) {
+        pEofrTimerWheel->buckets[pKinesisVideoStream->eofrTimerBucket] = pKinesisVideoStream->pNextEofrTimer;
+    } else {
+        pKinesisVideoStream->pPrevEofrTimer->pNextEofrTimer = pKinesisVideoStream->pNextEofrTimer;
+    }
+
+    if (pKinesisVideoStream->pNextEofrTimer != NULL) {
+        pKinesisVideoStream->pNextEofrTimer->pPrevEofrTimer = pKinesisVideoStream->pPrevEofrTimer;
+    }
+
+    pKinesisVideoStream->pNextEofrTimer = NULL;
+    pKinesisVideoStream->pPrevEofrTimer = NULL;
+    pKinesisVideoStream->eofrTimerArmed = FALSE;
+}
+
+STATUS createEofrTimerWheel(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PEofrTimerWheel pEofrTimerWheel;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    CHK(pKinesisVideoClient->deviceInfo.clientInfo.reservedCallbackPeriod != 0, STATUS_INVALID_ARG);
+    pEofrTimerWheel = &pKinesisVideoClient->eofrTimerWheel;
+
+    // The wheel ticks with the timer callback which compares the deadlines with the system time
+    pEofrTimerWheel->tickPeriod = pKinesisVideoClient->deviceInfo.clientInfo.reservedCallbackPeriod;
+    pEofrTimerWheel->lastExpiredTick = GETTIME() / pEofrTimerWheel->tickPeriod;
+
+    pEofrTimerWheel->lock = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pEofrTimerWheel->lock), STATUS_NOT_ENOUGH_MEMORY);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS freeEofrTimerWheel(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PEofrTimerWheel pEofrTimerWheel;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pEofrTimerWheel = &pKinesisVideoClient->eofrTimerWheel;
+
+    if (IS_VALID_MUTEX_VALUE(pEofrTimerWheel->lock)) {
+        pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+        pEofrTimerWheel->lock = INVALID_MUTEX_VALUE;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS armEofrTimer(PKinesisVideoStream pKinesisVideoStream, UINT64 deadline)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient;
+    PEofrTimerWheel pEofrTimerWheel;
+    PKinesisVideoStream pHead;
+    UINT64 tick;
+    BOOL locked = FALSE;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pEofrTimerWheel = &pKinesisVideoClient->eofrTimerWheel;
+
+    // Early return without locking if the wheel is not used or the stream has been armed already
+    CHK(IS_VALID_MUTEX_VALUE(pEofrTimerWheel->lock) && !pKinesisVideoStream->eofrTimerArmed, retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+    locked = TRUE;
+
+    CHK(!pKinesisVideoStream->eofrTimerArmed, retStatus);
+
+    // The deadline which has passed expires on the next tick. The deadline beyond the wheel span is
+    // armed into the farthest bucket and re-armed once it expires.
+    tick = deadline / pEofrTimerWheel->tickPeriod;
+    tick = MAX(tick, pEofrTimerWheel->lastExpiredTick + 1);
+    tick = MIN(tick, pEofrTimerWheel->lastExpiredTick + EOFR_TIMER_WHEEL_BUCKET_COUNT - 1);
+
+    pKinesisVideoStream->eofrTimerBucket = (UINT32) (tick % EOFR_TIMER_WHEEL_BUCKET_COUNT);
+    pHead = pEofrTimerWheel->buckets[pKinesisVideoStream->eofrTimerBucket];
+    pKinesisVideoStream->pPrevEofrTimer = NULL;
+    pKinesisVideoStream->pNextEofrTimer = pHead;
+    if (pHead != NULL) {
+        pHead->pPrevEofrTimer = pKinesisVideoStream;
+    }
+
+    pEofrTimerWheel->buckets[pKinesisVideoStream->eofrTimerBucket] = pKinesisVideoStream;
+    pKinesisVideoStream->eofrTimerArmed = TRUE;
+
+CleanUp:
+
+    if (locked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS disarmEofrTimer(PKinesisVideoStream pKinesisVideoStream)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient;
+    PEofrTimerWheel pEofrTimerWheel;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pEofrTimerWheel = &pKinesisVideoClient->eofrTimerWheel;
+
+    CHK(IS_VALID_MUTEX_VALUE(pEofrTimerWheel->lock), retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+    if (pKinesisVideoStream->eofrTimerArmed) {
+        unlinkEofrTimer(pEofrTimerWheel, pKinesisVideoStream);
+    }
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS expireEofrTimers(PKinesisVideoClient pKinesisVideoClient, UINT64 currentTime, StreamVisitFunc expireFn, UINT64 customData)
+{
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PEofrTimerWheel pEofrTimerWheel;
+    PKinesisVideoStream pKinesisVideoStream;
+    UINT64 tick, currentTick;
+    UINT32 bucket;
+    BOOL pinned;
+
+    CHK(pKinesisVideoClient != NULL && expireFn != NULL, STATUS_NULL_ARG);
+    pEofrTimerWheel = &pKinesisVideoClient->eofrTimerWheel;
+    CHK(IS_VALID_MUTEX_VALUE(pEofrTimerWheel->lock), retStatus);
+
+    // The last expired tick is only advanced here so it can be read without locking.
+    // Expiring the buckets of a single revolution expires all of the armed streams.
+    currentTick = currentTime / pEofrTimerWheel->tickPeriod;
+    tick = pEofrTimerWheel->lastExpiredTick;
+    if (currentTick > tick + EOFR_TIMER_WHEEL_BUCKET_COUNT) {
+        tick = currentTick - EOFR_TIMER_WHEEL_BUCKET_COUNT;
+    }
+
+    while (tick < currentTick) {
+        tick++;
+        bucket = (UINT32) (tick % EOFR_TIMER_WHEEL_BUCKET_COUNT);
+
+        // Advance the wheel first so the streams re-armed while expiring land in the following buckets
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+        pEofrTimerWheel->lastExpiredTick = tick;
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+
+        do {
+            // Unlink the streams one at a time as they might be re-armed by the put frame while expiring
+            pinned = FALSE;
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+            pKinesisVideoStream = pEofrTimerWheel->buckets[bucket];
+            if (pKinesisVideoStream != NULL) {
+                unlinkEofrTimer(pEofrTimerWheel, pKinesisVideoStream);
+
+                // Pin the stream so it can't be freed once unlocked. The streams being freed are skipped.
+                pinned = STATUS_SUCCEEDED(semaphoreAcquire(pKinesisVideoStream->base.shutdownSemaphore, 0));
+            }
+            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pEofrTimerWheel->lock);
+
+            if (pinned) {
+                status = expireFn(pKinesisVideoStream, customData);
+                semaphoreRelease(pKinesisVideoStream->base.shutdownSemaphore);
+
+                // The failure of one stream should not leave the rest of the bucket armed
+                retStatus = STATUS_SUCCEEDED(retStatus) ? status : retStatus;
+            }
+        } while (pKinesisVideoStream != NULL);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
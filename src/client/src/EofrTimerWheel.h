@@ -0,0 +1,47 @@
+/*******************************************
+Intermittent producer EoFR timer wheel internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_EOFR_TIMER_WHEEL_INCLUDE_I__
+#define __KINESIS_VIDEO_EOFR_TIMER_WHEEL_INCLUDE_I__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of the wheel buckets. The deadlines further than the bucket count less one ticks
+ * away are armed into the farthest bucket and re-armed when it expires.
+ */
+#define EOFR_TIMER_WHEEL_BUCKET_COUNT 256
+
+/**
+ * Timer wheel of the deadlines at which the streams of the intermittent producer get the automatic EoFR.
+ * The wheel advances a tick on each invocation of the client timer callback. A stream is armed once its
+ * first frame is put and is only re-armed when its deadline expires so putting a frame is a flag check.
+ * The expired stream is re-armed at the deadline following its last frame if a frame has been put since.
+ *
+ * The buckets are the lists of the streams linked through the streams and are guarded by the wheel lock
+ * which is only held to link and unlink the streams.
+ */
+typedef struct __EofrTimerWheel EofrTimerWheel;
+struct __EofrTimerWheel {
+    // Guards the buckets and the timer links of the streams. Invalid if the wheel is not used.
+    MUTEX lock;
+
+    // Duration of a tick
+    UINT64 tickPeriod;
+
+    // Number of the last tick the buckets have expired at. Counted from the epoch.
+    UINT64 lastExpiredTick;
+
+    // Heads of the lists of the streams armed to expire at the tick of the bucket
+    PKinesisVideoStream buckets[EOFR_TIMER_WHEEL_BUCKET_COUNT];
+};
+typedef struct __EofrTimerWheel* PEofrTimerWheel;
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__KINESIS_VIDEO_EOFR_TIMER_WHEEL_INCLUDE_I__*/
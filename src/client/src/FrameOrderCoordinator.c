@@ -265,11 +265,10 @@ STATUS frameOrderCoordinatorPutFrame(PKinesisVideoStream pKinesisVideoStream, PF
     pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pFrameOrderCoordinator->lock);
     locked = TRUE;
 
-    for (i = 0; i < pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount; ++i) {
-        if (pFrameOrderCoordinator->putFrameTrackDataList[i].pTrackInfo->trackId == pUserFrame->trackId) {
-            pPutFrameTrackData = &pFrameOrderCoordinator->putFrameTrackDataList[i];
-            break;
-        }
+    // The track data list is indexed the same as the track info list
+    if (STATUS_SUCCEEDED(mkvgenGetTrackInfoFromMap(&pKinesisVideoStream->trackIndexMap, pKinesisVideoStream->streamInfo.streamCaps.trackInfoList,
+                                                   pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount, pUserFrame->trackId, NULL, &i))) {
+        pPutFrameTrackData = &pFrameOrderCoordinator->putFrameTrackDataList[i];
     }
 
     CHK(pPutFrameTrackData != NULL || CHECK_FRAME_FLAG_END_OF_FRAGMENT(pUserFrame->flags), STATUS_MKV_TRACK_INFO_NOT_FOUND);
@@ -52,7 +52,7 @@ struct __KinesisVideoBase {
     // Lock needed to create/free a stream + iterating over a stream
     MUTEX streamListLock;
 
-    // Lock for putKinesisVideoFrame API call
+    // Lock for putKinesisVideoFrame API call. Only used by the streams.
     MUTEX putFrameLock;
 
     // Conditional variable for Ready state
@@ -87,6 +87,26 @@ struct __EndpointInfo {
 };
 typedef struct __EndpointInfo* PEndpointInfo;
 
+/**
+ * Content store arena. The streams are spread over the arenas the content store is partitioned into
+ * so the streams storing into different arenas don't contend on a single lock.
+ */
+typedef struct __StoreArena StoreArena;
+struct __StoreArena {
+    // The heap backing the arena
+    PHeap pHeap;
+
+    // The share of the storage size of the arena
+    UINT64 storageSize;
+
+    // Lock guarding the heap of the arena. The client lock guards the content store if it's not partitioned.
+    MUTEX lock;
+
+    // Number of the streams storing into the arena
+    UINT32 streamCount;
+};
+typedef struct __StoreArena* PStoreArena;
+
 // Testability hooks functions
 typedef STATUS (*KinesisVideoClientCallbackHookFunc)(UINT64);
 
@@ -97,6 +117,11 @@ typedef STATUS (*KinesisVideoClientCallbackHookFunc)(UINT64);
 #include "InputValidator.h"
 #include "AckParser.h"
 #include "FrameOrderCoordinator.h"
+#include "StreamJournal.h"
+#include "PutFrameRing.h"
+#include "StreamTable.h"
+#include "EofrTimerWheel.h"
+#include "LaceTimers.h"
 #include "Stream.h"
 
 ////////////////////////////////////////////////////
@@ -153,8 +178,10 @@ typedef STATUS (*KinesisVideoClientCallbackHookFunc)(UINT64);
 /**
  * Default heap flags
  */
-#define MEMORY_BASED_HEAP_FLAGS FLAGS_USE_AIV_HEAP
-#define FILE_BASED_HEAP_FLAGS   (FLAGS_USE_AIV_HEAP | FLAGS_USE_HYBRID_FILE_HEAP)
+#define MEMORY_BASED_HEAP_FLAGS          FLAGS_USE_AIV_HEAP
+#define FILE_BASED_HEAP_FLAGS            (FLAGS_USE_AIV_HEAP | FLAGS_USE_HYBRID_FILE_HEAP)
+#define PERSISTENT_FILE_BASED_HEAP_FLAGS (FILE_BASED_HEAP_FLAGS | FLAGS_PERSIST_HYBRID_FILE_HEAP)
+#define RING_BUFFER_HEAP_FLAGS           FLAGS_USE_RING_HEAP
 
 /**
  * Checks whether the dropped connection can be due to host issues
@@ -240,6 +267,21 @@ typedef STATUS (*KinesisVideoClientCallbackHookFunc)(UINT64);
  */
 #define INTERMITTENT_PRODUCER_MAX_TIMEOUT (20LL * HUNDREDS_OF_NANOS_IN_A_SECOND)
 
+/**
+ * How often the callback is invoked to demote the already sent content to the file storage tier
+ */
+#define STORAGE_TIERING_PERIOD (1 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+/**
+ * Initial time to delay before firing first callback for the storage tiering
+ */
+#define STORAGE_TIERING_TIMER_START_DELAY (1 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+/**
+ * In-memory storage usage percentage at or above which the sent content is demoted to the file storage tier
+ */
+#define STORAGE_TIERING_MEMORY_WATERMARK 75
+
 /**
  * Kinesis Video client internal structure
  */
@@ -253,14 +295,19 @@ typedef struct __KinesisVideoClient {
     // Client callbacks
     ClientCallbacks clientCallbacks;
 
-    // Client storage
+    // Client storage. Points to the heap of the first arena if the content store is partitioned.
     PHeap pHeap;
 
+    // The arenas of the content store. There is a single arena backed by the client storage
+    // and guarded by the client lock if the content store is not partitioned.
+    StoreArena storeArenas[MAX_STORE_ARENA_COUNT];
+    UINT32 storeArenaCount;
+
     // Current number of the streams
     UINT32 streamCount;
 
-    // The array of streams objects
-    PKinesisVideoStream* streams;
+    // The stream handle table
+    StreamTable streamTable;
 
     // Authentication info - Token and Cert
     AuthInfo tokenAuthInfo;
@@ -285,6 +332,26 @@ typedef struct __KinesisVideoClient {
     // ID for timer created to wake and check if streams have incoming data
     UINT32 timerId;
 
+    // Deadlines of the automatic EoFR of the streams advanced by the intermittent producer timer
+    EofrTimerWheel eofrTimerWheel;
+
+    // ID for timer created to demote the sent content to the file storage tier
+    UINT32 tieringTimerId;
+
+    // Deadlines of the partial audio laces of the streams and the timer putting them
+    LaceTimers laceTimers;
+
+    // Thread pool running the workers draining the async putFrame ingestion rings of the streams
+    PThreadpool pPutFrameThreadpool;
+
+    // The workers, their count and the number of them still running
+    PutFrameWorker putFrameWorkers[MAX_PUT_FRAME_WORKER_COUNT];
+    UINT32 putFrameWorkerCount;
+    volatile SIZE_T runningPutFrameWorkers;
+
+    // Whether the workers should exit
+    volatile ATOMIC_BOOL putFrameWorkersTerminate;
+
     // Stored function pointers to reset on exit
     memAlloc storedMemAlloc;
     memAlignAlloc storedMemAlignAlloc;
@@ -471,10 +538,155 @@ STATUS executeReadyClientState(UINT64, UINT64);
 STATUS defaultClientStateTransitionHook(UINT64, PUINT64);
 
 STATUS checkIntermittentProducerCallback(UINT32, UINT64, UINT64);
+STATUS storageTieringCallback(UINT32, UINT64, UINT64);
+STATUS laceFlushCallback(UINT32, UINT64, UINT64);
+STATUS checkIntermittentProducerStream(PKinesisVideoStream, UINT64);
+STATUS storageTieringStream(PKinesisVideoStream, UINT64);
+STATUS laceFlushStream(PKinesisVideoStream, UINT64);
+STATUS stopStreamVisitor(PKinesisVideoStream, UINT64);
+
+/**
+ * Client metrics accumulated while visiting the streams
+ */
+typedef struct __ClientMetricsAccumulator ClientMetricsAccumulator;
+struct __ClientMetricsAccumulator {
+    // The client metrics to accumulate into
+    PClientMetrics pClientMetrics;
+
+    // Sum of the API call retry counts of the streams
+    UINT32 totalClientRetryCount;
+};
+typedef struct __ClientMetricsAccumulator* PClientMetricsAccumulator;
+
+STATUS accumulateStreamMetrics(PKinesisVideoStream, UINT64);
 
 STATUS freeClientRetryStrategy(PKinesisVideoClient);
 STATUS configureClientWithRetryStrategy(PKinesisVideoClient);
 
+/**
+ * Starts and stops the workers draining the async putFrame ingestion rings of the streams.
+ * IMPORTANT: The streams list lock should not be held when stopping the workers.
+ */
+STATUS createPutFrameWorkers(PKinesisVideoClient);
+STATUS freePutFrameWorkers(PKinesisVideoClient);
+PVOID putFrameWorkerRoutine(PVOID);
+STATUS putFrameWorkerDrainStream(PKinesisVideoStream, UINT64);
+
+/**
+ * Frees the content persisted by the previous run which is not recorded by any of the stream journals.
+ * IMPORTANT: Should be called before the streams are created.
+ */
+STATUS releaseUnjournaledContent(PKinesisVideoClient);
+PCHAR getStreamJournalRootDirectory(PKinesisVideoClient);
+
+/**
+ * Initializes and frees the stream handle table. The slots are expected to be zeroed.
+ */
+STATUS createStreamTable(PKinesisVideoClient);
+STATUS freeStreamTable(PKinesisVideoClient);
+
+/**
+ * Checks whether a stream with the name exists.
+ * IMPORTANT: The streams list lock should be held.
+ *
+ * @return - STATUS_DUPLICATE_STREAM_NAME if the name is already taken.
+ */
+STATUS streamTableCheckName(PKinesisVideoClient, PCHAR);
+
+/**
+ * Inserts the stream into a free slot setting the stream id and removes it
+ * invalidating the handles of the stream. Removing the stream which is not inserted is a no-op.
+ * IMPORTANT: The streams list lock should be held.
+ */
+STATUS streamTableInsert(PKinesisVideoClient, PKinesisVideoStream);
+STATUS streamTableRemove(PKinesisVideoClient, PKinesisVideoStream);
+
+/**
+ * Visits the streams in the slots from the start index stepping by the stride. Each stream is pinned
+ * by its shutdown semaphore while visited and no client-wide lock is held. The streams being freed are skipped.
+ *
+ * @PKinesisVideoClient - IN - the client object.
+ * @UINT32 - IN - index of the first slot to visit.
+ * @UINT32 - IN - the stride.
+ * @StreamVisitFunc - IN - the function to call for each stream.
+ * @UINT64 - IN - custom data to pass to the function.
+ *
+ * @return - STATUS - the first failure of the visitor function or status code of the operation.
+ */
+STATUS streamTableVisit(PKinesisVideoClient, UINT32, UINT32, StreamVisitFunc, UINT64);
+
+/**
+ * Initializes and frees the EoFR timer wheel of the intermittent producer.
+ * The wheel is not used unless created and the rest of the calls are no-op.
+ */
+STATUS createEofrTimerWheel(PKinesisVideoClient);
+STATUS freeEofrTimerWheel(PKinesisVideoClient);
+
+/**
+ * Arms the automatic EoFR deadline of the stream unless it's armed already and disarms it.
+ * IMPORTANT: The wheel lock is taken so it should be the last one to acquire.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ * @UINT64 - IN - the deadline.
+ */
+STATUS armEofrTimer(PKinesisVideoStream, UINT64);
+STATUS disarmEofrTimer(PKinesisVideoStream);
+
+/**
+ * Advances the wheel to the current time disarming the streams whose deadlines have expired.
+ * Each of the streams is pinned by its shutdown semaphore while expired and no lock is held.
+ * The streams being freed are skipped.
+ *
+ * @PKinesisVideoClient - IN - the client object.
+ * @UINT64 - IN - the current time.
+ * @StreamVisitFunc - IN - the function to call for each of the expired streams.
+ * @UINT64 - IN - custom data to pass to the function.
+ *
+ * @return - STATUS - the first failure of the function or status code of the operation.
+ */
+STATUS expireEofrTimers(PKinesisVideoClient, UINT64, StreamVisitFunc, UINT64);
+
+/**
+ * Initializes the lace deadlines for the first stream lacing the audio and frees them.
+ * The rest of the calls are no-op until initialized.
+ */
+STATUS createLaceTimers(PKinesisVideoClient);
+STATUS freeLaceTimers(PKinesisVideoClient);
+
+/**
+ * Arms the deadline of the pending lace of the stream and disarms it.
+ * IMPORTANT: The lace timers lock is taken so it should be the last one to acquire.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ * @UINT64 - IN - the deadline in the client time.
+ */
+STATUS armLaceTimer(PKinesisVideoStream, UINT64);
+STATUS disarmLaceTimer(PKinesisVideoStream);
+
+/**
+ * Starts the lace flush timer or reschedules it to the earliest deadline if a deadline has been armed ahead of it.
+ * IMPORTANT: The putFrame lock should not be held as the timer queue is called.
+ *
+ * @PKinesisVideoClient - IN - the client object.
+ */
+STATUS scheduleLaceFlushTimer(PKinesisVideoClient);
+
+/**
+ * Disarms the streams whose deadlines have expired and reschedules the lace flush timer to the earliest
+ * deadline. Each of the streams is pinned by its shutdown semaphore while expired and no lock is held.
+ * The streams being freed are skipped.
+ *
+ * @PKinesisVideoClient - IN - the client object.
+ * @UINT32 - IN - the lace flush timer ID.
+ * @UINT64 - IN - the current client time.
+ * @StreamVisitFunc - IN - the function to call for each of the expired streams.
+ * @UINT64 - IN - custom data to pass to the function.
+ *
+ * @return - STATUS - STATUS_TIMER_QUEUE_STOP_SCHEDULING once no stream is armed, the first failure
+ * of the function or status code of the operation.
+ */
+STATUS expireLaceTimers(PKinesisVideoClient, UINT32, UINT64, StreamVisitFunc, UINT64);
+
 #ifdef __cplusplus
 }
 #endif
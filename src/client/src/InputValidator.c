@@ -132,6 +132,14 @@ STATUS validateDeviceInfo(PDeviceInfo pDeviceInfo)
         STATUS_INVALID_STORAGE_SIZE);
     CHK(pDeviceInfo->storageInfo.spillRatio <= 100, STATUS_INVALID_SPILL_RATIO);
     CHK(STRNLEN(pDeviceInfo->storageInfo.rootDirectory, MAX_PATH_LEN + 1) <= MAX_PATH_LEN, STATUS_INVALID_ROOT_DIRECTORY_LENGTH);
+
+    // Each of the arenas needs to be a valid content store on its own
+    if (pDeviceInfo->storageInfo.version >= 1 && pDeviceInfo->storageInfo.storeArenaCount > 1) {
+        CHK(pDeviceInfo->storageInfo.storeArenaCount <= MAX_STORE_ARENA_COUNT &&
+                pDeviceInfo->storageInfo.storageSize / pDeviceInfo->storageInfo.storeArenaCount >= MIN_STORAGE_ALLOCATION_SIZE,
+            STATUS_INVALID_STORE_ARENA_COUNT);
+    }
+
     CHK(STRNLEN(pDeviceInfo->name, MAX_DEVICE_NAME_LEN + 1) <= MAX_DEVICE_NAME_LEN, STATUS_INVALID_DEVICE_NAME_LENGTH);
 
     // Validate the tags
@@ -161,6 +169,13 @@ STATUS validateClientInfo(PClientInfo pClientInfo)
     CHK(pClientInfo != NULL, STATUS_NULL_ARG);
     CHK(pClientInfo->version <= CLIENT_INFO_CURRENT_VERSION, STATUS_INVALID_CLIENT_INFO_VERSION);
 
+    if (pClientInfo->version >= 4) {
+        CHK(pClientInfo->putFrameRingSize <= MAX_PUT_FRAME_RING_SIZE && (pClientInfo->putFrameRingSize & (pClientInfo->putFrameRingSize - 1)) == 0,
+            STATUS_INVALID_PUT_FRAME_RING_SIZE);
+        CHK(pClientInfo->putFrameRingBufferSize <= MAX_PUT_FRAME_RING_BUFFER_SIZE, STATUS_INVALID_PUT_FRAME_RING_BUFFER_SIZE);
+        CHK(pClientInfo->putFrameWorkerCount <= MAX_PUT_FRAME_WORKER_COUNT, STATUS_INVALID_PUT_FRAME_WORKER_COUNT);
+    }
+
 CleanUp:
     return retStatus;
 }
@@ -281,6 +296,12 @@ VOID fixupDeviceInfo(PDeviceInfo pClientDeviceInfo, PDeviceInfo pDeviceInfo)
             pClientDeviceInfo->tagCount = pDeviceInfo->tagCount;
             pClientDeviceInfo->tags = pDeviceInfo->tags;
             pClientDeviceInfo->storageInfo = pDeviceInfo->storageInfo;
+
+            // The content store is not partitioned prior to V1 of the storage info
+            if (pDeviceInfo->storageInfo.version == 0) {
+                pClientDeviceInfo->storageInfo.storeArenaCount = 0;
+            }
+
             pClientDeviceInfo->streamCount = pDeviceInfo->streamCount;
 
             break;
@@ -313,6 +334,12 @@ VOID fixupClientInfo(PClientInfo pClientInfo, PClientInfo pOrigClientInfo)
         pClientInfo->kvsRetryStrategyCallbacks = pOrigClientInfo->kvsRetryStrategyCallbacks;
 
         switch (pOrigClientInfo->version) {
+            case 4:
+                pClientInfo->putFrameRingSize = pOrigClientInfo->putFrameRingSize;
+                pClientInfo->putFrameRingBufferSize = pOrigClientInfo->putFrameRingBufferSize;
+                pClientInfo->putFrameWorkerCount = pOrigClientInfo->putFrameWorkerCount;
+
+                // explicit fall through
             case 3:
                 pClientInfo->serviceCallCompletionTimeout = pOrigClientInfo->serviceCallCompletionTimeout;
                 pClientInfo->serviceCallConnectionTimeout = pOrigClientInfo->serviceCallConnectionTimeout;
@@ -450,8 +477,14 @@ VOID fixupStreamInfo(PStreamInfo pStreamInfo)
 
         case 2:
             pStreamInfo->streamCaps.allowStreamCreation = TRUE;
-            break;
+
         case 3:
+            pStreamInfo->streamCaps.audioLacingDuration = 0;
+
+        case 4:
+            pStreamInfo->streamCaps.fragmentExtentSize = 0;
+            break;
+        case 5:
             // No-op - the latest versionn
             break;
     }
@@ -0,0 +1,278 @@
+/**
+ * Kinesis Video partial audio lace deadlines
+ */
+#define LOG_CLASS "LaceTimers"
+
+#include "Include_i.h"
+
+/**
+ * Unlinks the armed stream from the list. The lace timers lock should be held.
+ */
+static VOID unlinkLaceTimer(PLaceTimers pLaceTimers, PKinesisVideoStream pKinesisVideoStream)
+{
+    if (pKinesisVideoStream->pPrevLaceTimer == NULL) {
+        pLaceTimers->pHead = pKinesisVideoStream->pNextLaceTimer;
+    } else {
+        pKinesisVideoStream->pPrevLaceTimer->pNextLaceTimer = pKinesisVideoStream->pNextLaceTimer;
+    }
+
+    if (pKinesisVideoStream->pNextLaceTimer == NULL) {
+        pLaceTimers->pTail = pKinesisVideoStream->pPrevLaceTimer;
+    } else {
+        pKinesisVideoStream->pNextLaceTimer->pPrevLaceTimer = pKinesisVideoStream->pPrevLaceTimer;
+    }
+
+    pKinesisVideoStream->pNextLaceTimer = NULL;
+    pKinesisVideoStream->pPrevLaceTimer = NULL;
+    pKinesisVideoStream->laceTimerArmed = FALSE;
+}
+
+/**
+ * Period of the lace flush timer firing at the deadline
+ */
+static UINT64 getLaceFlushTimerPeriod(PKinesisVideoClient pKinesisVideoClient, UINT64 deadline)
+{
+    UINT64 currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+
+    return deadline > currentTime + MIN_TIMER_QUEUE_PERIOD_DURATION ? deadline - currentTime : MIN_TIMER_QUEUE_PERIOD_DURATION;
+}
+
+STATUS createLaceTimers(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PLaceTimers pLaceTimers;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pLaceTimers = &pKinesisVideoClient->laceTimers;
+
+    // Created once for the first stream lacing the audio
+    CHK(!IS_VALID_MUTEX_VALUE(pLaceTimers->lock), retStatus);
+
+    pLaceTimers->scheduleLock = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pLaceTimers->scheduleLock), STATUS_NOT_ENOUGH_MEMORY);
+
+    pLaceTimers->lock = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pLaceTimers->lock), STATUS_NOT_ENOUGH_MEMORY);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS freeLaceTimers(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PLaceTimers pLaceTimers;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pLaceTimers = &pKinesisVideoClient->laceTimers;
+
+    if (IS_VALID_MUTEX_VALUE(pLaceTimers->lock)) {
+        pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+        pLaceTimers->lock = INVALID_MUTEX_VALUE;
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pLaceTimers->scheduleLock)) {
+        pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->scheduleLock);
+        pLaceTimers->scheduleLock = INVALID_MUTEX_VALUE;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS armLaceTimer(PKinesisVideoStream pKinesisVideoStream, UINT64 deadline)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient;
+    PLaceTimers pLaceTimers;
+    PKinesisVideoStream pPrev;
+    BOOL locked = FALSE;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pLaceTimers = &pKinesisVideoClient->laceTimers;
+
+    CHK(IS_VALID_MUTEX_VALUE(pLaceTimers->lock), retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+    locked = TRUE;
+
+    if (pKinesisVideoStream->laceTimerArmed) {
+        unlinkLaceTimer(pLaceTimers, pKinesisVideoStream);
+    }
+
+    // The streams lacing with the same duration arm in the order of their deadlines so the stream
+    // is linked after the last one in most cases
+    pPrev = pLaceTimers->pTail;
+    while (pPrev != NULL && pPrev->laceDeadline > deadline) {
+        pPrev = pPrev->pPrevLaceTimer;
+    }
+
+    pKinesisVideoStream->laceDeadline = deadline;
+    pKinesisVideoStream->pPrevLaceTimer = pPrev;
+    pKinesisVideoStream->pNextLaceTimer = pPrev == NULL ? pLaceTimers->pHead : pPrev->pNextLaceTimer;
+    if (pKinesisVideoStream->pNextLaceTimer == NULL) {
+        pLaceTimers->pTail = pKinesisVideoStream;
+    } else {
+        pKinesisVideoStream->pNextLaceTimer->pPrevLaceTimer = pKinesisVideoStream;
+    }
+
+    if (pPrev == NULL) {
+        pLaceTimers->pHead = pKinesisVideoStream;
+    } else {
+        pPrev->pNextLaceTimer = pKinesisVideoStream;
+    }
+
+    pKinesisVideoStream->laceTimerArmed = TRUE;
+
+    // The timer is scheduled once the putFrame lock is released
+    if (!pLaceTimers->timerStarted || deadline < pLaceTimers->timerDeadline) {
+        ATOMIC_STORE_BOOL(&pLaceTimers->schedulePending, TRUE);
+    }
+
+CleanUp:
+
+    if (locked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS disarmLaceTimer(PKinesisVideoStream pKinesisVideoStream)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient;
+    PLaceTimers pLaceTimers;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pLaceTimers = &pKinesisVideoClient->laceTimers;
+
+    // Early return without locking for the streams which are not armed. The flag is only set by the producer.
+    CHK(IS_VALID_MUTEX_VALUE(pLaceTimers->lock) && pKinesisVideoStream->laceTimerArmed, retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+    if (pKinesisVideoStream->laceTimerArmed) {
+        unlinkLaceTimer(pLaceTimers, pKinesisVideoStream);
+    }
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS scheduleLaceFlushTimer(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PLaceTimers pLaceTimers;
+    UINT64 deadline = 0, period;
+    BOOL scheduleLocked = FALSE, start = FALSE, reschedule = FALSE;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pLaceTimers = &pKinesisVideoClient->laceTimers;
+
+    // Early return without locking unless a deadline has been armed ahead of the timer
+    CHK(IS_VALID_MUTEX_VALUE(pLaceTimers->lock) && ATOMIC_LOAD_BOOL(&pLaceTimers->schedulePending), retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->scheduleLock);
+    scheduleLocked = TRUE;
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+    ATOMIC_STORE_BOOL(&pLaceTimers->schedulePending, FALSE);
+    if (pLaceTimers->pHead != NULL && (!pLaceTimers->timerStarted || pLaceTimers->pHead->laceDeadline < pLaceTimers->timerDeadline)) {
+        start = !pLaceTimers->timerStarted;
+        reschedule = !start;
+        deadline = pLaceTimers->pHead->laceDeadline;
+        pLaceTimers->timerStarted = TRUE;
+        pLaceTimers->timerDeadline = deadline;
+    }
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+
+    CHK(start || reschedule, retStatus);
+    period = getLaceFlushTimerPeriod(pKinesisVideoClient, deadline);
+
+    if (start) {
+        retStatus = timerQueueAddTimer(pKinesisVideoClient->timerQueueHandle, period, period, laceFlushCallback, (UINT64) pKinesisVideoClient,
+                                       &pLaceTimers->timerId);
+
+        // Retry with the following put
+        if (STATUS_FAILED(retStatus)) {
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+            pLaceTimers->timerStarted = FALSE;
+            ATOMIC_STORE_BOOL(&pLaceTimers->schedulePending, TRUE);
+            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+        }
+    } else {
+        // No-op if the timer has stopped in the meantime as the deadline has expired already
+        retStatus = timerQueueUpdateTimerPeriod(pKinesisVideoClient->timerQueueHandle, (UINT64) pKinesisVideoClient, pLaceTimers->timerId, period);
+    }
+
+CleanUp:
+
+    if (scheduleLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->scheduleLock);
+    }
+
+    return retStatus;
+}
+
+STATUS expireLaceTimers(PKinesisVideoClient pKinesisVideoClient, UINT32 timerId, UINT64 currentTime, StreamVisitFunc expireFn, UINT64 customData)
+{
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PLaceTimers pLaceTimers;
+    PKinesisVideoStream pKinesisVideoStream;
+    UINT64 deadline = 0;
+    BOOL pinned, stop;
+
+    CHK(pKinesisVideoClient != NULL && expireFn != NULL, STATUS_NULL_ARG);
+    pLaceTimers = &pKinesisVideoClient->laceTimers;
+    CHK(IS_VALID_MUTEX_VALUE(pLaceTimers->lock), STATUS_TIMER_QUEUE_STOP_SCHEDULING);
+
+    do {
+        // Unlink the expired streams one at a time as they might be re-armed by the put frame while expiring
+        pinned = FALSE;
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+        pKinesisVideoStream = pLaceTimers->pHead;
+        if (pKinesisVideoStream != NULL && pKinesisVideoStream->laceDeadline <= currentTime) {
+            unlinkLaceTimer(pLaceTimers, pKinesisVideoStream);
+
+            // Pin the stream so it can't be freed once unlocked. The streams being freed are skipped.
+            pinned = STATUS_SUCCEEDED(semaphoreAcquire(pKinesisVideoStream->base.shutdownSemaphore, 0));
+        } else {
+            pKinesisVideoStream = NULL;
+        }
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+
+        if (pinned) {
+            status = expireFn(pKinesisVideoStream, customData);
+            semaphoreRelease(pKinesisVideoStream->base.shutdownSemaphore);
+
+            // The failure of one stream should not leave the rest of the expired streams armed
+            retStatus = STATUS_SUCCEEDED(retStatus) ? status : retStatus;
+        }
+    } while (pKinesisVideoStream != NULL);
+
+    // Stop the timer once no stream is lacing. Otherwise it fires at the earliest deadline.
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+    stop = pLaceTimers->pHead == NULL;
+    if (stop) {
+        pLaceTimers->timerStarted = FALSE;
+    } else {
+        deadline = pLaceTimers->pHead->laceDeadline;
+        pLaceTimers->timerDeadline = deadline;
+    }
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pLaceTimers->lock);
+
+    CHK(!stop, STATUS_TIMER_QUEUE_STOP_SCHEDULING);
+    status = timerQueueUpdateTimerPeriod(pKinesisVideoClient->timerQueueHandle, (UINT64) pKinesisVideoClient, timerId,
+                                         getLaceFlushTimerPeriod(pKinesisVideoClient, deadline));
+    retStatus = STATUS_SUCCEEDED(retStatus) ? status : retStatus;
+
+CleanUp:
+
+    return retStatus;
+}
@@ -0,0 +1,51 @@
+/*******************************************
+Partial audio lace deadlines internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_LACE_TIMERS_INCLUDE_I__
+#define __KINESIS_VIDEO_LACE_TIMERS_INCLUDE_I__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Deadlines at which the partial audio laces of the idle producers are put.
+ * A stream is armed once the first frame of its lace is accumulated and is disarmed when the lace is put.
+ * The armed streams are kept in the order of their deadlines so the timer only visits the expired ones.
+ *
+ * The lace flush timer is started for the first armed stream, fires at the earliest deadline and stops
+ * once no stream is armed. The intermittent producer callback takes the putFrame lock on the timer thread
+ * so the timer queue is not called with the putFrame lock held. Arming a deadline ahead of the timer only
+ * marks the timer to be scheduled by the producer once it releases the putFrame lock.
+ *
+ * The list is linked through the streams and is guarded by the lace timers lock which is only held to
+ * link and unlink the streams.
+ */
+typedef struct __LaceTimers LaceTimers;
+struct __LaceTimers {
+    // Guards the list, the timer links of the streams and the timer state. Invalid if no stream laces the audio.
+    MUTEX lock;
+
+    // Serializes starting and rescheduling the timer. Not taken by the timer callback.
+    MUTEX scheduleLock;
+
+    // Head and tail of the list of the armed streams in the order of their deadlines
+    PKinesisVideoStream pHead;
+    PKinesisVideoStream pTail;
+
+    // Whether the timer is running, its ID and the client time it fires at next
+    BOOL timerStarted;
+    UINT32 timerId;
+    UINT64 timerDeadline;
+
+    // Whether a deadline has been armed ahead of the timer
+    volatile ATOMIC_BOOL schedulePending;
+};
+typedef struct __LaceTimers* PLaceTimers;
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__KINESIS_VIDEO_LACE_TIMERS_INCLUDE_I__*/
@@ -0,0 +1,430 @@
+/**
+ * Kinesis Video async putFrame ingestion ring
+ */
+#define LOG_CLASS "PutFrameRing"
+
+#include "Include_i.h"
+
+STATUS createPutFrameRing(PKinesisVideoStream pKinesisVideoStream, UINT32 capacity, UINT64 bufferSize, PPutFrameRing* ppPutFrameRing)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PPutFrameRing pPutFrameRing = NULL;
+    PStreamCaps pStreamCaps;
+    UINT64 size;
+
+    CHK(pKinesisVideoStream != NULL && ppPutFrameRing != NULL, STATUS_NULL_ARG);
+    CHK(capacity != 0 && (capacity & (capacity - 1)) == 0, STATUS_INVALID_PUT_FRAME_RING_SIZE);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pStreamCaps = &pKinesisVideoStream->streamInfo.streamCaps;
+
+    // Give each slot a few average frames worth of the frame bits
+    if (bufferSize == 0) {
+        bufferSize = (UINT64) capacity * PUT_FRAME_RING_AVERAGE_FRAME_SIZE_MULTIPLIER * pStreamCaps->avgBandwidthBps / 8 / pStreamCaps->frameRate;
+        bufferSize = MIN(MAX(bufferSize, PUT_FRAME_RING_MIN_BUFFER_SIZE), MAX_PUT_FRAME_RING_BUFFER_SIZE);
+    }
+
+    // The running offsets wrap around consistently with the power of two size
+    for (size = 1; size < bufferSize; size <<= 1) {
+    }
+
+    // Allocate the entire structure with the slots and the frame bits buffer following it
+    pPutFrameRing = (PPutFrameRing) MEMALLOC(SIZEOF(PutFrameRing) + capacity * SIZEOF(PutFrameRingSlot) + (SIZE_T) size);
+    CHK(pPutFrameRing != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    MEMSET(pPutFrameRing, 0x00, SIZEOF(PutFrameRing) + capacity * SIZEOF(PutFrameRingSlot));
+
+    pPutFrameRing->capacity = capacity;
+    pPutFrameRing->slots = (PPutFrameRingSlot) (pPutFrameRing + 1);
+    pPutFrameRing->buffer = (PBYTE) (pPutFrameRing->slots + capacity);
+    pPutFrameRing->bufferSize = (SIZE_T) size;
+    pPutFrameRing->consumerLock = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, TRUE);
+    CHK(IS_VALID_MUTEX_VALUE(pPutFrameRing->consumerLock), STATUS_NOT_ENOUGH_MEMORY);
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        SAFE_MEMFREE(pPutFrameRing);
+    }
+
+    if (ppPutFrameRing != NULL) {
+        *ppPutFrameRing = pPutFrameRing;
+    }
+
+    return retStatus;
+}
+
+STATUS freePutFrameRing(PKinesisVideoStream pKinesisVideoStream, PPutFrameRing* ppPutFrameRing)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PPutFrameRing pPutFrameRing = NULL;
+
+    CHK(pKinesisVideoStream != NULL && ppPutFrameRing != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pPutFrameRing = *ppPutFrameRing;
+
+    // Call is idempotent
+    CHK(pPutFrameRing != NULL, retStatus);
+
+    // The frames which have not been put are discarded with the ring
+    pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameRing->consumerLock);
+
+    MEMFREE(pPutFrameRing);
+    *ppPutFrameRing = NULL;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS putFrameRingEnqueue(PKinesisVideoStream pKinesisVideoStream, PFrame pUserFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPutFrameRing pPutFrameRing = NULL;
+    PPutFrameRingSlot pSlot;
+    SIZE_T head, tail, dataStart, dataOffset;
+    BOOL producing = FALSE;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pPutFrameRing != NULL && pUserFrame != NULL, STATUS_NULL_ARG);
+    CHK(pUserFrame->frameData != NULL || pUserFrame->size == 0, STATUS_NULL_ARG);
+    pPutFrameRing = pKinesisVideoStream->pPutFrameRing;
+
+    // Claim the producer role before checking the closed flag. Either the ring is seen closed here
+    // or the close waits for the frame to be published so it's drained by the stream stop.
+    CHK(!ATOMIC_EXCHANGE_BOOL(&pPutFrameRing->producing, TRUE), STATUS_PUT_FRAME_RING_CONCURRENT_PRODUCER);
+    producing = TRUE;
+
+    CHK(!ATOMIC_LOAD_BOOL(&pPutFrameRing->closed), STATUS_PUT_FRAME_RING_CLOSED);
+
+    // The producer owns the head and the consumer can only free up the slots
+    head = ATOMIC_LOAD(&pPutFrameRing->head);
+    tail = ATOMIC_LOAD(&pPutFrameRing->tail);
+
+    // The frame bits are kept contiguous skipping the end of the buffer they don't fit into
+    dataStart = pPutFrameRing->dataHead;
+    dataOffset = dataStart & (pPutFrameRing->bufferSize - 1);
+    if (dataOffset + pUserFrame->size > pPutFrameRing->bufferSize) {
+        dataStart += pPutFrameRing->bufferSize - dataOffset;
+        dataOffset = 0;
+    }
+
+    if (head - tail >= pPutFrameRing->capacity ||
+        dataStart + pUserFrame->size - ATOMIC_LOAD(&pPutFrameRing->dataTail) > pPutFrameRing->bufferSize) {
+        ATOMIC_INCREMENT(&pPutFrameRing->fullRejections);
+        CHK(FALSE, STATUS_PUT_FRAME_RING_FULL);
+    }
+
+    // Copy the frame as the caller owns the frame bits
+    pSlot = &pPutFrameRing->slots[head & (pPutFrameRing->capacity - 1)];
+    pSlot->frame = *pUserFrame;
+    pSlot->frame.frameData = pPutFrameRing->buffer + dataOffset;
+    if (pUserFrame->size != 0) {
+        MEMCPY(pSlot->frame.frameData, pUserFrame->frameData, pUserFrame->size);
+    }
+
+    pSlot->dataEnd = dataStart + pUserFrame->size;
+    pPutFrameRing->dataHead = pSlot->dataEnd;
+
+    // Publish the slot by advancing the head
+    ATOMIC_STORE(&pPutFrameRing->head, head + 1);
+    ATOMIC_STORE_BOOL(&pPutFrameRing->producing, FALSE);
+    producing = FALSE;
+
+    // Count the high-water mark once until the ring is drained
+    if ((head + 1 - tail) * 100 >= (SIZE_T) pPutFrameRing->capacity * PUT_FRAME_RING_HIGH_WATER_MARK &&
+        !ATOMIC_EXCHANGE_BOOL(&pPutFrameRing->aboveHighWater, TRUE)) {
+        ATOMIC_INCREMENT(&pPutFrameRing->highWaterMarks);
+    }
+
+    // Wake up the affined worker only on the transition so the producer mostly stays off the worker lock
+    putFrameWorkerWakeup(pKinesisVideoStream);
+
+CleanUp:
+
+    if (producing) {
+        ATOMIC_STORE_BOOL(&pPutFrameRing->producing, FALSE);
+    }
+
+    return retStatus;
+}
+
+STATUS putFrameRingClose(PKinesisVideoStream pKinesisVideoStream)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPutFrameRing pPutFrameRing = NULL;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pPutFrameRing = pKinesisVideoStream->pPutFrameRing;
+
+    // No-op for the synchronous streams
+    CHK(pPutFrameRing != NULL, retStatus);
+
+    ATOMIC_STORE_BOOL(&pPutFrameRing->closed, TRUE);
+
+    // The producer has passed the closed check and is about to publish the frame.
+    // A concurrent producer being rejected holds the role only briefly.
+    while (ATOMIC_LOAD_BOOL(&pPutFrameRing->producing)) {
+        THREAD_SLEEP(PUT_FRAME_RING_CLOSE_POLL_INTERVAL);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS putFrameRingDrain(PKinesisVideoStream pKinesisVideoStream, UINT32 maxFrameCount, BOOL waitForAvailability, PUINT32 pFrameCount)
+{
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PPutFrameRing pPutFrameRing = NULL;
+    PPutFrameRingSlot pSlot;
+    PFrame pFrame;
+    SIZE_T tail;
+    UINT32 frameCount = 0;
+    BOOL consumerLocked = FALSE, available = TRUE;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pPutFrameRing = pKinesisVideoStream->pPutFrameRing;
+
+    // No-op for the synchronous streams
+    CHK(pPutFrameRing != NULL, retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameRing->consumerLock);
+    consumerLocked = TRUE;
+
+    for (tail = ATOMIC_LOAD(&pPutFrameRing->tail); tail != ATOMIC_LOAD(&pPutFrameRing->head) && frameCount < maxFrameCount; tail++) {
+        pSlot = &pPutFrameRing->slots[tail & (pPutFrameRing->capacity - 1)];
+        pFrame = &pSlot->frame;
+
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+
+        // Leave the frame in the ring until the OFFLINE stream has the space for it. The check is best effort
+        // and the put still waits if the packaged frame turns out larger than estimated.
+        if (!waitForAvailability) {
+            CHK_LOG_ERR(checkFrameAvailability(pKinesisVideoStream, pFrame, &available));
+            if (!available) {
+                pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                                   pKinesisVideoStream->base.putFrameLock);
+                break;
+            }
+        }
+
+        status = frameOrderCoordinatorPutFrame(pKinesisVideoStream, pFrame);
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+
+        // The producer has already returned so the frame is reported as dropped
+        if (STATUS_FAILED(status)) {
+            DLOGW("[%s] Failed to put the enqueued frame. status: 0x%08x decoding timestamp: %" PRIu64 " presentation timestamp: %" PRIu64,
+                  pKinesisVideoStream->streamInfo.name, status, pFrame->decodingTs, pFrame->presentationTs);
+
+            if (pKinesisVideoClient->clientCallbacks.droppedFrameReportFn != NULL) {
+                pKinesisVideoClient->clientCallbacks.droppedFrameReportFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                                          TO_STREAM_HANDLE(pKinesisVideoStream), pFrame->presentationTs);
+            }
+        }
+
+        // Free up the frame bits before the slot so the producer never sees the slot free with its bits still in use
+        ATOMIC_STORE(&pPutFrameRing->dataTail, pSlot->dataEnd);
+        ATOMIC_STORE(&pPutFrameRing->tail, tail + 1);
+        frameCount++;
+    }
+
+    // Count the high-water mark again once the ring has been emptied
+    if (tail == ATOMIC_LOAD(&pPutFrameRing->head)) {
+        ATOMIC_STORE_BOOL(&pPutFrameRing->aboveHighWater, FALSE);
+    }
+
+CleanUp:
+
+    if (consumerLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameRing->consumerLock);
+
+        // The lace flush timer is scheduled with the putFrame lock released
+        CHK_LOG_ERR(scheduleLaceFlushTimer(pKinesisVideoClient));
+    }
+
+    if (pFrameCount != NULL) {
+        *pFrameCount = frameCount;
+    }
+
+    return retStatus;
+}
+
+BOOL putFrameRingIsEmpty(PKinesisVideoStream pKinesisVideoStream)
+{
+    PPutFrameRing pPutFrameRing = pKinesisVideoStream->pPutFrameRing;
+
+    return pPutFrameRing == NULL || ATOMIC_LOAD(&pPutFrameRing->tail) == ATOMIC_LOAD(&pPutFrameRing->head);
+}
+
+VOID putFrameWorkerWakeup(PKinesisVideoStream pKinesisVideoStream)
+{
+    PKinesisVideoClient pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    PPutFrameWorker pPutFrameWorker;
+
+    if (pKinesisVideoStream->pPutFrameRing == NULL) {
+        return;
+    }
+
+    pPutFrameWorker = &pKinesisVideoClient->putFrameWorkers[pKinesisVideoStream->streamId % pKinesisVideoClient->putFrameWorkerCount];
+    if (!ATOMIC_EXCHANGE_BOOL(&pPutFrameWorker->pending, TRUE)) {
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->lock);
+        pKinesisVideoClient->clientCallbacks.signalConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->wakeup);
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->lock);
+    }
+}
+
+STATUS createPutFrameWorkers(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPutFrameWorker pPutFrameWorker;
+    UINT32 i, workerCount;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    workerCount = pKinesisVideoClient->deviceInfo.clientInfo.putFrameWorkerCount;
+    if (workerCount == 0) {
+        workerCount = DEFAULT_PUT_FRAME_WORKER_COUNT;
+    }
+
+    ATOMIC_STORE_BOOL(&pKinesisVideoClient->putFrameWorkersTerminate, FALSE);
+    ATOMIC_STORE(&pKinesisVideoClient->runningPutFrameWorkers, 0);
+
+    // Set the count first so the workers are torn down on a partial failure
+    pKinesisVideoClient->putFrameWorkerCount = workerCount;
+    for (i = 0; i < workerCount; i++) {
+        pPutFrameWorker = &pKinesisVideoClient->putFrameWorkers[i];
+        pPutFrameWorker->pKinesisVideoClient = pKinesisVideoClient;
+        pPutFrameWorker->index = i;
+        ATOMIC_STORE_BOOL(&pPutFrameWorker->pending, FALSE);
+
+        pPutFrameWorker->lock = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, FALSE);
+        CHK(IS_VALID_MUTEX_VALUE(pPutFrameWorker->lock), STATUS_NOT_ENOUGH_MEMORY);
+
+        pPutFrameWorker->wakeup = pKinesisVideoClient->clientCallbacks.createConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData);
+        CHK(IS_VALID_CVAR_VALUE(pPutFrameWorker->wakeup), STATUS_NOT_ENOUGH_MEMORY);
+    }
+
+    // Each worker occupies a pool thread for the lifetime of the client
+    CHK_STATUS(threadpoolCreate(&pKinesisVideoClient->pPutFrameThreadpool, workerCount, workerCount));
+    for (i = 0; i < workerCount; i++) {
+        ATOMIC_INCREMENT(&pKinesisVideoClient->runningPutFrameWorkers);
+        retStatus = threadpoolPush(pKinesisVideoClient->pPutFrameThreadpool, putFrameWorkerRoutine, (PVOID) &pKinesisVideoClient->putFrameWorkers[i]);
+        if (STATUS_FAILED(retStatus)) {
+            ATOMIC_DECREMENT(&pKinesisVideoClient->runningPutFrameWorkers);
+            CHK(FALSE, retStatus);
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS freePutFrameWorkers(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPutFrameWorker pPutFrameWorker;
+    UINT32 i;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    ATOMIC_STORE_BOOL(&pKinesisVideoClient->putFrameWorkersTerminate, TRUE);
+
+    for (i = 0; i < pKinesisVideoClient->putFrameWorkerCount; i++) {
+        pPutFrameWorker = &pKinesisVideoClient->putFrameWorkers[i];
+        if (IS_VALID_MUTEX_VALUE(pPutFrameWorker->lock) && IS_VALID_CVAR_VALUE(pPutFrameWorker->wakeup)) {
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->lock);
+            pKinesisVideoClient->clientCallbacks.signalConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->wakeup);
+            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->lock);
+        }
+    }
+
+    // The pool threads are detached and do not interrupt the running routines so wait for the workers to exit
+    while (ATOMIC_LOAD(&pKinesisVideoClient->runningPutFrameWorkers) != 0) {
+        THREAD_SLEEP(PUT_FRAME_WORKER_EXIT_POLL_INTERVAL);
+    }
+
+    if (pKinesisVideoClient->pPutFrameThreadpool != NULL) {
+        retStatus = threadpoolFree(pKinesisVideoClient->pPutFrameThreadpool);
+        pKinesisVideoClient->pPutFrameThreadpool = NULL;
+    }
+
+    for (i = 0; i < pKinesisVideoClient->putFrameWorkerCount; i++) {
+        pPutFrameWorker = &pKinesisVideoClient->putFrameWorkers[i];
+        if (IS_VALID_CVAR_VALUE(pPutFrameWorker->wakeup)) {
+            pKinesisVideoClient->clientCallbacks.freeConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->wakeup);
+            pPutFrameWorker->wakeup = INVALID_CVAR_VALUE;
+        }
+
+        if (IS_VALID_MUTEX_VALUE(pPutFrameWorker->lock)) {
+            pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->lock);
+            pPutFrameWorker->lock = INVALID_MUTEX_VALUE;
+        }
+    }
+
+    pKinesisVideoClient->putFrameWorkerCount = 0;
+
+CleanUp:
+
+    return retStatus;
+}
+
+PVOID putFrameWorkerRoutine(PVOID customData)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPutFrameWorker pPutFrameWorker = (PPutFrameWorker) customData;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+
+    CHK(pPutFrameWorker != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pPutFrameWorker->pKinesisVideoClient;
+
+    while (!ATOMIC_LOAD_BOOL(&pKinesisVideoClient->putFrameWorkersTerminate)) {
+        // Sleep until an affined ring is produced into. The timeout is a safety net which also retries
+        // the frames left in the rings for the availability.
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->lock);
+        if (!ATOMIC_LOAD_BOOL(&pPutFrameWorker->pending) && !ATOMIC_LOAD_BOOL(&pKinesisVideoClient->putFrameWorkersTerminate)) {
+            pKinesisVideoClient->clientCallbacks.waitConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->wakeup,
+                                                                         pPutFrameWorker->lock, PUT_FRAME_WORKER_WAIT_TIMEOUT);
+        }
+
+        // Clear before draining so the frames enqueued while draining wake up the worker again
+        ATOMIC_STORE_BOOL(&pPutFrameWorker->pending, FALSE);
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pPutFrameWorker->lock);
+
+        // Visit the affined streams pinning them one at a time
+        CHK_LOG_ERR(
+            streamTableVisit(pKinesisVideoClient, pPutFrameWorker->index, pKinesisVideoClient->putFrameWorkerCount, putFrameWorkerDrainStream, 0));
+    }
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (pKinesisVideoClient != NULL) {
+        ATOMIC_DECREMENT(&pKinesisVideoClient->runningPutFrameWorkers);
+    }
+
+    return NULL;
+}
+
+STATUS putFrameWorkerDrainStream(PKinesisVideoStream pKinesisVideoStream, UINT64 customData)
+{
+    UINT32 frameCount = 0;
+
+    UNUSED_PARAM(customData);
+
+    // Don't block the other affined streams waiting for the availability and bound the frames put per visit
+    if (!putFrameRingIsEmpty(pKinesisVideoStream)) {
+        CHK_LOG_ERR(putFrameRingDrain(pKinesisVideoStream, PUT_FRAME_WORKER_MAX_DRAIN_COUNT, FALSE, &frameCount));
+
+        // Revisit right away if the visit has been cut short
+        if (frameCount == PUT_FRAME_WORKER_MAX_DRAIN_COUNT) {
+            putFrameWorkerWakeup(pKinesisVideoStream);
+        }
+    }
+
+    // The failure to drain one ring should not stop the visit
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,220 @@
+/*******************************************
+Async putFrame ingestion ring internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_PUT_FRAME_RING_INCLUDE_I__
+#define __KINESIS_VIDEO_PUT_FRAME_RING_INCLUDE_I__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Ring occupancy percentage at which the high-water mark is considered hit
+ */
+#define PUT_FRAME_RING_HIGH_WATER_MARK 75
+
+/**
+ * The longest a put frame worker sleeps before re-checking the rings
+ */
+#define PUT_FRAME_WORKER_WAIT_TIMEOUT (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * Interval to check whether the put frame workers have exited when stopping them
+ */
+#define PUT_FRAME_WORKER_EXIT_POLL_INTERVAL (5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * Max number of frames a worker puts into a stream per visit so the other affined streams aren't starved
+ */
+#define PUT_FRAME_WORKER_MAX_DRAIN_COUNT 32
+
+/**
+ * Interval to check whether the producer has finished publishing the frame when closing the ring
+ */
+#define PUT_FRAME_RING_CLOSE_POLL_INTERVAL (100 * HUNDREDS_OF_NANOS_IN_A_MICROSECOND)
+
+/**
+ * Multiple of the average frame size each slot gets in the frame bits buffer when its size is not specified
+ */
+#define PUT_FRAME_RING_AVERAGE_FRAME_SIZE_MULTIPLIER 4
+
+/**
+ * Min size of the frame bits buffer when its size is not specified so the key frames fit into the small rings
+ */
+#define PUT_FRAME_RING_MIN_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * A slot of the ring holding the frame with the frame bits in the frame bits buffer
+ */
+typedef struct __PutFrameRingSlot PutFrameRingSlot;
+struct __PutFrameRingSlot {
+    // The frame pointing to its bits in the buffer
+    Frame frame;
+
+    // Running offset of the end of the frame bits in the buffer
+    SIZE_T dataEnd;
+};
+typedef struct __PutFrameRingSlot* PPutFrameRingSlot;
+
+/**
+ * Bounded single producer/single consumer ring of the frames handed over by putKinesisVideoFrame
+ * in the async mode. The slots and the buffer the frame bits are copied into are preallocated so
+ * the producer never allocates. The producer side is lock-free with the producer role claimed
+ * for the duration of the enqueue. The consumers - the put frame worker the stream is affined to
+ * and the stream stop/commit paths - are serialized by the consumer lock.
+ */
+typedef struct __PutFrameRing PutFrameRing;
+struct __PutFrameRing {
+    // Number of the slots. Power of two.
+    UINT32 capacity;
+
+    // Running index of the next slot to produce into. Only advanced by the producer.
+    volatile SIZE_T head;
+
+    // Running index of the next slot to consume from. Only advanced by the consumer.
+    volatile SIZE_T tail;
+
+    // Whether the ring rejects the frames. Set when the stream is stopped.
+    volatile ATOMIC_BOOL closed;
+
+    // Whether a producer is enqueueing a frame. Claimed before checking the closed flag and released once the frame is published.
+    volatile ATOMIC_BOOL producing;
+
+    // Whether the occupancy has reached the high-water mark since the ring was last drained
+    volatile ATOMIC_BOOL aboveHighWater;
+
+    // Number of times the occupancy reached the high-water mark
+    volatile SIZE_T highWaterMarks;
+
+    // Number of frames rejected as the ring was full
+    volatile SIZE_T fullRejections;
+
+    // Serializes the consumers
+    MUTEX consumerLock;
+
+    // The slots holding the copies of the frames
+    PPutFrameRingSlot slots;
+
+    // The buffer the frame bits are copied into contiguously in the order of the slots. Power of two size.
+    PBYTE buffer;
+    SIZE_T bufferSize;
+
+    // Running offset of the end of the frame bits of the last produced frame. Only accessed by the producer.
+    SIZE_T dataHead;
+
+    // Running offset of the end of the frame bits of the last consumed frame. Only advanced by the consumer.
+    volatile SIZE_T dataTail;
+};
+typedef struct __PutFrameRing* PPutFrameRing;
+
+/**
+ * One of the client-owned workers draining the ingestion rings of the streams. The workers run on
+ * the client put frame thread pool. A stream is affined to the worker at the index of the stream id
+ * modulo the worker count so its frames are packaged in order while different streams are packaged
+ * in parallel.
+ */
+typedef struct __PutFrameWorker PutFrameWorker;
+struct __PutFrameWorker {
+    // The owning client
+    struct __KinesisVideoClient* pKinesisVideoClient;
+
+    // Index of the worker in the client worker array
+    UINT32 index;
+
+    // Lock and condition variable the worker sleeps on
+    MUTEX lock;
+    CVAR wakeup;
+
+    // Whether any of the affined rings has been produced into since the worker last woke up
+    volatile ATOMIC_BOOL pending;
+};
+typedef struct __PutFrameWorker* PPutFrameWorker;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates the ingestion ring for the stream
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ * @UINT32 - IN - number of the slots. Power of two.
+ * @UINT64 - IN - size of the frame bits buffer. 0 to size it from the stream caps.
+ * @PPutFrameRing* - OUT - the newly created ring.
+ *
+ * @return - STATUS - status code of the operation.
+ */
+STATUS createPutFrameRing(PKinesisVideoStream, UINT32, UINT64, PPutFrameRing*);
+
+/**
+ * Frees the ingestion ring discarding the frames which have not been put.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ * @PPutFrameRing* - IN/OUT - the ring to free. Idempotent.
+ *
+ * @return - STATUS - status code of the operation.
+ */
+STATUS freePutFrameRing(PKinesisVideoStream, PPutFrameRing*);
+
+/**
+ * Copies the frame into the ingestion ring of the stream and wakes up the worker.
+ * The ring has a single producer. The call racing another enqueue into the same ring is rejected.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ * @PFrame - IN - the frame to enqueue.
+ *
+ * @return - STATUS_PUT_FRAME_RING_FULL if the ring has no free slot or no buffer space for the frame bits,
+ *           STATUS_PUT_FRAME_RING_CLOSED if the stream has been stopped and STATUS_PUT_FRAME_RING_CONCURRENT_PRODUCER
+ *           if another thread is enqueueing into the ring.
+ */
+STATUS putFrameRingEnqueue(PKinesisVideoStream, PFrame);
+
+/**
+ * Closes the ingestion ring so it rejects the frames. Returns once the frame being published, if any,
+ * is in the ring so the drain following the close puts every frame the producer has been acknowledged for.
+ * No-op for the streams without the ring.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ *
+ * @return - STATUS - status code of the operation.
+ */
+STATUS putFrameRingClose(PKinesisVideoStream);
+
+/**
+ * Puts the frames enqueued into the ingestion ring of the stream. The frames which fail to be put
+ * are reported as dropped. No-op for the streams without the ring.
+ *
+ * Without waiting for the availability the drain stops at the frame the OFFLINE stream has no space for
+ * yet leaving it in the ring.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ * @UINT32 - IN - max number of the frames to put.
+ * @BOOL - IN - whether to wait for the availability in the OFFLINE mode.
+ * @PUINT32 - OUT - OPTIONAL number of the frames taken off the ring.
+ *
+ * @return - STATUS - status code of the operation.
+ */
+STATUS putFrameRingDrain(PKinesisVideoStream, UINT32, BOOL, PUINT32);
+
+/**
+ * Whether the ingestion ring has no frames pending. TRUE for the streams without the ring.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ *
+ * @return - BOOL - TRUE if there are no frames pending.
+ */
+BOOL putFrameRingIsEmpty(PKinesisVideoStream);
+
+/**
+ * Wakes up the put frame worker the stream is affined to. No-op for the streams without the ring.
+ *
+ * @PKinesisVideoStream - IN - the stream object.
+ */
+VOID putFrameWorkerWakeup(PKinesisVideoStream);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__KINESIS_VIDEO_PUT_FRAME_RING_INCLUDE_I__*/
@@ -26,6 +26,7 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
     PStateMachine pStateMachine = NULL;
     UINT32 allocationSize, maxViewItems, i;
     PBYTE pCurPnt = NULL;
+    PStoreArena pStoreArena = NULL;
     BOOL clientLocked = FALSE, clientStreamsListLocked = FALSE;
     BOOL tearDownOnError = TRUE;
     CHAR tempStreamName[MAX_STREAM_NAME_LEN];
@@ -64,11 +65,7 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
     }
 
     // Check if a stream by that name already exists
-    for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
-        if (NULL != pKinesisVideoClient->streams[i]) {
-            CHK(0 != STRCMP(pKinesisVideoClient->streams[i]->streamInfo.name, tempStreamName), STATUS_DUPLICATE_STREAM_NAME);
-        }
-    }
+    CHK_STATUS(streamTableCheckName(pKinesisVideoClient, tempStreamName));
 
     // Space for track info bits
     trackInfoSize = SIZEOF(TrackInfo) * pStreamInfo->streamCaps.trackInfoCount;
@@ -84,21 +81,23 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
     pKinesisVideoStream = (PKinesisVideoStream) MEMCALLOC(1, allocationSize);
     CHK(pKinesisVideoStream != NULL, STATUS_NOT_ENOUGH_MEMORY);
 
-    // Set the stream id first available slot so during the teardown it will clean it up.
-    for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
-        if (NULL == pKinesisVideoClient->streams[i]) {
-            // Found an empty slot
-            pKinesisVideoStream->streamId = i;
-            break;
-        }
-    }
-
     // set the maximum frame size observed to 0
     pKinesisVideoStream->maxFrameSizeSeen = 0;
 
     // Set the back reference
     pKinesisVideoStream->pKinesisVideoClient = pKinesisVideoClient;
 
+    // Store into the arena of the content store with the fewest streams
+    pStoreArena = &pKinesisVideoClient->storeArenas[0];
+    for (i = 1; i < pKinesisVideoClient->storeArenaCount; i++) {
+        if (pKinesisVideoClient->storeArenas[i].streamCount < pStoreArena->streamCount) {
+            pStoreArena = &pKinesisVideoClient->storeArenas[i];
+        }
+    }
+
+    pStoreArena->streamCount++;
+    pKinesisVideoStream->pStoreArena = pStoreArena;
+
     // Set the basic info
     pKinesisVideoStream->base.identifier = KINESIS_VIDEO_OBJECT_IDENTIFIER_STREAM;
     pKinesisVideoStream->base.version = STREAM_CURRENT_VERSION;
@@ -162,6 +161,9 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
     MEMSET(&pKinesisVideoStream->curViewItem, 0x00, SIZEOF(CurrentViewItem));
     pKinesisVideoStream->curViewItem.viewItem.handle = INVALID_ALLOCATION_HANDLE_VALUE;
 
+    // No fragment extent is open
+    pKinesisVideoStream->fragmentExtents.handle = INVALID_ALLOCATION_HANDLE_VALUE;
+
     // Copy the structures in their entirety
     MEMCPY(&pKinesisVideoStream->streamInfo, pStreamInfo, SIZEOF(StreamInfo));
     fixupStreamInfo(&pKinesisVideoStream->streamInfo);
@@ -176,6 +178,10 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
     // Create the stream lock
     pKinesisVideoStream->base.lock = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, TRUE);
 
+    // Create the putFrame lock
+    pKinesisVideoStream->base.putFrameLock =
+        pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, TRUE);
+
     // Create the Ready state condition variable
     pKinesisVideoStream->base.ready = pKinesisVideoClient->clientCallbacks.createConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData);
 
@@ -219,12 +225,21 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
     MEMCPY(pCurPnt, pStreamInfo->streamCaps.trackInfoList, trackInfoSize);
     pKinesisVideoStream->streamInfo.streamCaps.trackInfoList = (PTrackInfo) pCurPnt;
     fixupTrackInfo(pKinesisVideoStream->streamInfo.streamCaps.trackInfoList, pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount);
+    CHK_STATUS(mkvgenBuildTrackIndexMap(pKinesisVideoStream->streamInfo.streamCaps.trackInfoList,
+                                        pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount, &pKinesisVideoStream->trackIndexMap));
 
     pKinesisVideoStream->pFrameOrderCoordinator = NULL;
     if (pKinesisVideoStream->streamInfo.streamCaps.frameOrderingMode != FRAME_ORDER_MODE_PASS_THROUGH) {
         CHK_STATUS(createFrameOrderCoordinator(pKinesisVideoStream, &pKinesisVideoStream->pFrameOrderCoordinator));
     }
 
+    // The frames are handed over to the client worker through the ring in the async putFrame mode
+    pKinesisVideoStream->pPutFrameRing = NULL;
+    if (pKinesisVideoClient->deviceInfo.clientInfo.putFrameRingSize != 0) {
+        CHK_STATUS(createPutFrameRing(pKinesisVideoStream, pKinesisVideoClient->deviceInfo.clientInfo.putFrameRingSize,
+                                      pKinesisVideoClient->deviceInfo.clientInfo.putFrameRingBufferSize, &pKinesisVideoStream->pPutFrameRing));
+    }
+
     // Move pCurPnt to the end of pKinesisVideoStream->streamInfo.streamCaps.trackInfoList
     pCurPnt = (PBYTE) (pKinesisVideoStream->streamInfo.streamCaps.trackInfoList + pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount);
 
@@ -236,6 +251,19 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
                                  TO_CUSTOM_DATA(pKinesisVideoStream), pStreamInfo->streamCaps.viewOverflowPolicy, &pView));
     pKinesisVideoStream->pView = pView;
 
+    // Set up the per-fragment extents. The journal records an allocation per view item so the
+    // persistent content store keeps storing every frame in its own allocation.
+    if (pKinesisVideoStream->streamInfo.streamCaps.fragmentExtentSize != 0) {
+        if (pKinesisVideoClient->deviceInfo.storageInfo.storageType == DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE) {
+            DLOGW("[%s] Fragment extents are not supported with the persistent content store", pKinesisVideoStream->streamInfo.name);
+        } else {
+            CHK_STATUS(hashTableCreate(&pKinesisVideoStream->fragmentExtents.pRefCounts));
+            pKinesisVideoStream->fragmentExtents.pItemOffsets = (PUINT32) MEMCALLOC(maxViewItems, SIZEOF(UINT32));
+            CHK(pKinesisVideoStream->fragmentExtents.pItemOffsets != NULL, STATUS_NOT_ENOUGH_MEMORY);
+            pKinesisVideoStream->fragmentExtents.itemCount = maxViewItems;
+        }
+    }
+
     // Create an MKV generator
     CHK_STATUS(createPackager(pKinesisVideoStream, &pMkvGenerator));
 
@@ -269,10 +297,24 @@ STATUS createStream(PKinesisVideoClient pKinesisVideoClient, PStreamInfo pStream
     // Reset the ACK parser
     CHK_STATUS(resetAckParserState(pKinesisVideoStream));
 
+    // Re-attach the content persisted by the previous run
+    if (pKinesisVideoClient->deviceInfo.storageInfo.storageType == DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE) {
+        CHK_STATUS(createStreamJournal(pKinesisVideoStream, maxViewItems));
+    }
+
+    // The partial laces of the idle producers are put by the timer scheduled at their deadlines
+    if (pKinesisVideoStream->streamInfo.streamCaps.audioLacingDuration != 0) {
+        if (!IS_VALID_TIMER_QUEUE_HANDLE(pKinesisVideoClient->timerQueueHandle)) {
+            CHK_STATUS(timerQueueCreate(&pKinesisVideoClient->timerQueueHandle));
+        }
+
+        CHK_STATUS(createLaceTimers(pKinesisVideoClient));
+    }
+
     // Set the new object in the parent object, set the ID and increment the current count
     // NOTE: Make sure we set the stream in the client object before setting the return value and
     // no tear-down flag is set.
-    pKinesisVideoClient->streams[pKinesisVideoStream->streamId] = pKinesisVideoStream;
+    CHK_STATUS(streamTableInsert(pKinesisVideoClient, pKinesisVideoStream));
     pKinesisVideoClient->streamCount++;
 
     // Assign the created object
@@ -345,11 +387,40 @@ STATUS freeStream(PKinesisVideoStream pKinesisVideoStream)
     // Shutdown the processing
     CHK_STATUS_CONTINUE(shutdownStream(pKinesisVideoStream, FALSE));
 
+    // The stream can no longer be pinned so it's safe to unlink it from the EoFR timer wheel and the lace deadlines
+    CHK_STATUS_CONTINUE(disarmEofrTimer(pKinesisVideoStream));
+    CHK_STATUS_CONTINUE(disarmLaceTimer(pKinesisVideoStream));
+
     // Lock the stream
     pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
 
+    // Release the stream data segments the caller might still hold
+    if (pKinesisVideoStream->segmentsOutstanding) {
+        CHK_STATUS_CONTINUE(releaseStreamDataSegments(pKinesisVideoStream));
+    }
+
+    // Free the frame buffer the encoder might still hold
+    CHK_STATUS_CONTINUE(freeAcquiredFrameBuffer(pKinesisVideoStream));
+
+    // Free the storage of the pending lace
+    SAFE_MEMFREE(pKinesisVideoStream->lacedFrames.pData);
+
+    // Keep the persisted content for the next run
+    freeStreamJournal(pKinesisVideoStream);
+
     // Release the underlying objects
     freeContentView(pKinesisVideoStream->pView);
+
+    // Release the open extent after the view has dropped its items
+    if (pKinesisVideoStream->fragmentExtents.pItemOffsets != NULL) {
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+        CHK_STATUS_CONTINUE(closeFragmentExtent(pKinesisVideoStream));
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    hashTableFree(pKinesisVideoStream->fragmentExtents.pRefCounts);
+    SAFE_MEMFREE(pKinesisVideoStream->fragmentExtents.pItemOffsets);
+
     freeMkvGenerator(pKinesisVideoStream->pMkvGenerator);
     freeStateMachine(pKinesisVideoStream->base.pStateMachine);
 
@@ -371,14 +442,23 @@ STATUS freeStream(PKinesisVideoStream pKinesisVideoStream)
     // Free FrameOrderCoordinator
     freeFrameOrderCoordinator(pKinesisVideoStream, &pKinesisVideoStream->pFrameOrderCoordinator);
 
+    // Free the ingestion ring discarding the frames not put yet. The shutdown keeps the workers out.
+    freePutFrameRing(pKinesisVideoStream, &pKinesisVideoStream->pPutFrameRing);
+
     pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
 
     // Lock the client to update the streams
     pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
 
-    // Remove from the parent object by setting the ref to NULL
-    pKinesisVideoClient->streams[pKinesisVideoStream->streamId] = NULL;
-    pKinesisVideoClient->streamCount--;
+    // Remove from the parent object invalidating the handles
+    if (pKinesisVideoClient->streamTable.slots[pKinesisVideoStream->streamId].pKinesisVideoStream == pKinesisVideoStream) {
+        streamTableRemove(pKinesisVideoClient, pKinesisVideoStream);
+        pKinesisVideoClient->streamCount--;
+    }
+
+    if (pKinesisVideoStream->pStoreArena != NULL) {
+        pKinesisVideoStream->pStoreArena->streamCount--;
+    }
 
     if (IS_VALID_CVAR_VALUE(pKinesisVideoStream->bufferAvailabilityCondition)) {
         pKinesisVideoClient->clientCallbacks.freeConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData,
@@ -406,6 +486,10 @@ STATUS freeStream(PKinesisVideoStream pKinesisVideoStream)
     pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
     pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
 
+    if (IS_VALID_MUTEX_VALUE(pKinesisVideoStream->base.putFrameLock)) {
+        pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+    }
+
     if (IS_VALID_SEMAPHORE_HANDLE(pKinesisVideoStream->base.shutdownSemaphore)) {
         semaphoreFree(&pKinesisVideoStream->base.shutdownSemaphore);
     }
@@ -462,19 +546,36 @@ STATUS stopStream(PKinesisVideoStream pKinesisVideoStream)
     PKinesisVideoClient pKinesisVideoClient;
     UINT64 duration, viewByteSize;
     UINT32 i, sessionCount;
-    BOOL streamLocked = FALSE, clientLocked = FALSE, streamsListLock = FALSE, notSent = FALSE;
+    BOOL streamLocked = FALSE, storeLocked = FALSE, streamsListLock = FALSE, notSent = FALSE;
     PUploadHandleInfo pUploadHandleInfo = NULL;
     UINT64 item;
 
     CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
     pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
 
+    // Stop accepting the async frames and put the ones already handed over ahead of the flush
+    if (pKinesisVideoStream->pPutFrameRing != NULL) {
+        CHK_STATUS(putFrameRingClose(pKinesisVideoStream));
+        retStatus = putFrameRingDrain(pKinesisVideoStream, MAX_UINT32, TRUE, NULL);
+        if (STATUS_FAILED(retStatus)) {
+            DLOGE("[%s] putFrameRingDrain failed with 0x%08x", pKinesisVideoStream->streamInfo.name, retStatus);
+            retStatus = STATUS_SUCCESS;
+        }
+    }
+
     retStatus = frameOrderCoordinatorFlush(pKinesisVideoStream);
     if (STATUS_FAILED(retStatus)) {
         DLOGE("[%s] frameOrderCoordinatorFlush failed with 0x%08x", pKinesisVideoStream->streamInfo.name, retStatus);
         retStatus = STATUS_SUCCESS;
     }
 
+    // Put the pending lace regardless of its age
+    retStatus = flushExpiredLacedFrames(pKinesisVideoStream, MAX_UINT64);
+    if (STATUS_FAILED(retStatus)) {
+        DLOGE("[%s] flushLacedFrames failed with 0x%08x", pKinesisVideoStream->streamInfo.name, retStatus);
+        retStatus = STATUS_SUCCESS;
+    }
+
     // Lock the stream
     pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
     streamLocked = TRUE;
@@ -491,9 +592,9 @@ STATUS stopStream(PKinesisVideoStream pKinesisVideoStream)
                                                                        pKinesisVideoStream->bufferAvailabilityCondition);
     }
 
-    // Lock the client
-    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = TRUE;
+    // Lock the store arena
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
 
     // Get the duration from current point to the head
     // Get the size of the allocation from current point to the head
@@ -540,9 +641,9 @@ STATUS stopStream(PKinesisVideoStream pKinesisVideoStream)
         CHK_STATUS(notifyStreamClosed(pKinesisVideoStream, pUploadHandleInfo == NULL ? INVALID_UPLOAD_HANDLE_VALUE : pUploadHandleInfo->handle));
     }
 
-    // Unlock the client as we no longer need it locked
-    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = FALSE;
+    // Unlock the store arena as we no longer need it locked
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = FALSE;
 
     // Unlock the stream (even though it will be unlocked in the cleanup)
     pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
@@ -550,8 +651,8 @@ STATUS stopStream(PKinesisVideoStream pKinesisVideoStream)
 
 CleanUp:
 
-    if (clientLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
     }
 
     if (streamLocked) {
@@ -730,6 +831,10 @@ STATUS logStreamMetric(PKinesisVideoStream pKinesisVideoStream)
     // V3 stream information
     DLOGD("\tAPI Call Retry Count : %lu", streamMetrics.streamApiCallRetryCount);
 
+    // V4 stream information
+    DLOGD("\tPut frame ring high-water marks: %" PRIu64 " ", streamMetrics.putFrameRingHighWaterMarks);
+    DLOGD("\tPut frame ring full rejections: %" PRIu64 " ", streamMetrics.putFrameRingFullRejections);
+
     // V1 client information
     DLOGD("\tTotal elementary frame rate (fps): %lf ", clientMetrics.totalElementaryFrameRate);
 
@@ -744,22 +849,140 @@ CleanUp:
  * Puts a frame into the stream
  */
 STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
+{
+    return putFrameInternal(pKinesisVideoStream, pFrame, NULL, NULL);
+}
+
+/**
+ * Puts a batch of frames into the stream. The token expiration, the pressure checks, the metrics logging and
+ * the data available notification are done once per batch rather than per frame.
+ *
+ * The stream and the store arena locks are acquired once and held for the whole batch with the frames re-entering
+ * the recursive locks. The streams sharing the arena are not packaged in parallel with the batch as a result.
+ * The OFFLINE mode wait for the availability releases a single hold of the stream lock so the frames of an OFFLINE
+ * stream take the locks on their own for the data to be consumed while the batch waits.
+ *
+ * The batch is processed to the end and the first failure is returned with the per-frame statuses optionally reported.
+ */
+STATUS putFrames(PKinesisVideoStream pKinesisVideoStream, PFrame pFrames, UINT32 frameCount, PSTATUS pFrameStatuses)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PutFrameBatch batch;
+    BOOL streamLocked = FALSE, storeLocked = FALSE;
+    UINT32 i = 0;
+
+    CHK(pKinesisVideoStream != NULL && pFrames != NULL, STATUS_NULL_ARG);
+    CHK(frameCount != 0, STATUS_INVALID_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    // Check if the stream has been stopped
+    CHK(!pKinesisVideoStream->streamStopped, STATUS_STREAM_HAS_BEEN_STOPPED);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = TRUE;
+
+    CHK_STATUS(checkStreamingTokenExpiration(pKinesisVideoStream));
+
+    if (IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
+        // The frames lock the stream themselves
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+        streamLocked = FALSE;
+    } else {
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+        storeLocked = TRUE;
+    }
+
+    MEMSET(&batch, 0x00, SIZEOF(PutFrameBatch));
+    batch.currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+
+    for (i = 0; i < frameCount; i++) {
+        status = putFrameInternal(pKinesisVideoStream, &pFrames[i], NULL, &batch);
+
+        if (pFrameStatuses != NULL) {
+            pFrameStatuses[i] = status;
+        }
+
+        if (STATUS_FAILED(status) && STATUS_SUCCEEDED(retStatus)) {
+            retStatus = status;
+        }
+    }
+
+    // Nothing else to do if none of the frames made it into the view
+    CHK(batch.frameCount != 0, retStatus);
+
+    if (!streamLocked) {
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+        streamLocked = TRUE;
+
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+        storeLocked = TRUE;
+    }
+
+    // Evaluate the pressures and notify about the data once for the whole batch
+    CHK_STATUS(checkStreamStoragePressures(pKinesisVideoStream));
+    CHK_STATUS(checkStreamLatencyPressure(pKinesisVideoStream));
+    CHK_STATUS(notifyStreamDataAvailable(pKinesisVideoStream));
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = FALSE;
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = FALSE;
+
+    // Log the metrics if any of the frames started a fragment. The locks can't be held while logging.
+    if (batch.fragmentStarted && pKinesisVideoClient->deviceInfo.clientInfo.logMetric) {
+        if (batch.currentTime >= pKinesisVideoStream->diagnostics.nextLoggingTime && STATUS_FAILED(status = logStreamMetric(pKinesisVideoStream))) {
+            DLOGW("[%s] Failed to log stream metric with error 0x%08x", pKinesisVideoStream->streamInfo.name, status);
+        }
+
+        // Update the next log time
+        pKinesisVideoStream->diagnostics.nextLoggingTime = batch.currentTime + pKinesisVideoClient->deviceInfo.clientInfo.metricLoggingPeriod;
+    }
+
+CleanUp:
+
+    // Report the failure for the frames which have not been processed
+    if (STATUS_FAILED(retStatus) && pFrameStatuses != NULL) {
+        for (; i < frameCount; i++) {
+            pFrameStatuses[i] = retStatus;
+        }
+    }
+
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Puts a frame into the stream. If the acquired frame buffer is specified then the frame payload is already
+ * in the buffer and only the MKV bits are packaged in front of it. The buffer is owned by the call and is freed on error.
+ * If the batch is specified then the per-frame housekeeping is left to the batch.
+ */
+STATUS putFrameInternal(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame, PAcquiredFrameBuffer pFrameBuffer, PPutFrameBatch pBatch)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PKinesisVideoClient pKinesisVideoClient = NULL;
     ALLOCATION_HANDLE allocHandle = INVALID_ALLOCATION_HANDLE_VALUE;
-    UINT64 remainingSize = 0, remainingDuration = 0, thresholdPercent = 0, duration = 0, viewByteSize = 0, allocSize = 0;
+    UINT64 allocSize = 0;
     PBYTE pAlloc = NULL;
-    UINT32 trackIndex, packagedSize = 0, packagedMetadataSize = 0, overallSize = 0, itemFlags = ITEM_FLAG_NONE;
-    BOOL streamLocked = FALSE, clientLocked = FALSE, freeOnError = TRUE;
+    UINT32 trackIndex, packagedSize = 0, packagedMetadataSize = 0, overallSize = 0, headerSize, itemFlags = ITEM_FLAG_NONE, frameCount = 1,
+           extentOffset = 0;
+    BOOL streamLocked = FALSE, storeLocked = FALSE, freeOnError = TRUE, lacedFlush, extentReserved = FALSE;
     EncodedFrameInfo encodedFrameInfo;
     MKV_STREAM_STATE generatorState = MKV_STATE_START_BLOCK;
     UINT64 currentTime = INVALID_TIMESTAMP_VALUE;
     DOUBLE frameRate, deltaInSeconds;
     PViewItem pViewItem = NULL;
-    PUploadHandleInfo pUploadHandleInfo;
-    UINT64 windowDuration, currentDuration;
     PTrackInfo pTrackInfo = NULL;
     PSerializedMetadata pSerializedMetadata = NULL;
     PFrameOrderCoordinator pFrameOrderCoordinator;
@@ -768,10 +991,20 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
     pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
     pFrameOrderCoordinator = pKinesisVideoStream->pFrameOrderCoordinator;
 
+    if (pFrameBuffer != NULL) {
+        // Take the ownership of the acquired storage which is still mapped
+        allocHandle = pFrameBuffer->handle;
+        pAlloc = pFrameBuffer->pAllocation;
+        allocSize = pFrameBuffer->size;
+
+        // EoFr has no payload to be produced in place
+        CHK(!CHECK_FRAME_FLAG_END_OF_FRAGMENT(pFrame->flags), STATUS_INVALID_ARG);
+    }
+
     if (!CHECK_FRAME_FLAG_END_OF_FRAGMENT(pFrame->flags)) {
         // Lookup the track that pFrame belongs to
-        CHK_STATUS(mkvgenGetTrackInfo(pKinesisVideoStream->streamInfo.streamCaps.trackInfoList,
-                                      pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount, pFrame->trackId, &pTrackInfo, &trackIndex));
+        CHK_STATUS(mkvgenGetTrackInfoFromMap(&pKinesisVideoStream->trackIndexMap, pKinesisVideoStream->streamInfo.streamCaps.trackInfoList,
+                                             pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount, pFrame->trackId, &pTrackInfo, &trackIndex));
     }
 
     // Check if the stream has been stopped
@@ -783,8 +1016,25 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
 
     fixupFrame(pFrame);
 
-    // Set the last PutFrame time to current time
-    currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+    // The pending lace is put as its first frame
+    lacedFlush = pFrame == pKinesisVideoStream->lacedFrames.frames;
+    if (lacedFlush) {
+        frameCount = pKinesisVideoStream->lacedFrames.frameCount;
+    } else if (pKinesisVideoStream->lacedFrames.frameCount != 0 && !canLaceFrame(pKinesisVideoStream, pFrame, pTrackInfo, pFrameBuffer)) {
+        // Put the pending lace ahead of the frame which can't be laced with it.
+        // The lace is put with the stream unlocked as the put might wait for the availability.
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+        streamLocked = FALSE;
+
+        CHK_STATUS(flushLacedFrames(pKinesisVideoStream, pBatch));
+
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+        streamLocked = TRUE;
+    }
+
+    // Set the last PutFrame time to current time. The batch samples the time once for all of its frames.
+    currentTime = pBatch != NULL ? pBatch->currentTime
+                                 : pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
 
     if (pKinesisVideoStream->eofrFrame) {
         // After EOFR we again need to skip non-key frames before starting up new fragment
@@ -802,11 +1052,17 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
     // If we have the streaming token and it's in the grace period
     // then we need to go back to the get streaming end point and
     // get the streaming end point and the new streaming token.
-    CHK_STATUS(checkStreamingTokenExpiration(pKinesisVideoStream));
+    // NOTE: The batch checks the expiration once before putting the frames.
+    if (pBatch == NULL) {
+        CHK_STATUS(checkStreamingTokenExpiration(pKinesisVideoStream));
+    }
 
     // Check if we have passed the delay for resetting generator.
     if (IS_VALID_TIMESTAMP(pKinesisVideoStream->resetGeneratorTime)) {
-        currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+        if (pBatch == NULL) {
+            currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+        }
+
         if (currentTime >= pKinesisVideoStream->resetGeneratorTime) {
             pKinesisVideoStream->resetGeneratorTime = INVALID_TIMESTAMP_VALUE;
             pKinesisVideoStream->resetGeneratorOnKeyFrame = TRUE;
@@ -836,15 +1092,37 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
         }
     }
 
+    // Accumulate the audio frame to be laced with the following ones
+    if (!lacedFlush && canLaceFrame(pKinesisVideoStream, pFrame, pTrackInfo, pFrameBuffer)) {
+        CHK_STATUS(appendLacedFrame(pKinesisVideoStream, pFrame));
+        if (pKinesisVideoStream->lacedFrames.frameCount == 1) {
+            pKinesisVideoStream->lacedFrames.startTime = currentTime;
+            CHK_STATUS(armLaceTimer(pKinesisVideoStream, currentTime + pKinesisVideoStream->streamInfo.streamCaps.audioLacingDuration));
+        }
+
+        pKinesisVideoStream->lastPutFrameTimestamp = currentTime;
+        CHK_STATUS(armEofrTimer(pKinesisVideoStream, currentTime + INTERMITTENT_PRODUCER_MAX_TIMEOUT));
+
+        // Put the lace once it's full or spans the lacing window
+        if (pKinesisVideoStream->lacedFrames.frameCount == MAX_LACED_FRAME_COUNT ||
+            pFrame->presentationTs + pFrame->duration >=
+                pKinesisVideoStream->lacedFrames.frames[0].presentationTs + pKinesisVideoStream->streamInfo.streamCaps.audioLacingDuration) {
+            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+            streamLocked = FALSE;
+
+            CHK_STATUS(flushLacedFrames(pKinesisVideoStream, pBatch));
+        }
+
+        CHK(FALSE, retStatus);
+    }
+
     // Package and store the frame.
     // If the frame is a special End-of-Fragment indicator
     // then we need to package the not yet sent metadata with EoFr metadata
     // and indicate the new cluster boundary
 
-    // Currently, we are storing every frame in a separate allocation
-    // We will need to optimize for storing perhaps an entire cluster but
-    // Not right now as we need to deal with mapping/unmapping and allocating
-    // the cluster storage up-front which might be more hassle than needed.
+    // Every frame is stored in a separate allocation unless the stream appends
+    // the frames of a fragment into a shared extent.
 
     if (CHECK_FRAME_FLAG_END_OF_FRAGMENT(pFrame->flags)) {
         // We will append the EoFr tag and package the tags
@@ -856,7 +1134,8 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
         CHK_STATUS(packageStreamMetadata(pKinesisVideoStream, MKV_STATE_START_CLUSTER, TRUE, NULL, &packagedSize));
     } else {
         // Get the size of the packaged frame
-        CHK_STATUS(mkvgenPackageFrame(pKinesisVideoStream->pMkvGenerator, pFrame, pTrackInfo, NULL, &packagedSize, &encodedFrameInfo));
+        CHK_STATUS(
+            mkvgenPackageLacedFrames(pKinesisVideoStream->pMkvGenerator, pFrame, frameCount, pTrackInfo, NULL, &packagedSize, &encodedFrameInfo));
 
         // Preserve the current stream state as it might change after we apply the metadata
         generatorState = encodedFrameInfo.streamState;
@@ -875,23 +1154,60 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
 
     pKinesisVideoStream->maxFrameSizeSeen = MAX(pKinesisVideoStream->maxFrameSizeSeen, overallSize);
 
-    // Might need to block on the availability in the OFFLINE mode
-    CHK_STATUS(handleAvailability(pKinesisVideoStream, overallSize, &allocHandle));
+    if (pFrameBuffer == NULL && pKinesisVideoStream->fragmentExtents.pItemOffsets != NULL) {
+        // Append to the extent of the fragment. A new extent is started on the fragment boundary.
+        CHK_STATUS(reserveFragmentExtent(pKinesisVideoStream, overallSize, generatorState != MKV_STATE_START_BLOCK, &allocHandle, &extentOffset));
+        SET_ITEM_FRAGMENT_EXTENT(itemFlags);
+        extentReserved = IS_VALID_ALLOCATION_HANDLE(allocHandle);
 
-    if (IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
-        // offline streaming mode can block so we need to reset the currentTime just in case
-        currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+        // The extent is shared and is released through the view items
+        freeOnError = FALSE;
+    } else if (pFrameBuffer == NULL) {
+        // Might need to block on the availability in the OFFLINE mode
+        CHK_STATUS(handleAvailability(pKinesisVideoStream, overallSize, &allocHandle));
+
+        if (IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
+            // offline streaming mode can block so we need to reset the currentTime just in case
+            currentTime = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
+        }
     }
 
-    // Lock the client
-    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = TRUE;
+    // Lock the store arena
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
 
     // Ensure we have space and if not then bail
     CHK(IS_VALID_ALLOCATION_HANDLE(allocHandle), STATUS_STORE_OUT_OF_MEMORY);
 
-    // Map the storage
-    CHK_STATUS(heapMap(pKinesisVideoClient->pHeap, allocHandle, (PVOID*) &pAlloc, &allocSize));
+    if (pFrameBuffer == NULL) {
+        // Map the storage and skip to the reserved slice of the extent if any
+        CHK_STATUS(heapMap(pKinesisVideoStream->pStoreArena->pHeap, allocHandle, (PVOID*) &pAlloc, &allocSize));
+        CHK(allocSize >= extentOffset, STATUS_INVALID_ALLOCATION_SIZE);
+        pAlloc += extentOffset;
+        allocSize -= extentOffset;
+    } else {
+        // The header size might differ from the reserved one if the stream state has changed since the buffer
+        // has been acquired, for example, when other frames have been put or metadata has been added.
+        // In this unlikely case the payload needs to be relocated.
+        headerSize = overallSize - pFrame->size;
+        if (headerSize != pFrameBuffer->headerSize) {
+            if (overallSize > allocSize) {
+                CHK_STATUS(heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pAlloc));
+                pAlloc = NULL;
+                CHK_STATUS(heapSetAllocSize(pKinesisVideoStream->pStoreArena->pHeap, &allocHandle, overallSize));
+                CHK_STATUS(heapMap(pKinesisVideoStream->pStoreArena->pHeap, allocHandle, (PVOID*) &pAlloc, &allocSize));
+            }
+
+            MEMMOVE(pAlloc + headerSize, pAlloc + pFrameBuffer->headerSize, pFrame->size);
+        }
+
+        pFrame->frameData = pAlloc + headerSize;
+    }
+
+    // Package with the store arena unlocked so the streams sharing the arena are packaged in parallel.
+    // The mapped storage is only reachable through the frame until it's added to the view.
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = FALSE;
 
     // Validate we had allocated enough storage just in case
     CHK(overallSize <= allocSize, STATUS_ALLOCATION_SIZE_SMALLER_THAN_REQUESTED);
@@ -918,60 +1234,40 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
 
         // Set the EoFr flag so we won't append not-sent metadata/EOS on StreamStop
         pKinesisVideoStream->eofrFrame = TRUE;
+    } else if (pFrameBuffer != NULL) {
+        // Package the MKV bits in front of the payload leaving the room for the metadata after the MKV header.
+        // The payload is already in place and will not be copied.
+        packagedSize = (UINT32) allocSize;
+        CHK_STATUS(mkvgenPackageFramesWithGap(pKinesisVideoStream->pMkvGenerator, pFrame, 1, pTrackInfo, packagedMetadataSize, pAlloc,
+                                              &packagedSize, &encodedFrameInfo));
     } else {
-        // Actually package the bits in the storage
-        CHK_STATUS(mkvgenPackageFrame(pKinesisVideoStream->pMkvGenerator, pFrame, pTrackInfo, pAlloc, &packagedSize, &encodedFrameInfo));
-
-        // Package the metadata if specified
-        if (packagedMetadataSize != 0) {
-            // Move the packaged bits out first to make room for the metadata
-            // NOTE: need to use MEMMOVE due to the overlapping ranges
-            MEMMOVE(pAlloc + encodedFrameInfo.dataOffset + packagedMetadataSize, pAlloc + encodedFrameInfo.dataOffset,
-                    packagedSize - encodedFrameInfo.dataOffset);
-
-            // Metadata will be packaged after the MKV header but before the cluster
-            CHK_STATUS(packageStreamMetadata(pKinesisVideoStream, MKV_STATE_START_CLUSTER, FALSE, pAlloc + encodedFrameInfo.dataOffset,
-                                             &packagedMetadataSize));
-        }
+        // Actually package the bits in the storage leaving the room for the metadata after the MKV header
+        packagedSize += packagedMetadataSize;
+        CHK_STATUS(mkvgenPackageFramesWithGap(pKinesisVideoStream->pMkvGenerator, pFrame, frameCount, pTrackInfo, packagedMetadataSize, pAlloc,
+                                              &packagedSize, &encodedFrameInfo));
     }
 
-    // Unmap the storage for the frame
-    CHK_STATUS(heapUnmap(pKinesisVideoClient->pHeap, ((PVOID) pAlloc)));
-
-    // Check for storage pressures. No need for offline mode as the media pipeline will be blocked when there
-    // is not enough storage
-    if (!IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
-        remainingSize = pKinesisVideoClient->pHeap->heapLimit - pKinesisVideoClient->pHeap->heapSize;
-        thresholdPercent = (UINT32) (((DOUBLE) remainingSize / pKinesisVideoClient->pHeap->heapLimit) * 100);
-
-        if (thresholdPercent <= STORAGE_PRESSURE_NOTIFICATION_THRESHOLD) {
-            pKinesisVideoStream->diagnostics.storagePressures++;
+    // Metadata will be packaged into the gap after the MKV header but before the cluster
+    if (packagedMetadataSize != 0) {
+        CHK_STATUS(
+            packageStreamMetadata(pKinesisVideoStream, MKV_STATE_START_CLUSTER, FALSE, pAlloc + encodedFrameInfo.dataOffset, &packagedMetadataSize));
+    }
 
-            if (pKinesisVideoClient->clientCallbacks.storageOverflowPressureFn != NULL) {
-                // Notify the client app about buffer pressure
-                CHK_STATUS(
-                    pKinesisVideoClient->clientCallbacks.storageOverflowPressureFn(pKinesisVideoClient->clientCallbacks.customData, remainingSize));
-            }
-        }
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
 
-        // No need to report buffer duration overflow in offline since the putFrame thread will be blocked.
-        // Only report buffer duration overflow if retention is non-zero, since if retention is zero, there will be no
-        // persisted ack and buffer will drop off tail all the time.
-        if (pKinesisVideoStream->streamInfo.retention != RETENTION_PERIOD_SENTINEL &&
-            pKinesisVideoClient->clientCallbacks.bufferDurationOverflowPressureFn != NULL) {
-            CHK_STATUS(contentViewGetWindowDuration(pKinesisVideoStream->pView, &currentDuration, &windowDuration));
+    // Unmap the storage for the frame
+    CHK_STATUS(heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, ((PVOID) (pAlloc - extentOffset))));
+    pAlloc = NULL;
 
-            // Check for buffer duration pressure. Note that streamCaps.bufferDuration will never be 0.
-            remainingDuration = pKinesisVideoStream->streamInfo.streamCaps.bufferDuration - windowDuration;
-            thresholdPercent = (UINT32) (((DOUBLE) remainingDuration / pKinesisVideoStream->streamInfo.streamCaps.bufferDuration) * 100);
-            if (thresholdPercent <= BUFFER_DURATION_PRESSURE_NOTIFICATION_THRESHOLD) {
-                pKinesisVideoStream->diagnostics.bufferPressures++;
+    if (pFrameBuffer != NULL) {
+        // Return the unused part of the acquired buffer to the content store
+        CHK_STATUS(heapSetAllocSize(pKinesisVideoStream->pStoreArena->pHeap, &allocHandle, overallSize));
+    }
 
-                // Notify the client app about buffer pressure
-                CHK_STATUS(pKinesisVideoClient->clientCallbacks.bufferDurationOverflowPressureFn(
-                    pKinesisVideoClient->clientCallbacks.customData, TO_STREAM_HANDLE(pKinesisVideoStream), remainingDuration));
-            }
-        }
+    // Check for storage pressures. The batch evaluates the pressures once after the frames have been put.
+    if (pBatch == NULL) {
+        CHK_STATUS(checkStreamStoragePressures(pKinesisVideoStream));
     }
 
     // Generate the view flags
@@ -990,15 +1286,19 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
             break;
     }
 
-    if (CHECK_ITEM_FRAGMENT_START(itemFlags) && pKinesisVideoClient->deviceInfo.clientInfo.logMetric) {
+    if (CHECK_ITEM_FRAGMENT_START(itemFlags) && pBatch != NULL) {
+        // The batch logs the metrics once the locks are released
+        pBatch->fragmentStarted = TRUE;
+    } else if (CHECK_ITEM_FRAGMENT_START(itemFlags) && pKinesisVideoClient->deviceInfo.clientInfo.logMetric) {
         currentTime = IS_VALID_TIMESTAMP(currentTime)
             ? currentTime
             : pKinesisVideoClient->clientCallbacks.getCurrentTimeFn(pKinesisVideoClient->clientCallbacks.customData);
 
         if (currentTime >= pKinesisVideoStream->diagnostics.nextLoggingTime) {
-            // unlock the client
-            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-            clientLocked = FALSE;
+            // unlock the store arena
+            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                               pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = FALSE;
 
             // unlock the stream
             pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
@@ -1022,9 +1322,9 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
             pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
             streamLocked = TRUE;
 
-            // lock the client
-            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-            clientLocked = TRUE;
+            // lock the store arena
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = TRUE;
         }
 
         // Update the next log time
@@ -1048,40 +1348,30 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
     // From now on we don't need to free the allocation as it's in the view already and will be collected
     freeOnError = FALSE;
 
+    CHK_STATUS(contentViewGetHead(pKinesisVideoStream->pView, &pViewItem));
+    journalViewItem(pKinesisVideoStream->pJournal, pViewItem);
+
+    if (extentReserved) {
+        // The item references its slice of the extent
+        pKinesisVideoStream->fragmentExtents.pItemOffsets[pViewItem->index % pKinesisVideoStream->fragmentExtents.itemCount] = extentOffset;
+        if (!IS_VALID_VIEW_INDEX(pKinesisVideoStream->fragmentExtents.firstIndex)) {
+            pKinesisVideoStream->fragmentExtents.firstIndex = pViewItem->index;
+        }
+
+        extentReserved = FALSE;
+    }
+
     if (CHECK_ITEM_STREAM_START(itemFlags)) {
         // Store the stream start timestamp for ACK timecode adjustment for relative cluster timecode streams
         pKinesisVideoStream->newSessionTimestamp = encodedFrameInfo.streamStartTs;
-        CHK_STATUS(contentViewGetHead(pKinesisVideoStream->pView, &pViewItem));
         pKinesisVideoStream->newSessionIndex = pViewItem->index;
     }
 
-    // We need to check for the latency pressure. If the view head is ahead of the current
-    // for more than the specified max latency then we need to call the optional user callback.
-    // NOTE: A special sentinel value is used to determine whether the latency is specified.
-    if (pKinesisVideoStream->streamInfo.streamCaps.maxLatency != STREAM_LATENCY_PRESSURE_CHECK_SENTINEL &&
-        pKinesisVideoClient->clientCallbacks.streamLatencyPressureFn != NULL) {
-        // Get the window duration from the view
-        CHK_STATUS(contentViewGetWindowDuration(pKinesisVideoStream->pView, &duration, NULL));
-
-        // Check for the breach and invoke the user provided callback
-        if (duration > pKinesisVideoStream->streamInfo.streamCaps.maxLatency) {
-            pKinesisVideoStream->diagnostics.latencyPressures++;
-
-            CHK_STATUS(pKinesisVideoClient->clientCallbacks.streamLatencyPressureFn(pKinesisVideoClient->clientCallbacks.customData,
-                                                                                    TO_STREAM_HANDLE(pKinesisVideoStream), duration));
-        }
-    }
-
-    // Notify about data is available
-    pUploadHandleInfo = getStreamUploadInfoWithState(pKinesisVideoStream, UPLOAD_HANDLE_STATE_READY | UPLOAD_HANDLE_STATE_STREAMING);
-    if (NULL != pUploadHandleInfo && IS_VALID_UPLOAD_HANDLE(pUploadHandleInfo->handle)) {
-        // Get the duration and the size
-        CHK_STATUS(getAvailableViewSize(pKinesisVideoStream, &duration, &viewByteSize));
-
-        // Call the notification callback
-        CHK_STATUS(pKinesisVideoClient->clientCallbacks.streamDataAvailableFn(
-            pKinesisVideoClient->clientCallbacks.customData, TO_STREAM_HANDLE(pKinesisVideoStream), pKinesisVideoStream->streamInfo.name,
-            pUploadHandleInfo->handle, duration, viewByteSize));
+    if (pBatch == NULL) {
+        CHK_STATUS(checkStreamLatencyPressure(pKinesisVideoStream));
+        CHK_STATUS(notifyStreamDataAvailable(pKinesisVideoStream));
+    } else {
+        pBatch->frameCount++;
     }
 
     // Recalculate frame rate if enabled
@@ -1123,9 +1413,14 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
     } else {
         pKinesisVideoStream->lastPutFrameTimestamp = currentTime;
     }
-    // Unlock the client as we no longer need it locked
-    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = FALSE;
+    // Unlock the store arena as we no longer need it locked
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = FALSE;
+
+    // Arm the automatic EoFR deadline unless the stream is armed already. The expired deadline is re-armed lazily.
+    if (!pKinesisVideoStream->eofrFrame) {
+        CHK_STATUS(armEofrTimer(pKinesisVideoStream, currentTime + INTERMITTENT_PRODUCER_MAX_TIMEOUT));
+    }
 
     // Unlock the stream (even though it will be unlocked in  cleanup)
     pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
@@ -1133,20 +1428,43 @@ STATUS putFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
 
 CleanUp:
 
-    // We need to see whether we need to remove the allocation on error. Otherwise, we will leak
-    if (STATUS_FAILED(retStatus) && IS_VALID_ALLOCATION_HANDLE(allocHandle) && freeOnError) {
-        // Lock the client if it's not locked
-        if (!clientLocked) {
-            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-            clientLocked = TRUE;
+    // Return the reserved slice to the extent if the item hasn't been added to the view
+    if (extentReserved) {
+        if (!storeLocked) {
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = TRUE;
+        }
+
+        if (pAlloc != NULL) {
+            heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) (pAlloc - extentOffset));
+        }
+
+        if (pKinesisVideoStream->fragmentExtents.handle == allocHandle && pKinesisVideoStream->fragmentExtents.used == extentOffset + overallSize) {
+            pKinesisVideoStream->fragmentExtents.used = extentOffset;
+        }
+
+        releaseFragmentExtent(pKinesisVideoStream, allocHandle);
+    }
+
+    // We need to see whether we need to remove the allocation on error. Otherwise, we will leak.
+    // NOTE: The acquired frame buffer needs to be freed when the frame is skipped as well.
+    if ((STATUS_FAILED(retStatus) || pFrameBuffer != NULL) && IS_VALID_ALLOCATION_HANDLE(allocHandle) && freeOnError) {
+        // Lock the store arena if it's not locked
+        if (!storeLocked) {
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = TRUE;
+        }
+
+        if (pAlloc != NULL) {
+            heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pAlloc);
         }
 
         // Free the actual allocation as we will leak otherwise.
-        heapFree(pKinesisVideoClient->pHeap, allocHandle);
+        heapFree(pKinesisVideoStream->pStoreArena->pHeap, allocHandle);
     }
 
-    if (clientLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
     }
 
     if (streamLocked) {
@@ -1158,23 +1476,717 @@ CleanUp:
 }
 
 /**
- * Fills the caller buffer with the stream data
+ * Whether the frame can be appended to the pending lace. Only the audio frames put by copy are laced
+ * and the frame has to follow the frames of the same track within the lacing window.
+ * IMPORTANT: The stream lock should be held
  */
-STATUS getStreamData(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uploadHandle, PBYTE pBuffer, UINT32 bufferSize, PUINT32 pFillSize)
+BOOL canLaceFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame, PTrackInfo pTrackInfo, PAcquiredFrameBuffer pFrameBuffer)
 {
-    ENTERS();
-    STATUS retStatus = STATUS_SUCCESS, stalenessCheckStatus = STATUS_SUCCESS;
+    PLacedFrames pLacedFrames = &pKinesisVideoStream->lacedFrames;
+    PFrame pFirstFrame = &pLacedFrames->frames[0];
+
+    if (pKinesisVideoStream->streamInfo.streamCaps.audioLacingDuration == 0 || pFrameBuffer != NULL || pTrackInfo == NULL ||
+        pTrackInfo->trackType != MKV_TRACK_INFO_TYPE_AUDIO || CHECK_FRAME_FLAG_END_OF_FRAGMENT(pFrame->flags)) {
+        return FALSE;
+    }
+
+    if (pLacedFrames->frameCount == 0) {
+        return TRUE;
+    }
+
+    // The key frame starts a new fragment with the key frame fragmentation so it can't be laced behind other frames
+    if (CHECK_FRAME_FLAG_KEY_FRAME(pFrame->flags) && pKinesisVideoStream->streamInfo.streamCaps.keyFrameFragmentation) {
+        return FALSE;
+    }
+
+    return pLacedFrames->frameCount < MAX_LACED_FRAME_COUNT && pFrame->trackId == pFirstFrame->trackId &&
+        pFrame->presentationTs >= pLacedFrames->frames[pLacedFrames->frameCount - 1].presentationTs &&
+        pFrame->presentationTs < pFirstFrame->presentationTs + pKinesisVideoStream->streamInfo.streamCaps.audioLacingDuration;
+}
+
+/**
+ * Copies the frame into the pending lace.
+ * IMPORTANT: The stream lock should be held
+ */
+STATUS appendLacedFrame(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PLacedFrames pLacedFrames;
+    PBYTE pData;
+    UINT32 allocationSize;
+
+    CHK(pKinesisVideoStream != NULL && pFrame != NULL, STATUS_NULL_ARG);
+    CHK(pFrame->size != 0 && pFrame->frameData != NULL, STATUS_MKV_INVALID_FRAME_DATA);
+    pLacedFrames = &pKinesisVideoStream->lacedFrames;
+    CHK(pLacedFrames->frameCount < MAX_LACED_FRAME_COUNT, STATUS_INTERNAL_ERROR);
+
+    // Grow the data buffer to fit the frame. The buffer is kept for the following laces.
+    if (pLacedFrames->dataSize + pFrame->size > pLacedFrames->dataAllocationSize) {
+        allocationSize = MAX(pLacedFrames->dataSize + pFrame->size, 2 * pLacedFrames->dataAllocationSize);
+        CHK(NULL != (pData = (PBYTE) MEMREALLOC(pLacedFrames->pData, allocationSize)), STATUS_NOT_ENOUGH_MEMORY);
+        pLacedFrames->pData = pData;
+        pLacedFrames->dataAllocationSize = allocationSize;
+    }
+
+    MEMCPY(pLacedFrames->pData + pLacedFrames->dataSize, pFrame->frameData, pFrame->size);
+    pLacedFrames->dataSize += pFrame->size;
+
+    // The frame data is pointed to the data buffer once the lace is put as the buffer might move
+    pLacedFrames->frames[pLacedFrames->frameCount] = *pFrame;
+    pLacedFrames->frames[pLacedFrames->frameCount].frameData = NULL;
+    pLacedFrames->frameCount++;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Packages the pending lace into a single block and puts it into the stream.
+ * The frames of the lace are dropped if the put fails.
+ * IMPORTANT: The putFrame lock should be held as the lace is only modified by the producers. The stream lock
+ * should not be held so the put can release the stream while waiting for the availability in the OFFLINE mode.
+ */
+STATUS flushLacedFrames(PKinesisVideoStream pKinesisVideoStream, PPutFrameBatch pBatch)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PLacedFrames pLacedFrames;
+    UINT32 i, offset = 0;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pLacedFrames = &pKinesisVideoStream->lacedFrames;
+
+    CHK(pLacedFrames->frameCount != 0, retStatus);
+
+    for (i = 0; i < pLacedFrames->frameCount; i++) {
+        pLacedFrames->frames[i].frameData = pLacedFrames->pData + offset;
+        offset += pLacedFrames->frames[i].size;
+    }
+
+    retStatus = putFrameInternal(pKinesisVideoStream, pLacedFrames->frames, NULL, pBatch);
+
+    pLacedFrames->frameCount = 0;
+    pLacedFrames->dataSize = 0;
+    disarmLaceTimer(pKinesisVideoStream);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Puts the pending lace if the lacing duration has elapsed since its first frame has been accumulated.
+ * Takes the putFrame lock guarding the lace and the frame order coordinator lock as the put releases it
+ * while logging the metrics.
+ */
+STATUS flushExpiredLacedFrames(PKinesisVideoStream pKinesisVideoStream, UINT64 currentTime)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
     PKinesisVideoClient pKinesisVideoClient = NULL;
+    PFrameOrderCoordinator pFrameOrderCoordinator = NULL;
+    PLacedFrames pLacedFrames;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pLacedFrames = &pKinesisVideoStream->lacedFrames;
+
+    // Early return without locking for the streams which don't lace the audio frames
+    CHK(pKinesisVideoStream->streamInfo.streamCaps.audioLacingDuration != 0, retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+    if (pKinesisVideoStream->streamInfo.streamCaps.frameOrderingMode != FRAME_ORDER_MODE_PASS_THROUGH) {
+        pFrameOrderCoordinator = pKinesisVideoStream->pFrameOrderCoordinator;
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pFrameOrderCoordinator->lock);
+    }
+
+    if (pLacedFrames->frameCount != 0 && currentTime >= pLacedFrames->startTime + pKinesisVideoStream->streamInfo.streamCaps.audioLacingDuration) {
+        retStatus = flushLacedFrames(pKinesisVideoStream, NULL);
+    }
+
+    if (pFrameOrderCoordinator != NULL) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pFrameOrderCoordinator->lock);
+    }
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.putFrameLock);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Reserves the slice of the fragment extent for the packaged frame and references the extent for the view item.
+ * The open extent is grown when it runs out of room. A new extent is opened on the fragment boundary
+ * or when the open extent can't be grown. Returns an invalid handle if the content store has no room.
+ * IMPORTANT: The stream lock should be held
+ */
+STATUS reserveFragmentExtent(PKinesisVideoStream pKinesisVideoStream, UINT32 size, BOOL fragmentStart, PALLOCATION_HANDLE pHandle, PUINT32 pOffset)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PFragmentExtents pExtents = NULL;
+    ALLOCATION_HANDLE handle = INVALID_ALLOCATION_HANDLE_VALUE;
+    UINT64 refCount;
+    UINT32 extentSize;
+    BOOL storeLocked = FALSE;
+
+    CHK(pKinesisVideoStream != NULL && pHandle != NULL && pOffset != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    pExtents = &pKinesisVideoStream->fragmentExtents;
+    *pHandle = INVALID_ALLOCATION_HANDLE_VALUE;
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
+
+    // Try growing the open extent to keep the frames of the fragment contiguous
+    if (IS_VALID_ALLOCATION_HANDLE(pExtents->handle) && !fragmentStart && size > pExtents->size - pExtents->used) {
+        extentSize = MAX(pExtents->used + size, MIN(2 * (UINT64) pExtents->size, MAX_UINT32));
+        if (STATUS_FAILED(retStatus = resizeFragmentExtent(pKinesisVideoStream, extentSize))) {
+            DLOGV("[%s] Failed to grow the fragment extent to %u with 0x%08x", pKinesisVideoStream->streamInfo.name, extentSize, retStatus);
+            retStatus = STATUS_SUCCESS;
+        }
+    }
+
+    if (!IS_VALID_ALLOCATION_HANDLE(pExtents->handle) || fragmentStart || size > pExtents->size - pExtents->used) {
+        CHK_STATUS(closeFragmentExtent(pKinesisVideoStream));
+
+        // Might need to block on the availability so the store arena lock can't be held
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+        storeLocked = FALSE;
+
+        extentSize = MAX(size, pKinesisVideoStream->streamInfo.streamCaps.fragmentExtentSize);
+        CHK_STATUS(handleAvailability(pKinesisVideoStream, extentSize, &handle));
+        CHK(IS_VALID_ALLOCATION_HANDLE(handle), retStatus);
+
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+        storeLocked = TRUE;
+
+        // The open extent holds a reference until it's closed
+        CHK_STATUS(hashTablePut(pExtents->pRefCounts, handle, 1));
+        pExtents->handle = handle;
+        pExtents->size = extentSize;
+        pExtents->used = 0;
+        pExtents->firstIndex = INVALID_VIEW_INDEX_VALUE;
+        handle = INVALID_ALLOCATION_HANDLE_VALUE;
+    }
+
+    CHK_STATUS(hashTableGet(pExtents->pRefCounts, pExtents->handle, &refCount));
+    CHK_STATUS(hashTableUpsert(pExtents->pRefCounts, pExtents->handle, refCount + 1));
+
+    *pHandle = pExtents->handle;
+    *pOffset = pExtents->used;
+    pExtents->used += size;
+
+CleanUp:
+
+    if (IS_VALID_ALLOCATION_HANDLE(handle)) {
+        if (!storeLocked) {
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = TRUE;
+        }
+
+        heapFree(pKinesisVideoStream->pStoreArena->pHeap, handle);
+    }
+
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Resizes the open extent. The view items of the extent are re-pointed if the content store moves the extent
+ * which can't happen while the extent is in use by the stream data segments.
+ * IMPORTANT: The stream and the store arena locks should be held
+ */
+STATUS resizeFragmentExtent(PKinesisVideoStream pKinesisVideoStream, UINT32 size)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PFragmentExtents pExtents = NULL;
     PViewItem pViewItem = NULL;
+    ALLOCATION_HANDLE handle;
+    UINT64 refCount, index;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pExtents = &pKinesisVideoStream->fragmentExtents;
+    CHK(IS_VALID_ALLOCATION_HANDLE(pExtents->handle) && size >= pExtents->used, STATUS_INVALID_ARG);
+    CHK(getPinnedAllocation(pKinesisVideoStream, pExtents->handle) == NULL, STATUS_INVALID_OPERATION);
+
+    handle = pExtents->handle;
+    CHK_STATUS(heapSetAllocSize(pKinesisVideoStream->pStoreArena->pHeap, &handle, size));
+    pExtents->size = size;
+
+    // Early return if the extent stays in place
+    CHK(handle != pExtents->handle, retStatus);
+
+    CHK_STATUS(hashTableGet(pExtents->pRefCounts, pExtents->handle, &refCount));
+    CHK_STATUS(hashTableRemove(pExtents->pRefCounts, pExtents->handle));
+    CHK_STATUS(hashTablePut(pExtents->pRefCounts, handle, refCount));
+
+    // The items of the extent follow the first one up to the head. Some might have rolled out of the window.
+    if (IS_VALID_VIEW_INDEX(pExtents->firstIndex) && STATUS_SUCCEEDED(contentViewGetTail(pKinesisVideoStream->pView, &pViewItem))) {
+        for (index = MAX(pExtents->firstIndex, pViewItem->index);
+             STATUS_SUCCEEDED(contentViewGetItemAt(pKinesisVideoStream->pView, index, &pViewItem)); index++) {
+            if (pViewItem->handle == pExtents->handle) {
+                pViewItem->handle = handle;
+            }
+        }
+    }
+
+    if (pKinesisVideoStream->curViewItem.viewItem.handle == pExtents->handle) {
+        pKinesisVideoStream->curViewItem.viewItem.handle = handle;
+    }
+
+    pExtents->handle = handle;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Closes the open extent returning its unused room to the content store.
+ * The extent is freed once it's no longer referenced by the view items.
+ * IMPORTANT: The stream and the store arena locks should be held
+ */
+STATUS closeFragmentExtent(PKinesisVideoStream pKinesisVideoStream)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PFragmentExtents pExtents = NULL;
+    ALLOCATION_HANDLE handle;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pExtents = &pKinesisVideoStream->fragmentExtents;
+    CHK(IS_VALID_ALLOCATION_HANDLE(pExtents->handle), retStatus);
+
+    if (pExtents->used != 0 && pExtents->used < pExtents->size && getPinnedAllocation(pKinesisVideoStream, pExtents->handle) == NULL) {
+        if (STATUS_FAILED(retStatus = resizeFragmentExtent(pKinesisVideoStream, pExtents->used))) {
+            DLOGW("[%s] Failed to trim the fragment extent with 0x%08x", pKinesisVideoStream->streamInfo.name, retStatus);
+            retStatus = STATUS_SUCCESS;
+        }
+    }
+
+    handle = pExtents->handle;
+    pExtents->handle = INVALID_ALLOCATION_HANDLE_VALUE;
+    pExtents->size = 0;
+    pExtents->used = 0;
+    pExtents->firstIndex = INVALID_VIEW_INDEX_VALUE;
+
+    CHK_STATUS(releaseFragmentExtent(pKinesisVideoStream, handle));
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Releases a reference to the extent and frees the extent once it's no longer referenced
+ * IMPORTANT: The stream and the store arena locks should be held
+ */
+STATUS releaseFragmentExtent(PKinesisVideoStream pKinesisVideoStream, ALLOCATION_HANDLE handle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PHashTable pRefCounts = NULL;
+    UINT64 refCount;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pRefCounts = pKinesisVideoStream->fragmentExtents.pRefCounts;
+
+    CHK_STATUS(hashTableGet(pRefCounts, handle, &refCount));
+    if (refCount > 1) {
+        CHK_STATUS(hashTableUpsert(pRefCounts, handle, refCount - 1));
+    } else {
+        CHK_STATUS(hashTableRemove(pRefCounts, handle));
+        freeStoreAllocation(pKinesisVideoStream, handle);
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Returns the offset of the view item data in its allocation
+ */
+UINT32 getViewItemExtentOffset(PKinesisVideoStream pKinesisVideoStream, PViewItem pViewItem)
+{
+    PFragmentExtents pExtents = &pKinesisVideoStream->fragmentExtents;
+
+    if (!CHECK_ITEM_FRAGMENT_EXTENT(pViewItem->flags) || pExtents->pItemOffsets == NULL) {
+        return 0;
+    }
+
+    return pExtents->pItemOffsets[pViewItem->index % pExtents->itemCount];
+}
+
+/**
+ * Frees the content store allocation or defers it until the stream data segments using it are released
+ * IMPORTANT: The store arena lock should be held
+ */
+VOID freeStoreAllocation(PKinesisVideoStream pKinesisVideoStream, ALLOCATION_HANDLE handle)
+{
+    PPinnedAllocation pPinnedAllocation;
+
+    if ((pPinnedAllocation = getPinnedAllocation(pKinesisVideoStream, handle)) != NULL) {
+        pPinnedAllocation->removed = TRUE;
+    } else {
+        heapFree(pKinesisVideoStream->pStoreArena->pHeap, handle);
+    }
+}
+
+/**
+ * Reserves the storage for the frame in the content store and returns the writable buffer for the payload.
+ * The storage for the MKV bits is reserved in front of the payload based on the current stream state.
+ */
+STATUS acquireFrameBuffer(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame, PBYTE* ppBuffer, PUINT32 pBufferSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    ALLOCATION_HANDLE allocHandle = INVALID_ALLOCATION_HANDLE_VALUE;
+    UINT64 allocSize = 0;
     PBYTE pAlloc = NULL;
-    UINT32 size = 0, remainingSize = bufferSize, uploadHandleCount;
+    UINT32 trackIndex, payloadSize, packagedSize = 0, packagedMetadataSize = 0, overallSize;
+    BOOL streamLocked = FALSE, storeLocked = FALSE;
+    PTrackInfo pTrackInfo = NULL;
+    EncodedFrameInfo encodedFrameInfo;
+    Frame frame;
+
+    CHK(pKinesisVideoStream != NULL && pFrame != NULL && ppBuffer != NULL && pBufferSize != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    // EoFr has no payload and the frame ordering would need to copy the frames
+    CHK(!CHECK_FRAME_FLAG_END_OF_FRAGMENT(pFrame->flags), STATUS_INVALID_ARG);
+    CHK(pKinesisVideoStream->streamInfo.streamCaps.frameOrderingMode == FRAME_ORDER_MODE_PASS_THROUGH, STATUS_INVALID_OPERATION);
+
+    CHK_STATUS(mkvgenGetTrackInfoFromMap(&pKinesisVideoStream->trackIndexMap, pKinesisVideoStream->streamInfo.streamCaps.trackInfoList,
+                                         pKinesisVideoStream->streamInfo.streamCaps.trackInfoCount, pFrame->trackId, &pTrackInfo, &trackIndex));
+
+    // Annex-B adaptation can't be done in place
+    CHK(pTrackInfo->trackType != MKV_TRACK_INFO_TYPE_VIDEO ||
+            (pKinesisVideoStream->streamInfo.streamCaps.nalAdaptationFlags & NAL_ADAPTATION_ANNEXB_NALS) == NAL_ADAPTATION_FLAG_NONE,
+        STATUS_INVALID_OPERATION);
+
+    // Use the max frame size seen if the max payload size is not specified
+    payloadSize = pFrame->size != 0 ? pFrame->size : (UINT32) pKinesisVideoStream->maxFrameSizeSeen;
+    CHK(payloadSize != 0, STATUS_INVALID_ARG);
+
+    // Check if the stream has been stopped
+    CHK(!pKinesisVideoStream->streamStopped, STATUS_STREAM_HAS_BEEN_STOPPED);
+
+    // Lock the stream
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = TRUE;
+
+    CHK(!IS_VALID_ALLOCATION_HANDLE(pKinesisVideoStream->acquiredFrameBuffer.handle), STATUS_FRAME_BUFFER_ALREADY_ACQUIRED);
+
+    // Calculate the packaged size of the max payload in the current stream state.
+    // NOTE: The payload is not accessed when calculating the size so any non-NULL data pointer will do.
+    frame = *pFrame;
+    frame.size = payloadSize;
+    frame.frameData = (PBYTE) pFrame;
+    CHK_STATUS(mkvgenPackageFrame(pKinesisVideoStream->pMkvGenerator, &frame, pTrackInfo, NULL, &packagedSize, &encodedFrameInfo));
+
+    if (encodedFrameInfo.streamState == MKV_STATE_START_STREAM || encodedFrameInfo.streamState == MKV_STATE_START_CLUSTER) {
+        CHK_STATUS(packageStreamMetadata(pKinesisVideoStream, MKV_STATE_START_CLUSTER, FALSE, NULL, &packagedMetadataSize));
+    }
+
+    overallSize = packagedSize + packagedMetadataSize;
+
+    // Might need to block on the availability in the OFFLINE mode
+    CHK_STATUS(handleAvailability(pKinesisVideoStream, overallSize, &allocHandle));
+
+    // Lock the store arena
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
+
+    // Ensure we have space and if not then bail
+    CHK(IS_VALID_ALLOCATION_HANDLE(allocHandle), STATUS_STORE_OUT_OF_MEMORY);
+
+    // Map the storage which will stay mapped until the frame is committed
+    CHK_STATUS(heapMap(pKinesisVideoStream->pStoreArena->pHeap, allocHandle, (PVOID*) &pAlloc, &allocSize));
+    CHK(overallSize <= allocSize, STATUS_ALLOCATION_SIZE_SMALLER_THAN_REQUESTED);
+
+    pKinesisVideoStream->acquiredFrameBuffer.handle = allocHandle;
+    pKinesisVideoStream->acquiredFrameBuffer.pAllocation = pAlloc;
+    pKinesisVideoStream->acquiredFrameBuffer.size = overallSize;
+    pKinesisVideoStream->acquiredFrameBuffer.headerSize = overallSize - payloadSize;
+
+    *ppBuffer = pAlloc + pKinesisVideoStream->acquiredFrameBuffer.headerSize;
+    *pBufferSize = payloadSize;
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus) && IS_VALID_ALLOCATION_HANDLE(allocHandle)) {
+        if (pAlloc != NULL) {
+            heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pAlloc);
+        }
+
+        heapFree(pKinesisVideoStream->pStoreArena->pHeap, allocHandle);
+    }
+
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Puts the frame produced in the acquired frame buffer into the stream
+ */
+STATUS commitFrameBuffer(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    AcquiredFrameBuffer frameBuffer;
+    Frame frame;
+    BOOL streamLocked = FALSE;
+
+    CHK(pKinesisVideoStream != NULL && pFrame != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = TRUE;
+
+    CHK(IS_VALID_ALLOCATION_HANDLE(pKinesisVideoStream->acquiredFrameBuffer.handle), STATUS_FRAME_BUFFER_NOT_ACQUIRED);
+    frameBuffer = pKinesisVideoStream->acquiredFrameBuffer;
+
+    // Validate the frame has been produced in the acquired buffer
+    CHK(pFrame->frameData == frameBuffer.pAllocation + frameBuffer.headerSize && pFrame->size != 0 &&
+            pFrame->size <= frameBuffer.size - frameBuffer.headerSize,
+        STATUS_INVALID_ARG);
+
+    // Take the buffer over as it's released whether the frame is put or not
+    MEMSET(&pKinesisVideoStream->acquiredFrameBuffer, 0x00, SIZEOF(AcquiredFrameBuffer));
+    pKinesisVideoStream->acquiredFrameBuffer.handle = INVALID_ALLOCATION_HANDLE_VALUE;
+
+    // The stream lock can't be held while putting the frame as it's released when logging the metrics
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = FALSE;
+
+    // The frame is copied as the data pointer might be adjusted
+    frame = *pFrame;
+    CHK_STATUS(putFrameInternal(pKinesisVideoStream, &frame, &frameBuffer, NULL));
+
+CleanUp:
+
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the acquired frame buffer without putting the frame
+ */
+STATUS discardFrameBuffer(PKinesisVideoStream pKinesisVideoStream)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    BOOL streamLocked = FALSE;
+
+    CHK(pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = TRUE;
+
+    CHK(IS_VALID_ALLOCATION_HANDLE(pKinesisVideoStream->acquiredFrameBuffer.handle), STATUS_FRAME_BUFFER_NOT_ACQUIRED);
+    CHK_STATUS(freeAcquiredFrameBuffer(pKinesisVideoStream));
+
+CleanUp:
+
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Unmaps and frees the acquired frame buffer if any.
+ * IMPORTANT: The stream lock should be held
+ */
+STATUS freeAcquiredFrameBuffer(PKinesisVideoStream pKinesisVideoStream)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    PAcquiredFrameBuffer pFrameBuffer = &pKinesisVideoStream->acquiredFrameBuffer;
+
+    CHK(IS_VALID_ALLOCATION_HANDLE(pFrameBuffer->handle), retStatus);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    CHK_STATUS_CONTINUE(heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pFrameBuffer->pAllocation));
+    CHK_STATUS_CONTINUE(heapFree(pKinesisVideoStream->pStoreArena->pHeap, pFrameBuffer->handle));
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+
+    MEMSET(pFrameBuffer, 0x00, SIZEOF(AcquiredFrameBuffer));
+    pFrameBuffer->handle = INVALID_ALLOCATION_HANDLE_VALUE;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Fills the caller buffer with the stream data
+ */
+STATUS getStreamData(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uploadHandle, PBYTE pBuffer, UINT32 bufferSize, PUINT32 pFillSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pBuffer != NULL, STATUS_NULL_ARG);
+    retStatus = getStreamDataInternal(pKinesisVideoStream, uploadHandle, pBuffer, bufferSize, NULL, 0, NULL, pFillSize);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Returns the segments of the stream data without copying. The segments remain valid until released.
+ */
+STATUS getStreamDataSegments(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uploadHandle, UINT32 maxSize, PStreamDataSegment pSegments,
+                             UINT32 segmentCount, PUINT32 pSegmentCount, PUINT32 pFillSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pSegments != NULL && pSegmentCount != NULL, STATUS_NULL_ARG);
+    CHK(segmentCount != 0, STATUS_INVALID_ARG);
+
+    *pSegmentCount = 0;
+    retStatus = getStreamDataInternal(pKinesisVideoStream, uploadHandle, NULL, maxSize, pSegments, MIN(segmentCount, MAX_STREAM_DATA_SEGMENT_COUNT),
+                                      pSegmentCount, pFillSize);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Releases the stream data segments returned by getStreamDataSegments
+ */
+STATUS releaseStreamDataSegments(PKinesisVideoStream pKinesisVideoStream)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PPinnedAllocation pPinnedAllocation;
+    BOOL streamLocked = FALSE, storeLocked = FALSE;
+    UINT32 i;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = TRUE;
+
+    CHK(pKinesisVideoStream->segmentsOutstanding, STATUS_STREAM_DATA_SEGMENTS_NOT_OUTSTANDING);
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
+
+    // Unmap the allocations and free the ones which have been removed from the view while in use.
+    // An extent might be mapped by several segments so all of the mappings are released first.
+    for (i = 0; i < pKinesisVideoStream->pinnedAllocationCount; i++) {
+        pPinnedAllocation = &pKinesisVideoStream->pinnedAllocations[i];
+        CHK_STATUS_CONTINUE(heapUnmapReadOnly(pKinesisVideoStream->pStoreArena->pHeap, pPinnedAllocation->pAllocation));
+    }
+
+    for (i = 0; i < pKinesisVideoStream->pinnedAllocationCount; i++) {
+        pPinnedAllocation = &pKinesisVideoStream->pinnedAllocations[i];
+        if (pPinnedAllocation->removed) {
+            CHK_STATUS_CONTINUE(heapFree(pKinesisVideoStream->pStoreArena->pHeap, pPinnedAllocation->handle));
+        }
+    }
+
+    pKinesisVideoStream->pinnedAllocationCount = 0;
+    pKinesisVideoStream->segmentsOutstanding = FALSE;
+
+    // Free the packaged metadata which has been replaced while in use
+    SAFE_MEMFREE(pKinesisVideoStream->pRetiredMetadata);
+
+CleanUp:
+
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Gets the pinned allocation for the handle if it's in use by the outstanding stream data segments or NULL otherwise
+ */
+PPinnedAllocation getPinnedAllocation(PKinesisVideoStream pKinesisVideoStream, ALLOCATION_HANDLE handle)
+{
+    UINT32 i;
+
+    for (i = 0; i < pKinesisVideoStream->pinnedAllocationCount; i++) {
+        if (pKinesisVideoStream->pinnedAllocations[i].handle == handle) {
+            return &pKinesisVideoStream->pinnedAllocations[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Fills the caller buffer with the stream data or, if the segments are specified, returns the segments
+ * pointing to the stream data and pins the backing allocations.
+ */
+STATUS getStreamDataInternal(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uploadHandle, PBYTE pBuffer, UINT32 bufferSize,
+                             PStreamDataSegment pSegments, UINT32 segmentCount, PUINT32 pSegmentCount, PUINT32 pFillSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, stalenessCheckStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PViewItem pViewItem = NULL;
+    PBYTE pAlloc = NULL, pData;
+    UINT32 size = 0, remainingSize = bufferSize, uploadHandleCount, extentOffset;
     UINT64 allocSize, currentTime, duration, viewByteSize;
     PBYTE pCurPnt = pBuffer;
-    BOOL streamLocked = FALSE, clientLocked = FALSE, rollbackToLastAck, restarted = FALSE, eosSent = FALSE;
+    BOOL streamLocked = FALSE, storeLocked = FALSE, rollbackToLastAck, restarted = FALSE, eosSent = FALSE;
     DOUBLE transferRate, deltaInSeconds;
     PUploadHandleInfo pUploadHandleInfo = NULL, pNextUploadHandleInfo = NULL;
+    PPinnedAllocation pPinnedAllocation;
 
-    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL && pBuffer != NULL && pFillSize != NULL, STATUS_NULL_ARG);
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL && pFillSize != NULL, STATUS_NULL_ARG);
     CHK(bufferSize != 0 && IS_VALID_UPLOAD_HANDLE(uploadHandle), STATUS_INVALID_ARG);
 
     pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
@@ -1183,6 +2195,9 @@ STATUS getStreamData(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uplo
     pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
     streamLocked = TRUE;
 
+    // The data can't be consumed while the previously returned segments are in use
+    CHK(!pKinesisVideoStream->segmentsOutstanding, STATUS_STREAM_DATA_SEGMENTS_OUTSTANDING);
+
     // If the state of the connection is IN_USE
     // and we are not in grace period
     // and we are not in a retry state on rotation
@@ -1305,11 +2320,17 @@ STATUS getStreamData(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uplo
             } else {
                 // Copy as much as we can
                 size = MIN(remainingSize, pKinesisVideoStream->metadataTracker.size - pKinesisVideoStream->metadataTracker.offset);
-                MEMCPY(pCurPnt, pKinesisVideoStream->metadataTracker.data + pKinesisVideoStream->metadataTracker.offset, size);
+                if (pSegments == NULL) {
+                    MEMCPY(pCurPnt, pKinesisVideoStream->metadataTracker.data + pKinesisVideoStream->metadataTracker.offset, size);
+                    pCurPnt += size;
+                } else {
+                    pSegments[*pSegmentCount].pData = pKinesisVideoStream->metadataTracker.data + pKinesisVideoStream->metadataTracker.offset;
+                    pSegments[*pSegmentCount].size = size;
+                    (*pSegmentCount)++;
+                }
 
                 // Set the values for the next iteration.
                 pKinesisVideoStream->metadataTracker.offset += size;
-                pCurPnt += size;
                 remainingSize -= size;
                 *pFillSize += size;
             }
@@ -1342,11 +2363,17 @@ STATUS getStreamData(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uplo
 
             // Copy as much as we can
             size = MIN(remainingSize, pKinesisVideoStream->eosTracker.size - pKinesisVideoStream->eosTracker.offset);
-            MEMCPY(pCurPnt, pKinesisVideoStream->eosTracker.data + pKinesisVideoStream->eosTracker.offset, size);
+            if (pSegments == NULL) {
+                MEMCPY(pCurPnt, pKinesisVideoStream->eosTracker.data + pKinesisVideoStream->eosTracker.offset, size);
+                pCurPnt += size;
+            } else {
+                pSegments[*pSegmentCount].pData = pKinesisVideoStream->eosTracker.data + pKinesisVideoStream->eosTracker.offset;
+                pSegments[*pSegmentCount].size = size;
+                (*pSegmentCount)++;
+            }
 
             // Set the values
             pKinesisVideoStream->eosTracker.offset += size;
-            pCurPnt += size;
             remainingSize -= size;
             *pFillSize += size;
         } else if (!IS_VALID_ALLOCATION_HANDLE(pKinesisVideoStream->curViewItem.viewItem.handle)) {
@@ -1431,40 +2458,68 @@ STATUS getStreamData(PKinesisVideoStream pKinesisVideoStream, UPLOAD_HANDLE uplo
                 pUploadHandleInfo->lastFragmentTs = pKinesisVideoStream->curViewItem.viewItem.ackTimestamp;
             }
 
-            // Lock the client
-            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-            clientLocked = TRUE;
+            // Lock the store arena
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = TRUE;
 
             // Fill the rest of the buffer of the current view item first
-            // Map the storage
-            CHK_STATUS(heapMap(pKinesisVideoClient->pHeap, pKinesisVideoStream->curViewItem.viewItem.handle, (PVOID*) &pAlloc, &allocSize));
+            // Map the storage for reading only as we don't modify the content
+            CHK_STATUS(heapMapReadOnly(pKinesisVideoStream->pStoreArena->pHeap, pKinesisVideoStream->curViewItem.viewItem.handle, (PVOID*) &pAlloc,
+                                       &allocSize));
+            extentOffset = getViewItemExtentOffset(pKinesisVideoStream, &pKinesisVideoStream->curViewItem.viewItem);
             CHK(allocSize < MAX_UINT32 && (UINT32) allocSize >= pKinesisVideoStream->curViewItem.viewItem.length, STATUS_INVALID_ALLOCATION_SIZE);
 
             // Validate we had allocated enough storage just in case
-            CHK(pKinesisVideoStream->curViewItem.viewItem.length - pKinesisVideoStream->curViewItem.offset <= allocSize,
-                STATUS_VIEW_ITEM_SIZE_GREATER_THAN_ALLOCATION);
+            CHK(extentOffset + pKinesisVideoStream->curViewItem.viewItem.length <= allocSize, STATUS_VIEW_ITEM_SIZE_GREATER_THAN_ALLOCATION);
 
             // Copy as much as we can
             size = MIN(remainingSize, pKinesisVideoStream->curViewItem.viewItem.length - pKinesisVideoStream->curViewItem.offset);
-            MEMCPY(pCurPnt, pAlloc + pKinesisVideoStream->curViewItem.offset, size);
+            pData = pAlloc + extentOffset + pKinesisVideoStream->curViewItem.offset;
+            if (pSegments == NULL) {
+                MEMCPY(pCurPnt, pData, size);
+                pCurPnt += size;
 
-            // Unmap the storage for the frame
-            CHK_STATUS(heapUnmap(pKinesisVideoClient->pHeap, ((PVOID) pAlloc)));
+                // Unmap the storage for the frame
+                CHK_STATUS(heapUnmapReadOnly(pKinesisVideoStream->pStoreArena->pHeap, ((PVOID) pAlloc)));
+            } else if (*pSegmentCount != 0 && pKinesisVideoStream->pinnedAllocationCount != 0 &&
+                       pKinesisVideoStream->pinnedAllocations[pKinesisVideoStream->pinnedAllocationCount - 1].handle ==
+                           pKinesisVideoStream->curViewItem.viewItem.handle &&
+                       pSegments[*pSegmentCount - 1].pData + pSegments[*pSegmentCount - 1].size == pData) {
+                // The item follows the previous one in the same extent so the segment is extended
+                // and the extent stays pinned by the mapping of the segment
+                pSegments[*pSegmentCount - 1].size += size;
+                CHK_STATUS(heapUnmapReadOnly(pKinesisVideoStream->pStoreArena->pHeap, ((PVOID) pAlloc)));
+            } else {
+                // Keep the storage mapped and the allocation pinned until the segments are released
+                pSegments[*pSegmentCount].pData = pData;
+                pSegments[*pSegmentCount].size = size;
+                (*pSegmentCount)++;
+
+                pPinnedAllocation = &pKinesisVideoStream->pinnedAllocations[pKinesisVideoStream->pinnedAllocationCount++];
+                pPinnedAllocation->handle = pKinesisVideoStream->curViewItem.viewItem.handle;
+                pPinnedAllocation->pAllocation = pAlloc;
+                pPinnedAllocation->removed = FALSE;
+            }
 
-            // unLock the client
-            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-            clientLocked = FALSE;
+            // unLock the store arena
+            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                               pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = FALSE;
 
             // Set the values
             pKinesisVideoStream->curViewItem.offset += size;
-            pCurPnt += size;
             remainingSize -= size;
             *pFillSize += size;
         }
-    } while (remainingSize != 0);
+    } while (remainingSize != 0 && (pSegments == NULL || *pSegmentCount < segmentCount));
 
 CleanUp:
 
+    // The segments need to be released before the data can be consumed further
+    if (pSegmentCount != NULL && *pSegmentCount != 0) {
+        pKinesisVideoStream->segmentsOutstanding = TRUE;
+    }
+
     // Run staleness detection if we have ACKs enabled and if we have retrieved any data
     if (pFillSize != NULL && *pFillSize != 0) {
         stalenessCheckStatus = checkForConnectionStaleness(pKinesisVideoStream, &pKinesisVideoStream->curViewItem.viewItem);
@@ -1583,8 +2638,8 @@ CleanUp:
         }
     }
 
-    if (clientLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
     }
 
     if (streamLocked) {
@@ -1627,6 +2682,15 @@ STATUS getStreamMetrics(PKinesisVideoStream pKinesisVideoStream, PStreamMetrics
     streamLocked = FALSE;
 
     switch (pStreamMetrics->version) {
+        case 4:
+            // Fill in data for V4 metrics
+            pStreamMetrics->putFrameRingHighWaterMarks = 0;
+            pStreamMetrics->putFrameRingFullRejections = 0;
+            if (pKinesisVideoStream->pPutFrameRing != NULL) {
+                pStreamMetrics->putFrameRingHighWaterMarks = ATOMIC_LOAD(&pKinesisVideoStream->pPutFrameRing->highWaterMarks);
+                pStreamMetrics->putFrameRingFullRejections = ATOMIC_LOAD(&pKinesisVideoStream->pPutFrameRing->fullRejections);
+            }
+            // explicit fall through to populate other version metrics
         case 3:
             // Fill in data for V3 metrics
             pStreamMetrics->streamApiCallRetryCount = pKinesisVideoStream->diagnostics.streamApiCallRetryCount;
@@ -1667,62 +2731,179 @@ STATUS getStreamMetrics(PKinesisVideoStream pKinesisVideoStream, PStreamMetrics
             break;
     }
 
-CleanUp:
+CleanUp:
+
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Check if there is enough content store for the frame. If not, block waiting if in OFFLINE mode,
+ * otherwise if the content store pressure is set to evict the tail frames then kick them out, otherwise
+ * return with INVALID_ALLOCATION_HANDLE.
+ *
+ * IMPORTANT: The assumption is that both the stream IS locked but
+ * the store arena is NOT locked.
+ *
+ * The parameters are assumed to have been sanitized.
+ * The call will block only in the offline mode waiting for the
+ * available space in the content store and available spot
+ * in the content view in order to proceed.
+ *
+ * The caller thread will be blocked in the OFFLINE mode.
+ * The operation will return interrupted error in case the stream is terminated.
+ */
+STATUS handleAvailability(PKinesisVideoStream pKinesisVideoStream, UINT32 allocationSize, PALLOCATION_HANDLE pAllocationHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    while (TRUE) {
+        // Check if we have enough space to proceed - the stream should be locked
+        CHK_STATUS(checkForAvailability(pKinesisVideoStream, allocationSize, pAllocationHandle));
+
+        // Early return if available
+        CHK(!IS_VALID_ALLOCATION_HANDLE(*pAllocationHandle), STATUS_SUCCESS);
+
+        // if no space available, wait only if in OFFLINE mode or if we are going to evict the tail frames
+        CHK(pKinesisVideoStream->streamInfo.streamCaps.storePressurePolicy == CONTENT_STORE_PRESSURE_POLICY_DROP_TAIL_ITEM ||
+                IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType),
+            STATUS_SUCCESS);
+
+        if (IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
+            // Long path which will await for the availability notification or cancellation
+            CHK_STATUS(pKinesisVideoClient->clientCallbacks.waitConditionVariableFn(
+                pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->bufferAvailabilityCondition, pKinesisVideoStream->base.lock,
+                pKinesisVideoClient->deviceInfo.clientInfo.offlineBufferAvailabilityTimeout));
+        } else {
+            // Need to evict the tail frames by trimming the tail
+            CHK_STATUS(contentViewTrimTailItems(pKinesisVideoStream->pView));
+        }
+
+        // Check for the stream termination
+        CHK(!pKinesisVideoStream->streamStopped && !pKinesisVideoStream->base.shutdown, STATUS_BLOCKING_PUT_INTERRUPTED_STREAM_TERMINATED);
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Checks for the storage and buffer duration pressures and notifies the application
+ * IMPORTANT: The stream and the store arena locks should be held
+ */
+STATUS checkStreamStoragePressures(PKinesisVideoStream pKinesisVideoStream)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    UINT64 remainingSize, remainingDuration, thresholdPercent, windowDuration, currentDuration;
+
+    // Check for storage pressures. No need for offline mode as the media pipeline will be blocked when there
+    // is not enough storage
+    if (!IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
+        remainingSize = pKinesisVideoStream->pStoreArena->pHeap->heapLimit - pKinesisVideoStream->pStoreArena->pHeap->heapSize;
+        thresholdPercent = (UINT32) (((DOUBLE) remainingSize / pKinesisVideoStream->pStoreArena->pHeap->heapLimit) * 100);
+
+        if (thresholdPercent <= STORAGE_PRESSURE_NOTIFICATION_THRESHOLD) {
+            pKinesisVideoStream->diagnostics.storagePressures++;
+
+            if (pKinesisVideoClient->clientCallbacks.storageOverflowPressureFn != NULL) {
+                // Notify the client app about buffer pressure
+                CHK_STATUS(
+                    pKinesisVideoClient->clientCallbacks.storageOverflowPressureFn(pKinesisVideoClient->clientCallbacks.customData, remainingSize));
+            }
+        }
+
+        // No need to report buffer duration overflow in offline since the putFrame thread will be blocked.
+        // Only report buffer duration overflow if retention is non-zero, since if retention is zero, there will be no
+        // persisted ack and buffer will drop off tail all the time.
+        if (pKinesisVideoStream->streamInfo.retention != RETENTION_PERIOD_SENTINEL &&
+            pKinesisVideoClient->clientCallbacks.bufferDurationOverflowPressureFn != NULL) {
+            CHK_STATUS(contentViewGetWindowDuration(pKinesisVideoStream->pView, &currentDuration, &windowDuration));
 
-    if (streamLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+            // Check for buffer duration pressure. Note that streamCaps.bufferDuration will never be 0.
+            remainingDuration = pKinesisVideoStream->streamInfo.streamCaps.bufferDuration - windowDuration;
+            thresholdPercent = (UINT32) (((DOUBLE) remainingDuration / pKinesisVideoStream->streamInfo.streamCaps.bufferDuration) * 100);
+            if (thresholdPercent <= BUFFER_DURATION_PRESSURE_NOTIFICATION_THRESHOLD) {
+                pKinesisVideoStream->diagnostics.bufferPressures++;
+
+                // Notify the client app about buffer pressure
+                CHK_STATUS(pKinesisVideoClient->clientCallbacks.bufferDurationOverflowPressureFn(
+                    pKinesisVideoClient->clientCallbacks.customData, TO_STREAM_HANDLE(pKinesisVideoStream), remainingDuration));
+            }
+        }
     }
 
+CleanUp:
+
     LEAVES();
     return retStatus;
 }
 
 /**
- * Check if there is enough content store for the frame. If not, block waiting if in OFFLINE mode,
- * otherwise if the content store pressure is set to evict the tail frames then kick them out, otherwise
- * return with INVALID_ALLOCATION_HANDLE.
- *
- * IMPORTANT: The assumption is that both the stream IS locked but
- * the client is NOT locked.
- *
- * The parameters are assumed to have been sanitized.
- * The call will block only in the offline mode waiting for the
- * available space in the content store and available spot
- * in the content view in order to proceed.
- *
- * The caller thread will be blocked in the OFFLINE mode.
- * The operation will return interrupted error in case the stream is terminated.
+ * Checks for the latency pressure and notifies the application
+ * IMPORTANT: The stream and the store arena locks should be held
  */
-STATUS handleAvailability(PKinesisVideoStream pKinesisVideoStream, UINT32 allocationSize, PALLOCATION_HANDLE pAllocationHandle)
+STATUS checkStreamLatencyPressure(PKinesisVideoStream pKinesisVideoStream)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PKinesisVideoClient pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    UINT64 duration;
 
-    while (TRUE) {
-        // Check if we have enough space to proceed - the stream should be locked
-        CHK_STATUS(checkForAvailability(pKinesisVideoStream, allocationSize, pAllocationHandle));
-
-        // Early return if available
-        CHK(!IS_VALID_ALLOCATION_HANDLE(*pAllocationHandle), STATUS_SUCCESS);
+    // We need to check for the latency pressure. If the view head is ahead of the current
+    // for more than the specified max latency then we need to call the optional user callback.
+    // NOTE: A special sentinel value is used to determine whether the latency is specified.
+    if (pKinesisVideoStream->streamInfo.streamCaps.maxLatency != STREAM_LATENCY_PRESSURE_CHECK_SENTINEL &&
+        pKinesisVideoClient->clientCallbacks.streamLatencyPressureFn != NULL) {
+        // Get the window duration from the view
+        CHK_STATUS(contentViewGetWindowDuration(pKinesisVideoStream->pView, &duration, NULL));
 
-        // if no space available, wait only if in OFFLINE mode or if we are going to evict the tail frames
-        CHK(pKinesisVideoStream->streamInfo.streamCaps.storePressurePolicy == CONTENT_STORE_PRESSURE_POLICY_DROP_TAIL_ITEM ||
-                IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType),
-            STATUS_SUCCESS);
+        // Check for the breach and invoke the user provided callback
+        if (duration > pKinesisVideoStream->streamInfo.streamCaps.maxLatency) {
+            pKinesisVideoStream->diagnostics.latencyPressures++;
 
-        if (IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
-            // Long path which will await for the availability notification or cancellation
-            CHK_STATUS(pKinesisVideoClient->clientCallbacks.waitConditionVariableFn(
-                pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->bufferAvailabilityCondition, pKinesisVideoStream->base.lock,
-                pKinesisVideoClient->deviceInfo.clientInfo.offlineBufferAvailabilityTimeout));
-        } else {
-            // Need to evict the tail frames by trimming the tail
-            CHK_STATUS(contentViewTrimTailItems(pKinesisVideoStream->pView));
+            CHK_STATUS(pKinesisVideoClient->clientCallbacks.streamLatencyPressureFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                                                    TO_STREAM_HANDLE(pKinesisVideoStream), duration));
         }
+    }
 
-        // Check for the stream termination
-        CHK(!pKinesisVideoStream->streamStopped && !pKinesisVideoStream->base.shutdown, STATUS_BLOCKING_PUT_INTERRUPTED_STREAM_TERMINATED);
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Notifies the application about the stream data available for the upload
+ * IMPORTANT: The stream and the store arena locks should be held
+ */
+STATUS notifyStreamDataAvailable(PKinesisVideoStream pKinesisVideoStream)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    PUploadHandleInfo pUploadHandleInfo;
+    UINT64 duration, viewByteSize;
+
+    // Notify about data is available
+    pUploadHandleInfo = getStreamUploadInfoWithState(pKinesisVideoStream, UPLOAD_HANDLE_STATE_READY | UPLOAD_HANDLE_STATE_STREAMING);
+    if (NULL != pUploadHandleInfo && IS_VALID_UPLOAD_HANDLE(pUploadHandleInfo->handle)) {
+        // Get the duration and the size
+        CHK_STATUS(getAvailableViewSize(pKinesisVideoStream, &duration, &viewByteSize));
+
+        // Call the notification callback
+        CHK_STATUS(pKinesisVideoClient->clientCallbacks.streamDataAvailableFn(
+            pKinesisVideoClient->clientCallbacks.customData, TO_STREAM_HANDLE(pKinesisVideoStream), pKinesisVideoStream->streamInfo.name,
+            pUploadHandleInfo->handle, duration, viewByteSize));
     }
 
 CleanUp:
@@ -1735,7 +2916,7 @@ CleanUp:
  * Checks for the availability of space in the content store and if there is enough duration
  * is available in the content view.
  *
- * IMPORTANT: The stream SHOULD be locked and the client is NOT locked
+ * IMPORTANT: The stream SHOULD be locked and the store arena is NOT locked
  *
  * All the parameters are assumed to have been sanitized.
  */
@@ -1744,8 +2925,8 @@ STATUS checkForAvailability(PKinesisVideoStream pKinesisVideoStream, UINT32 allo
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PKinesisVideoClient pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
-    BOOL clientLocked = FALSE, availability = FALSE;
-    UINT64 heapSize, availableHeapSize;
+    BOOL storeLocked = FALSE, availability = FALSE;
+    UINT64 availableHeapSize;
 
     // Set to invalid whether we failed to allocate or we don't have content view availability
     *pAllocationHandle = INVALID_ALLOCATION_HANDLE_VALUE;
@@ -1759,39 +2940,121 @@ STATUS checkForAvailability(PKinesisVideoStream pKinesisVideoStream, UINT32 allo
         CHK(availability, STATUS_SUCCESS);
     }
 
-    // Lock the client
-    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = TRUE;
-
-    // Get the heap size
-    CHK_STATUS(heapGetSize(pKinesisVideoClient->pHeap, &heapSize));
-
-    // Check for underflow
-    CHK(pKinesisVideoClient->deviceInfo.storageInfo.storageSize >
-            heapSize + MAX_ALLOCATION_OVERHEAD_SIZE + pKinesisVideoStream->maxFrameSizeSeen * FRAME_ALLOC_FRAGMENTATION_FACTOR,
-        STATUS_SUCCESS);
+    // Lock the store arena
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
 
-    // Check if we have enough space available. Adding maxFrameSizeSeen to handle fragmentation as well as when curl thread needs to alloc space for
-    // sending data.
-    availableHeapSize = pKinesisVideoClient->deviceInfo.storageInfo.storageSize - heapSize - MAX_ALLOCATION_OVERHEAD_SIZE -
-        (UINT64) (pKinesisVideoStream->maxFrameSizeSeen * FRAME_ALLOC_FRAGMENTATION_FACTOR);
+    CHK_STATUS(getAvailableStorageSize(pKinesisVideoStream, &availableHeapSize));
 
     // Early return if storage space is unavailable.
     CHK(availableHeapSize >= allocationSize, STATUS_SUCCESS);
 
     // Get the heap size. Do not need to check status. If heapAlloc failed then pAllocationHandle would remain invalid.
-    retStatus = heapAlloc(pKinesisVideoClient->pHeap, allocationSize, pAllocationHandle);
+    retStatus = heapAlloc(pKinesisVideoStream->pStoreArena->pHeap, allocationSize, pAllocationHandle);
     CHK(retStatus == STATUS_SUCCESS || retStatus == STATUS_NOT_ENOUGH_MEMORY, retStatus);
     retStatus = STATUS_SUCCESS;
 
-    // Unlock the client
-    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = FALSE;
+    // Unlock the store arena
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = FALSE;
 CleanUp:
 
-    // Unlock the client if locked.
-    if (clientLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+    // Unlock the store arena if locked.
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Gets the content store space available for the allocations.
+ *
+ * IMPORTANT: The store arena SHOULD be locked
+ */
+STATUS getAvailableStorageSize(PKinesisVideoStream pKinesisVideoStream, PUINT64 pAvailableSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 heapSize, reservedSize;
+
+    *pAvailableSize = 0;
+
+    // Get the heap size
+    CHK_STATUS(heapGetSize(pKinesisVideoStream->pStoreArena->pHeap, &heapSize));
+
+    // Reserving maxFrameSizeSeen to handle fragmentation as well as when curl thread needs to alloc space for sending data.
+    reservedSize = heapSize + MAX_ALLOCATION_OVERHEAD_SIZE + (UINT64) (pKinesisVideoStream->maxFrameSizeSeen * FRAME_ALLOC_FRAGMENTATION_FACTOR);
+
+    // Check for underflow
+    CHK(pKinesisVideoStream->pStoreArena->storageSize > reservedSize, STATUS_SUCCESS);
+
+    *pAvailableSize = pKinesisVideoStream->pStoreArena->storageSize - reservedSize;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Checks whether the frame can be put into the OFFLINE stream without waiting for the availability.
+ *
+ * IMPORTANT: The stream and the store arena are NOT locked
+ */
+STATUS checkFrameAvailability(PKinesisVideoStream pKinesisVideoStream, PFrame pFrame, PBOOL pAvailable)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PFragmentExtents pExtents;
+    BOOL streamLocked = FALSE, storeLocked = FALSE, availability = TRUE;
+    UINT64 availableSize, allocationSize;
+
+    CHK(pKinesisVideoStream != NULL && pFrame != NULL && pAvailable != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    // Only the OFFLINE streams wait for the availability
+    CHK(IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType), retStatus);
+
+    // Lock the stream
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    streamLocked = TRUE;
+
+    CHK_STATUS(contentViewCheckAvailability(pKinesisVideoStream->pView, &availability));
+    CHK(availability, retStatus);
+
+    // Lock the store arena
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
+
+    allocationSize = (UINT64) pFrame->size + PACKAGED_FRAME_OVERHEAD_ESTIMATE;
+    pExtents = &pKinesisVideoStream->fragmentExtents;
+    if (pExtents->pItemOffsets != NULL) {
+        // The frame is appended to the open extent unless it starts a new fragment
+        CHK(!IS_VALID_ALLOCATION_HANDLE(pExtents->handle) || CHECK_FRAME_FLAG_KEY_FRAME(pFrame->flags) ||
+                allocationSize > pExtents->size - pExtents->used,
+            retStatus);
+
+        allocationSize = MAX(allocationSize, pKinesisVideoStream->streamInfo.streamCaps.fragmentExtentSize);
+    }
+
+    CHK_STATUS(getAvailableStorageSize(pKinesisVideoStream, &availableSize));
+    availability = availableSize >= allocationSize;
+
+CleanUp:
+
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    }
+
+    if (pAvailable != NULL) {
+        *pAvailable = availability;
     }
 
     LEAVES();
@@ -2117,17 +3380,15 @@ STATUS streamStartFixupOnReconnect(PKinesisVideoStream pKinesisVideoStream)
     UINT64 curIndex;
     UINT64 streamStartTs;
     PViewItem pViewItem = NULL;
-    UINT32 headerSize, packagedSize, overallSize;
+    UINT32 headerSize, packagedSize, overallSize, extentOffset;
     UINT64 allocSize, currentItemCount, windowItemCount;
     PBYTE pAlloc = NULL, pFrame = NULL;
-    PKinesisVideoClient pKinesisVideoClient = NULL;
     ALLOCATION_HANDLE allocationHandle = INVALID_ALLOCATION_HANDLE_VALUE;
     ALLOCATION_HANDLE oldAllocationHandle;
+    BOOL releaseExtent = FALSE;
 
     CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
 
-    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
-
     // Fix-up the current item as it might be a stream start
     CHK_STATUS(resetCurrentViewItemStreamStart(pKinesisVideoStream));
 
@@ -2165,60 +3426,70 @@ STATUS streamStartFixupOnReconnect(PKinesisVideoStream pKinesisVideoStream)
     // Early termination if the item is already has a stream start indicator.
     CHK(!CHECK_ITEM_STREAM_START(pViewItem->flags), retStatus);
 
-    // Get the existing frame allocation
-    CHK_STATUS(heapMap(pKinesisVideoClient->pHeap, pViewItem->handle, (PVOID*) &pFrame, &allocSize));
+    // Get the existing frame allocation. We only copy out of it
+    CHK_STATUS(heapMapReadOnly(pKinesisVideoStream->pStoreArena->pHeap, pViewItem->handle, (PVOID*) &pFrame, &allocSize));
     CHK(allocSize < MAX_UINT32, STATUS_INVALID_ALLOCATION_SIZE);
     packagedSize = pViewItem->length;
     CHK(pFrame != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    extentOffset = getViewItemExtentOffset(pKinesisVideoStream, pViewItem);
+    CHK(extentOffset + packagedSize <= allocSize, STATUS_VIEW_ITEM_SIZE_GREATER_THAN_ALLOCATION);
 
     // Allocate storage for the frame
     overallSize = packagedSize + headerSize;
-    CHK_STATUS(heapAlloc(pKinesisVideoClient->pHeap, overallSize, &allocationHandle));
+    CHK_STATUS(heapAlloc(pKinesisVideoStream->pStoreArena->pHeap, overallSize, &allocationHandle));
 
     // Ensure we have space and if not then bail
     CHK(IS_VALID_ALLOCATION_HANDLE(allocationHandle), STATUS_STORE_OUT_OF_MEMORY);
 
     // Map the storage
-    CHK_STATUS(heapMap(pKinesisVideoClient->pHeap, allocationHandle, (PVOID*) &pAlloc, &allocSize));
+    CHK_STATUS(heapMap(pKinesisVideoStream->pStoreArena->pHeap, allocationHandle, (PVOID*) &pAlloc, &allocSize));
     CHK(overallSize == (UINT32) allocSize, STATUS_INTERNAL_ERROR);
 
     // Actually package the bits in the storage
     CHK_STATUS(mkvgenGenerateHeader(pKinesisVideoStream->pMkvGenerator, pAlloc, &headerSize, &streamStartTs));
 
     // Copy the rest of the packaged frame which will include the possible tags and the cluster info
-    MEMCPY(pAlloc + headerSize, pFrame, packagedSize);
+    MEMCPY(pAlloc + headerSize, pFrame + extentOffset, packagedSize);
 
     // At this stage we are done and need to swap the allocation handle with the old one so it can be freed later
     // in the cleanup clause. The idea is to free either old one if all OK or the new one if something failed.
+    // The item no longer references the extent if it was stored in one.
     oldAllocationHandle = pViewItem->handle;
     pViewItem->handle = allocationHandle;
     allocationHandle = oldAllocationHandle;
+    if (CHECK_ITEM_FRAGMENT_EXTENT(pViewItem->flags)) {
+        CLEAR_ITEM_FRAGMENT_EXTENT(pViewItem->flags);
+        releaseExtent = TRUE;
+    }
     SET_ITEM_STREAM_START(pViewItem->flags);
     SET_ITEM_STREAM_START_DEBUG(pViewItem->flags);
     SET_ITEM_DATA_OFFSET(pViewItem->flags, headerSize);
-    pViewItem->length = overallSize;
+    CHK_STATUS(contentViewSetItemLength(pKinesisVideoStream->pView, pViewItem->index, overallSize));
+    journalViewItem(pKinesisVideoStream->pJournal, pViewItem);
 
     // We will unmap the allocations while holding the lock
-    CHK_STATUS(heapUnmap(pKinesisVideoClient->pHeap, (PVOID) pFrame));
+    CHK_STATUS(heapUnmapReadOnly(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pFrame));
     pFrame = NULL;
-    CHK_STATUS(heapUnmap(pKinesisVideoClient->pHeap, (PVOID) pAlloc));
+    CHK_STATUS(heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pAlloc));
     pAlloc = NULL;
 
 CleanUp:
 
     // Unmap the old mapping
     if (pFrame != NULL) {
-        heapUnmap(pKinesisVideoClient->pHeap, (PVOID) pFrame);
+        heapUnmapReadOnly(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pFrame);
     }
 
     // Unmap the new mapping
     if (pAlloc != NULL) {
-        heapUnmap(pKinesisVideoClient->pHeap, (PVOID) pAlloc);
+        heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pAlloc);
     }
 
     // Clear up the previous allocation handle
-    if (IS_VALID_ALLOCATION_HANDLE(allocationHandle)) {
-        heapFree(pKinesisVideoClient->pHeap, allocationHandle);
+    if (releaseExtent) {
+        releaseFragmentExtent(pKinesisVideoStream, allocationHandle);
+    } else if (IS_VALID_ALLOCATION_HANDLE(allocationHandle)) {
+        heapFree(pKinesisVideoStream->pStoreArena->pHeap, allocationHandle);
     }
 
     LEAVES();
@@ -2230,7 +3501,7 @@ STATUS resetCurrentViewItemStreamStart(PKinesisVideoStream pKinesisVideoStream)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PViewItem pViewItem = NULL;
-    BOOL streamLocked = FALSE, clientLocked = FALSE;
+    BOOL streamLocked = FALSE, storeLocked = FALSE;
     UINT32 packagedSize, overallSize, dataOffset;
     UINT64 allocSize;
     PBYTE pFrame = NULL;
@@ -2240,14 +3511,14 @@ STATUS resetCurrentViewItemStreamStart(PKinesisVideoStream pKinesisVideoStream)
 
     pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
 
-    // Lock the client
-    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = TRUE;
-
     // Lock the stream
     pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
     streamLocked = TRUE;
 
+    // Lock the store arena
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
+
     // Quick check if we need to do anything by checking the current view items allocation handle
     // and whether it has a stream start indicator. Early exit if it's not a stream start.
     CHK(IS_VALID_ALLOCATION_HANDLE(pKinesisVideoStream->curViewItem.viewItem.handle) &&
@@ -2260,21 +3531,29 @@ STATUS resetCurrentViewItemStreamStart(PKinesisVideoStream pKinesisVideoStream)
     // As we are removing the MKV header, the resulting allocation size will be actually smaller
     // We will simply copy/shift the data, including the MKV tags if any and the cluster header
     // forward and will set the size of the allocation
-
-    // Get the existing frame allocation
-    CHK_STATUS(heapMap(pKinesisVideoClient->pHeap, pViewItem->handle, (PVOID*) &pFrame, &allocSize));
-    CHK(allocSize < MAX_UINT32 && (UINT32) allocSize >= pViewItem->length, STATUS_INVALID_ALLOCATION_SIZE);
-
     packagedSize = pViewItem->length;
-    CHK(pFrame != NULL, STATUS_NOT_ENOUGH_MEMORY);
 
     // Calculate the overall size by subtracting the offset
     dataOffset = GET_ITEM_DATA_OFFSET(pViewItem->flags);
     overallSize = packagedSize - dataOffset;
 
-    // NOTE: we need to move the frame bits forward - can't use memcpy due to undefined
-    // behavior when copying overlapping ranges.
-    MEMMOVE(pFrame, pFrame + dataOffset, overallSize);
+    if (CHECK_ITEM_FRAGMENT_EXTENT(pViewItem->flags)) {
+        // The slice of the extent simply starts past the header
+        pKinesisVideoStream->fragmentExtents.pItemOffsets[pViewItem->index % pKinesisVideoStream->fragmentExtents.itemCount] += dataOffset;
+    } else {
+        // Get the existing frame allocation
+        CHK_STATUS(heapMap(pKinesisVideoStream->pStoreArena->pHeap, pViewItem->handle, (PVOID*) &pFrame, &allocSize));
+        CHK(allocSize < MAX_UINT32 && (UINT32) allocSize >= pViewItem->length, STATUS_INVALID_ALLOCATION_SIZE);
+        CHK(pFrame != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+        // NOTE: we need to move the frame bits forward - can't use memcpy due to undefined
+        // behavior when copying overlapping ranges.
+        MEMMOVE(pFrame, pFrame + dataOffset, overallSize);
+
+        // No need to set the size of the actual allocation - just unmap
+        CHK_STATUS(heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, pFrame));
+        pFrame = NULL;
+    }
 
     // Set the old allocation handle to be freed
     CLEAR_ITEM_STREAM_START(pViewItem->flags);
@@ -2289,23 +3568,20 @@ STATUS resetCurrentViewItemStreamStart(PKinesisVideoStream pKinesisVideoStream)
     }
 
     // Set the new length in the view
-    pViewItem->length = overallSize;
-
-    // No need to set the size of the actual allocation - just unmap
-    CHK_STATUS(heapUnmap(pKinesisVideoClient->pHeap, pFrame));
-    pFrame = NULL;
+    CHK_STATUS(contentViewSetItemLength(pKinesisVideoStream->pView, pViewItem->index, overallSize));
+    journalViewItem(pKinesisVideoStream->pJournal, pViewItem);
 
     // Re-set back the current
     pKinesisVideoStream->curViewItem.viewItem = *pViewItem;
 
+    // Unlock the store arena
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = FALSE;
+
     // Unlock the stream (even though it will be unlocked in the cleanup
     pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
     streamLocked = FALSE;
 
-    // Unlock the client
-    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-    clientLocked = FALSE;
-
 CleanUp:
 
     /* fix up retStatus if contentViewGetItemAt could not find curViewItem */
@@ -2315,24 +3591,25 @@ CleanUp:
 
     // Unmap the handle if not yet unmapped
     if (pFrame != NULL) {
-        if (!clientLocked) {
+        if (!storeLocked) {
             // Need to re-acquire the lock
-            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+            pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
         }
 
-        heapUnmap(pKinesisVideoClient->pHeap, (PVOID) pFrame);
-        if (!clientLocked) {
-            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
-            clientLocked = FALSE;
+        heapUnmap(pKinesisVideoStream->pStoreArena->pHeap, (PVOID) pFrame);
+        if (!storeLocked) {
+            pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                               pKinesisVideoStream->pStoreArena->lock);
+            storeLocked = FALSE;
         }
     }
 
-    if (streamLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
     }
 
-    if (clientLocked) {
-        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoClient->base.lock);
+    if (streamLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
     }
 
     LEAVES();
@@ -2348,20 +3625,14 @@ STATUS getNextBoundaryViewItem(PKinesisVideoStream pKinesisVideoStream, PViewIte
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PViewItem pViewItem = NULL;
-    BOOL iterate = TRUE;
 
     CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL && ppViewItem != NULL, STATUS_NULL_ARG);
 
     // Set the result to null first
     *ppViewItem = NULL;
 
-    // Iterate until we find a key frame item.
-    while (iterate) {
-        CHK_STATUS(getNextViewItem(pKinesisVideoStream, &pViewItem));
-        if (CHECK_ITEM_FRAGMENT_START(pViewItem->flags) || CHECK_ITEM_FRAGMENT_END(pViewItem->flags)) {
-            iterate = FALSE;
-        }
-    }
+    // Look up the next key frame item in the boundary index of the view.
+    CHK_STATUS(contentViewGetNextBoundary(pKinesisVideoStream->pView, &pViewItem));
 
     // Assign the return value
     *ppViewItem = pViewItem;
@@ -2651,6 +3922,7 @@ STATUS streamFragmentPersistedAck(PKinesisVideoStream pKinesisVideoStream, UINT6
     // Get the fragment start frame.
     CHK_STATUS(contentViewGetItemWithTimestamp(pKinesisVideoStream->pView, timestamp, TRUE, &pCurItem));
     SET_ITEM_PERSISTED_ACK(pCurItem->flags);
+    journalViewItem(pKinesisVideoStream->pJournal, pCurItem);
 
     // Iterate linearly and find the first ready state handle
     CHK_STATUS(stackQueueGetIterator(pKinesisVideoStream->pUploadInfoQueue, &iterator));
@@ -2730,6 +4002,11 @@ STATUS streamFragmentPersistedAck(PKinesisVideoStream pKinesisVideoStream, UINT6
     if (IS_OFFLINE_STREAMING_MODE(pKinesisVideoStream->streamInfo.streamCaps.streamingType)) {
         pKinesisVideoClient->clientCallbacks.broadcastConditionVariableFn(pKinesisVideoClient->clientCallbacks.customData,
                                                                           pKinesisVideoStream->bufferAvailabilityCondition);
+
+        // The put frame worker leaves the frames in the ring until there is space for them
+        if (!putFrameRingIsEmpty(pKinesisVideoStream)) {
+            putFrameWorkerWakeup(pKinesisVideoStream);
+        }
     }
 CleanUp:
 
@@ -2953,30 +4230,6 @@ CleanUp:
     return retStatus;
 }
 
-/**
- * Converts the stream to a stream handle
- */
-STREAM_HANDLE toStreamHandle(PKinesisVideoStream pKinesisVideoStream)
-{
-    if (pKinesisVideoStream == NULL) {
-        return INVALID_STREAM_HANDLE_VALUE;
-    } else {
-        return (STREAM_HANDLE) &pKinesisVideoStream->pKinesisVideoClient->streams[pKinesisVideoStream->streamId];
-    }
-}
-
-/**
- * Converts handle to a stream
- */
-PKinesisVideoStream fromStreamHandle(STREAM_HANDLE streamHandle)
-{
-    if (streamHandle == INVALID_STREAM_HANDLE_VALUE) {
-        return NULL;
-    } else {
-        return *((PKinesisVideoStream*) streamHandle);
-    }
-}
-
 /**
  * Packages the stream metadata.
  */
@@ -3171,6 +4424,21 @@ CleanUp:
     return retStatus;
 }
 
+VOID releasePackagedMetadata(PKinesisVideoStream pKinesisVideoStream)
+{
+    PBYTE pData = pKinesisVideoStream->metadataTracker.data;
+
+    pKinesisVideoStream->metadataTracker.data = NULL;
+
+    // Only the buffer packaged before the segments have been handed out can be aliased by them
+    // as no data can be consumed until they are released so a single retired buffer is kept.
+    if (pKinesisVideoStream->segmentsOutstanding && pKinesisVideoStream->pRetiredMetadata == NULL) {
+        pKinesisVideoStream->pRetiredMetadata = pData;
+    } else {
+        SAFE_MEMFREE(pData);
+    }
+}
+
 STATUS packageNotSentMetadata(PKinesisVideoStream pKinesisVideoStream)
 {
     ENTERS();
@@ -3251,10 +4519,7 @@ STATUS packageNotSentMetadata(PKinesisVideoStream pKinesisVideoStream)
     pKinesisVideoStream->metadataTracker.send = TRUE;
     pKinesisVideoStream->metadataTracker.size = overallSize;
     pKinesisVideoStream->metadataTracker.offset = 0;
-    if (pKinesisVideoStream->metadataTracker.data != NULL) {
-        MEMFREE(pKinesisVideoStream->metadataTracker.data);
-    }
-
+    releasePackagedMetadata(pKinesisVideoStream);
     pKinesisVideoStream->metadataTracker.data = pBuffer;
 
 CleanUp:
@@ -3357,6 +4622,72 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Demotes the view items behind the current to the slower storage tier.
+ *
+ * The items between the tail and the current are only needed on re-transmission so the content store
+ * can move them out of memory, keeping the memory for the send frontier and the incoming frames.
+ * The item being sent is skipped as its handle is cached in the current view item.
+ *
+ * The walk resumes from the stream's demotion cursor so the demoted items are not visited again.
+ * The cursor stops at the first item left in memory - the one being sent, pinned or not moved as the in-memory tier
+ * was below the watermark or the file tier was full - so it is demoted on a later call.
+ *
+ * IMPORTANT: The stream lock and the store arena lock need to be held in this order as the heap is accessed.
+ */
+STATUS demoteSentViewItems(PKinesisVideoStream pKinesisVideoStream, UINT32 watermark)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PViewItem pViewItem = NULL;
+    UINT64 index, currentIndex, resumeIndex;
+    ALLOCATION_HANDLE handle;
+    BOOL demoted;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    // Early return if the view is empty
+    CHK(STATUS_SUCCEEDED(contentViewGetTail(pKinesisVideoStream->pView, &pViewItem)), retStatus);
+    CHK_STATUS(contentViewGetCurrentIndex(pKinesisVideoStream->pView, &currentIndex));
+
+    // The items behind the cursor which are still in the view have already been visited
+    resumeIndex = currentIndex;
+    for (index = MAX(pViewItem->index, pKinesisVideoStream->demoteIndex); index < currentIndex; index++) {
+        if (IS_VALID_ALLOCATION_HANDLE(pKinesisVideoStream->curViewItem.viewItem.handle) &&
+            index == pKinesisVideoStream->curViewItem.viewItem.index) {
+            resumeIndex = MIN(resumeIndex, index);
+            continue;
+        }
+
+        CHK_STATUS(contentViewGetItemAt(pKinesisVideoStream->pView, index, &pViewItem));
+
+        // Dropped items have their allocations already freed and the pinned allocations can't be moved until released.
+        // The extents are shared with the items which are yet to be sent so they stay in place.
+        if (IS_VALID_ALLOCATION_HANDLE(pViewItem->handle) && !CHECK_ITEM_FRAGMENT_EXTENT(pViewItem->flags)) {
+            if (getPinnedAllocation(pKinesisVideoStream, pViewItem->handle) != NULL) {
+                resumeIndex = MIN(resumeIndex, index);
+                continue;
+            }
+
+            handle = pViewItem->handle;
+            CHK_STATUS(heapDemote(pKinesisVideoStream->pStoreArena->pHeap, &pViewItem->handle, watermark, &demoted));
+
+            if (!demoted) {
+                resumeIndex = MIN(resumeIndex, index);
+            } else if (handle != pViewItem->handle) {
+                journalViewItem(pKinesisVideoStream->pJournal, pViewItem);
+            }
+        }
+    }
+
+    pKinesisVideoStream->demoteIndex = resumeIndex;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS getAvailableViewSize(PKinesisVideoStream pKinesisVideoStream, PUINT64 pDuration, PUINT64 pViewSize)
 {
     ENTERS();
@@ -3456,6 +4787,18 @@ STATUS resetStream(PKinesisVideoStream pKinesisVideoStream)
     // Trim all the buffer to head
     CHK_STATUS_CONTINUE(contentViewRemoveAll(pKinesisVideoStream->pView));
 
+    // Drop the pending lace
+    pKinesisVideoStream->lacedFrames.frameCount = 0;
+    pKinesisVideoStream->lacedFrames.dataSize = 0;
+    CHK_STATUS_CONTINUE(disarmLaceTimer(pKinesisVideoStream));
+
+    // Release the open extent as the view has dropped its items
+    if (pKinesisVideoStream->fragmentExtents.pItemOffsets != NULL) {
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+        CHK_STATUS_CONTINUE(closeFragmentExtent(pKinesisVideoStream));
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
     CHK_STATUS_CONTINUE(freeStackQueue(pKinesisVideoStream->pMetadataQueue, FALSE));
     CHK_STATUS_CONTINUE(freeStackQueue(pKinesisVideoStream->pUploadInfoQueue, FALSE));
 
@@ -3483,6 +4826,11 @@ STATUS resetStream(PKinesisVideoStream pKinesisVideoStream)
     pKinesisVideoStream->streamStopped = FALSE;
     pKinesisVideoStream->streamClosed = FALSE;
 
+    // Accept the async frames again
+    if (pKinesisVideoStream->pPutFrameRing != NULL) {
+        ATOMIC_STORE_BOOL(&pKinesisVideoStream->pPutFrameRing->closed, FALSE);
+    }
+
     // Set the stream start timestamps and index
     pKinesisVideoStream->newSessionTimestamp = INVALID_TIMESTAMP_VALUE;
     pKinesisVideoStream->newSessionIndex = INVALID_VIEW_INDEX_VALUE;
@@ -3524,11 +4872,7 @@ STATUS resetStream(PKinesisVideoStream pKinesisVideoStream)
     pKinesisVideoStream->metadataTracker.size = 0;
     pKinesisVideoStream->metadataTracker.offset = 0;
     pKinesisVideoStream->metadataTracker.send = FALSE;
-    if (pKinesisVideoStream->metadataTracker.data != NULL) {
-        MEMFREE(pKinesisVideoStream->metadataTracker.data);
-    }
-
-    pKinesisVideoStream->metadataTracker.data = NULL;
+    releasePackagedMetadata(pKinesisVideoStream);
 
     // Reset mkv generator
     mkvgenResetGenerator(pKinesisVideoStream->pMkvGenerator);
@@ -3598,6 +4942,8 @@ VOID logStreamInfo(PStreamInfo pStreamInfo)
     DLOGD("\tStore Pressure Policy: %u", pStreamInfo->streamCaps.storePressurePolicy);
     DLOGD("\tView Overflow Policy: %u", pStreamInfo->streamCaps.viewOverflowPolicy);
     DLOGD("\tAllow stream creation: %s", pStreamInfo->streamCaps.allowStreamCreation ? "Yes" : "No");
+    DLOGD("\tAudio lacing duration: %" PRIu64, pStreamInfo->streamCaps.audioLacingDuration);
+    DLOGD("\tFragment extent size: %u", pStreamInfo->streamCaps.fragmentExtentSize);
 
     if (pStreamInfo->streamCaps.segmentUuid != NULL) {
         hasSegmentUUID = TRUE;
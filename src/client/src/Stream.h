@@ -73,11 +73,21 @@ extern "C" {
  */
 #define MAX_ALLOCATION_OVERHEAD_SIZE 100
 
+/**
+ * Estimate of the MKV packaging bloat of a frame when checking for the availability ahead of packaging it
+ */
+#define PACKAGED_FRAME_OVERHEAD_ESTIMATE 256
+
 /**
  * Max wait time for the blocking put frame. An persisted ack should come back within this period.
  */
 #define MAX_BLOCKING_PUT_WAIT 15 * HUNDREDS_OF_NANOS_IN_A_SECOND
 
+/**
+ * Max number of the audio frames laced into a single block
+ */
+#define MAX_LACED_FRAME_COUNT 32
+
 /**
  * Valid status codes from get stream data
  */
@@ -197,6 +207,111 @@ struct __CurrentViewItem {
 };
 typedef struct __CurrentViewItem* PCurrentViewItem;
 
+/**
+ * Allocation mapped for the stream data segments which have been handed out to the caller
+ */
+typedef struct __PinnedAllocation PinnedAllocation;
+struct __PinnedAllocation {
+    // The allocation handle
+    ALLOCATION_HANDLE handle;
+
+    // Read-only mapping of the allocation
+    PVOID pAllocation;
+
+    // Whether the view item has been removed in which case the allocation is freed on release
+    BOOL removed;
+};
+typedef struct __PinnedAllocation* PPinnedAllocation;
+
+/**
+ * Frame buffer acquired by the encoder to produce the frame payload directly in the content store
+ */
+typedef struct __AcquiredFrameBuffer AcquiredFrameBuffer;
+struct __AcquiredFrameBuffer {
+    // The allocation handle
+    ALLOCATION_HANDLE handle;
+
+    // Writable mapping of the allocation
+    PBYTE pAllocation;
+
+    // Size of the allocation
+    UINT32 size;
+
+    // Size of the MKV header bits reserved in front of the payload
+    UINT32 headerSize;
+};
+typedef struct __AcquiredFrameBuffer* PAcquiredFrameBuffer;
+
+/**
+ * Consecutive frames of an audio track accumulated to be laced into a single block
+ */
+typedef struct __LacedFrames LacedFrames;
+struct __LacedFrames {
+    // Number of the accumulated frames
+    UINT32 frameCount;
+
+    // The accumulated frames. The frame data is stored back to back in the data buffer.
+    Frame frames[MAX_LACED_FRAME_COUNT];
+
+    // Buffer holding the copies of the frame data
+    PBYTE pData;
+
+    // Size of the stored frame data
+    UINT32 dataSize;
+
+    // Size of the data buffer
+    UINT32 dataAllocationSize;
+
+    // Time the first frame has been accumulated at. The lace is put by the timer once the lacing duration elapses.
+    UINT64 startTime;
+};
+typedef struct __LacedFrames* PLacedFrames;
+
+/**
+ * Content store extents shared by the view items of a fragment. The packaged frames of the fragment
+ * are appended into the open extent and the view items reference their slice of it.
+ */
+typedef struct __FragmentExtents FragmentExtents;
+struct __FragmentExtents {
+    // The open extent the packaged frames are appended to
+    ALLOCATION_HANDLE handle;
+
+    // Reserved size of the open extent
+    UINT32 size;
+
+    // Bytes of the open extent taken by the packaged frames
+    UINT32 used;
+
+    // Index of the first view item in the open extent
+    UINT64 firstIndex;
+
+    // Number of the view items referencing the extent keyed by the extent handle
+    PHashTable pRefCounts;
+
+    // Offsets of the view items in their extents indexed by the view item index modulo the item count
+    PUINT32 pItemOffsets;
+
+    // Number of the item offsets which is the max number of the items in the view
+    UINT32 itemCount;
+};
+typedef struct __FragmentExtents* PFragmentExtents;
+
+/**
+ * State of a batch of frames sharing the per-frame housekeeping
+ */
+typedef struct __PutFrameBatch PutFrameBatch;
+struct __PutFrameBatch {
+    // Current time sampled once for the batch
+    UINT64 currentTime;
+
+    // Number of frames put into the view
+    UINT32 frameCount;
+
+    // Whether any of the frames started a new fragment
+    BOOL fragmentStarted;
+};
+typedef struct __PutFrameBatch* PPutFrameBatch;
+
 /**
  * Helper structure storing and tracking metadata.
  */
@@ -344,6 +459,9 @@ struct __KinesisVideoStream {
     // Content view object for the stream
     PContentView pView;
 
+    // Journal of the view items persisted across the restarts. NULL if the storage is not persistent
+    PStreamJournal pJournal;
+
     // MKV stream generator
     PMkvGenerator pMkvGenerator;
 
@@ -386,6 +504,9 @@ struct __KinesisVideoStream {
     // Current view item
     CurrentViewItem curViewItem;
 
+    // Index of the view item to resume the demotion of the sent content from
+    UINT64 demoteIndex;
+
     // Current EOS sending tracker
     MetadataTracker eosTracker;
 
@@ -442,8 +563,52 @@ struct __KinesisVideoStream {
     // Manage the order of frames being put depending on FRAME_ORDER_MODE in streamCaps
     PFrameOrderCoordinator pFrameOrderCoordinator;
 
+    // Track id to index map of the stream caps track info list
+    TrackIndexMap trackIndexMap;
+
     // Last PutFrame timestamp
     UINT64 lastPutFrameTimestamp;
+
+    // Links of the stream in the EoFR timer wheel bucket and the bucket. Guarded by the wheel lock.
+    PKinesisVideoStream pNextEofrTimer;
+    PKinesisVideoStream pPrevEofrTimer;
+    UINT32 eofrTimerBucket;
+
+    // Whether the automatic EoFR deadline is armed. Set under the wheel lock.
+    volatile BOOL eofrTimerArmed;
+
+    // Links of the stream in the lace deadline list and the deadline of its pending lace. Guarded by the lace timers lock.
+    PKinesisVideoStream pNextLaceTimer;
+    PKinesisVideoStream pPrevLaceTimer;
+    UINT64 laceDeadline;
+
+    // Whether the lace deadline is armed. Set under the lace timers lock.
+    volatile BOOL laceTimerArmed;
+
+    // Whether the stream data segments have been handed out to the caller and not yet released
+    BOOL segmentsOutstanding;
+
+    // Allocations pinned by the outstanding stream data segments
+    UINT32 pinnedAllocationCount;
+    PinnedAllocation pinnedAllocations[MAX_STREAM_DATA_SEGMENT_COUNT];
+
+    // Packaged metadata buffer released while the outstanding stream data segments might point into it
+    PBYTE pRetiredMetadata;
+
+    // Frame buffer handed out to the encoder and not yet committed. The handle is invalid if none.
+    AcquiredFrameBuffer acquiredFrameBuffer;
+
+    // Audio frames pending to be laced into a single block
+    LacedFrames lacedFrames;
+
+    // Per-fragment content store extents. Enabled when the item offsets are allocated.
+    FragmentExtents fragmentExtents;
+
+    // The arena of the content store the stream stores the frames into
+    PStoreArena pStoreArena;
+
+    // Ingestion ring of the async putFrame mode. NULL if the frames are put synchronously.
+    PPutFrameRing pPutFrameRing;
 };
 
 /**
@@ -548,6 +713,68 @@ STATUS stopStreamSync(PKinesisVideoStream);
  */
 STATUS putFrame(PKinesisVideoStream, PFrame);
 
+/**
+ * Puts a batch of frames into the stream amortizing the per-frame housekeeping.
+ *
+ * @param 1 PKinesisVideoStream - Kinesis Video stream object.
+ * @param 2 PFrame - The frames to process.
+ * @param 3 UINT32 - Number of the frames.
+ * @param 4 PSTATUS - OUT OPT - Per-frame statuses.
+ *
+ * @return Status of the function call - the first failed frame status if any.
+ */
+STATUS putFrames(PKinesisVideoStream, PFrame, UINT32, PSTATUS);
+
+/**
+ * Reserves the storage for a frame which will be produced directly into the content store.
+ *
+ * @param 1 PKinesisVideoStream - Kinesis Video stream object.
+ * @param 2 PFrame - The frame descriptor. The frame size is the max payload size or 0 to use the max frame size seen.
+ * @param 3 PBYTE* - OUT - Writable buffer for the frame payload.
+ * @param 4 PUINT32 - OUT - Size of the payload buffer.
+ *
+ * @return Status of the function call.
+ */
+STATUS acquireFrameBuffer(PKinesisVideoStream, PFrame, PBYTE*, PUINT32);
+
+/**
+ * Packages the frame produced into the acquired buffer and puts it into the stream without copying the payload.
+ *
+ * @param 1 PKinesisVideoStream - Kinesis Video stream object.
+ * @param 2 PFrame - The frame with the data pointing to the acquired buffer.
+ *
+ * @return Status of the function call.
+ */
+STATUS commitFrameBuffer(PKinesisVideoStream, PFrame);
+
+/**
+ * Frees the acquired frame buffer without putting the frame.
+ *
+ * @param 1 PKinesisVideoStream - Kinesis Video stream object.
+ *
+ * @return Status of the function call.
+ */
+STATUS discardFrameBuffer(PKinesisVideoStream);
+
+/**
+ * Internal functionality
+ */
+STATUS putFrameInternal(PKinesisVideoStream, PFrame, PAcquiredFrameBuffer, PPutFrameBatch);
+STATUS freeAcquiredFrameBuffer(PKinesisVideoStream);
+BOOL canLaceFrame(PKinesisVideoStream, PFrame, PTrackInfo, PAcquiredFrameBuffer);
+STATUS appendLacedFrame(PKinesisVideoStream, PFrame);
+STATUS flushLacedFrames(PKinesisVideoStream, PPutFrameBatch);
+STATUS flushExpiredLacedFrames(PKinesisVideoStream, UINT64);
+STATUS reserveFragmentExtent(PKinesisVideoStream, UINT32, BOOL, PALLOCATION_HANDLE, PUINT32);
+STATUS resizeFragmentExtent(PKinesisVideoStream, UINT32);
+STATUS closeFragmentExtent(PKinesisVideoStream);
+STATUS releaseFragmentExtent(PKinesisVideoStream, ALLOCATION_HANDLE);
+UINT32 getViewItemExtentOffset(PKinesisVideoStream, PViewItem);
+VOID freeStoreAllocation(PKinesisVideoStream, ALLOCATION_HANDLE);
+STATUS checkStreamStoragePressures(PKinesisVideoStream);
+STATUS checkStreamLatencyPressure(PKinesisVideoStream);
+STATUS notifyStreamDataAvailable(PKinesisVideoStream);
+
 /**
  * Puts a metadata into the stream.
  *
@@ -699,6 +926,15 @@ PUploadHandleInfo getStreamUploadInfo(PKinesisVideoStream, UPLOAD_HANDLE);
  */
 STATUS getAvailableViewSize(PKinesisVideoStream, PUINT64, PUINT64);
 
+/**
+ * Demotes the already sent view items to the slower storage tier of the content store
+ *
+ * @param 1 - IN - KVS stream object
+ * @param 2 - IN - In-memory storage usage percentage at or above which to demote
+ * @return Status code of the operation
+ */
+STATUS demoteSentViewItems(PKinesisVideoStream, UINT32);
+
 /**
  * Await for the frame availability in OFFLINE mode
  *
@@ -715,6 +951,30 @@ STATUS handleAvailability(PKinesisVideoStream pKinesisVideoStream, UINT32 alloca
  */
 STATUS checkForAvailability(PKinesisVideoStream, UINT32, PALLOCATION_HANDLE);
 
+/**
+ * Gets the content store space available for the allocations less the reserve for the fragmentation.
+ * IMPORTANT: The store arena should be locked
+ *
+ * @param 1 - IN - KVS stream object
+ * @param 2 - OUT - Available size
+ * @return Status code of the operation
+ */
+STATUS getAvailableStorageSize(PKinesisVideoStream, PUINT64);
+
+/**
+ * Checks whether the frame can be put into the OFFLINE stream without waiting for the availability.
+ * Nothing is allocated and the packaged size is estimated. The frames are always available for the
+ * streams in the other modes as they never wait.
+ *
+ * IMPORTANT: The stream and the store arena should NOT be locked
+ *
+ * @param 1 - IN - KVS stream object
+ * @param 2 - IN - Frame to be put
+ * @param 3 - OUT - Whether the frame can be put without waiting
+ * @return Status code of the operation
+ */
+STATUS checkFrameAvailability(PKinesisVideoStream, PFrame, PBOOL);
+
 /**
  * Packages the stream metadata.
  *
@@ -755,6 +1015,15 @@ STATUS checkForNotSentMetadata(PKinesisVideoStream, PBOOL);
  */
 STATUS packageNotSentMetadata(PKinesisVideoStream);
 
+/**
+ * Releases the packaged metadata buffer before it's replaced or dropped.
+ *
+ * The buffer handed out in the outstanding stream data segments is retired and freed on their release.
+ *
+ * @param 1 - IN - KVS object
+ */
+VOID releasePackagedMetadata(PKinesisVideoStream);
+
 /**
  * Appends validated metadata name/value to the queue
  *
@@ -843,6 +1112,10 @@ STATUS streamFragmentErrorAck(PKinesisVideoStream, UINT64, UINT64, SERVICE_CALL_
 // Streaming event functions
 ///////////////////////////////////////////////////////////////////////////
 STATUS getStreamData(PKinesisVideoStream, UPLOAD_HANDLE, PBYTE, UINT32, PUINT32);
+STATUS getStreamDataSegments(PKinesisVideoStream, UPLOAD_HANDLE, UINT32, PStreamDataSegment, UINT32, PUINT32, PUINT32);
+STATUS releaseStreamDataSegments(PKinesisVideoStream);
+STATUS getStreamDataInternal(PKinesisVideoStream, UPLOAD_HANDLE, PBYTE, UINT32, PStreamDataSegment, UINT32, PUINT32, PUINT32);
+PPinnedAllocation getPinnedAllocation(PKinesisVideoStream, ALLOCATION_HANDLE);
 
 ///////////////////////////////////////////////////////////////////////////
 // State machine iterator
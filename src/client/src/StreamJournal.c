@@ -0,0 +1,506 @@
+/**
+ * Kinesis Video stream content journal functionality.
+ *
+ * The journal keeps a record of every view item and its storage allocation handle so the content residing in
+ * the persistent storage can be re-attached to the stream after the process restart. The records are written
+ * through on each view item change and are indexed the same way as the content view items so the journal file
+ * doesn't grow beyond the view size.
+ */
+#define LOG_CLASS "StreamJournal"
+
+#include "Include_i.h"
+
+/**
+ * Whether the record describes a live view item stored at the given record slot
+ */
+#define IS_VALID_STREAM_JOURNAL_RECORD(pRecord, slot, count)                                                                                         \
+    (IS_VALID_VIEW_INDEX((pRecord)->index) && IS_VALID_ALLOCATION_HANDLE((pRecord)->handle) && (pRecord)->index % (count) == (slot))
+
+STATUS createStreamJournal(PKinesisVideoStream pKinesisVideoStream, UINT32 itemCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PStreamJournal pJournal = NULL;
+    PStreamJournalHeader pRecords = NULL;
+    StreamJournalHeader header;
+    CHAR filePath[MAX_PATH_LEN + 1], tempFilePath[MAX_PATH_LEN + 1];
+    UINT64 size = 0;
+    INT32 retCode;
+    BOOL exists = FALSE;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    CHK(itemCount != 0, STATUS_INVALID_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%s" STREAM_JOURNAL_FILE_EXTENSION, getStreamJournalRootDirectory(pKinesisVideoClient),
+                       FPATHSEPARATOR, pKinesisVideoStream->streamInfo.name);
+    CHK(retCode > 0 && retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
+    retCode = SNPRINTF(tempFilePath, MAX_PATH_LEN + 1, "%s" STREAM_JOURNAL_TEMP_FILE_EXTENSION, filePath);
+    CHK(retCode > 0 && retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
+
+    // The new journal is only renamed over the previous one once it's been replayed. Without the previous
+    // journal the previous run has stopped in between removing it and renaming the new one so the new one is complete.
+    CHK_STATUS(fileExists(filePath, &exists));
+    if (!exists) {
+        CHK_STATUS(fileExists(tempFilePath, &exists));
+        CHK(!exists || 0 == FRENAME(tempFilePath, filePath), STATUS_OPEN_FILE_FAILED);
+    }
+
+    // Load the records of the previous run if any
+    if (exists) {
+        CHK_STATUS(readFile(filePath, TRUE, NULL, &size));
+        if (size >= SIZEOF(StreamJournalHeader)) {
+            CHK(NULL != (pRecords = (PStreamJournalHeader) MEMALLOC((SIZE_T) size)), STATUS_NOT_ENOUGH_MEMORY);
+            CHK_STATUS(readFile(filePath, TRUE, (PBYTE) pRecords, &size));
+        }
+    }
+
+    // The zeroed records are invalid similar to the records past the end of the file
+    CHK(NULL != (pJournal = (PStreamJournal) MEMCALLOC(1, SIZEOF(StreamJournal) + itemCount * (SIZEOF(ViewItem) + SIZEOF(BYTE)))),
+        STATUS_NOT_ENOUGH_MEMORY);
+    pJournal->pHeap = pKinesisVideoStream->pStoreArena->pHeap;
+    pJournal->itemCount = itemCount;
+    pJournal->pRecords = (PViewItem) (pJournal + 1);
+    pJournal->pDirty = (PBYTE) (pJournal->pRecords + itemCount);
+
+    // Start a new journal next to the previous one. The re-attached items are recorded again as they are added to the view.
+    CHK(NULL != (pJournal->pFile = FOPEN(tempFilePath, "wb+")), STATUS_OPEN_FILE_FAILED);
+    header.version = STREAM_JOURNAL_CURRENT_VERSION;
+    header.itemCount = itemCount;
+    CHK(1 == FWRITE(&header, SIZEOF(StreamJournalHeader), 1, pJournal->pFile) && 0 == FFLUSH(pJournal->pFile), STATUS_WRITE_TO_FILE_FAILED);
+
+    pKinesisVideoStream->pJournal = pJournal;
+
+    if (pRecords != NULL) {
+        CHK_STATUS(replayStreamJournal(pKinesisVideoStream, pRecords, size));
+    }
+
+    // The previous journal is kept until the new one has taken over the replayed content
+    CHK_STATUS(commitStreamJournal(pJournal, tempFilePath, filePath));
+    pJournal = NULL;
+
+CleanUp:
+
+    if (pJournal != NULL) {
+        if (pJournal->pFile != NULL) {
+            FCLOSE(pJournal->pFile);
+        }
+
+        MEMFREE(pJournal);
+        pKinesisVideoStream->pJournal = NULL;
+    }
+
+    SAFE_MEMFREE(pRecords);
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Re-attaches the content persisted by the previous run to the view.
+ *
+ * The oldest contiguous run of the recorded items is resumed starting from the first fragment which has not
+ * been persisted by the backend. The items which didn't make it to the persistent storage tier break the run
+ * and the rest of the recorded content is released. The resumed content is sent in a new session so it
+ * requires the absolute fragment timestamps.
+ */
+STATUS replayStreamJournal(PKinesisVideoStream pKinesisVideoStream, PStreamJournalHeader pHeader, UINT64 size)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PHeap pHeap = pKinesisVideoStream->pStoreArena->pHeap;
+    PViewItem pRecords = (PViewItem) (pHeader + 1), pRecord, pViewItem;
+    UINT64 index, startIndex = INVALID_VIEW_INDEX_VALUE, allocSize;
+    UINT32 i, count = pHeader->itemCount, recordCount, flags, resumed = 0, released = 0;
+    BOOL persisted, resume;
+
+    // Discard the journal if the format has changed
+    if (pHeader->version != STREAM_JOURNAL_CURRENT_VERSION || count == 0) {
+        DLOGW("[%s] Discarding incompatible stream journal", pKinesisVideoStream->streamInfo.name);
+        CHK(FALSE, retStatus);
+    }
+
+    // The records past the last written one are not in the file
+    recordCount = (UINT32) MIN(count, (size - SIZEOF(StreamJournalHeader)) / SIZEOF(ViewItem));
+
+    // Find the oldest recorded item
+    for (i = 0; i < recordCount; i++) {
+        if (IS_VALID_STREAM_JOURNAL_RECORD(&pRecords[i], i, count) && pRecords[i].index < startIndex) {
+            startIndex = pRecords[i].index;
+        }
+    }
+
+    CHK(IS_VALID_VIEW_INDEX(startIndex), retStatus);
+
+    resume = pKinesisVideoStream->streamInfo.streamCaps.absoluteFragmentTimes;
+    if (!resume) {
+        DLOGW("[%s] Persisted content can't be resumed with relative fragment timestamps", pKinesisVideoStream->streamInfo.name);
+    }
+
+    for (index = startIndex; index < startIndex + count; index++) {
+        if (index % count >= recordCount) {
+            break;
+        }
+
+        pRecord = &pRecords[index % count];
+        if (!IS_VALID_STREAM_JOURNAL_RECORD(pRecord, (UINT32) (index % count), count) || pRecord->index != index) {
+            break;
+        }
+
+        // Stop resuming at the first item which is not in the storage to keep the content contiguous
+        persisted = FALSE;
+        if (STATUS_SUCCEEDED(heapCheckPersisted(pHeap, pRecord->handle, &persisted)) && persisted &&
+            (STATUS_FAILED(heapGetAllocSize(pHeap, pRecord->handle, &allocSize)) || allocSize < pRecord->length)) {
+            DLOGW("[%s] Persisted allocation doesn't match the recorded item %" PRIu64, pKinesisVideoStream->streamInfo.name, index);
+            persisted = FALSE;
+        }
+
+        if (!persisted) {
+            resume = FALSE;
+            pRecord->handle = INVALID_ALLOCATION_HANDLE_VALUE;
+            continue;
+        }
+
+        // Skip to the first fragment which has not been persisted by the backend
+        if (resume && resumed == 0 && (!CHECK_ITEM_FRAGMENT_START(pRecord->flags) || CHECK_ITEM_PERSISTED_ACK(pRecord->flags))) {
+            continue;
+        }
+
+        if (!resume) {
+            continue;
+        }
+
+        // Reset the ACK flags as the content will be re-sent
+        flags = pRecord->flags;
+        CLEAR_ITEM_BUFFERING_ACK(flags);
+        CLEAR_ITEM_RECEIVED_ACK(flags);
+
+        if (STATUS_FAILED(retStatus = contentViewAddItem(pKinesisVideoStream->pView, pRecord->timestamp, pRecord->ackTimestamp,
+                                                         pRecord->duration, pRecord->handle, GET_ITEM_DATA_OFFSET(flags), pRecord->length, flags))) {
+            DLOGW("[%s] Failed to resume the persisted item %" PRIu64 " with 0x%08x", pKinesisVideoStream->streamInfo.name, index, retStatus);
+            retStatus = STATUS_SUCCESS;
+            resume = FALSE;
+            continue;
+        }
+
+        // The view owns the allocation now
+        pRecord->handle = INVALID_ALLOCATION_HANDLE_VALUE;
+        resumed++;
+
+        CHK_STATUS(contentViewGetHead(pKinesisVideoStream->pView, &pViewItem));
+        journalViewItem(pKinesisVideoStream->pJournal, pViewItem);
+    }
+
+    // Release the rest of the recorded content
+    for (i = 0; i < recordCount; i++) {
+        pRecord = &pRecords[i];
+        if (IS_VALID_STREAM_JOURNAL_RECORD(pRecord, i, count) && STATUS_SUCCEEDED(heapCheckPersisted(pHeap, pRecord->handle, &persisted)) &&
+            persisted) {
+            heapFree(pHeap, pRecord->handle);
+            released++;
+        }
+    }
+
+    DLOGI("[%s] Resumed %u and released %u persisted items", pKinesisVideoStream->streamInfo.name, resumed, released);
+
+    // The resumed content needs a stream start fix-up which is done as on re-connect when the data is first requested
+    if (resumed != 0) {
+        pKinesisVideoStream->connectionState = UPLOAD_CONNECTION_STATE_IN_USE;
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * The persisted content is only released by the stream journal replay. Content of the streams which were not
+ * journaled, e.g. the journal has been lost or discarded, would otherwise occupy the storage forever.
+ * The content recorded by the journals of the streams which are not re-created is kept for the later runs.
+ */
+STATUS releaseUnjournaledContent(PKinesisVideoClient pKinesisVideoClient)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    StreamJournalClaims claims;
+
+    MEMSET(&claims, 0x00, SIZEOF(StreamJournalClaims));
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+
+    // Any of the journals failing to load would leave its content unclaimed so nothing is released
+    CHK_STATUS(traverseDirectory(getStreamJournalRootDirectory(pKinesisVideoClient), (UINT64) &claims, FALSE, claimStreamJournalContent));
+    CHK_STATUS(heapReleaseUnclaimed(pKinesisVideoClient->pHeap, claims.pHandles, claims.count));
+
+CleanUp:
+
+    SAFE_MEMFREE(claims.pHandles);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS freeStreamJournal(PKinesisVideoStream pKinesisVideoStream)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, flushStatus;
+    PKinesisVideoClient pKinesisVideoClient = NULL;
+    PStreamJournal pJournal = NULL;
+    PViewItem pViewItem;
+    UINT64 index, headIndex;
+    BOOL persisted, storeLocked = FALSE;
+
+    CHK(pKinesisVideoStream != NULL && pKinesisVideoStream->pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    // Call is idempotent
+    pJournal = pKinesisVideoStream->pJournal;
+    CHK(pJournal != NULL, retStatus);
+
+    // Lock the store arena as the heap is accessed
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    storeLocked = TRUE;
+
+    // Move the content to the persistent storage tier and detach it from the view so it's not freed with the view
+    CHK(pKinesisVideoStream->pView != NULL && STATUS_SUCCEEDED(contentViewGetHead(pKinesisVideoStream->pView, &pViewItem)), retStatus);
+    headIndex = pViewItem->index;
+    CHK_STATUS(contentViewGetTail(pKinesisVideoStream->pView, &pViewItem));
+
+    for (index = pViewItem->index; index <= headIndex; index++) {
+        CHK_STATUS(contentViewGetItemAt(pKinesisVideoStream->pView, index, &pViewItem));
+        if (!IS_VALID_ALLOCATION_HANDLE(pViewItem->handle)) {
+            continue;
+        }
+
+        persisted = FALSE;
+        if (STATUS_SUCCEEDED(heapDemote(pKinesisVideoStream->pStoreArena->pHeap, &pViewItem->handle, 0, NULL))) {
+            heapCheckPersisted(pKinesisVideoStream->pStoreArena->pHeap, pViewItem->handle, &persisted);
+        }
+
+        if (persisted) {
+            journalViewItem(pJournal, pViewItem);
+            pViewItem->handle = INVALID_ALLOCATION_HANDLE_VALUE;
+        } else {
+            journalRemoveViewItem(pJournal, pViewItem);
+        }
+    }
+
+CleanUp:
+
+    if (storeLocked) {
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    }
+
+    if (pJournal != NULL) {
+        if (STATUS_FAILED(flushStatus = flushStreamJournal(pJournal))) {
+            DLOGW("[%s] Failed to write the stream journal with 0x%08x", pKinesisVideoStream->streamInfo.name, flushStatus);
+        }
+
+        FCLOSE(pJournal->pFile);
+        MEMFREE(pJournal);
+        pKinesisVideoStream->pJournal = NULL;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+VOID journalViewItem(PStreamJournal pJournal, PViewItem pViewItem)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Journal is optional
+    CHK(pJournal != NULL && pViewItem != NULL, retStatus);
+
+    setStreamJournalRecord(pJournal, pViewItem->index, pViewItem);
+
+    // Write the records of the completed fragment
+    if (CHECK_ITEM_FRAGMENT_START(pViewItem->flags)) {
+        CHK_STATUS(flushStreamJournal(pJournal));
+    }
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        DLOGW("Failed to record the view item with 0x%08x", retStatus);
+    }
+}
+
+VOID journalRemoveViewItem(PStreamJournal pJournal, PViewItem pViewItem)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    ViewItem record;
+    BOOL persisted = FALSE;
+
+    // Journal is optional
+    CHK(pJournal != NULL && pViewItem != NULL, retStatus);
+
+    MEMSET(&record, 0x00, SIZEOF(ViewItem));
+    record.index = INVALID_VIEW_INDEX_VALUE;
+    record.handle = INVALID_ALLOCATION_HANDLE_VALUE;
+
+    setStreamJournalRecord(pJournal, pViewItem->index, &record);
+
+    // The removal needs to be in the file before the persisted allocation is freed and re-used
+    if (IS_VALID_ALLOCATION_HANDLE(pViewItem->handle)) {
+        CHK_STATUS(heapCheckPersisted(pJournal->pHeap, pViewItem->handle, &persisted));
+    }
+
+    if (persisted) {
+        CHK_STATUS(flushStreamJournal(pJournal));
+    }
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        DLOGW("Failed to record the view item removal with 0x%08x", retStatus);
+    }
+}
+
+/**
+ * Claims the allocations recorded by the journal. The journal being replaced is claimed too as it might be the
+ * only complete one. The journals which will be discarded on replay don't claim their content.
+ */
+STATUS claimStreamJournalContent(UINT64 callerData, DIR_ENTRY_TYPES entryType, PCHAR path, PCHAR name)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStreamJournalClaims pClaims = (PStreamJournalClaims) callerData;
+    PStreamJournalHeader pHeader = NULL;
+    PViewItem pRecords;
+    PALLOCATION_HANDLE pHandles;
+    UINT64 size = 0;
+    UINT32 i, recordCount, capacity;
+    SIZE_T strLen;
+
+    // Early return on non-file types
+    CHK(entryType == DIR_ENTRY_TYPE_FILE, retStatus);
+
+    // Check if the file ends with the extension for the journal or the journal being replaced
+    strLen = STRLEN(name);
+    if (strLen >= SIZEOF(STREAM_JOURNAL_TEMP_FILE_EXTENSION) &&
+        0 == STRCMP(name + strLen - SIZEOF(STREAM_JOURNAL_TEMP_FILE_EXTENSION) + 1, STREAM_JOURNAL_TEMP_FILE_EXTENSION)) {
+        strLen -= SIZEOF(STREAM_JOURNAL_TEMP_FILE_EXTENSION) - 1;
+    }
+
+    CHK(strLen >= SIZEOF(STREAM_JOURNAL_FILE_EXTENSION) &&
+            0 ==
+                STRNCMP(name + strLen - SIZEOF(STREAM_JOURNAL_FILE_EXTENSION) + 1, STREAM_JOURNAL_FILE_EXTENSION,
+                        SIZEOF(STREAM_JOURNAL_FILE_EXTENSION) - 1),
+        retStatus);
+
+    CHK_STATUS(readFile(path, TRUE, NULL, &size));
+    CHK(size >= SIZEOF(StreamJournalHeader), retStatus);
+    CHK(NULL != (pHeader = (PStreamJournalHeader) MEMALLOC((SIZE_T) size)), STATUS_NOT_ENOUGH_MEMORY);
+    CHK_STATUS(readFile(path, TRUE, (PBYTE) pHeader, &size));
+    CHK(pHeader->version == STREAM_JOURNAL_CURRENT_VERSION && pHeader->itemCount != 0, retStatus);
+
+    pRecords = (PViewItem) (pHeader + 1);
+    recordCount = (UINT32) MIN(pHeader->itemCount, (size - SIZEOF(StreamJournalHeader)) / SIZEOF(ViewItem));
+    for (i = 0; i < recordCount; i++) {
+        if (!IS_VALID_STREAM_JOURNAL_RECORD(&pRecords[i], i, pHeader->itemCount)) {
+            continue;
+        }
+
+        if (pClaims->count == pClaims->capacity) {
+            capacity = pClaims->capacity == 0 ? STREAM_JOURNAL_DEFAULT_CLAIM_COUNT : pClaims->capacity * 2;
+            CHK(capacity > pClaims->capacity, STATUS_NOT_ENOUGH_MEMORY);
+            CHK(NULL != (pHandles = (PALLOCATION_HANDLE) MEMREALLOC(pClaims->pHandles, capacity * SIZEOF(ALLOCATION_HANDLE))),
+                STATUS_NOT_ENOUGH_MEMORY);
+            pClaims->pHandles = pHandles;
+            pClaims->capacity = capacity;
+        }
+
+        pClaims->pHandles[pClaims->count++] = pRecords[i].handle;
+    }
+
+CleanUp:
+
+    SAFE_MEMFREE(pHeader);
+
+    return retStatus;
+}
+
+/**
+ * The journals are stored alongside the storage files
+ */
+PCHAR getStreamJournalRootDirectory(PKinesisVideoClient pKinesisVideoClient)
+{
+    PCHAR pRootDirectory = pKinesisVideoClient->deviceInfo.storageInfo.rootDirectory;
+
+    return pRootDirectory[0] == '\0' ? (PCHAR) STREAM_JOURNAL_DEFAULT_ROOT_DIRECTORY : pRootDirectory;
+}
+
+/**
+ * Renames the new journal over the previous one. The file is re-opened as the open files can't be renamed on
+ * some platforms.
+ */
+STATUS commitStreamJournal(PStreamJournal pJournal, PCHAR tempFilePath, PCHAR filePath)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK_STATUS(flushStreamJournal(pJournal));
+    FCLOSE(pJournal->pFile);
+    pJournal->pFile = NULL;
+
+    // Some platforms don't rename over the existing file
+    if (0 != FRENAME(tempFilePath, filePath)) {
+        FREMOVE(filePath);
+        CHK(0 == FRENAME(tempFilePath, filePath), STATUS_OPEN_FILE_FAILED);
+    }
+
+    CHK(NULL != (pJournal->pFile = FOPEN(filePath, "rb+")), STATUS_OPEN_FILE_FAILED);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Changes the in-memory record. The record is written to the file on the next flush
+ */
+VOID setStreamJournalRecord(PStreamJournal pJournal, UINT64 index, PViewItem pRecord)
+{
+    UINT32 slot = (UINT32) (index % pJournal->itemCount);
+
+    pJournal->pRecords[slot] = *pRecord;
+    if (!pJournal->pDirty[slot]) {
+        pJournal->pDirty[slot] = TRUE;
+        pJournal->dirtyCount++;
+    }
+}
+
+/**
+ * Writes the changed records through to the file so they survive the process termination.
+ * The adjacent changed records are written at once.
+ */
+STATUS flushStreamJournal(PStreamJournal pJournal)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 start, end;
+
+    // Journal is optional
+    CHK(pJournal != NULL && pJournal->dirtyCount != 0, retStatus);
+
+    for (start = 0; start < pJournal->itemCount; start = end) {
+        end = start + 1;
+        while (end < pJournal->itemCount && pJournal->pDirty[end] == pJournal->pDirty[start]) {
+            end++;
+        }
+
+        if (pJournal->pDirty[start]) {
+            CHK(0 == FSEEK(pJournal->pFile, SIZEOF(StreamJournalHeader) + (UINT64) start * SIZEOF(ViewItem), SEEK_SET),
+                STATUS_WRITE_TO_FILE_FAILED);
+            CHK(end - start == FWRITE(&pJournal->pRecords[start], SIZEOF(ViewItem), end - start, pJournal->pFile), STATUS_WRITE_TO_FILE_FAILED);
+        }
+    }
+
+    CHK(0 == FFLUSH(pJournal->pFile), STATUS_WRITE_TO_FILE_FAILED);
+
+    MEMSET(pJournal->pDirty, 0x00, pJournal->itemCount * SIZEOF(BYTE));
+    pJournal->dirtyCount = 0;
+
+CleanUp:
+
+    return retStatus;
+}
@@ -0,0 +1,128 @@
+/*******************************************
+Stream content journal internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_STREAM_JOURNAL_INCLUDE_I__
+#define __KINESIS_VIDEO_STREAM_JOURNAL_INCLUDE_I__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Extension for the stream journal files
+#define STREAM_JOURNAL_FILE_EXTENSION ".kvsj"
+
+// Extension appended to the journal being written until the previous one is replayed
+#define STREAM_JOURNAL_TEMP_FILE_EXTENSION ".tmp"
+
+// Default location of the stream journal files
+#define STREAM_JOURNAL_DEFAULT_ROOT_DIRECTORY "."
+
+// Current version of the journal format
+#define STREAM_JOURNAL_CURRENT_VERSION 0
+
+// Initial capacity of the claimed allocation handle array which doubles when exhausted
+#define STREAM_JOURNAL_DEFAULT_CLAIM_COUNT 64
+
+/**
+ * Journal file header. The header is followed by the view item records.
+ * The records are indexed by the view item index modulo the record count similar to the content view.
+ */
+typedef struct __StreamJournalHeader StreamJournalHeader;
+struct __StreamJournalHeader {
+    // Version of the journal format
+    UINT32 version;
+
+    // Number of the view item records following the header
+    UINT32 itemCount;
+};
+typedef struct __StreamJournalHeader* PStreamJournalHeader;
+
+/**
+ * Stream journal keeping track of the view items and their storage allocations so the content
+ * which is persisted in the storage can be re-attached to after the restart.
+ *
+ * The records are changed in memory and written to the file in batches on the fragment boundaries and
+ * on the storage tiering timer. The removal of an allocation which is persisted is written through
+ * as the allocation might be re-used once it's freed.
+ */
+typedef struct __StreamJournal StreamJournal;
+struct __StreamJournal {
+    // The journal file
+    FILE* pFile;
+
+    // The content store heap of the stream
+    PHeap pHeap;
+
+    // Number of the view item records
+    UINT32 itemCount;
+
+    // Number of the records changed since the last write
+    UINT32 dirtyCount;
+
+    // In-memory records followed by the changed record flags. Allocated after the structure
+    PViewItem pRecords;
+    PBYTE pDirty;
+};
+typedef struct __StreamJournal* PStreamJournal;
+
+/**
+ * Storage allocations recorded by the stream journals of the previous run
+ */
+typedef struct __StreamJournalClaims StreamJournalClaims;
+struct __StreamJournalClaims {
+    // The claimed allocation handles
+    PALLOCATION_HANDLE pHandles;
+
+    // Number of the claimed handles
+    UINT32 count;
+
+    // Capacity of the handle array
+    UINT32 capacity;
+};
+typedef struct __StreamJournalClaims* PStreamJournalClaims;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates the journal for the stream and re-attaches the stream to the content persisted by the previous run.
+ * IMPORTANT: The client lock should be held
+ */
+STATUS createStreamJournal(PKinesisVideoStream, UINT32);
+
+/**
+ * Keeps the persisted content of the stream for the next run and frees the journal.
+ * IMPORTANT: The stream lock should be held
+ */
+STATUS freeStreamJournal(PKinesisVideoStream);
+
+/**
+ * Records the current state of the view item
+ */
+VOID journalViewItem(PStreamJournal, PViewItem);
+
+/**
+ * Records the view item removal
+ */
+VOID journalRemoveViewItem(PStreamJournal, PViewItem);
+
+/**
+ * Writes the changed records to the file
+ */
+STATUS flushStreamJournal(PStreamJournal);
+
+/**
+ * Internal functionality
+ */
+STATUS replayStreamJournal(PKinesisVideoStream, PStreamJournalHeader, UINT64);
+STATUS commitStreamJournal(PStreamJournal, PCHAR, PCHAR);
+STATUS claimStreamJournalContent(UINT64, DIR_ENTRY_TYPES, PCHAR, PCHAR);
+VOID setStreamJournalRecord(PStreamJournal, UINT64, PViewItem);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__KINESIS_VIDEO_STREAM_JOURNAL_INCLUDE_I__*/
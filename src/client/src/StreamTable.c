@@ -0,0 +1,222 @@
+/**
+ * Kinesis Video stream handle table
+ */
+#define LOG_CLASS "StreamTable"
+
+#include "Include_i.h"
+
+STATUS createStreamTable(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStreamTable pStreamTable;
+    UINT32 i, slotCount;
+
+    CHK(pKinesisVideoClient != NULL && pKinesisVideoClient->streamTable.slots != NULL, STATUS_NULL_ARG);
+    pStreamTable = &pKinesisVideoClient->streamTable;
+    slotCount = pKinesisVideoClient->deviceInfo.streamCount;
+
+    // Chain all of the slots into the free list in the index order
+    for (i = 0; i < slotCount; i++) {
+        pStreamTable->slots[i].nextFreeSlot = i + 1 < slotCount ? i + 1 : STREAM_TABLE_INVALID_SLOT;
+    }
+
+    pStreamTable->freeSlotHead = slotCount != 0 ? 0 : STREAM_TABLE_INVALID_SLOT;
+    pStreamTable->freeSlotTail = slotCount != 0 ? slotCount - 1 : STREAM_TABLE_INVALID_SLOT;
+
+    for (i = 0; i < STREAM_TABLE_SHARD_COUNT; i++) {
+        pStreamTable->shardLocks[i] = pKinesisVideoClient->clientCallbacks.createMutexFn(pKinesisVideoClient->clientCallbacks.customData, FALSE);
+        CHK(IS_VALID_MUTEX_VALUE(pStreamTable->shardLocks[i]), STATUS_NOT_ENOUGH_MEMORY);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS freeStreamTable(PKinesisVideoClient pKinesisVideoClient)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStreamTable pStreamTable;
+    UINT32 i;
+
+    CHK(pKinesisVideoClient != NULL, STATUS_NULL_ARG);
+    pStreamTable = &pKinesisVideoClient->streamTable;
+
+    for (i = 0; i < STREAM_TABLE_SHARD_COUNT; i++) {
+        if (IS_VALID_MUTEX_VALUE(pStreamTable->shardLocks[i])) {
+            pKinesisVideoClient->clientCallbacks.freeMutexFn(pKinesisVideoClient->clientCallbacks.customData, pStreamTable->shardLocks[i]);
+            pStreamTable->shardLocks[i] = INVALID_MUTEX_VALUE;
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS streamTableCheckName(PKinesisVideoClient pKinesisVideoClient, PCHAR streamName)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStreamTableSlot pSlot;
+    UINT32 i, nameHash;
+
+    CHK(pKinesisVideoClient != NULL && streamName != NULL, STATUS_NULL_ARG);
+
+    // Compare the names only on the hash match to keep the scan within the slots
+    nameHash = COMPUTE_CRC32((PBYTE) streamName, (UINT32) STRLEN(streamName));
+    for (i = 0; i < pKinesisVideoClient->deviceInfo.streamCount; i++) {
+        pSlot = &pKinesisVideoClient->streamTable.slots[i];
+        if (pSlot->pKinesisVideoStream != NULL && pSlot->nameHash == nameHash) {
+            CHK(0 != STRCMP(pSlot->pKinesisVideoStream->streamInfo.name, streamName), STATUS_DUPLICATE_STREAM_NAME);
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS streamTableInsert(PKinesisVideoClient pKinesisVideoClient, PKinesisVideoStream pKinesisVideoStream)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStreamTable pStreamTable;
+    PStreamTableSlot pSlot;
+    UINT32 index;
+
+    CHK(pKinesisVideoClient != NULL && pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pStreamTable = &pKinesisVideoClient->streamTable;
+
+    // Take the slot vacated the longest time ago
+    index = pStreamTable->freeSlotHead;
+    CHK(index != STREAM_TABLE_INVALID_SLOT, STATUS_MAX_STREAM_COUNT);
+    pSlot = &pStreamTable->slots[index];
+
+    pStreamTable->freeSlotHead = pSlot->nextFreeSlot;
+    if (pStreamTable->freeSlotHead == STREAM_TABLE_INVALID_SLOT) {
+        pStreamTable->freeSlotTail = STREAM_TABLE_INVALID_SLOT;
+    }
+
+    pKinesisVideoStream->streamId = index;
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                     pStreamTable->shardLocks[index % STREAM_TABLE_SHARD_COUNT]);
+    pSlot->nameHash = COMPUTE_CRC32((PBYTE) pKinesisVideoStream->streamInfo.name, (UINT32) STRLEN(pKinesisVideoStream->streamInfo.name));
+    pSlot->nextFreeSlot = STREAM_TABLE_INVALID_SLOT;
+    pSlot->pKinesisVideoStream = pKinesisVideoStream;
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                       pStreamTable->shardLocks[index % STREAM_TABLE_SHARD_COUNT]);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS streamTableRemove(PKinesisVideoClient pKinesisVideoClient, PKinesisVideoStream pKinesisVideoStream)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStreamTable pStreamTable;
+    PStreamTableSlot pSlot;
+    UINT32 index;
+
+    CHK(pKinesisVideoClient != NULL && pKinesisVideoStream != NULL, STATUS_NULL_ARG);
+    pStreamTable = &pKinesisVideoClient->streamTable;
+    index = pKinesisVideoStream->streamId;
+
+    // The stream which failed to be created has never been inserted
+    CHK(index < pKinesisVideoClient->deviceInfo.streamCount && pStreamTable->slots[index].pKinesisVideoStream == pKinesisVideoStream, retStatus);
+    pSlot = &pStreamTable->slots[index];
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                     pStreamTable->shardLocks[index % STREAM_TABLE_SHARD_COUNT]);
+    pSlot->pKinesisVideoStream = NULL;
+    pSlot->generation++;
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                       pStreamTable->shardLocks[index % STREAM_TABLE_SHARD_COUNT]);
+
+    // Append to the tail so the slot is reused last
+    if (pStreamTable->freeSlotTail == STREAM_TABLE_INVALID_SLOT) {
+        pStreamTable->freeSlotHead = index;
+    } else {
+        pStreamTable->slots[pStreamTable->freeSlotTail].nextFreeSlot = index;
+    }
+
+    pStreamTable->freeSlotTail = index;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS streamTableVisit(PKinesisVideoClient pKinesisVideoClient, UINT32 startIndex, UINT32 stride, StreamVisitFunc streamVisitFn, UINT64 customData)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStreamTable pStreamTable;
+    PKinesisVideoStream pKinesisVideoStream;
+    MUTEX shardLock;
+    UINT32 i;
+
+    CHK(pKinesisVideoClient != NULL && streamVisitFn != NULL, STATUS_NULL_ARG);
+    CHK(stride != 0, STATUS_INVALID_ARG);
+    pStreamTable = &pKinesisVideoClient->streamTable;
+
+    for (i = startIndex; i < pKinesisVideoClient->deviceInfo.streamCount; i += stride) {
+        // Skip the free slots without locking
+        if (pStreamTable->slots[i].pKinesisVideoStream == NULL) {
+            continue;
+        }
+
+        // Pin the stream so it can't be freed while visited. The streams being freed are skipped.
+        shardLock = pStreamTable->shardLocks[i % STREAM_TABLE_SHARD_COUNT];
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, shardLock);
+        pKinesisVideoStream = pStreamTable->slots[i].pKinesisVideoStream;
+        if (pKinesisVideoStream != NULL && STATUS_FAILED(semaphoreAcquire(pKinesisVideoStream->base.shutdownSemaphore, 0))) {
+            pKinesisVideoStream = NULL;
+        }
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, shardLock);
+
+        if (pKinesisVideoStream != NULL) {
+            retStatus = streamVisitFn(pKinesisVideoStream, customData);
+            semaphoreRelease(pKinesisVideoStream->base.shutdownSemaphore);
+            CHK_STATUS(retStatus);
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Converts the stream to a stream handle
+ */
+STREAM_HANDLE toStreamHandle(PKinesisVideoStream pKinesisVideoStream)
+{
+    PStreamTableSlot pSlot;
+
+    if (pKinesisVideoStream == NULL) {
+        return INVALID_STREAM_HANDLE_VALUE;
+    } else {
+        pSlot = &pKinesisVideoStream->pKinesisVideoClient->streamTable.slots[pKinesisVideoStream->streamId];
+        return (STREAM_HANDLE) ((UINT64) (SIZE_T) pSlot | (pSlot->generation & STREAM_HANDLE_GENERATION_MASK));
+    }
+}
+
+/**
+ * Converts handle to a stream
+ */
+PKinesisVideoStream fromStreamHandle(STREAM_HANDLE streamHandle)
+{
+    PStreamTableSlot pSlot;
+
+    if (streamHandle == INVALID_STREAM_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    // The handle of a freed stream has a stale generation
+    pSlot = (PStreamTableSlot) (SIZE_T) (streamHandle & ~STREAM_HANDLE_GENERATION_MASK);
+    if ((pSlot->generation & STREAM_HANDLE_GENERATION_MASK) != (streamHandle & STREAM_HANDLE_GENERATION_MASK)) {
+        return NULL;
+    }
+
+    return pSlot->pKinesisVideoStream;
+}
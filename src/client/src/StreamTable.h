@@ -0,0 +1,93 @@
+/*******************************************
+Stream handle table internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_STREAM_TABLE_INCLUDE_I__
+#define __KINESIS_VIDEO_STREAM_TABLE_INCLUDE_I__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Size and alignment of a slot. A slot takes an entire cache line and its address leaves
+ * the low bits of the stream handle for the slot generation.
+ */
+#define STREAM_TABLE_SLOT_SIZE 64
+
+/**
+ * Mask of the slot generation bits in the stream handle
+ */
+#define STREAM_HANDLE_GENERATION_MASK ((UINT64) (STREAM_TABLE_SLOT_SIZE - 1))
+
+/**
+ * Number of the shards the slots are partitioned into by the slot index
+ */
+#define STREAM_TABLE_SHARD_COUNT 16
+
+/**
+ * Sentinel value terminating the free slot list
+ */
+#define STREAM_TABLE_INVALID_SLOT MAX_UINT32
+
+/**
+ * Stream handle table slot
+ */
+typedef struct __StreamTableSlot StreamTableSlot;
+struct __StreamTableSlot {
+    // The stream occupying the slot. NULL if the slot is free.
+    PKinesisVideoStream pKinesisVideoStream;
+
+    // CRC of the stream name to check the name uniqueness without touching the streams
+    UINT32 nameHash;
+
+    // Incremented each time the slot is vacated so the handles of the freed streams no longer resolve
+    volatile UINT32 generation;
+
+    // Index of the next slot in the free slot list
+    UINT32 nextFreeSlot;
+
+    // Pad to the slot size
+    BYTE padding[STREAM_TABLE_SLOT_SIZE - SIZEOF(PKinesisVideoStream) - 3 * SIZEOF(UINT32)];
+};
+typedef struct __StreamTableSlot* PStreamTableSlot;
+
+/**
+ * Client stream registry. The stream handle is the address of the stream slot tagged with the
+ * low bits of the slot generation so the handle resolves in O(1) and a stale handle does not
+ * resolve to the stream reusing the slot. The free slots are reused in FIFO order so a slot
+ * cycles through the generations as slowly as possible.
+ *
+ * The slots are added and removed under the streams list lock and published under the lock of
+ * their shard. The streams are visited by pinning them with their shutdown semaphores under
+ * the shard lock only so no client-wide lock is held while visiting a stream.
+ */
+typedef struct __StreamTable StreamTable;
+struct __StreamTable {
+    // The slots aligned to the slot size following the client structure
+    PStreamTableSlot slots;
+
+    // Head and tail of the free slot list
+    UINT32 freeSlotHead;
+    UINT32 freeSlotTail;
+
+    // Locks of the shards guarding the publishing of the slots
+    MUTEX shardLocks[STREAM_TABLE_SHARD_COUNT];
+};
+typedef struct __StreamTable* PStreamTable;
+
+/**
+ * Function called for each of the streams visited
+ *
+ * @PKinesisVideoStream - IN - the stream pinned for the duration of the call.
+ * @UINT64 - IN - custom data passed to the visit.
+ *
+ * @return - STATUS - status code of the operation. A failure stops the visit.
+ */
+typedef STATUS (*StreamVisitFunc)(PKinesisVideoStream, UINT64);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__KINESIS_VIDEO_STREAM_TABLE_INCLUDE_I__*/
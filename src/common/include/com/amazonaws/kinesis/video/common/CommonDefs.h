@@ -463,6 +463,9 @@ typedef INT_PTR SSIZE_T, *PSSIZE_T;
 // Status definitions
 ////////////////////////////////////////////////////
 #define STATUS UINT32
+#ifndef PSTATUS
+#define PSTATUS STATUS*
+#endif
 
 #define STATUS_SUCCESS ((STATUS) 0x00000000)
 
@@ -513,6 +516,8 @@ typedef INT_PTR SSIZE_T, *PSSIZE_T;
 
 #if !(defined _WIN32 || defined _WIN64)
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #include <sys/time.h>
 #include <sys/utsname.h>
@@ -843,6 +848,7 @@ extern PUBLIC_API atomicXor globalAtomicXor;
 #define MEMSET        memset
 #define MEMMOVE       memmove
 #define REALLOC       realloc
+#define QSORT         qsort
 
 //
 // Whether the buffer contains the same char
@@ -940,6 +946,9 @@ extern PUBLIC_API atomicXor globalAtomicXor;
 #ifndef FREAD
 #define FREAD fread
 #endif
+#ifndef FFLUSH
+#define FFLUSH fflush
+#endif
 #ifndef FEOF
 #define FEOF feof
 #endif
@@ -83,6 +83,27 @@ typedef enum {
      * Whether to use the hybrid heap allocator which combined RAM-based heap and file based heap
      */
     FLAGS_USE_HYBRID_FILE_HEAP = 0x1 << 4,
+
+    /**
+     * Whether the AIV heap should keep its free blocks in segregated size-class bins instead of a single
+     * first-fit list. This keeps the allocation and free times near-constant as the heap fragments.
+     * Only applicable in combination with FLAGS_USE_AIV_HEAP.
+     */
+    FLAGS_USE_AIV_HEAP_SIZE_CLASSES = 0x1 << 5,
+
+    /**
+     * Whether to use the FIFO ring buffer heap allocator. The allocations are carved out at the head
+     * and reclaimed at the tail which matches the content store lifecycle. Allocations freed out of
+     * order are reclaimed once all of the older allocations are freed.
+     */
+    FLAGS_USE_RING_HEAP = 0x1 << 6,
+
+    /**
+     * Whether the hybrid file heap should keep its segment files along with the block descriptors on release
+     * and re-attach to the surviving file allocations on initialization. Allocations residing in memory are lost.
+     * Only applicable in combination with FLAGS_USE_HYBRID_FILE_HEAP.
+     */
+    FLAGS_PERSIST_HYBRID_FILE_HEAP = 0x1 << 7,
 } HEAP_BEHAVIOR_FLAGS;
 
 /**
@@ -191,6 +212,35 @@ PUBLIC_API STATUS heapMap(PHeap, ALLOCATION_HANDLE, PVOID*, PUINT64);
  */
 PUBLIC_API STATUS heapUnmap(PHeap, PVOID);
 
+/**
+ * Maps the allocated handle for read-only access and retrieves a memory address.
+ * NOTE: The content must not be modified and the mapping should be released with heapUnmapReadOnly
+ */
+PUBLIC_API STATUS heapMapReadOnly(PHeap, ALLOCATION_HANDLE, PVOID*, PUINT64);
+
+/**
+ * Un-maps the memory previously mapped with heapMapReadOnly
+ */
+PUBLIC_API STATUS heapUnmapReadOnly(PHeap, PVOID);
+
+/**
+ * Demotes the allocation to the slower storage tier if the in-memory tier usage is at or above the watermark percentage.
+ * NOTE: pHandle is IN/OUT param and will be updated in case the allocation has been moved.
+ * The optional PBOOL is set to whether the allocation resides in the slower tier on return.
+ */
+PUBLIC_API STATUS heapDemote(PHeap, PALLOCATION_HANDLE, UINT32, PBOOL);
+
+/**
+ * Checks whether the allocation is stored in the persistent storage tier and survives the heap release
+ */
+PUBLIC_API STATUS heapCheckPersisted(PHeap, ALLOCATION_HANDLE, PBOOL);
+
+/**
+ * Releases the persisted allocations recovered from the previous run which are not claimed by the given handles.
+ * NOTE: The claimed handle array is re-ordered. Should be called before the heap is used.
+ */
+PUBLIC_API STATUS heapReleaseUnclaimed(PHeap, PALLOCATION_HANDLE, UINT32);
+
 /**
  * Debug validates/outputs information about the heap
  */
@@ -30,6 +30,7 @@ DEFINE_HEAP_CHK(aivHeapDebugCheckAllocator)
     STATUS retStatus = STATUS_SUCCESS;
     PAIV_ALLOCATION_HEADER pBlock = NULL;
     PAivHeap pAivHeap = (PAivHeap) pHeap;
+    UINT32 binIndex;
 
     // Call the base heap functionality
     CHK_STATUS(commonHeapDebugCheckAllocator(pHeap, dump));
@@ -81,39 +82,54 @@ DEFINE_HEAP_CHK(aivHeapDebugCheckAllocator)
     if (dump) {
         DLOGV("*******************************************");
         DLOGV("Free blocks pointer: \t\t\t\t%p", pAivHeap->pFree);
+        DLOGV("Size-class bitmap: \t\t\t\t0x%016" PRIx64, pAivHeap->freeBinBitmap);
         DLOGV("*******************************************");
     }
 
-    pBlock = pAivHeap->pFree;
-    // walk the free blocks
-    while (pBlock != NULL) {
-        if (dump) {
-            DLOGV("Block:\t%p\t\tsize:\t%" PRIu64, pBlock, GET_AIV_ALLOCATION_SIZE(pBlock));
-        }
+    // Walk the single free list or each of the size-class bins
+    for (binIndex = 0; binIndex < (pAivHeap->sizeClassed ? AIV_HEAP_FREE_BIN_COUNT : 1); binIndex++) {
+        pBlock = pAivHeap->sizeClassed ? pAivHeap->freeBins[binIndex] : pAivHeap->pFree;
 
-        if (pBlock->header.flags != ALLOCATION_FLAGS_FREE) {
-            DLOGE("Block %p is in free list but doesn't have it's flag set as free", pBlock);
+        if (pAivHeap->sizeClassed && ((pAivHeap->freeBinBitmap >> binIndex) & 1) != (pBlock != NULL ? 1 : 0)) {
+            DLOGE("Size-class bin %u doesn't match the bitmap 0x%016" PRIx64, binIndex, pAivHeap->freeBinBitmap);
             retStatus = STATUS_HEAP_CORRUPTED;
         }
 
-        if (GET_AIV_ALLOCATION_SIZE(pBlock) != GET_AIV_ALLOCATION_FOOTER_SIZE(pBlock)) {
-            DLOGE("Block %p header and footer allocation sizes mismatch", pBlock);
-            retStatus = STATUS_HEAP_CORRUPTED;
-        }
+        // walk the free blocks
+        while (pBlock != NULL) {
+            if (dump) {
+                DLOGV("Block:\t%p\t\tsize:\t%" PRIu64, pBlock, GET_AIV_ALLOCATION_SIZE(pBlock));
+            }
+
+            if (pBlock->header.flags != ALLOCATION_FLAGS_FREE) {
+                DLOGE("Block %p is in free list but doesn't have it's flag set as free", pBlock);
+                retStatus = STATUS_HEAP_CORRUPTED;
+            }
+
+            if (GET_AIV_ALLOCATION_SIZE(pBlock) != GET_AIV_ALLOCATION_FOOTER_SIZE(pBlock)) {
+                DLOGE("Block %p header and footer allocation sizes mismatch", pBlock);
+                retStatus = STATUS_HEAP_CORRUPTED;
+            }
+
+            if (pAivHeap->sizeClassed && getFreeBinIndex(GET_AIV_ALLOCATION_SIZE(pBlock)) != binIndex) {
+                DLOGE("Block %p with size %" PRIu64 " is in a wrong size-class bin %u", pBlock, GET_AIV_ALLOCATION_SIZE(pBlock), binIndex);
+                retStatus = STATUS_HEAP_CORRUPTED;
+            }
 #ifdef HEAP_DEBUG
-        // Check the allocation 'guard band' in debug mode
-        if (0 != MEMCMP(((PALLOCATION_HEADER) pBlock)->magic, ALLOCATION_HEADER_MAGIC, SIZEOF(ALLOCATION_HEADER_MAGIC))) {
-            DLOGE("Invalid header for allocation %p", pBlock);
-            retStatus = STATUS_HEAP_CORRUPTED;
-        }
-
-        // Check the footer
-        if (0 != MEMCMP(GET_AIV_ALLOCATION_FOOTER(pBlock)->magic, ALLOCATION_FOOTER_MAGIC, SIZEOF(ALLOCATION_FOOTER_MAGIC))) {
-            DLOGE("Invalid footer for allocation %p", pBlock);
-            retStatus = STATUS_HEAP_CORRUPTED;
-        }
+            // Check the allocation 'guard band' in debug mode
+            if (0 != MEMCMP(((PALLOCATION_HEADER) pBlock)->magic, ALLOCATION_HEADER_MAGIC, SIZEOF(ALLOCATION_HEADER_MAGIC))) {
+                DLOGE("Invalid header for allocation %p", pBlock);
+                retStatus = STATUS_HEAP_CORRUPTED;
+            }
+
+            // Check the footer
+            if (0 != MEMCMP(GET_AIV_ALLOCATION_FOOTER(pBlock)->magic, ALLOCATION_FOOTER_MAGIC, SIZEOF(ALLOCATION_FOOTER_MAGIC))) {
+                DLOGE("Invalid footer for allocation %p", pBlock);
+                retStatus = STATUS_HEAP_CORRUPTED;
+            }
 #endif
-        pBlock = pBlock->pNext;
+            pBlock = pBlock->pNext;
+        }
     }
 
     if (dump) {
@@ -147,6 +163,9 @@ DEFINE_CREATE_HEAP(aivHeapCreate)
     pBaseHeap->heapSetAllocSizeFn = aivHeapSetAllocSize;
     pBaseHeap->heapMapFn = aivHeapMap;
     pBaseHeap->heapUnmapFn = aivHeapUnmap;
+    pBaseHeap->heapDemoteFn = commonHeapDemote; // Single tier heap
+    pBaseHeap->heapCheckPersistedFn = commonHeapCheckPersisted;
+    pBaseHeap->heapReleaseUnclaimedFn = commonHeapReleaseUnclaimed;
     pBaseHeap->heapDebugCheckAllocatorFn = aivHeapDebugCheckAllocator;
     pBaseHeap->getAllocationSizeFn = aivGetAllocationSize;
     pBaseHeap->getAllocationHeaderSizeFn = aivGetAllocationHeaderSize;
@@ -174,6 +193,8 @@ DEFINE_INIT_HEAP(aivHeapInit)
     pAivHeap->pAllocation = NULL;
     pAivHeap->pFree = NULL;
     pAivHeap->pAlloc = NULL;
+    pAivHeap->freeBinBitmap = 0;
+    MEMSET(pAivHeap->freeBins, 0x00, SIZEOF(pAivHeap->freeBins));
 
     // We will align heap limit to ensure the allocations are always aligned
     heapLimit = HEAP_PACKED_SIZE(heapLimit);
@@ -198,8 +219,8 @@ DEFINE_INIT_HEAP(aivHeapInit)
     SET_AIV_ALLOCATION_SIZE(pAivHeap->pAllocation, pHeap->heapLimit - AIV_ALLOCATION_HEADER_SIZE - AIV_ALLOCATION_FOOTER_SIZE);
     SET_AIV_ALLOCATION_FOOTER_SIZE(pAivHeap->pAllocation);
 
-    // Set the free pointer
-    pAivHeap->pFree = (PAIV_ALLOCATION_HEADER) pAivHeap->pAllocation;
+    // Chain in the free block
+    linkFreeBlock(pAivHeap, (PAIV_ALLOCATION_HEADER) pAivHeap->pAllocation);
 
 CleanUp:
 
@@ -387,7 +408,7 @@ DEFINE_HEAP_MAP(aivHeapMap)
     CHK_AIV_ALLOCATION(pAivHeap, pAllocation);
 
     // Call the common heap function
-    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize));
+    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize, readOnly));
 
     *ppAllocation = pAllocation;
     pHeader = (PAIV_ALLOCATION_HEADER) pAllocation - 1;
@@ -414,7 +435,7 @@ DEFINE_HEAP_UNMAP(aivHeapUnmap)
     STATUS retStatus = STATUS_SUCCESS;
 
     // Delegate the call directly
-    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation));
+    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation, readOnly));
 
 CleanUp:
     LEAVES();
@@ -547,11 +568,11 @@ DEFINE_HEAP_SET_ALLOC_SIZE(aivHeapSetAllocSize)
 
     CHK_STATUS(aivHeapAlloc(pHeap, newSize, &newAllocationHandle));
     CHK(IS_VALID_ALLOCATION_HANDLE(newAllocationHandle), STATUS_NOT_ENOUGH_MEMORY);
-    CHK_STATUS(aivHeapMap(pHeap, existingAllocationHandle, &pExistingBuffer, &size));
-    CHK_STATUS(aivHeapMap(pHeap, newAllocationHandle, &pNewBuffer, &newSize));
+    CHK_STATUS(aivHeapMap(pHeap, existingAllocationHandle, &pExistingBuffer, &size, TRUE));
+    CHK_STATUS(aivHeapMap(pHeap, newAllocationHandle, &pNewBuffer, &newSize, FALSE));
     MEMCPY(pNewBuffer, pExistingBuffer, MIN(size, newSize));
-    CHK_STATUS(aivHeapUnmap(pHeap, pExistingBuffer));
-    CHK_STATUS(aivHeapUnmap(pHeap, pNewBuffer));
+    CHK_STATUS(aivHeapUnmap(pHeap, pExistingBuffer, TRUE));
+    CHK_STATUS(aivHeapUnmap(pHeap, pNewBuffer, FALSE));
     CHK_STATUS(aivHeapFree(pHeap, existingAllocationHandle));
 
     // Set the return
@@ -582,6 +603,10 @@ PAIV_ALLOCATION_HEADER getFreeBlock(PAivHeap pAivHeap, UINT64 size)
 {
     PAIV_ALLOCATION_HEADER pFree = pAivHeap->pFree;
 
+    if (pAivHeap->sizeClassed) {
+        return getFreeBinBlock(pAivHeap, size);
+    }
+
     // Perform the allocation by looking for the first fit in the free list
     while (pFree != NULL) {
         // check for the fit
@@ -596,6 +621,148 @@ PAIV_ALLOCATION_HEADER getFreeBlock(PAivHeap pAivHeap, UINT64 size)
     return NULL;
 }
 
+/**
+ * Free block finding in the segregated size-class bins
+ */
+PAIV_ALLOCATION_HEADER getFreeBinBlock(PAivHeap pAivHeap, UINT64 size)
+{
+    UINT64 alignedSize = HEAP_PACKED_SIZE(size), binMask = 0;
+    UINT32 binIndex = getFreeBinIndex(alignedSize), probeCount = 0;
+    PAIV_ALLOCATION_HEADER pFree = pAivHeap->freeBins[binIndex];
+
+    // The blocks in the same size class might still be smaller than requested so we probe only a few
+    while (pFree != NULL && probeCount < AIV_HEAP_FREE_BIN_PROBE_COUNT) {
+        if (GET_AIV_ALLOCATION_SIZE(pFree) >= alignedSize) {
+            return pFree;
+        }
+
+        pFree = pFree->pNext;
+        probeCount++;
+    }
+
+    // Any block from a larger size class fits so take the head of the smallest non-empty one
+    if (binIndex + 1 < AIV_HEAP_FREE_BIN_COUNT) {
+        binMask = pAivHeap->freeBinBitmap & (MAX_UINT64 << (binIndex + 1));
+    }
+
+    if (binMask != 0) {
+        return pAivHeap->freeBins[getLowestBitIndex(binMask)];
+    }
+
+    // Last resort is to walk the remainder of the size class
+    while (pFree != NULL) {
+        if (GET_AIV_ALLOCATION_SIZE(pFree) >= alignedSize) {
+            return pFree;
+        }
+
+        pFree = pFree->pNext;
+    }
+
+    return NULL;
+}
+
+/**
+ * Returns the size-class bin index for the given block size
+ */
+UINT32 getFreeBinIndex(UINT64 size)
+{
+    UINT32 index = 0;
+
+    if (size == 0) {
+        return 0;
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    index = 63 - (UINT32) __builtin_clzll(size);
+#else
+    while ((size >>= 1) != 0) {
+        index++;
+    }
+#endif
+
+    return index;
+}
+
+/**
+ * Returns the index of the lowest set bit. The value must be non-zero.
+ */
+UINT32 getLowestBitIndex(UINT64 value)
+{
+    UINT32 index = 0;
+
+#if defined(__GNUC__) || defined(__clang__)
+    index = (UINT32) __builtin_ctzll(value);
+#else
+    while ((value & 1) == 0) {
+        value >>= 1;
+        index++;
+    }
+#endif
+
+    return index;
+}
+
+/**
+ * Chains in the free block to the head of the free list or the head of its size-class bin.
+ * The block size should be already set.
+ */
+VOID linkFreeBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock)
+{
+    UINT32 binIndex = 0;
+    PAIV_ALLOCATION_HEADER* ppHead = &pAivHeap->pFree;
+
+    if (pAivHeap->sizeClassed) {
+        binIndex = getFreeBinIndex(GET_AIV_ALLOCATION_SIZE(pBlock));
+        ppHead = &pAivHeap->freeBins[binIndex];
+        pAivHeap->freeBinBitmap |= (UINT64) 1 << binIndex;
+    }
+
+    pBlock->header.flags = ALLOCATION_FLAGS_FREE;
+    pBlock->pPrev = NULL;
+    pBlock->pNext = *ppHead;
+    if (pBlock->pNext != NULL) {
+        pBlock->pNext->pPrev = pBlock;
+    }
+
+    *ppHead = pBlock;
+}
+
+/**
+ * Removes the free block from the free list or its size-class bin.
+ * The block size should not be modified while the block is chained in.
+ */
+VOID unlinkFreeBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock)
+{
+    UINT32 binIndex = 0;
+    PAIV_ALLOCATION_HEADER* ppHead = &pAivHeap->pFree;
+
+    if (pAivHeap->sizeClassed) {
+        binIndex = getFreeBinIndex(GET_AIV_ALLOCATION_SIZE(pBlock));
+        ppHead = &pAivHeap->freeBins[binIndex];
+    }
+
+    // Fix the prev block
+    if (pBlock->pPrev != NULL) {
+        pBlock->pPrev->pNext = pBlock->pNext;
+    } else {
+        // this is the case where we need to Fix-up the list head
+        CHECK_EXT(*ppHead == pBlock, "Free block pointer is invalid");
+        *ppHead = pBlock->pNext;
+
+        if (pAivHeap->sizeClassed && *ppHead == NULL) {
+            pAivHeap->freeBinBitmap &= ~((UINT64) 1 << binIndex);
+        }
+    }
+
+    // Fix the next block
+    if (pBlock->pNext != NULL) {
+        pBlock->pNext->pPrev = pBlock->pPrev;
+    }
+
+    pBlock->pNext = pBlock->pPrev = NULL;
+    pBlock->header.flags = ALLOCATION_FLAGS_NONE;
+}
+
 /**
  * Splits the free block
  */
@@ -608,19 +775,7 @@ VOID splitFreeBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock, UINT64 siz
     // In case we end up with smaller block then we will just attach that to the allocated
     if (GET_AIV_ALLOCATION_SIZE(pBlock) < alignedSize + MIN_FREE_BLOCK_SIZE) {
         // use the entire block
-        // Fix the next block
-        if (pBlock->pNext != NULL) {
-            pBlock->pNext->pPrev = pBlock->pPrev;
-        }
-
-        // Fix the prev block
-        if (pBlock->pPrev != NULL) {
-            pBlock->pPrev->pNext = pBlock->pNext;
-        } else {
-            // this is the case where we need to Fix-up the pAivHeap->pFree
-            CHECK_EXT(pAivHeap->pFree == pBlock, "Free block pointer is invalid");
-            pAivHeap->pFree = pBlock->pNext;
-        }
+        unlinkFreeBlock(pAivHeap, pBlock);
 
 #ifdef HEAP_DEBUG
         // Zero the memory in debug mode
@@ -641,30 +796,36 @@ VOID splitFreeBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock, UINT64 siz
         SET_AIV_ALLOCATION_SIZE(pNewFree, GET_AIV_ALLOCATION_SIZE(pBlock) - alignedSize - AIV_ALLOCATION_HEADER_SIZE - AIV_ALLOCATION_FOOTER_SIZE);
         SET_AIV_ALLOCATION_FOOTER_SIZE(pNewFree);
 
-        // Set the type of the block
-        pNewFree->header.flags = ALLOCATION_FLAGS_FREE;
-
-        // Linking it in
-        pNewFree->pNext = pBlock->pNext;
-        pNewFree->pPrev = pBlock->pPrev;
-
 #ifdef HEAP_DEBUG
         // Null the memory in debug mode
         MEMSET(pNewFree + 1, 0x00, (SIZE_T) GET_AIV_ALLOCATION_SIZE(pNewFree));
 #endif
 
-        // Fix the next block
-        if (pNewFree->pNext != NULL) {
-            pNewFree->pNext->pPrev = pNewFree;
-        }
-
-        // Fix the prev block
-        if (pNewFree->pPrev != NULL) {
-            pNewFree->pPrev->pNext = pNewFree;
+        if (pAivHeap->sizeClassed) {
+            // The remainder is most likely of a different size class
+            unlinkFreeBlock(pAivHeap, pBlock);
+            linkFreeBlock(pAivHeap, pNewFree);
         } else {
-            // This is the case where we need to Fix-up the pAivHeap->pFree
-            CHECK_EXT(pAivHeap->pFree == pBlock, "Free block pointer is invalid");
-            pAivHeap->pFree = pNewFree;
+            // Set the type of the block
+            pNewFree->header.flags = ALLOCATION_FLAGS_FREE;
+
+            // Linking it in
+            pNewFree->pNext = pBlock->pNext;
+            pNewFree->pPrev = pBlock->pPrev;
+
+            // Fix the next block
+            if (pNewFree->pNext != NULL) {
+                pNewFree->pNext->pPrev = pNewFree;
+            }
+
+            // Fix the prev block
+            if (pNewFree->pPrev != NULL) {
+                pNewFree->pPrev->pNext = pNewFree;
+            } else {
+                // This is the case where we need to Fix-up the pAivHeap->pFree
+                CHECK_EXT(pAivHeap->pFree == pBlock, "Free block pointer is invalid");
+                pAivHeap->pFree = pNewFree;
+            }
         }
 
         // adjust the free block size
@@ -744,19 +905,7 @@ VOID coalesceFreeToAllocatedBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pAll
     // In case we end up with smaller block then we will just attach that to the allocated
     if (freeSize < alignedDiffSize + MIN_FREE_ALLOCATION_SIZE) {
         // use the entire block
-        // Fix the next block
-        if (pFree->pNext != NULL) {
-            pFree->pNext->pPrev = pFree->pPrev;
-        }
-
-        // Fix the prev block
-        if (pFree->pPrev != NULL) {
-            pFree->pPrev->pNext = pFree->pNext;
-        } else {
-            // this is the case where we need to Fix-up the pAivHeap->pFree
-            CHECK_EXT(pAivHeap->pFree == pFree, "Free block pointer is invalid");
-            pAivHeap->pFree = pFree->pNext;
-        }
+        unlinkFreeBlock(pAivHeap, pFree);
 
 #ifdef HEAP_DEBUG
         // Null the memory in debug mode
@@ -779,33 +928,42 @@ VOID coalesceFreeToAllocatedBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pAll
         pNext = pFree->pNext;
         pPrev = pFree->pPrev;
 
-        // Set the header for the new free block
-        MEMCPY(pNewFree, &gAivHeader, AIV_ALLOCATION_HEADER_SIZE);
-
-        // Re-chain the new free block
-        pNewFree->pNext = pNext;
-        pNewFree->pPrev = pPrev;
-
-        // Fix the next block
-        if (pNewFree->pNext != NULL) {
-            pNewFree->pNext->pPrev = pNewFree;
+        // The new header might overlap the existing one so the block needs to be unlinked from its size class first
+        if (pAivHeap->sizeClassed) {
+            unlinkFreeBlock(pAivHeap, pFree);
         }
 
-        // Fix the prev block
-        if (pNewFree->pPrev != NULL) {
-            pNewFree->pPrev->pNext = pNewFree;
-        } else {
-            // This is the case where we need to Fix-up the pAivHeap->pFree
-            CHECK_EXT(pAivHeap->pFree == pFree, "Free block pointer is invalid");
-            pAivHeap->pFree = pNewFree;
-        }
+        // Set the header for the new free block
+        MEMCPY(pNewFree, &gAivHeader, AIV_ALLOCATION_HEADER_SIZE);
 
-        // Set the size and link to the chain
+        // Set the size
         SET_AIV_ALLOCATION_SIZE(pNewFree, freeSize - alignedDiffSize);
         SET_AIV_ALLOCATION_FOOTER_SIZE(pNewFree);
 
-        // Set the type of the block
-        pNewFree->header.flags = ALLOCATION_FLAGS_FREE;
+        if (pAivHeap->sizeClassed) {
+            linkFreeBlock(pAivHeap, pNewFree);
+        } else {
+            // Re-chain the new free block
+            pNewFree->pNext = pNext;
+            pNewFree->pPrev = pPrev;
+
+            // Fix the next block
+            if (pNewFree->pNext != NULL) {
+                pNewFree->pNext->pPrev = pNewFree;
+            }
+
+            // Fix the prev block
+            if (pNewFree->pPrev != NULL) {
+                pNewFree->pPrev->pNext = pNewFree;
+            } else {
+                // This is the case where we need to Fix-up the pAivHeap->pFree
+                CHECK_EXT(pAivHeap->pFree == pFree, "Free block pointer is invalid");
+                pAivHeap->pFree = pNewFree;
+            }
+
+            // Set the type of the block
+            pNewFree->header.flags = ALLOCATION_FLAGS_FREE;
+        }
 
         // set the new footer for the allocated
         MEMCPY((PBYTE) pNewFree - AIV_ALLOCATION_FOOTER_SIZE, &gAivFooter, AIV_ALLOCATION_FOOTER_SIZE);
@@ -850,30 +1008,30 @@ VOID removeChainedBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock)
 {
     CHECK(pAivHeap != NULL && pBlock != NULL && pBlock->header.flags != ALLOCATION_FLAGS_NONE && GET_AIV_ALLOCATION_SIZE(pBlock) > 0);
 
-    // Fix-up the prev
-    if (pBlock->pPrev == NULL) {
-        // This is the case of the first block
-        if (pBlock->header.flags == ALLOCATION_FLAGS_FREE) {
-            CHECK_EXT(pAivHeap->pFree == pBlock, "Free Block pointer is invalid");
-            pAivHeap->pFree = pBlock->pNext;
-        } else {
+    if (pBlock->header.flags == ALLOCATION_FLAGS_FREE) {
+        // Free blocks might be chained in the size-class bins
+        unlinkFreeBlock(pAivHeap, pBlock);
+    } else {
+        // Fix-up the prev
+        if (pBlock->pPrev == NULL) {
+            // This is the case of the first block
             CHECK_EXT(pAivHeap->pAlloc == pBlock, "Alloc Block pointer is invalid");
             pAivHeap->pAlloc = pBlock->pNext;
+        } else {
+            pBlock->pPrev->pNext = pBlock->pNext;
         }
-    } else {
-        pBlock->pPrev->pNext = pBlock->pNext;
-    }
 
-    // Fix-up the next
-    if (pBlock->pNext != NULL) {
-        pBlock->pNext->pPrev = pBlock->pPrev;
-    }
+        // Fix-up the next
+        if (pBlock->pNext != NULL) {
+            pBlock->pNext->pPrev = pBlock->pPrev;
+        }
 
-    // Set the status as undefined
-    pBlock->header.flags = ALLOCATION_FLAGS_NONE;
+        // Set the status as undefined
+        pBlock->header.flags = ALLOCATION_FLAGS_NONE;
 
-    // Nullify the links
-    pBlock->pNext = pBlock->pPrev = NULL;
+        // Nullify the links
+        pBlock->pNext = pBlock->pPrev = NULL;
+    }
 
     // Set the requested allocation size to 0
     pBlock->allocSize = 0;
@@ -891,12 +1049,9 @@ VOID addFreeBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock)
     // and then try to coalesce the neighboring blocks
 
     // Special case with early return if it's the first block
-    if (pAivHeap->pFree == NULL) {
-        // Set as free
-        pBlock->header.flags = ALLOCATION_FLAGS_FREE;
-
+    if (pAivHeap->pFree == NULL && pAivHeap->freeBinBitmap == 0) {
         // Set the first free block
-        pAivHeap->pFree = pBlock;
+        linkFreeBlock(pAivHeap, pBlock);
         return;
     }
 
@@ -908,6 +1063,11 @@ VOID addFreeBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock)
 
     // Check for coalescence
     if (pLeft != NULL && pLeft->header.flags == ALLOCATION_FLAGS_FREE) {
+        // The coalesced block will move to a different size class so unlink it before changing the size
+        if (pAivHeap->sizeClassed) {
+            unlinkFreeBlock(pAivHeap, pLeft);
+        }
+
         overallSize = GET_AIV_ALLOCATION_SIZE(pLeft) + blockSize + AIV_ALLOCATION_HEADER_SIZE + AIV_ALLOCATION_FOOTER_SIZE;
         SET_AIV_ALLOCATION_SIZE(pLeft, overallSize);
         SET_AIV_ALLOCATION_FOOTER_SIZE(pLeft);
@@ -930,15 +1090,7 @@ VOID addFreeBlock(PAivHeap pAivHeap, PAIV_ALLOCATION_HEADER pBlock)
 
     // Chain it in if needed hasn't been chained in
     if (pBlock->header.flags == ALLOCATION_FLAGS_NONE) {
-        pBlock->header.flags = ALLOCATION_FLAGS_FREE;
-        pBlock->pNext = pAivHeap->pFree;
-        pBlock->pPrev = NULL;
-        if (pBlock->pNext != NULL) {
-            pBlock->pNext->pPrev = pBlock;
-        }
-
-        // Set the new free header
-        pAivHeap->pFree = pBlock;
+        linkFreeBlock(pAivHeap, pBlock);
     }
 }
 
@@ -20,6 +20,17 @@ extern "C" {
  */
 #define MIN_FREE_ALLOCATION_SIZE 16
 
+/**
+ * Number of the size-class free bins. Bin i holds the free blocks with the size in [2^i, 2^(i+1)) range
+ * so the non-empty bins can be tracked in a single 64 bit bitmap.
+ */
+#define AIV_HEAP_FREE_BIN_COUNT 64
+
+/**
+ * Max number of blocks to probe in the size class of the requested allocation before moving to a larger size class
+ */
+#define AIV_HEAP_FREE_BIN_PROBE_COUNT 4
+
 /**
  * Allocation header for low fragmentation heap implementation.
  *
@@ -61,6 +72,21 @@ typedef struct {
      */
     PAIV_ALLOCATION_HEADER pFree;
     PAIV_ALLOCATION_HEADER pAlloc;
+
+    /**
+     * Whether the free blocks are kept in the segregated size-class bins instead of the pFree list
+     */
+    BOOL sizeClassed;
+
+    /**
+     * Bitmap of the non-empty size-class bins
+     */
+    UINT64 freeBinBitmap;
+
+    /**
+     * Heads of the size-class free bins
+     */
+    PAIV_ALLOCATION_HEADER freeBins[AIV_HEAP_FREE_BIN_COUNT];
 } AivHeap, *PAivHeap;
 
 /**
@@ -177,6 +203,11 @@ DEFINE_HEAP_LIMITS(aivGetHeapLimits);
  * AIV Heap specific functions
  */
 PAIV_ALLOCATION_HEADER getFreeBlock(PAivHeap, UINT64);
+PAIV_ALLOCATION_HEADER getFreeBinBlock(PAivHeap, UINT64);
+UINT32 getFreeBinIndex(UINT64);
+UINT32 getLowestBitIndex(UINT64);
+VOID linkFreeBlock(PAivHeap, PAIV_ALLOCATION_HEADER);
+VOID unlinkFreeBlock(PAivHeap, PAIV_ALLOCATION_HEADER);
 VOID splitFreeBlock(PAivHeap, PAIV_ALLOCATION_HEADER, UINT64);
 VOID splitAllocatedBlock(PAivHeap, PAIV_ALLOCATION_HEADER, UINT64);
 VOID addAllocatedBlock(PAivHeap, PAIV_ALLOCATION_HEADER);
@@ -287,6 +287,9 @@ DEFINE_HEAP_MAP(commonHeapMap)
     STATUS retStatus = STATUS_SUCCESS;
     DLOGS("Mapping handle 0x%016" PRIx64, handle);
 
+    // Direct memory heaps map in place so the access intent makes no difference
+    UNUSED_PARAM(readOnly);
+
     // Check the input params
     CHK(pHeap != NULL && ppAllocation != NULL && pSize != NULL, STATUS_NULL_ARG);
     CHK(handle != INVALID_ALLOCATION_HANDLE_VALUE, STATUS_INVALID_ARG);
@@ -314,6 +317,7 @@ DEFINE_HEAP_UNMAP(commonHeapUnmap)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     DLOGS("Un-mapping buffer at %p", pAllocation);
+    UNUSED_PARAM(readOnly);
 
     // Check the input param
     CHK(pHeap != NULL && pAllocation != NULL, STATUS_NULL_ARG);
@@ -329,6 +333,65 @@ CleanUp:
     return retStatus;
 }
 
+DEFINE_HEAP_DEMOTE(commonHeapDemote)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Check the input params
+    CHK(pHeap != NULL && pHandle != NULL && pDemoted != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_ALLOCATION_HANDLE(*pHandle) && watermark <= 100, STATUS_INVALID_ARG);
+
+    // Single tier heaps keep the allocations in place
+    *pDemoted = FALSE;
+
+    // Check if we are initialized by looking at heap limit
+    CHK_ERR(pHeap->heapLimit != 0, STATUS_HEAP_NOT_INITIALIZED, "Heap has not been initialized.");
+
+    // Validate the heap
+    CHK_STATUS(validateHeap(pHeap));
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+DEFINE_HEAP_CHECK_PERSISTED(commonHeapCheckPersisted)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Check the input params
+    CHK(pHeap != NULL && pPersisted != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_ALLOCATION_HANDLE(handle), STATUS_INVALID_ARG);
+
+    // Set the default
+    *pPersisted = FALSE;
+
+    // Check if we are initialized by looking at heap limit
+    CHK_ERR(pHeap->heapLimit != 0, STATUS_HEAP_NOT_INITIALIZED, "Heap has not been initialized.");
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+DEFINE_HEAP_RELEASE_UNCLAIMED(commonHeapReleaseUnclaimed)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Check the input params
+    CHK(pHeap != NULL && (pClaimed != NULL || claimedCount == 0), STATUS_NULL_ARG);
+
+    // Check if we are initialized by looking at heap limit
+    CHK_ERR(pHeap->heapLimit != 0, STATUS_HEAP_NOT_INITIALIZED, "Heap has not been initialized.");
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
 /**
  * Increments the heap usage
  */
@@ -89,6 +89,21 @@ DEFINE_HEAP_MAP(commonHeapMap);
  */
 DEFINE_HEAP_UNMAP(commonHeapUnmap);
 
+/**
+ * Demotes the allocation to a slower storage tier. Single tier heaps keep the allocation in place.
+ */
+DEFINE_HEAP_DEMOTE(commonHeapDemote);
+
+/**
+ * Checks whether the allocation is persisted. Allocations of the non-persistent heaps are not.
+ */
+DEFINE_HEAP_CHECK_PERSISTED(commonHeapCheckPersisted);
+
+/**
+ * Releases the unclaimed recovered allocations. The non-persistent heaps don't recover any.
+ */
+DEFINE_HEAP_RELEASE_UNCLAIMED(commonHeapReleaseUnclaimed);
+
 /**
  * Release the entire heap
  */
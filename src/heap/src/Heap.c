@@ -43,14 +43,18 @@ STATUS heapInitialize(UINT64 heapLimit, UINT32 spillRatio, UINT32 behaviorFlags,
     PHeap pHeap = NULL;
     PHybridHeap pHybridHeap = NULL;
     PHybridFileHeap pFileHeap = NULL;
-    UINT32 heapTypeFlags = (behaviorFlags & (FLAGS_USE_AIV_HEAP | FLAGS_USE_SYSTEM_HEAP));
+    UINT32 heapTypeFlags = (behaviorFlags & (FLAGS_USE_AIV_HEAP | FLAGS_USE_SYSTEM_HEAP | FLAGS_USE_RING_HEAP));
 
     CHK(ppHeap != NULL, STATUS_NULL_ARG);
     CHK(heapLimit >= MIN_HEAP_SIZE, STATUS_INVALID_ARG);
     CHK(spillRatio <= 100, STATUS_INVALID_ARG);
 
-    // Flags should have either system or AIV heap specified but not both at the same time
-    CHK(heapTypeFlags != HEAP_FLAGS_NONE && heapTypeFlags != (FLAGS_USE_AIV_HEAP | FLAGS_USE_SYSTEM_HEAP), STATUS_HEAP_FLAGS_ERROR);
+    // Flags should have exactly one of system, AIV or ring heap specified
+    CHK(heapTypeFlags != HEAP_FLAGS_NONE && (heapTypeFlags & (heapTypeFlags - 1)) == HEAP_FLAGS_NONE, STATUS_HEAP_FLAGS_ERROR);
+
+    // Persistence is only supported by the hybrid file heap
+    CHK((behaviorFlags & FLAGS_PERSIST_HYBRID_FILE_HEAP) == HEAP_FLAGS_NONE || (behaviorFlags & FLAGS_USE_HYBRID_FILE_HEAP) != HEAP_FLAGS_NONE,
+        STATUS_HEAP_FLAGS_ERROR);
 
     DLOGI("Initializing native heap with limit size %" PRIu64 ", spill ratio %u%% and flags 0x%08x", heapLimit, spillRatio, behaviorFlags);
 
@@ -58,13 +62,22 @@ STATUS heapInitialize(UINT64 heapLimit, UINT32 spillRatio, UINT32 behaviorFlags,
     // The logic is to check if we are allowed to use the hybrid implementation and
     // whether the system libraries are present.
     // We will fallback to AIV heap implementation otherwise
-    // First, check whether we need to use system or AIV heap
+    // First, check whether we need to use system, ring or AIV heap
     if ((behaviorFlags & FLAGS_USE_SYSTEM_HEAP) != HEAP_FLAGS_NONE) {
         DLOGI("Creating system heap.");
         CHK_STATUS(sysHeapCreate(&pHeap));
+    } else if ((behaviorFlags & FLAGS_USE_RING_HEAP) != HEAP_FLAGS_NONE) {
+        DLOGI("Creating ring heap.");
+        CHK_STATUS(ringHeapCreate(&pHeap));
     } else {
         DLOGI("Creating AIV heap.");
         CHK_STATUS(aivHeapCreate(&pHeap));
+
+        // Check whether we need to use the segregated size-class free lists
+        if ((behaviorFlags & FLAGS_USE_AIV_HEAP_SIZE_CLASSES) != HEAP_FLAGS_NONE) {
+            DLOGI("Using AIV heap size-class free lists.");
+            ((PAivHeap) pHeap)->sizeClassed = TRUE;
+        }
     }
 
     // See if we have hybrid heap specified and if vcsm libs are present
@@ -76,7 +89,7 @@ STATUS heapInitialize(UINT64 heapLimit, UINT32 spillRatio, UINT32 behaviorFlags,
         pHeap = (PHeap) pHybridHeap;
     } else if ((behaviorFlags & FLAGS_USE_HYBRID_FILE_HEAP) != HEAP_FLAGS_NONE) {
         DLOGI("Creating hybrid file heap with flags: 0x%08x", behaviorFlags);
-        CHK_STATUS(hybridFileCreateHeap(pHeap, spillRatio, pRootDirectory, &pFileHeap));
+        CHK_STATUS(hybridFileCreateHeap(pHeap, spillRatio, behaviorFlags, pRootDirectory, &pFileHeap));
 
         // Store the file hybrid heap as the returned heap object
         pHeap = (PHeap) pFileHeap;
@@ -279,7 +292,7 @@ STATUS heapMap(PHeap pHeap, ALLOCATION_HANDLE handle, PVOID* ppAllocation, PUINT
     CHK(IS_VALID_ALLOCATION_HANDLE(handle), STATUS_INVALID_ARG);
 
     DLOGS("Mapping handle 0x%016" PRIx64, handle);
-    CHK_STATUS(pBase->heapMapFn(pHeap, handle, ppAllocation, pSize));
+    CHK_STATUS(pBase->heapMapFn(pHeap, handle, ppAllocation, pSize, FALSE));
 
 CleanUp:
     LEAVES();
@@ -302,7 +315,137 @@ STATUS heapUnmap(PHeap pHeap, PVOID pAllocation)
     CHK(pBase != NULL && pAllocation != NULL, STATUS_NULL_ARG);
 
     DLOGS("Un-mapping buffer: %p", pAllocation);
-    CHK_STATUS(pBase->heapUnmapFn(pHeap, pAllocation));
+    CHK_STATUS(pBase->heapUnmapFn(pHeap, pAllocation, FALSE));
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Maps the previously allocated memory handle for read-only access.
+ * The heap can skip persisting the content when the mapping is released.
+ *
+ * Param:
+ *      @pHeap - The heap pointer
+ *      @handle - The allocated memory handle
+ *      @ppAllocation - The returned memory pointer
+ *      @pSize - The returned size of the allocation
+ */
+STATUS heapMapReadOnly(PHeap pHeap, ALLOCATION_HANDLE handle, PVOID* ppAllocation, PUINT64 pSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PBaseHeap pBase = (PBaseHeap) pHeap;
+
+    CHK(pBase != NULL && ppAllocation != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_ALLOCATION_HANDLE(handle), STATUS_INVALID_ARG);
+
+    DLOGS("Mapping read-only handle 0x%016" PRIx64, handle);
+    CHK_STATUS(pBase->heapMapFn(pHeap, handle, ppAllocation, pSize, TRUE));
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Un maps the allocation previously mapped for read-only access.
+ *
+ * Param:
+ *      @pHeap - The heap pointer
+ *      @pAllocation - The mapped allocation pointer
+ */
+STATUS heapUnmapReadOnly(PHeap pHeap, PVOID pAllocation)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PBaseHeap pBase = (PBaseHeap) pHeap;
+
+    CHK(pBase != NULL && pAllocation != NULL, STATUS_NULL_ARG);
+
+    DLOGS("Un-mapping read-only buffer: %p", pAllocation);
+    CHK_STATUS(pBase->heapUnmapFn(pHeap, pAllocation, TRUE));
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Demotes the allocation to the slower storage tier for the heaps supporting tiering.
+ * The handle is left intact for the single tier heaps or if the in-memory tier usage is below the watermark.
+ *
+ * Param:
+ *      @pHeap - The heap pointer
+ *      @pHandle - IN/OUT - The allocation handle which will be updated on demotion
+ *      @watermark - The in-memory tier usage percentage at or above which to demote
+ *      @pDemoted - OUT - OPTIONAL Whether the allocation has been moved or already resided in the slower tier
+ */
+STATUS heapDemote(PHeap pHeap, PALLOCATION_HANDLE pHandle, UINT32 watermark, PBOOL pDemoted)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PBaseHeap pBase = (PBaseHeap) pHeap;
+    BOOL demoted = FALSE;
+
+    CHK(pBase != NULL && pHandle != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_ALLOCATION_HANDLE(*pHandle) && watermark <= 100, STATUS_INVALID_ARG);
+
+    DLOGS("Demoting handle 0x%016" PRIx64, *pHandle);
+    CHK_STATUS(pBase->heapDemoteFn(pHeap, pHandle, watermark, &demoted));
+
+CleanUp:
+
+    if (pDemoted != NULL) {
+        *pDemoted = demoted;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Checks whether the allocation is stored in the persistent storage tier and will survive the heap release.
+ *
+ * Param:
+ *      @pHeap - The heap pointer
+ *      @handle - The allocation handle
+ *      @pPersisted - OUT - Whether the allocation is persisted
+ */
+STATUS heapCheckPersisted(PHeap pHeap, ALLOCATION_HANDLE handle, PBOOL pPersisted)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PBaseHeap pBase = (PBaseHeap) pHeap;
+
+    CHK(pBase != NULL && pPersisted != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_ALLOCATION_HANDLE(handle), STATUS_INVALID_ARG);
+
+    CHK_STATUS(pBase->heapCheckPersistedFn(pHeap, handle, pPersisted));
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Releases the persisted allocations recovered from the previous run which are not claimed by the caller.
+ *
+ * Param:
+ *      @pHeap - The heap pointer
+ *      @pClaimed - IN/OUT - The claimed allocation handles. The array is re-ordered
+ *      @claimedCount - The number of the claimed handles
+ */
+STATUS heapReleaseUnclaimed(PHeap pHeap, PALLOCATION_HANDLE pClaimed, UINT32 claimedCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PBaseHeap pBase = (PBaseHeap) pHeap;
+
+    CHK(pBase != NULL && (pClaimed != NULL || claimedCount == 0), STATUS_NULL_ARG);
+
+    CHK_STATUS(pBase->heapReleaseUnclaimedFn(pHeap, pClaimed, claimedCount));
 
 CleanUp:
     LEAVES();
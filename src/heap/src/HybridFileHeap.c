@@ -17,7 +17,10 @@ ALLOCATION_FOOTER gFileFooter = {0};
 
 #define FILE_ALLOCATION_HEADER_SIZE SIZEOF(gFileHeader)
 
-STATUS hybridFileCreateHeap(PHeap pHeap, UINT32 spillRatio, PCHAR pRootDirectory, PHybridFileHeap* ppHybridHeap)
+// Overall segment block size for a given allocation size
+#define FILE_HEAP_BLOCK_SIZE(size) FILE_HEAP_PACKED_SIZE(FILE_ALLOCATION_HEADER_SIZE + (size))
+
+STATUS hybridFileCreateHeap(PHeap pHeap, UINT32 spillRatio, UINT32 behaviorFlags, PCHAR pRootDirectory, PHybridFileHeap* ppHybridHeap)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
@@ -35,9 +38,19 @@ STATUS hybridFileCreateHeap(PHeap pHeap, UINT32 spillRatio, PCHAR pRootDirectory
     // Set the values
     pHybridHeap->pMemHeap = (PBaseHeap) pHeap;
     pHybridHeap->spillRatio = (DOUBLE) spillRatio / 100;
-
-    // IMPORTANT: We should start from a non-zero handle num to avoid a collision with the invalid handle value
-    pHybridHeap->handleNum = FILE_HEAP_STARTING_FILE_INDEX;
+    pHybridHeap->persistent = (behaviorFlags & FLAGS_PERSIST_HYBRID_FILE_HEAP) != HEAP_FLAGS_NONE;
+
+    // The segment files and the block descriptors are created on heap initialization
+    pHybridHeap->fileHeapLimit = 0;
+    pHybridHeap->segmentCount = 0;
+    pHybridHeap->pSegmentMappings = NULL;
+    pHybridHeap->recovered = FALSE;
+    pHybridHeap->indexFile = FILE_HEAP_INVALID_SEGMENT_FILE;
+    pHybridHeap->pIndex = NULL;
+    pHybridHeap->pBlocks = NULL;
+    pHybridHeap->blockCapacity = 0;
+    pHybridHeap->freeBlock = FILE_HEAP_INVALID_BLOCK_INDEX;
+    pHybridHeap->unusedBlock = FILE_HEAP_INVALID_BLOCK_INDEX;
 
     // Set the root path. Use default if not specified
     if (pRootDirectory == NULL || pRootDirectory[0] == '\0') {
@@ -65,6 +78,9 @@ STATUS hybridFileCreateHeap(PHeap pHeap, UINT32 spillRatio, PCHAR pRootDirectory
     pBaseHeap->heapSetAllocSizeFn = hybridFileHeapSetAllocSize;
     pBaseHeap->heapMapFn = hybridFileHeapMap;
     pBaseHeap->heapUnmapFn = hybridFileHeapUnmap;
+    pBaseHeap->heapDemoteFn = hybridFileHeapDemote;
+    pBaseHeap->heapCheckPersistedFn = hybridFileHeapCheckPersisted;
+    pBaseHeap->heapReleaseUnclaimedFn = hybridFileHeapReleaseUnclaimed;
     pBaseHeap->heapDebugCheckAllocatorFn = hybridFileHeapDebugCheckAllocator;
     pBaseHeap->getAllocationSizeFn = hybridFileGetAllocationSize;
     pBaseHeap->getAllocationHeaderSizeFn = hybridFileGetAllocationHeaderSize;
@@ -93,6 +109,9 @@ DEFINE_HEAP_CHK(hybridFileHeapDebugCheckAllocator)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
+    PFILE_HEAP_BLOCK pBlock, pNext;
+    UINT32 i, freeCount = 0, freeListCount = 0, allocCount = 0;
+    UINT64 freeSize = 0;
 
     // Try the contained heap first
     CHK_STATUS(pHybridHeap->pMemHeap->heapDebugCheckAllocatorFn((PHeap) pHybridHeap->pMemHeap, dump));
@@ -100,6 +119,50 @@ DEFINE_HEAP_CHK(hybridFileHeapDebugCheckAllocator)
     // Delegate the call directly
     CHK_STATUS(commonHeapDebugCheckAllocator(pHeap, dump));
 
+    // Validate the segment block chains
+    for (i = 0; i < pHybridHeap->blockCapacity; i++) {
+        pBlock = &pHybridHeap->pBlocks[i];
+        if (pBlock->flags == ALLOCATION_FLAGS_NONE) {
+            continue;
+        }
+
+        if (pBlock->flags == ALLOCATION_FLAGS_ALLOC) {
+            CHK_ERR(FILE_HEAP_BLOCK_SIZE(pBlock->allocSize) <= pBlock->size, STATUS_HEAP_CORRUPTED,
+                    "Block %u allocation size %" PRIu64 " exceeds the block size %" PRIu64, i, pBlock->allocSize, pBlock->size);
+            CHK_ERR(GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pBlock)->size == pBlock->allocSize, STATUS_HEAP_CORRUPTED,
+                    "Block %u mapped allocation header doesn't match the descriptor", i);
+        }
+
+        if (pBlock->next != FILE_HEAP_INVALID_BLOCK_INDEX) {
+            pNext = &pHybridHeap->pBlocks[pBlock->next];
+            CHK_ERR(pNext->prev == i && pNext->offset == pBlock->offset + pBlock->size, STATUS_HEAP_CORRUPTED, "Block %u has an invalid next link",
+                    i);
+            CHK_ERR(pBlock->flags != ALLOCATION_FLAGS_FREE || pNext->flags != ALLOCATION_FLAGS_FREE, STATUS_HEAP_CORRUPTED,
+                    "Adjacent free blocks %u and %u are not coalesced", i, pBlock->next);
+        }
+
+        if (pBlock->flags == ALLOCATION_FLAGS_FREE) {
+            freeCount++;
+            freeSize += pBlock->size;
+        } else {
+            allocCount++;
+        }
+    }
+
+    for (i = pHybridHeap->freeBlock; i != FILE_HEAP_INVALID_BLOCK_INDEX; i = pHybridHeap->pBlocks[i].nextFree) {
+        freeListCount++;
+    }
+
+    CHK_ERR(freeCount == freeListCount, STATUS_HEAP_CORRUPTED, "Free block count %u doesn't match the free list count %u", freeCount,
+            freeListCount);
+
+    if (dump) {
+        DLOGI("File heap segment count: \t%u", pHybridHeap->segmentCount);
+        DLOGI("File heap allocated blocks: \t%u", allocCount);
+        DLOGI("File heap free blocks: \t%u", freeCount);
+        DLOGI("File heap free size: \t%" PRIu64, freeSize);
+    }
+
 CleanUp:
     LEAVES();
     return retStatus;
@@ -114,6 +177,7 @@ DEFINE_INIT_HEAP(hybridFileHeapInit)
     STATUS retStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
     UINT64 memHeapLimit, fileHeapLimit;
+    UINT32 i, index;
 
     // Calling base "class" functionality first
     CHK_STATUS(commonHeapInit(pHeap, heapLimit));
@@ -129,7 +193,35 @@ DEFINE_INIT_HEAP(hybridFileHeapInit)
     CHK_STATUS_ERR(pHybridHeap->pMemHeap->heapInitializeFn((PHeap) pHybridHeap->pMemHeap, memHeapLimit), STATUS_HEAP_DIRECT_MEM_INIT,
                    "Failed to initialize the in-memory heap with limit size %" PRIu64, memHeapLimit);
 
-    // Initialize the file hybrid heap
+    // Initialize the file hybrid heap.
+    // The file heap limit is covered by the segment files. The segment files are created, sized and memory mapped
+    // on first use so only the segments in use take up the address space. The segment files are sparse so the
+    // storage is not committed upfront. The allocations are accessed in place within the mapped segments.
+    pHybridHeap->fileHeapLimit = fileHeapLimit;
+    pHybridHeap->segmentCount = (UINT32) ((fileHeapLimit + FILE_HEAP_MAX_SEGMENT_SIZE - 1) / FILE_HEAP_MAX_SEGMENT_SIZE);
+    CHK(pHybridHeap->segmentCount == 0 ||
+            NULL != (pHybridHeap->pSegmentMappings = (PBYTE*) MEMCALLOC(pHybridHeap->segmentCount, SIZEOF(PBYTE))),
+        STATUS_NOT_ENOUGH_MEMORY);
+
+    // The persistent heap keeps the block descriptors in a memory mapped index file. In case the index
+    // from the previous run matches the heap configuration we re-attach to the existing segment files.
+    if (pHybridHeap->persistent) {
+        CHK_STATUS(openFileHeapIndex(pHybridHeap, &pHybridHeap->recovered));
+    }
+
+    // The block chains are re-created from the persisted descriptors on recovery
+    if (pHybridHeap->recovered) {
+        CHK_STATUS(recoverFileHeapBlocks(pHybridHeap));
+    } else {
+        // Each segment starts as a single free block. The first segment is kept at the head of the free list.
+        for (i = pHybridHeap->segmentCount; i > 0; i--) {
+            CHK_STATUS(newFileHeapBlock(pHybridHeap, &index));
+            pHybridHeap->pBlocks[index].segment = i - 1;
+            pHybridHeap->pBlocks[index].offset = 0;
+            pHybridHeap->pBlocks[index].size = GET_FILE_HEAP_SEGMENT_SIZE(fileHeapLimit, i - 1);
+            linkFreeFileHeapBlock(pHybridHeap, index);
+        }
+    }
 
 CleanUp:
 
@@ -147,6 +239,7 @@ DEFINE_RELEASE_HEAP(hybridFileHeapRelease)
     STATUS memHeapStatus = STATUS_SUCCESS;
     STATUS hybridHeapStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
+    UINT32 i;
 
     // The call should be idempotent
     CHK(pHeap != NULL, STATUS_SUCCESS);
@@ -159,8 +252,31 @@ DEFINE_RELEASE_HEAP(hybridFileHeapRelease)
         DLOGW("Failed to release in-memory heap with 0x%08x", memHeapStatus);
     }
 
-    // Remove all of the lingering files if any
-    if (STATUS_FAILED(hybridHeapStatus = traverseDirectory(pHybridHeap->rootDirectory, (UINT64) pHybridHeap, FALSE, removeHeapFile))) {
+    // Unmap the segment files before removing them
+    if (pHybridHeap->pSegmentMappings != NULL) {
+        for (i = 0; i < pHybridHeap->segmentCount; i++) {
+            if (pHybridHeap->pSegmentMappings[i] != NULL) {
+                unmapSegmentFile(pHybridHeap->pSegmentMappings[i], GET_FILE_HEAP_SEGMENT_SIZE(pHybridHeap->fileHeapLimit, i));
+            }
+        }
+
+        MEMFREE(pHybridHeap->pSegmentMappings);
+    }
+
+    // The descriptors of the persistent heap live in the index file mapping
+    if (pHybridHeap->pIndex != NULL) {
+        unmapSegmentFile((PBYTE) pHybridHeap->pIndex, GET_FILE_HEAP_INDEX_SIZE(pHybridHeap->blockCapacity));
+    } else {
+        SAFE_MEMFREE(pHybridHeap->pBlocks);
+    }
+
+    if (pHybridHeap->indexFile != FILE_HEAP_INVALID_SEGMENT_FILE) {
+        closeSegmentFile(pHybridHeap->indexFile);
+    }
+
+    // Remove all of the lingering files if any. The persistent heap keeps the files for the next run.
+    if (!pHybridHeap->persistent &&
+        STATUS_FAILED(hybridHeapStatus = traverseDirectory(pHybridHeap->rootDirectory, (UINT64) pHybridHeap, FALSE, removeHeapFile))) {
         DLOGW("Failed to clear file heap remaining files with 0x%08x", hybridHeapStatus);
     }
 
@@ -180,13 +296,8 @@ DEFINE_HEAP_ALLOC(hybridFileHeapAlloc)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
-
-    // overall allocation size
-    UINT64 allocationSize = size + FILE_ALLOCATION_HEADER_SIZE + FILE_ALLOCATION_FOOTER_SIZE;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    ALLOCATION_HEADER allocationHeader;
-    ALLOCATION_HANDLE handle;
-    INT32 retCode;
+    PALLOCATION_HEADER pHeader;
+    UINT32 index = FILE_HEAP_INVALID_BLOCK_INDEX;
 
     // Call the base class for the accounting
     retStatus = commonHeapAlloc(pHeap, size, pHandle);
@@ -213,29 +324,26 @@ DEFINE_HEAP_ALLOC(hybridFileHeapAlloc)
 
     DLOGS("Allocating from File heap");
 
-    // Try to allocate from file storage
-    retCode =
-        SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR, pHybridHeap->handleNum);
-    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
+    // Try to allocate from the segment files. This is pure bookkeeping apart from mapping the segment on first use.
+    retStatus = acquireFileHeapBlock(pHybridHeap, size, &index);
 
-    // Create a file with the overall size
-    CHK_STATUS(createFile(filePath, allocationSize));
+    // We might hit this due to fragmentation of the segments
+    // IMPORTANT! We will return success without setting the handle
+    if (index == FILE_HEAP_INVALID_BLOCK_INDEX) {
+        // Make sure we decrement the counters by calling decrement
+        decrementUsage(pHeap, FILE_ALLOCATION_HEADER_SIZE + size + FILE_ALLOCATION_FOOTER_SIZE);
 
-    // Return the file handle number and increment it
-    handle = FROM_FILE_HANDLE(pHybridHeap->handleNum);
+        CHK(FALSE, retStatus);
+    }
 
-    // map, write, unmap
-    // Set the header - no footer for file heap
-    allocationHeader = gFileHeader;
-    allocationHeader.size = size;
-    allocationHeader.fileHandle = pHybridHeap->handleNum;
-    CHK_STATUS(updateFile(filePath, TRUE, (PBYTE) &allocationHeader, 0, FILE_ALLOCATION_HEADER_SIZE));
+    // Set the header in the mapped segment - no footer for file heap
+    pHeader = GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, &pHybridHeap->pBlocks[index]);
+    *pHeader = gFileHeader;
+    pHeader->size = size;
+    pHeader->fileHandle = index;
 
     // Setting the return handle
-    *pHandle = handle;
-
-    // Increment the handle number
-    pHybridHeap->handleNum++;
+    *pHandle = FROM_FILE_HANDLE(index);
 
 CleanUp:
 
@@ -250,9 +358,6 @@ DEFINE_HEAP_FREE(hybridFileHeapFree)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    UINT32 fileHandle;
-    INT32 retCode;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
 
     // Calling the base first - this should do the accounting
@@ -267,29 +372,10 @@ DEFINE_HEAP_FREE(hybridFileHeapFree)
         CHK(FALSE, STATUS_SUCCESS);
     }
 
-    // In case it's a direct allocation handle use the encapsulated direct memory heap
     DLOGS("Indirect allocation");
-    // Convert the handle and create the file path
-    fileHandle = TO_FILE_HANDLE(handle);
-    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR, fileHandle);
-    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
-
-    retCode = FREMOVE(filePath);
-
-    if (retCode != 0) {
-        switch (errno) {
-            case EACCES:
-                retStatus = STATUS_DIRECTORY_ACCESS_DENIED;
-                break;
 
-            case ENOENT:
-                retStatus = STATUS_DIRECTORY_MISSING_PATH;
-                break;
-
-            default:
-                retStatus = STATUS_REMOVE_FILE_FAILED;
-        }
-    }
+    // The handle has been validated by the accounting. Return the block to the segment.
+    freeFileHeapBlock(pHybridHeap, TO_FILE_HANDLE(handle));
 
 CleanUp:
     LEAVES();
@@ -304,10 +390,7 @@ DEFINE_HEAP_GET_ALLOC_SIZE(hybridFileHeapGetAllocSize)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
-    ALLOCATION_HEADER allocationHeader;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    UINT32 fileHandle;
-    INT32 retCode;
+    PFILE_HEAP_BLOCK pBlock;
 
     // Call the base class to ensure the params are ok and set the default ret values
     CHK_STATUS(commonHeapGetAllocSize(pHeap, handle, pAllocSize));
@@ -321,17 +404,11 @@ DEFINE_HEAP_GET_ALLOC_SIZE(hybridFileHeapGetAllocSize)
         CHK(FALSE, STATUS_SUCCESS);
     }
 
-    // Convert the handle
-    fileHandle = TO_FILE_HANDLE(handle);
-    DLOGS("File heap allocation. Handle 0x%016" PRIx64 " File handle 0x%08x", handle, fileHandle);
-
-    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR, fileHandle);
-    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
-
-    CHK_STATUS(readFileSegment(filePath, TRUE, (PBYTE) &allocationHeader, 0, FILE_ALLOCATION_HEADER_SIZE));
+    DLOGS("File heap allocation. Handle 0x%016" PRIx64, handle);
+    CHK_STATUS(getFileHeapBlock(pHybridHeap, handle, &pBlock));
 
     // Set the values and return
-    *pAllocSize = allocationHeader.size;
+    *pAllocSize = pBlock->allocSize;
 
 CleanUp:
     LEAVES();
@@ -346,19 +423,14 @@ DEFINE_HEAP_SET_ALLOC_SIZE(hybridFileHeapSetAllocSize)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
+    PFILE_HEAP_BLOCK pBlock, pNext, pNewBlock;
+    PALLOCATION_HEADER pHeader, pNewHeader;
     ALLOCATION_HANDLE handle;
-    ALLOCATION_HEADER allocationHeader;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    UINT32 fileHandle;
-    UINT64 overallSize;
-    INT32 retCode;
+    UINT32 index, nextIndex, newIndex = FILE_HEAP_INVALID_BLOCK_INDEX;
 
     // Call the base class to ensure the params are ok and set the default ret values
     CHK_STATUS(commonHeapSetAllocSize(pHeap, pHandle, size, newSize));
 
-    // overall allocation size
-    overallSize = FILE_ALLOCATION_HEADER_SIZE + newSize + FILE_ALLOCATION_FOOTER_SIZE;
-
     handle = *pHandle;
     // In case it's a direct allocation handle use the encapsulated direct memory heap
     if (IS_DIRECT_ALLOCATION_HANDLE(handle)) {
@@ -373,20 +445,209 @@ DEFINE_HEAP_SET_ALLOC_SIZE(hybridFileHeapSetAllocSize)
         retStatus = STATUS_SUCCESS;
     }
 
-    // Perform in-place file size change
-    fileHandle = TO_FILE_HANDLE(handle);
-    DLOGS("Sets new allocation size %\" PRIu64 \" for handle 0x%016" PRIx64, newSize, handle);
+    DLOGS("Sets new allocation size %" PRIu64 " for handle 0x%016" PRIx64, newSize, handle);
+    CHK_STATUS(getFileHeapBlock(pHybridHeap, handle, &pBlock));
+    index = TO_FILE_HANDLE(handle);
+
+    // Absorb the free block to the right if the new size doesn't fit into the existing block
+    nextIndex = pBlock->next;
+    if (FILE_HEAP_BLOCK_SIZE(newSize) > pBlock->size && nextIndex != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        pNext = &pHybridHeap->pBlocks[nextIndex];
+        if (pNext->flags == ALLOCATION_FLAGS_FREE && pBlock->size + pNext->size >= FILE_HEAP_BLOCK_SIZE(newSize)) {
+            unlinkFreeFileHeapBlock(pHybridHeap, nextIndex);
+            pBlock->size += pNext->size;
+            pBlock->next = pNext->next;
+            if (pBlock->next != FILE_HEAP_INVALID_BLOCK_INDEX) {
+                pHybridHeap->pBlocks[pBlock->next].prev = index;
+            }
+
+            releaseFileHeapBlock(pHybridHeap, nextIndex);
+        }
+    }
 
-    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR, fileHandle);
-    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
-    // Set the file size
-    CHK_STATUS(setFileLength(filePath, overallSize));
+    // Resize in place if the new size fits and split off the remainder
+    if (FILE_HEAP_BLOCK_SIZE(newSize) <= pBlock->size) {
+        pBlock->allocSize = newSize;
+        GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pBlock)->size = newSize;
+        CHK_STATUS(splitFileHeapBlock(pHybridHeap, index, newSize));
+
+        // Early exit
+        CHK(FALSE, retStatus);
+    }
+
+    // Otherwise, move the allocation to a new block
+    CHK_STATUS(acquireFileHeapBlock(pHybridHeap, newSize, &newIndex));
+    CHK(newIndex != FILE_HEAP_INVALID_BLOCK_INDEX, STATUS_NOT_ENOUGH_MEMORY);
+
+    // Re-acquire the pointers as the descriptor table might have been re-allocated
+    pBlock = &pHybridHeap->pBlocks[index];
+    pNewBlock = &pHybridHeap->pBlocks[newIndex];
+
+    // Copy the content over within the mapped segments
+    pHeader = GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pBlock);
+    pNewHeader = GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pNewBlock);
+    *pNewHeader = gFileHeader;
+    pNewHeader->size = newSize;
+    pNewHeader->fileHandle = newIndex;
+    MEMCPY(pNewHeader + 1, pHeader + 1, (SIZE_T) MIN(pBlock->allocSize, newSize));
 
-    // Write the new size
-    allocationHeader = gFileHeader;
-    allocationHeader.size = newSize;
+    freeFileHeapBlock(pHybridHeap, index);
 
-    CHK_STATUS(updateFile(filePath, TRUE, (PBYTE) &allocationHeader, 0, FILE_ALLOCATION_HEADER_SIZE));
+    // Set the return
+    *pHandle = FROM_FILE_HANDLE(newIndex);
+
+CleanUp:
+
+    // Clean-up in case of failure
+    if (STATUS_FAILED(retStatus) && newIndex != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        freeFileHeapBlock(pHybridHeap, newIndex);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Demotes a direct memory allocation into the file system.
+ *
+ * The demotion happens only when the memory heap usage is at or above the watermark percentage of its limit.
+ * Allocations already residing in the file system are left intact and reported demoted. In case there is no space
+ * left in the segment files the handle is left intact and the call still succeeds, similar to the allocation.
+ *
+ * NOTE: The overall heap accounting doesn't change as the allocation is accounted with the file heap
+ * header and footer sizes regardless of the tier it resides in.
+ */
+DEFINE_HEAP_DEMOTE(hybridFileHeapDemote)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
+    PBaseHeap pMemHeap = NULL;
+    PALLOCATION_HEADER pHeader;
+    PVOID pAllocation = NULL;
+    ALLOCATION_HANDLE handle;
+    UINT64 size;
+    UINT32 index = FILE_HEAP_INVALID_BLOCK_INDEX;
+
+    // Call the base class to ensure the params are ok
+    CHK_STATUS(commonHeapDemote(pHeap, pHandle, watermark, pDemoted));
+
+    handle = *pHandle;
+    pMemHeap = pHybridHeap->pMemHeap;
+    *pDemoted = !IS_DIRECT_ALLOCATION_HANDLE(handle);
+
+    // Early exit on allocations which are already in the file system or if the memory heap is below the watermark
+    CHK(IS_DIRECT_ALLOCATION_HANDLE(handle) && pMemHeap->heap.heapSize * 100 >= pMemHeap->heap.heapLimit * watermark, retStatus);
+
+    CHK_STATUS(pMemHeap->heapMapFn((PHeap) pMemHeap, handle, &pAllocation, &size, TRUE));
+
+    // Early exit with success in case the segments are full or fragmented
+    CHK_STATUS(acquireFileHeapBlock(pHybridHeap, size, &index));
+    CHK(index != FILE_HEAP_INVALID_BLOCK_INDEX, retStatus);
+
+    // Set the header and copy the content into the mapped segment
+    pHeader = GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, &pHybridHeap->pBlocks[index]);
+    *pHeader = gFileHeader;
+    pHeader->size = size;
+    pHeader->fileHandle = index;
+    MEMCPY(pHeader + 1, pAllocation, size);
+
+    // Release the memory allocation directly from the memory heap as the accounting stays the same
+    CHK_STATUS(pMemHeap->heapUnmapFn((PHeap) pMemHeap, pAllocation, TRUE));
+    pAllocation = NULL;
+    CHK_STATUS(pMemHeap->heapFreeFn((PHeap) pMemHeap, handle));
+
+    DLOGS("Demoted direct allocation 0x%016" PRIx64 " to file heap block %u", handle, index);
+    *pHandle = FROM_FILE_HANDLE(index);
+    *pDemoted = TRUE;
+
+CleanUp:
+
+    if (pAllocation != NULL) {
+        pMemHeap->heapUnmapFn((PHeap) pMemHeap, pAllocation, TRUE);
+    }
+
+    // Return the block to the segment if we failed to move the allocation
+    if (STATUS_FAILED(retStatus) && index != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        freeFileHeapBlock(pHybridHeap, index);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Checks whether the allocation resides in the segment files of the persistent heap
+ */
+DEFINE_HEAP_CHECK_PERSISTED(hybridFileHeapCheckPersisted)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
+    UINT32 index;
+
+    // Call the base class to ensure the params are ok and set the default ret values
+    CHK_STATUS(commonHeapCheckPersisted(pHeap, handle, pPersisted));
+
+    // Direct allocations are lost with the process
+    CHK(pHybridHeap->persistent && !IS_DIRECT_ALLOCATION_HANDLE(handle), retStatus);
+
+    index = TO_FILE_HANDLE(handle);
+    *pPersisted = index < pHybridHeap->blockCapacity && pHybridHeap->pBlocks[index].flags == ALLOCATION_FLAGS_ALLOC;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the allocations re-attached to on recovery which are not claimed by the caller. The owners of the
+ * persisted allocations, if any, might not survive the restart so their allocations would leak otherwise.
+ *
+ * NOTE: All of the segment file allocations are considered so this should be called before the heap is used.
+ */
+DEFINE_HEAP_RELEASE_UNCLAIMED(hybridFileHeapReleaseUnclaimed)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
+    ALLOCATION_HANDLE handle;
+    UINT32 i, low, high, mid, released = 0;
+
+    // Call the base class to ensure the params are ok
+    CHK_STATUS(commonHeapReleaseUnclaimed(pHeap, pClaimed, claimedCount));
+
+    // Only the persistent heap recovers the allocations
+    CHK(pHybridHeap->persistent, retStatus);
+
+    if (claimedCount != 0) {
+        QSORT(pClaimed, claimedCount, SIZEOF(ALLOCATION_HANDLE), compareAllocationHandles);
+    }
+
+    // Freeing a block only releases the free descriptors so the descriptor table is not re-allocated
+    for (i = 0; i < pHybridHeap->blockCapacity; i++) {
+        if (pHybridHeap->pBlocks[i].flags != ALLOCATION_FLAGS_ALLOC) {
+            continue;
+        }
+
+        handle = FROM_FILE_HANDLE(i);
+        for (low = 0, high = claimedCount; low < high;) {
+            mid = low + (high - low) / 2;
+            if (pClaimed[mid] < handle) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        if (low == claimedCount || pClaimed[low] != handle) {
+            CHK_STATUS(hybridFileHeapFree(pHeap, handle));
+            released++;
+        }
+    }
+
+    DLOGI("Released %u unclaimed file heap allocations", released);
 
 CleanUp:
 
@@ -400,59 +661,37 @@ CleanUp:
  * This works because all our allocators are at least 8 byte aligned so the handle will have it's
  * least significant two bits set as 0. The File heap handle will have it set to 1s.
  *
- * NOTE: In order to map a particular allocation, we will allocate from the common heap for now.
- * A more advanced implementation that requires a tight control over the memory and allocation might
- * choose to reserve a certain amount of memory from the direct RAM heap and allocate from there.
+ * NOTE: The segment files are memory mapped so mapping a file allocation returns a pointer into the
+ * segment mapping without copying. The OS pages the content in and out as needed.
  */
 DEFINE_HEAP_MAP(hybridFileHeapMap)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    UINT32 fileHandle;
-    PALLOCATION_HEADER pAllocation = NULL;
-    UINT64 fileLength;
-    INT32 retCode;
+    PFILE_HEAP_BLOCK pBlock;
 
     // Call the base class to ensure the params are ok and set the default ret values
-    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize));
+    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize, readOnly));
 
     // In case it's a direct allocation handle use the encapsulated direct memory heap
     if (IS_DIRECT_ALLOCATION_HANDLE(handle)) {
         DLOGS("Direct allocation 0x%016" PRIx64, handle);
-        CHK_STATUS(pHybridHeap->pMemHeap->heapMapFn((PHeap) pHybridHeap->pMemHeap, handle, ppAllocation, pSize));
+        CHK_STATUS(pHybridHeap->pMemHeap->heapMapFn((PHeap) pHybridHeap->pMemHeap, handle, ppAllocation, pSize, readOnly));
 
         // Exit on success
         CHK(FALSE, STATUS_SUCCESS);
     }
 
-    // Convert the handle
-    fileHandle = TO_FILE_HANDLE(handle);
-    DLOGS("File heap allocation. Handle 0x%016" PRIx64 " File handle 0x%08x", handle, fileHandle);
-
-    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR, fileHandle);
-    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
-
-    // Get the file size, allocate and read the entire file into memory
-    CHK_STATUS(getFileLength(filePath, &fileLength));
-
-    CHK(NULL != (pAllocation = (PALLOCATION_HEADER) MEMALLOC(fileLength)), STATUS_NOT_ENOUGH_MEMORY);
-
-    CHK_STATUS(readFile(filePath, TRUE, (PBYTE) pAllocation, &fileLength));
-    CHK(pAllocation->type == FILE_ALLOCATION_TYPE && pAllocation->size == fileLength - FILE_ALLOCATION_HEADER_SIZE,
-        STATUS_HEAP_FILE_HEAP_FILE_CORRUPT);
+    DLOGS("File heap allocation. Handle 0x%016" PRIx64, handle);
+    CHK_STATUS(getFileHeapBlock(pHybridHeap, handle, &pBlock));
 
     // Set the values and return
-    *ppAllocation = pAllocation + 1;
-    *pSize = pAllocation->size;
+    *ppAllocation = GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pBlock) + 1;
+    *pSize = pBlock->allocSize;
 
 CleanUp:
 
-    if (STATUS_FAILED(retStatus)) {
-        SAFE_MEMFREE(pAllocation);
-    }
-
     LEAVES();
     return retStatus;
 }
@@ -466,32 +705,28 @@ DEFINE_HEAP_UNMAP(hybridFileHeapUnmap)
     STATUS retStatus = STATUS_SUCCESS;
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
     PALLOCATION_HEADER pHeader = (PALLOCATION_HEADER) pAllocation - 1;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    INT32 retCode;
+    PFILE_HEAP_BLOCK pBlock;
 
     // Call the base class to ensure the params are ok
-    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation));
+    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation, readOnly));
 
     // Check if this is a direct allocation by examining the type
     if (FILE_ALLOCATION_TYPE != pHeader->type) {
         DLOGS("Direct allocation");
 
         // This is a direct allocation - call the encapsulated heap
-        CHK_STATUS(pHybridHeap->pMemHeap->heapUnmapFn((PHeap) pHybridHeap->pMemHeap, pAllocation));
+        CHK_STATUS(pHybridHeap->pMemHeap->heapUnmapFn((PHeap) pHybridHeap->pMemHeap, pAllocation, readOnly));
 
         // Exit on success
         CHK(FALSE, STATUS_SUCCESS);
     }
 
     DLOGS("Indirect allocation");
-    retCode =
-        SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR, pHeader->fileHandle);
-    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
 
-    // Un-maping in this case is simply writing the content into the file storage and releasing the mapped memory
-    CHK_STATUS(writeFile(filePath, TRUE, FALSE, (PBYTE) pHeader, pHeader->size + FILE_ALLOCATION_HEADER_SIZE));
-
-    SAFE_MEMFREE(pHeader);
+    // The allocation points directly into the segment mapping so there is nothing to copy or write back
+    // regardless of the access intent. Just validate the allocation belongs to the heap.
+    CHK_STATUS(getFileHeapBlock(pHybridHeap, FROM_FILE_HANDLE(pHeader->fileHandle), &pBlock));
+    CHK(GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pBlock) == pHeader, STATUS_INVALID_HANDLE_ERROR);
 
 CleanUp:
     LEAVES();
@@ -516,11 +751,8 @@ DEFINE_ALIGNED_SIZE(hybridFileGetAllocationAlignedSize)
 DEFINE_ALLOC_SIZE(hybridFileGetAllocationSize)
 {
     PHybridFileHeap pHybridHeap = (PHybridFileHeap) pHeap;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    UINT32 fileHandle;
-    ALLOCATION_HEADER allocationHeader;
+    PFILE_HEAP_BLOCK pBlock;
     UINT64 memSizes, fileSizes, memHeapAllocationSize;
-    INT32 retCode;
 
     CHECK_EXT(pHeap != NULL, "Internal error with file heap being null");
 
@@ -533,36 +765,13 @@ DEFINE_ALLOC_SIZE(hybridFileGetAllocationSize)
         return memHeapAllocationSize - memSizes + fileSizes;
     }
 
-    // In case of File allocation we need to read the header and get the size
-    fileHandle = TO_FILE_HANDLE(handle);
-    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR, fileHandle);
-    if (retCode > MAX_PATH_LEN) {
-        DLOGW("filepath length has exceeded the maximum allowed");
-    }
-
-    // Read the header to get the size info so we can allocate enough storage
-    if (STATUS_FAILED(readFileSegment(filePath, TRUE, (PBYTE) &allocationHeader, 0, FILE_ALLOCATION_HEADER_SIZE))) {
-        DLOGW("Failed to read the allocation header from file handle %lu", fileHandle);
-        allocationHeader.size = 0;
-    }
-
-#ifdef HEAP_DEBUG
-    // Check the allocation 'guard band' in debug mode
-    if (0 != MEMCMP(allocationHeader.magic, ALLOCATION_HEADER_MAGIC, SIZEOF(ALLOCATION_HEADER_MAGIC))) {
-        DLOGE("Invalid header for file allocation handle %lu", fileHandle);
-        return INVALID_ALLOCATION_VALUE;
-    }
-
-    // We don't use the footer for file allocation for perf purpose
-
-    // Check the type
-    if (FILE_ALLOCATION_TYPE != allocationHeader.type) {
-        DLOGE("Invalid allocation type 0x%08x for file handle %lu", allocationHeader.type, fileHandle);
+    // In case of File allocation the size is kept in the block descriptor
+    if (STATUS_FAILED(getFileHeapBlock(pHybridHeap, handle, &pBlock))) {
+        DLOGE("Invalid file allocation handle 0x%016" PRIx64, handle);
         return INVALID_ALLOCATION_VALUE;
     }
-#endif
 
-    return FILE_ALLOCATION_HEADER_SIZE + allocationHeader.size + FILE_ALLOCATION_FOOTER_SIZE;
+    return FILE_ALLOCATION_HEADER_SIZE + pBlock->allocSize + FILE_ALLOCATION_FOOTER_SIZE;
 }
 
 DEFINE_HEAP_LIMITS(hybridFileGetHeapLimits)
@@ -609,3 +818,733 @@ STATUS removeHeapFile(UINT64 callerData, DIR_ENTRY_TYPES entryType, PCHAR path,
 CleanUp:
     return retStatus;
 }
+
+/**
+ * Opens or creates the segment file optionally discarding the existing content
+ */
+STATUS openSegmentFile(PCHAR filePath, BOOL truncate, PINT32 pFile)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    INT32 file = FILE_HEAP_INVALID_SEGMENT_FILE;
+
+    CHK(filePath != NULL && pFile != NULL, STATUS_NULL_ARG);
+
+#if defined __WINDOWS_BUILD__
+    file = _open(filePath, _O_RDWR | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+#else
+    file = open(filePath, O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), S_IRUSR | S_IWUSR);
+#endif
+    CHK(file != FILE_HEAP_INVALID_SEGMENT_FILE, STATUS_OPEN_FILE_FAILED);
+
+    *pFile = file;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Sets the segment file size. The files are extended sparsely with zeros
+ */
+STATUS resizeSegmentFile(INT32 file, UINT64 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+#if defined __WINDOWS_BUILD__
+    CHK(0 == _chsize_s(file, size), STATUS_NOT_ENOUGH_MEMORY);
+#else
+    CHK(0 == ftruncate(file, (off_t) size), STATUS_NOT_ENOUGH_MEMORY);
+#endif
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Reserves the disk blocks of the segment file. The stores into a sparse file mapping fault
+ * rather than fail once the volume fills up so the blocks are allocated before the file is mapped.
+ */
+STATUS reserveSegmentFile(INT32 file, UINT64 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+#if defined __MACH__
+    fstore_t store;
+#endif
+
+#if defined __WINDOWS_BUILD__
+    // The files are not sparse so extending the file allocates its clusters
+    CHK(0 == _chsize_s(file, size), STATUS_NOT_ENOUGH_MEMORY);
+#elif defined __MACH__
+    store.fst_flags = F_ALLOCATEALL;
+    store.fst_posmode = F_PEOFPOSMODE;
+    store.fst_offset = 0;
+    store.fst_length = (off_t) size;
+    store.fst_bytesalloc = 0;
+    CHK(-1 != fcntl(file, F_PREALLOCATE, &store), STATUS_NOT_ENOUGH_MEMORY);
+#else
+    CHK(0 == posix_fallocate(file, 0, (off_t) size), STATUS_NOT_ENOUGH_MEMORY);
+#endif
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Gets the current segment file size
+ */
+STATUS getSegmentFileSize(INT32 file, PUINT64 pSize)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+#if defined __WINDOWS_BUILD__
+    INT64 size;
+#else
+    struct stat fileStat;
+#endif
+
+    CHK(pSize != NULL, STATUS_NULL_ARG);
+
+#if defined __WINDOWS_BUILD__
+    CHK(-1 != (size = _filelengthi64(file)), STATUS_READ_FILE_FAILED);
+    *pSize = (UINT64) size;
+#else
+    CHK(0 == fstat(file, &fileStat), STATUS_READ_FILE_FAILED);
+    *pSize = (UINT64) fileStat.st_size;
+#endif
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Closes the segment file
+ */
+STATUS closeSegmentFile(INT32 file)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+#if defined __WINDOWS_BUILD__
+    CHK(0 == _close(file), STATUS_INVALID_OPERATION);
+#else
+    CHK(0 == close(file), STATUS_INVALID_OPERATION);
+#endif
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Maps the entire segment file into memory
+ */
+STATUS mapSegmentFile(INT32 file, UINT64 size, PBYTE* ppMapping)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PVOID pMapping = NULL;
+#if defined __WINDOWS_BUILD__
+    HANDLE mapping;
+#endif
+
+    CHK(ppMapping != NULL, STATUS_NULL_ARG);
+
+#if defined __WINDOWS_BUILD__
+    mapping = CreateFileMapping((HANDLE) _get_osfhandle(file), NULL, PAGE_READWRITE, (DWORD) (size >> 32), (DWORD) size, NULL);
+    CHK(mapping != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    // The view keeps the mapping object alive
+    pMapping = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T) size);
+    CloseHandle(mapping);
+    CHK(pMapping != NULL, STATUS_NOT_ENOUGH_MEMORY);
+#else
+    pMapping = mmap(NULL, (SIZE_T) size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    CHK(pMapping != MAP_FAILED, STATUS_NOT_ENOUGH_MEMORY);
+#endif
+
+    *ppMapping = (PBYTE) pMapping;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Un-maps the segment file
+ */
+STATUS unmapSegmentFile(PBYTE pMapping, UINT64 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+#if defined __WINDOWS_BUILD__
+    UNUSED_PARAM(size);
+    CHK(UnmapViewOfFile(pMapping), STATUS_INVALID_OPERATION);
+#else
+    CHK(0 == munmap(pMapping, (SIZE_T) size), STATUS_INVALID_OPERATION);
+#endif
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Creates, reserves, sizes and maps the segment file unless it's already mapped. The segment files of the previous
+ * run are discarded unless the heap is re-attached to them. Fails with STATUS_NOT_ENOUGH_MEMORY if the volume can't
+ * back the entire segment in which case the segment stays unmapped.
+ */
+STATUS mapFileHeapSegment(PHybridFileHeap pHybridHeap, UINT32 segment)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CHAR filePath[MAX_PATH_LEN + 1];
+    UINT64 segmentSize = GET_FILE_HEAP_SEGMENT_SIZE(pHybridHeap->fileHeapLimit, segment);
+    INT32 retCode, file = FILE_HEAP_INVALID_SEGMENT_FILE;
+
+    CHK(pHybridHeap->pSegmentMappings[segment] == NULL, retStatus);
+
+    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR,
+                       segment + FILE_HEAP_STARTING_FILE_INDEX);
+    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
+
+    CHK_STATUS(openSegmentFile(filePath, !pHybridHeap->recovered, &file));
+
+    // The mapping remains valid after the file is closed
+    CHK_STATUS(reserveSegmentFile(file, segmentSize));
+    CHK_STATUS(resizeSegmentFile(file, segmentSize));
+    CHK_STATUS(mapSegmentFile(file, segmentSize, &pHybridHeap->pSegmentMappings[segment]));
+
+    DLOGS("Mapped file heap segment %u with size %" PRIu64, segment, segmentSize);
+
+CleanUp:
+
+    if (file != FILE_HEAP_INVALID_SEGMENT_FILE) {
+        closeSegmentFile(file);
+    }
+
+    return retStatus;
+}
+
+/**
+ * Validates the file allocation handle and returns the block descriptor
+ */
+STATUS getFileHeapBlock(PHybridFileHeap pHybridHeap, ALLOCATION_HANDLE handle, PFILE_HEAP_BLOCK* ppBlock)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 index = TO_FILE_HANDLE(handle);
+
+    CHK(pHybridHeap != NULL && ppBlock != NULL, STATUS_NULL_ARG);
+    CHK_ERR(index < pHybridHeap->blockCapacity && pHybridHeap->pBlocks[index].flags == ALLOCATION_FLAGS_ALLOC, STATUS_INVALID_HANDLE_ERROR,
+            "Invalid file allocation handle 0x%016" PRIx64, handle);
+
+    *ppBlock = &pHybridHeap->pBlocks[index];
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Gets an unused block descriptor growing the descriptor table if needed.
+ *
+ * IMPORTANT!!! The descriptor table might be re-allocated so the block pointers need to be re-acquired
+ */
+STATUS newFileHeapBlock(PHybridFileHeap pHybridHeap, PUINT32 pIndex)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFILE_HEAP_BLOCK pBlocks;
+    UINT32 i, capacity;
+
+    if (pHybridHeap->unusedBlock == FILE_HEAP_INVALID_BLOCK_INDEX) {
+        capacity = pHybridHeap->blockCapacity == 0 ? FILE_HEAP_DEFAULT_BLOCK_DESCRIPTOR_COUNT : pHybridHeap->blockCapacity * 2;
+        CHK(capacity > pHybridHeap->blockCapacity && capacity < FILE_HEAP_INVALID_BLOCK_INDEX, STATUS_NOT_ENOUGH_MEMORY);
+
+        // The persistent heap grows the index file instead
+        if (pHybridHeap->persistent) {
+            CHK_STATUS(resizeFileHeapIndex(pHybridHeap, capacity));
+        } else {
+            CHK(NULL != (pBlocks = (PFILE_HEAP_BLOCK) MEMREALLOC(pHybridHeap->pBlocks, capacity * SIZEOF(FILE_HEAP_BLOCK))),
+                STATUS_NOT_ENOUGH_MEMORY);
+            pHybridHeap->pBlocks = pBlocks;
+        }
+
+        // Chain the new descriptors into the unused list
+        pBlocks = pHybridHeap->pBlocks;
+        for (i = pHybridHeap->blockCapacity; i < capacity; i++) {
+            pBlocks[i].flags = ALLOCATION_FLAGS_NONE;
+            pBlocks[i].nextFree = i + 1 < capacity ? i + 1 : FILE_HEAP_INVALID_BLOCK_INDEX;
+        }
+
+        pHybridHeap->unusedBlock = pHybridHeap->blockCapacity;
+        pHybridHeap->blockCapacity = capacity;
+    }
+
+    *pIndex = pHybridHeap->unusedBlock;
+    pBlocks = &pHybridHeap->pBlocks[*pIndex];
+    pHybridHeap->unusedBlock = pBlocks->nextFree;
+
+    pBlocks->offset = 0;
+    pBlocks->size = 0;
+    pBlocks->allocSize = 0;
+    pBlocks->segment = 0;
+    pBlocks->flags = ALLOCATION_FLAGS_FREE;
+    pBlocks->prev = FILE_HEAP_INVALID_BLOCK_INDEX;
+    pBlocks->next = FILE_HEAP_INVALID_BLOCK_INDEX;
+    pBlocks->prevFree = FILE_HEAP_INVALID_BLOCK_INDEX;
+    pBlocks->nextFree = FILE_HEAP_INVALID_BLOCK_INDEX;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Returns the block descriptor to the unused list
+ */
+VOID releaseFileHeapBlock(PHybridFileHeap pHybridHeap, UINT32 index)
+{
+    PFILE_HEAP_BLOCK pBlock = &pHybridHeap->pBlocks[index];
+
+    pBlock->flags = ALLOCATION_FLAGS_NONE;
+    pBlock->nextFree = pHybridHeap->unusedBlock;
+    pHybridHeap->unusedBlock = index;
+}
+
+/**
+ * Finds the first free block that fits the allocation
+ */
+UINT32 findFreeFileHeapBlock(PHybridFileHeap pHybridHeap, UINT64 size)
+{
+    UINT32 index;
+    UINT64 packedSize = FILE_HEAP_BLOCK_SIZE(size);
+
+    for (index = pHybridHeap->freeBlock; index != FILE_HEAP_INVALID_BLOCK_INDEX; index = pHybridHeap->pBlocks[index].nextFree) {
+        if (pHybridHeap->pBlocks[index].size >= packedSize) {
+            break;
+        }
+    }
+
+    return index;
+}
+
+/**
+ * Takes the first free block that fits the allocation off the free list and splits off the remainder.
+ * The segment of the block is mapped if needed. The index is invalid if there is no free block that fits.
+ */
+STATUS acquireFileHeapBlock(PHybridFileHeap pHybridHeap, UINT64 size, PUINT32 pIndex)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFILE_HEAP_BLOCK pBlock;
+    UINT32 index;
+
+    *pIndex = FILE_HEAP_INVALID_BLOCK_INDEX;
+
+    index = findFreeFileHeapBlock(pHybridHeap, size);
+    CHK(index != FILE_HEAP_INVALID_BLOCK_INDEX, retStatus);
+    CHK_STATUS(mapFileHeapSegment(pHybridHeap, pHybridHeap->pBlocks[index].segment));
+
+    unlinkFreeFileHeapBlock(pHybridHeap, index);
+    pBlock = &pHybridHeap->pBlocks[index];
+    pBlock->flags = ALLOCATION_FLAGS_ALLOC;
+    pBlock->allocSize = size;
+
+    // Split off the remainder of the block
+    if (STATUS_FAILED(retStatus = splitFileHeapBlock(pHybridHeap, index, size))) {
+        freeFileHeapBlock(pHybridHeap, index);
+        CHK(FALSE, retStatus);
+    }
+
+    *pIndex = index;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Links the block at the head of the free list
+ */
+VOID linkFreeFileHeapBlock(PHybridFileHeap pHybridHeap, UINT32 index)
+{
+    PFILE_HEAP_BLOCK pBlock = &pHybridHeap->pBlocks[index];
+
+    pBlock->prevFree = FILE_HEAP_INVALID_BLOCK_INDEX;
+    pBlock->nextFree = pHybridHeap->freeBlock;
+    if (pHybridHeap->freeBlock != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        pHybridHeap->pBlocks[pHybridHeap->freeBlock].prevFree = index;
+    }
+
+    pHybridHeap->freeBlock = index;
+}
+
+/**
+ * Removes the block from the free list
+ */
+VOID unlinkFreeFileHeapBlock(PHybridFileHeap pHybridHeap, UINT32 index)
+{
+    PFILE_HEAP_BLOCK pBlock = &pHybridHeap->pBlocks[index];
+
+    if (pBlock->prevFree != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        pHybridHeap->pBlocks[pBlock->prevFree].nextFree = pBlock->nextFree;
+    } else {
+        pHybridHeap->freeBlock = pBlock->nextFree;
+    }
+
+    if (pBlock->nextFree != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        pHybridHeap->pBlocks[pBlock->nextFree].prevFree = pBlock->prevFree;
+    }
+
+    pBlock->prevFree = FILE_HEAP_INVALID_BLOCK_INDEX;
+    pBlock->nextFree = FILE_HEAP_INVALID_BLOCK_INDEX;
+}
+
+/**
+ * Splits off the remainder of the allocated block past the given size and returns it to the free list.
+ * Small remainders are kept with the allocated block.
+ */
+STATUS splitFileHeapBlock(PHybridFileHeap pHybridHeap, UINT32 index, UINT64 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFILE_HEAP_BLOCK pBlock, pRemainder, pNext;
+    UINT64 packedSize = FILE_HEAP_BLOCK_SIZE(size);
+    UINT32 remainderIndex, nextIndex;
+
+    CHK(pHybridHeap->pBlocks[index].size - packedSize >= FILE_HEAP_MIN_FREE_BLOCK_SIZE, retStatus);
+
+    CHK_STATUS(newFileHeapBlock(pHybridHeap, &remainderIndex));
+
+    // Acquire the pointers after the descriptor table might have been re-allocated
+    pBlock = &pHybridHeap->pBlocks[index];
+    pRemainder = &pHybridHeap->pBlocks[remainderIndex];
+
+    pRemainder->segment = pBlock->segment;
+    pRemainder->offset = pBlock->offset + packedSize;
+    pRemainder->size = pBlock->size - packedSize;
+    pRemainder->prev = index;
+    pRemainder->next = pBlock->next;
+    pBlock->size = packedSize;
+    pBlock->next = remainderIndex;
+
+    // Coalesce with the following block if it's free
+    nextIndex = pRemainder->next;
+    if (nextIndex != FILE_HEAP_INVALID_BLOCK_INDEX && pHybridHeap->pBlocks[nextIndex].flags == ALLOCATION_FLAGS_FREE) {
+        pNext = &pHybridHeap->pBlocks[nextIndex];
+        unlinkFreeFileHeapBlock(pHybridHeap, nextIndex);
+        pRemainder->size += pNext->size;
+        pRemainder->next = pNext->next;
+        releaseFileHeapBlock(pHybridHeap, nextIndex);
+    }
+
+    if (pRemainder->next != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        pHybridHeap->pBlocks[pRemainder->next].prev = remainderIndex;
+    }
+
+    linkFreeFileHeapBlock(pHybridHeap, remainderIndex);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Frees the block coalescing it with the free neighbours
+ */
+VOID freeFileHeapBlock(PHybridFileHeap pHybridHeap, UINT32 index)
+{
+    PFILE_HEAP_BLOCK pBlock = &pHybridHeap->pBlocks[index], pNeighbour;
+    UINT32 neighbourIndex;
+
+    pBlock->flags = ALLOCATION_FLAGS_FREE;
+    pBlock->allocSize = 0;
+
+    // Absorb the following block if it's free
+    neighbourIndex = pBlock->next;
+    if (neighbourIndex != FILE_HEAP_INVALID_BLOCK_INDEX && pHybridHeap->pBlocks[neighbourIndex].flags == ALLOCATION_FLAGS_FREE) {
+        pNeighbour = &pHybridHeap->pBlocks[neighbourIndex];
+        unlinkFreeFileHeapBlock(pHybridHeap, neighbourIndex);
+        pBlock->size += pNeighbour->size;
+        pBlock->next = pNeighbour->next;
+        if (pBlock->next != FILE_HEAP_INVALID_BLOCK_INDEX) {
+            pHybridHeap->pBlocks[pBlock->next].prev = index;
+        }
+
+        releaseFileHeapBlock(pHybridHeap, neighbourIndex);
+    }
+
+    // Merge into the preceding block if it's free
+    neighbourIndex = pBlock->prev;
+    if (neighbourIndex != FILE_HEAP_INVALID_BLOCK_INDEX && pHybridHeap->pBlocks[neighbourIndex].flags == ALLOCATION_FLAGS_FREE) {
+        pNeighbour = &pHybridHeap->pBlocks[neighbourIndex];
+        pNeighbour->size += pBlock->size;
+        pNeighbour->next = pBlock->next;
+        if (pNeighbour->next != FILE_HEAP_INVALID_BLOCK_INDEX) {
+            pHybridHeap->pBlocks[pNeighbour->next].prev = neighbourIndex;
+        }
+
+        releaseFileHeapBlock(pHybridHeap, index);
+
+        // The preceding block is already on the free list
+        return;
+    }
+
+    linkFreeFileHeapBlock(pHybridHeap, index);
+}
+
+/**
+ * Opens the persisted block descriptor table and maps it in case it matches the heap configuration.
+ * Otherwise, the index is discarded and the heap starts afresh.
+ */
+STATUS openFileHeapIndex(PHybridFileHeap pHybridHeap, PBOOL pRecover)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFILE_HEAP_INDEX pIndex = NULL;
+    FILE_HEAP_INDEX index;
+    CHAR filePath[MAX_PATH_LEN + 1];
+    UINT64 size;
+    INT32 retCode;
+    BOOL recover = FALSE;
+
+    retCode = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, pHybridHeap->rootDirectory, FPATHSEPARATOR,
+                       FILE_HEAP_INDEX_FILE_INDEX);
+    CHK(retCode <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
+
+    CHK_STATUS(openSegmentFile(filePath, FALSE, &pHybridHeap->indexFile));
+    CHK_STATUS(getSegmentFileSize(pHybridHeap->indexFile, &size));
+
+    // Validate the header of the existing index
+    if (size >= SIZEOF(FILE_HEAP_INDEX)) {
+        CHK_STATUS(mapSegmentFile(pHybridHeap->indexFile, SIZEOF(FILE_HEAP_INDEX), (PBYTE*) &pIndex));
+        index = *pIndex;
+        unmapSegmentFile((PBYTE) pIndex, SIZEOF(FILE_HEAP_INDEX));
+
+        recover = index.magic == FILE_HEAP_INDEX_MAGIC && index.version == FILE_HEAP_INDEX_VERSION &&
+            index.fileHeapLimit == pHybridHeap->fileHeapLimit && index.blockCapacity != 0 && index.blockCapacity < FILE_HEAP_INVALID_BLOCK_INDEX &&
+            size >= GET_FILE_HEAP_INDEX_SIZE(index.blockCapacity);
+    }
+
+    if (recover) {
+        DLOGI("Recovering file heap with %u block descriptors", index.blockCapacity);
+        CHK_STATUS(resizeFileHeapIndex(pHybridHeap, index.blockCapacity));
+        pHybridHeap->blockCapacity = index.blockCapacity;
+    } else {
+        if (size != 0) {
+            DLOGW("Discarding the persisted file heap index which doesn't match the heap configuration");
+        }
+
+        // The descriptors are allocated on demand
+        CHK_STATUS(resizeSegmentFile(pHybridHeap->indexFile, 0));
+    }
+
+    *pRecover = recover;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Re-sizes and re-maps the persisted block descriptor table.
+ *
+ * IMPORTANT!!! The descriptor table is re-mapped so the block pointers need to be re-acquired
+ */
+STATUS resizeFileHeapIndex(PHybridFileHeap pHybridHeap, UINT32 capacity)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFILE_HEAP_INDEX pIndex = NULL;
+    UINT64 size = GET_FILE_HEAP_INDEX_SIZE(capacity);
+
+    // The new descriptors are zeroed which marks them as unused
+    CHK_STATUS(reserveSegmentFile(pHybridHeap->indexFile, size));
+    CHK_STATUS(resizeSegmentFile(pHybridHeap->indexFile, size));
+    CHK_STATUS(mapSegmentFile(pHybridHeap->indexFile, size, (PBYTE*) &pIndex));
+
+    if (pHybridHeap->pIndex != NULL) {
+        unmapSegmentFile((PBYTE) pHybridHeap->pIndex, GET_FILE_HEAP_INDEX_SIZE(pHybridHeap->blockCapacity));
+    }
+
+    pIndex->magic = FILE_HEAP_INDEX_MAGIC;
+    pIndex->version = FILE_HEAP_INDEX_VERSION;
+    pIndex->fileHeapLimit = pHybridHeap->fileHeapLimit;
+    pIndex->blockCapacity = capacity;
+    pIndex->reserved = 0;
+
+    pHybridHeap->pIndex = pIndex;
+    pHybridHeap->pBlocks = (PFILE_HEAP_BLOCK) (pIndex + 1);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Re-creates the block chains, the free and the unused lists and the heap accounting from the persisted descriptors.
+ *
+ * The process might have terminated mid-way through an operation so only the allocated blocks which are
+ * consistent with their mapped allocation headers are kept. The rest of the segment space is returned as free.
+ */
+STATUS recoverFileHeapBlocks(PHybridFileHeap pHybridHeap)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PHeap pHeap = (PHeap) pHybridHeap;
+    PFILE_HEAP_BLOCK pBlock, pLast;
+    PALLOCATION_HEADER pHeader;
+    PFILE_HEAP_BLOCK_POSITION pPositions = NULL;
+    UINT64 segmentSize, end = 0;
+    UINT32 i, index, count = 0, segment = 0, last = FILE_HEAP_INVALID_BLOCK_INDEX;
+
+    CHK(NULL != (pPositions = (PFILE_HEAP_BLOCK_POSITION) MEMALLOC(pHybridHeap->blockCapacity * SIZEOF(FILE_HEAP_BLOCK_POSITION))),
+        STATUS_NOT_ENOUGH_MEMORY);
+
+    pHybridHeap->freeBlock = FILE_HEAP_INVALID_BLOCK_INDEX;
+    pHybridHeap->unusedBlock = FILE_HEAP_INVALID_BLOCK_INDEX;
+
+    // Collect the consistent allocated blocks
+    for (i = 0; i < pHybridHeap->blockCapacity; i++) {
+        pBlock = &pHybridHeap->pBlocks[i];
+        if (pBlock->flags != ALLOCATION_FLAGS_ALLOC) {
+            continue;
+        }
+
+        if (pBlock->segment < pHybridHeap->segmentCount) {
+            segmentSize = GET_FILE_HEAP_SEGMENT_SIZE(pHybridHeap->fileHeapLimit, pBlock->segment);
+            if (pBlock->offset % FILE_HEAP_BLOCK_ALIGNMENT == 0 && pBlock->offset < segmentSize && pBlock->allocSize < segmentSize &&
+                FILE_HEAP_BLOCK_SIZE(pBlock->allocSize) <= segmentSize - pBlock->offset) {
+                CHK_STATUS(mapFileHeapSegment(pHybridHeap, pBlock->segment));
+                pHeader = GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pBlock);
+                if (pHeader->type == FILE_ALLOCATION_TYPE && pHeader->fileHandle == i && pHeader->size == pBlock->allocSize) {
+                    // Keep the slack with the allocation only if it's within the segment
+                    if (pBlock->size < FILE_HEAP_BLOCK_SIZE(pBlock->allocSize) || pBlock->size > segmentSize - pBlock->offset) {
+                        pBlock->size = FILE_HEAP_BLOCK_SIZE(pBlock->allocSize);
+                    }
+
+                    pPositions[count].position = (UINT64) pBlock->segment * FILE_HEAP_MAX_SEGMENT_SIZE + pBlock->offset;
+                    pPositions[count].index = i;
+                    count++;
+                    continue;
+                }
+            }
+        }
+
+        DLOGW("Discarding inconsistent file heap block %u", i);
+        pBlock->flags = ALLOCATION_FLAGS_NONE;
+    }
+
+    // Chain the rest of the descriptors into the unused list keeping the lower indexes first
+    for (i = pHybridHeap->blockCapacity; i > 0; i--) {
+        if (pHybridHeap->pBlocks[i - 1].flags != ALLOCATION_FLAGS_ALLOC) {
+            releaseFileHeapBlock(pHybridHeap, i - 1);
+        }
+    }
+
+    // Re-create the address ordered chains filling the gaps with the free blocks
+    QSORT(pPositions, count, SIZEOF(FILE_HEAP_BLOCK_POSITION), compareFileHeapBlockPositions);
+    for (i = 0; i < count; i++) {
+        index = pPositions[i].index;
+
+        // Complete the chains of the preceding segments
+        while (segment < pHybridHeap->pBlocks[index].segment) {
+            CHK_STATUS(chainFreeFileHeapBlock(pHybridHeap, segment, end, GET_FILE_HEAP_SEGMENT_SIZE(pHybridHeap->fileHeapLimit, segment), &last));
+            segment++;
+            end = 0;
+            last = FILE_HEAP_INVALID_BLOCK_INDEX;
+        }
+
+        pBlock = &pHybridHeap->pBlocks[index];
+        if (pBlock->offset < end) {
+            // Drop the block overlapping with the preceding allocation otherwise trim the slack of the preceding allocation
+            pLast = &pHybridHeap->pBlocks[last];
+            if (pBlock->offset < pLast->offset + FILE_HEAP_BLOCK_SIZE(pLast->allocSize)) {
+                DLOGW("Discarding overlapping file heap block %u", index);
+                releaseFileHeapBlock(pHybridHeap, index);
+                continue;
+            }
+
+            pLast->size = pBlock->offset - pLast->offset;
+            end = pBlock->offset;
+        }
+
+        CHK_STATUS(chainFreeFileHeapBlock(pHybridHeap, segment, end, pHybridHeap->pBlocks[index].offset, &last));
+        chainFileHeapBlock(pHybridHeap, index, &last);
+
+        pBlock = &pHybridHeap->pBlocks[index];
+        pBlock->prevFree = FILE_HEAP_INVALID_BLOCK_INDEX;
+        pBlock->nextFree = FILE_HEAP_INVALID_BLOCK_INDEX;
+        end = pBlock->offset + pBlock->size;
+
+        // Account for the surviving allocation
+        incrementUsage(pHeap, FILE_ALLOCATION_HEADER_SIZE + pBlock->allocSize + FILE_ALLOCATION_FOOTER_SIZE);
+    }
+
+    // Complete the remaining segments
+    for (; segment < pHybridHeap->segmentCount; segment++) {
+        CHK_STATUS(chainFreeFileHeapBlock(pHybridHeap, segment, end, GET_FILE_HEAP_SEGMENT_SIZE(pHybridHeap->fileHeapLimit, segment), &last));
+        end = 0;
+        last = FILE_HEAP_INVALID_BLOCK_INDEX;
+    }
+
+    DLOGI("Recovered %" PRIu64 " file heap allocations with overall size %" PRIu64 " bytes", pHeap->numAlloc, pHeap->heapSize);
+
+CleanUp:
+
+    SAFE_MEMFREE(pPositions);
+
+    return retStatus;
+}
+
+/**
+ * Chains a new free block covering the given range of the segment if the range is not empty
+ */
+STATUS chainFreeFileHeapBlock(PHybridFileHeap pHybridHeap, UINT32 segment, UINT64 start, UINT64 end, PUINT32 pLast)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFILE_HEAP_BLOCK pBlock;
+    UINT32 index;
+
+    CHK(start < end, retStatus);
+
+    CHK_STATUS(newFileHeapBlock(pHybridHeap, &index));
+    pBlock = &pHybridHeap->pBlocks[index];
+    pBlock->segment = segment;
+    pBlock->offset = start;
+    pBlock->size = end - start;
+
+    linkFreeFileHeapBlock(pHybridHeap, index);
+    chainFileHeapBlock(pHybridHeap, index, pLast);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Appends the block to the address ordered chain of the segment
+ */
+VOID chainFileHeapBlock(PHybridFileHeap pHybridHeap, UINT32 index, PUINT32 pLast)
+{
+    pHybridHeap->pBlocks[index].prev = *pLast;
+    pHybridHeap->pBlocks[index].next = FILE_HEAP_INVALID_BLOCK_INDEX;
+    if (*pLast != FILE_HEAP_INVALID_BLOCK_INDEX) {
+        pHybridHeap->pBlocks[*pLast].next = index;
+    }
+
+    *pLast = index;
+}
+
+/**
+ * Orders the blocks by their position across the segments
+ */
+INT32 compareFileHeapBlockPositions(const VOID* pFirst, const VOID* pSecond)
+{
+    UINT64 first = ((PFILE_HEAP_BLOCK_POSITION) pFirst)->position, second = ((PFILE_HEAP_BLOCK_POSITION) pSecond)->position;
+
+    return first < second ? -1 : (first > second ? 1 : 0);
+}
+
+/**
+ * Orders the allocation handles
+ */
+INT32 compareAllocationHandles(const VOID* pFirst, const VOID* pSecond)
+{
+    ALLOCATION_HANDLE first = *(PALLOCATION_HANDLE) pFirst, second = *(PALLOCATION_HANDLE) pSecond;
+
+    return first < second ? -1 : (first > second ? 1 : 0);
+}
@@ -20,14 +20,122 @@ extern "C" {
 // Starting index for the file heap files
 #define FILE_HEAP_STARTING_FILE_INDEX 1
 
+// Index of the file storing the block descriptor table of the persistent heap
+#define FILE_HEAP_INDEX_FILE_INDEX 0
+
+// Identifies the persisted block descriptor table file - "HFHI"
+#define FILE_HEAP_INDEX_MAGIC 0x49484648
+
+// Version of the persisted block descriptor table format
+#define FILE_HEAP_INDEX_VERSION 1
+
+// Max size of a single segment file. Keeping the segments under 4GB allows for FAT32 formatted storage
+#define FILE_HEAP_MAX_SEGMENT_SIZE ((UINT64) 1 * 1024 * 1024 * 1024)
+
+// Segment file blocks are 8 byte aligned
+#define FILE_HEAP_BLOCK_ALIGNMENT 8
+#define FILE_HEAP_PACKED_SIZE(size) ROUND_UP((size), FILE_HEAP_BLOCK_ALIGNMENT)
+
+// Minimal free block size - if we end up with a smaller remainder we will keep it with the allocated block
+#define FILE_HEAP_MIN_FREE_BLOCK_SIZE 64
+
+// Initial number of the block descriptors. The descriptor table doubles in size when exhausted
+#define FILE_HEAP_DEFAULT_BLOCK_DESCRIPTOR_COUNT 64
+
+// Sentinel value for the block descriptor links
+#define FILE_HEAP_INVALID_BLOCK_INDEX MAX_UINT32
+
+// Invalid value for a segment file descriptor
+#define FILE_HEAP_INVALID_SEGMENT_FILE (-1)
+
 // Define the max root directory length accounting for the max file size of 10, a separator and the file extension
 #define FILE_HEAP_MAX_ROOT_DIR_LEN (MAX_PATH_LEN - 10 - SIZEOF(FILE_HEAP_FILE_EXTENSION) - 1)
 
 /**
- * We will encode a sequential number as the handle in upper 32 bits
+ * We will encode the block descriptor index as the handle in upper 32 bits. The index is
+ * offset by one to avoid a collision with the invalid handle value
+ */
+#define TO_FILE_HANDLE(h)   ((UINT32) ((UINT64) (h) >> 32) - FILE_HEAP_STARTING_FILE_INDEX)
+#define FROM_FILE_HANDLE(h) (ALLOCATION_HANDLE)(((UINT64) ((h) + FILE_HEAP_STARTING_FILE_INDEX) << 32) | ALIGNMENT_BITS)
+
+/**
+ * Describes a block within a segment file. The descriptors are kept in memory so the
+ * allocations and frees are pure bookkeeping without touching the file system.
+ * Allocated blocks start with the allocation header followed by the allocation itself.
  */
-#define TO_FILE_HANDLE(h)   ((UINT32) ((UINT64) (h) >> 32))
-#define FROM_FILE_HANDLE(h) (ALLOCATION_HANDLE)(((UINT64) (h) << 32) | ALIGNMENT_BITS)
+typedef struct {
+    // Offset of the block within the segment file
+    UINT64 offset;
+
+    // Overall size of the block within the segment file
+    UINT64 size;
+
+    // The allocation size specified by the caller. 0 for the free blocks
+    UINT64 allocSize;
+
+    // Index of the segment file
+    UINT32 segment;
+
+    // Allocation flags. ALLOCATION_FLAGS_NONE for the unused descriptors
+    UINT32 flags;
+
+    // Address ordered neighbouring blocks within the segment
+    UINT32 prev;
+    UINT32 next;
+
+    // Free list links. Unused descriptors are chained using the next free link
+    UINT32 prevFree;
+    UINT32 nextFree;
+} FILE_HEAP_BLOCK, *PFILE_HEAP_BLOCK;
+
+/**
+ * Header of the persisted block descriptor table. The descriptors follow the header.
+ */
+typedef struct {
+    // Should be FILE_HEAP_INDEX_MAGIC
+    UINT32 magic;
+
+    // Should be FILE_HEAP_INDEX_VERSION
+    UINT32 version;
+
+    // The file heap limit the segment files were created for
+    UINT64 fileHeapLimit;
+
+    // Number of the descriptors following the header
+    UINT32 blockCapacity;
+
+    // Reserved for alignment
+    UINT32 reserved;
+} FILE_HEAP_INDEX, *PFILE_HEAP_INDEX;
+
+/**
+ * Gets the persisted block descriptor table file size for a given capacity
+ */
+#define GET_FILE_HEAP_INDEX_SIZE(capacity) (SIZEOF(FILE_HEAP_INDEX) + (UINT64) (capacity) * SIZEOF(FILE_HEAP_BLOCK))
+
+/**
+ * Sort entry used to re-create the segment chains on recovery
+ */
+typedef struct {
+    // Position of the block across the segments
+    UINT64 position;
+
+    // Index of the block descriptor
+    UINT32 index;
+} FILE_HEAP_BLOCK_POSITION, *PFILE_HEAP_BLOCK_POSITION;
+
+/**
+ * Gets the segment size for a given segment index
+ */
+#define GET_FILE_HEAP_SEGMENT_SIZE(fileHeapLimit, i)                                                                                                 \
+    FILE_HEAP_PACKED_SIZE(MIN((fileHeapLimit) - (UINT64) (i) * FILE_HEAP_MAX_SEGMENT_SIZE, FILE_HEAP_MAX_SEGMENT_SIZE))
+
+/**
+ * Gets the mapped allocation header of the block.
+ * IMPORTANT: The segment of the block should be mapped
+ */
+#define GET_FILE_HEAP_BLOCK_HEADER(pHybridHeap, pBlock)                                                                                              \
+    ((PALLOCATION_HEADER) ((pHybridHeap)->pSegmentMappings[(pBlock)->segment] + (pBlock)->offset))
 
 /**
  * Hybrid heap struct
@@ -49,9 +157,55 @@ typedef struct {
     CHAR rootDirectory[MAX_PATH_LEN + 1];
 
     /**
-     * Will keep the ever increasing number which will be used as a handle. OK to wrap
+     * The size of the file heap covered by the segment files
+     */
+    UINT64 fileHeapLimit;
+
+    /**
+     * Number of the segment files
+     */
+    UINT32 segmentCount;
+
+    /**
+     * Memory mapped segment files. The segment files are created and mapped on first use
+     */
+    PBYTE* pSegmentMappings;
+
+    /**
+     * Whether the heap files and the file allocations survive the restarts
+     */
+    BOOL persistent;
+
+    /**
+     * Whether the segment files of the previous run are re-attached to
+     */
+    BOOL recovered;
+
+    /**
+     * Persisted block descriptor table file and its mapping in case of the persistent heap
+     */
+    INT32 indexFile;
+    PFILE_HEAP_INDEX pIndex;
+
+    /**
+     * Block descriptor table. Points into the index file mapping in case of the persistent heap
+     */
+    PFILE_HEAP_BLOCK pBlocks;
+
+    /**
+     * Number of the descriptors in the block descriptor table
+     */
+    UINT32 blockCapacity;
+
+    /**
+     * Head of the free block list
      */
-    UINT32 handleNum;
+    UINT32 freeBlock;
+
+    /**
+     * Head of the unused descriptor list
+     */
+    UINT32 unusedBlock;
 
     /**
      * The direct memory allocation based heap
@@ -62,7 +216,7 @@ typedef struct {
 /**
  * Hybrid heap internal functions
  */
-STATUS hybridFileCreateHeap(PHeap, UINT32, PCHAR, PHybridFileHeap*);
+STATUS hybridFileCreateHeap(PHeap, UINT32, UINT32, PCHAR, PHybridFileHeap*);
 
 /**
  * Allocate a buffer from the heap
@@ -94,6 +248,21 @@ DEFINE_HEAP_MAP(hybridFileHeapMap);
  */
 DEFINE_HEAP_UNMAP(hybridFileHeapUnmap);
 
+/**
+ * Moves an in-memory allocation to the file system when the memory heap is filling up
+ */
+DEFINE_HEAP_DEMOTE(hybridFileHeapDemote);
+
+/**
+ * Checks whether the allocation is stored in the persistent segment files
+ */
+DEFINE_HEAP_CHECK_PERSISTED(hybridFileHeapCheckPersisted);
+
+/**
+ * Frees the recovered segment file allocations which are not claimed
+ */
+DEFINE_HEAP_RELEASE_UNCLAIMED(hybridFileHeapReleaseUnclaimed);
+
 /**
  * Release the entire heap
  */
@@ -123,6 +292,42 @@ DEFINE_HEAP_LIMITS(hybridFileGetHeapLimits);
  */
 STATUS removeHeapFile(UINT64, DIR_ENTRY_TYPES, PCHAR, PCHAR);
 
+/**
+ * Segment file functionality
+ */
+STATUS openSegmentFile(PCHAR, BOOL, PINT32);
+STATUS closeSegmentFile(INT32);
+STATUS resizeSegmentFile(INT32, UINT64);
+STATUS reserveSegmentFile(INT32, UINT64);
+STATUS getSegmentFileSize(INT32, PUINT64);
+STATUS mapSegmentFile(INT32, UINT64, PBYTE*);
+STATUS unmapSegmentFile(PBYTE, UINT64);
+STATUS mapFileHeapSegment(PHybridFileHeap, UINT32);
+
+/**
+ * Segment block management functionality
+ */
+STATUS getFileHeapBlock(PHybridFileHeap, ALLOCATION_HANDLE, PFILE_HEAP_BLOCK*);
+STATUS newFileHeapBlock(PHybridFileHeap, PUINT32);
+VOID releaseFileHeapBlock(PHybridFileHeap, UINT32);
+UINT32 findFreeFileHeapBlock(PHybridFileHeap, UINT64);
+STATUS acquireFileHeapBlock(PHybridFileHeap, UINT64, PUINT32);
+VOID linkFreeFileHeapBlock(PHybridFileHeap, UINT32);
+VOID unlinkFreeFileHeapBlock(PHybridFileHeap, UINT32);
+STATUS splitFileHeapBlock(PHybridFileHeap, UINT32, UINT64);
+VOID freeFileHeapBlock(PHybridFileHeap, UINT32);
+
+/**
+ * Persistent block descriptor table functionality
+ */
+STATUS openFileHeapIndex(PHybridFileHeap, PBOOL);
+STATUS resizeFileHeapIndex(PHybridFileHeap, UINT32);
+STATUS recoverFileHeapBlocks(PHybridFileHeap);
+STATUS chainFreeFileHeapBlock(PHybridFileHeap, UINT32, UINT64, UINT64, PUINT32);
+VOID chainFileHeapBlock(PHybridFileHeap, UINT32, PUINT32);
+INT32 compareFileHeapBlockPositions(const VOID*, const VOID*);
+INT32 compareAllocationHandles(const VOID*, const VOID*);
+
 #ifdef __cplusplus
 }
 #endif
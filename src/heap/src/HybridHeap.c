@@ -102,6 +102,9 @@ STATUS hybridCreateHeap(PHeap pHeap, UINT32 spillRatio, UINT32 behaviorFlags, PH
     pBaseHeap->heapSetAllocSizeFn = hybridHeapSetAllocSize;
     pBaseHeap->heapMapFn = hybridHeapMap;
     pBaseHeap->heapUnmapFn = hybridHeapUnmap;
+    pBaseHeap->heapDemoteFn = commonHeapDemote; // vRAM tier is not used for demotion
+    pBaseHeap->heapCheckPersistedFn = commonHeapCheckPersisted;
+    pBaseHeap->heapReleaseUnclaimedFn = commonHeapReleaseUnclaimed;
     pBaseHeap->heapDebugCheckAllocatorFn = hybridHeapDebugCheckAllocator;
     pBaseHeap->getAllocationSizeFn = hybridGetAllocationSize;
     pBaseHeap->getAllocationHeaderSizeFn = hybridGetAllocationHeaderSize;
@@ -198,6 +201,7 @@ DEFINE_RELEASE_HEAP(hybridHeapRelease)
     STATUS vramUninitStatus = STATUS_SUCCESS;
     PHybridHeap pHybridHeap = (PHybridHeap) pHeap;
     INT32 dlCloseRet, vramUninitRet;
+    UINT32 i;
 
     // The call should be idempotent
     CHK(pHeap != NULL, STATUS_SUCCESS);
@@ -205,6 +209,13 @@ DEFINE_RELEASE_HEAP(hybridHeapRelease)
     // Regardless of the status (heap might be corrupted) we still want to free the memory
     retStatus = commonHeapRelease(pHeap);
 
+    // Unlock the cached read-only mappings before the VRAM goes away
+    for (i = 0; i < HYBRID_HEAP_VRAM_MAPPING_CACHE_SIZE; i++) {
+        if (pHybridHeap->vramMappings[i].vramHandle != INVALID_VRAM_HANDLE) {
+            hybridHeapEvictVramMapping(pHybridHeap, &pHybridHeap->vramMappings[i]);
+        }
+    }
+
     // Release the direct memory heap
     if (pHybridHeap->pMemHeap != NULL && STATUS_SUCCESS != (memHeapStatus = pHybridHeap->pMemHeap->heapReleaseFn((PHeap) pHybridHeap->pMemHeap))) {
         DLOGW("Failed to release in-memory heap with 0x%08x", memHeapStatus);
@@ -338,6 +349,7 @@ DEFINE_HEAP_FREE(hybridHeapFree)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PHybridHeap pHybridHeap = (PHybridHeap) pHeap;
+    PHybridHeapVramMapping pMapping;
     UINT32 vramHandle;
     UINT32 ret;
 
@@ -357,6 +369,12 @@ DEFINE_HEAP_FREE(hybridHeapFree)
     DLOGS("Indirect allocation");
     // Convert the handle
     vramHandle = TO_VRAM_HANDLE(handle);
+
+    // Drop the cached read-only mapping so the region is not freed while locked
+    if (NULL != (pMapping = hybridHeapFindVramMapping(pHybridHeap, vramHandle))) {
+        hybridHeapEvictVramMapping(pHybridHeap, pMapping);
+    }
+
     CHK_ERR(0 == (ret = pHybridHeap->vramFree(vramHandle)), STATUS_HEAP_VRAM_FREE_FAILED, "Failed to free VRAM handle %08x with %lu", vramHandle,
             ret);
 
@@ -374,6 +392,7 @@ DEFINE_HEAP_GET_ALLOC_SIZE(hybridHeapGetAllocSize)
     STATUS retStatus = STATUS_SUCCESS;
     PHybridHeap pHybridHeap = (PHybridHeap) pHeap;
     PALLOCATION_HEADER pHeader;
+    PHybridHeapVramMapping pMapping;
     UINT32 vramHandle;
 
     // Call the base class to ensure the params are ok and set the default ret values
@@ -392,6 +411,14 @@ DEFINE_HEAP_GET_ALLOC_SIZE(hybridHeapGetAllocSize)
     vramHandle = TO_VRAM_HANDLE(handle);
     DLOGS("VRAM allocation. Handle 0x%016" PRIx64 " VRAM handle 0x%08x", handle, vramHandle);
 
+    // The cached read-only mapping is already locked
+    if (NULL != (pMapping = hybridHeapFindVramMapping(pHybridHeap, vramHandle))) {
+        *pAllocSize = pMapping->pHeader->size;
+
+        // Exit on success
+        CHK(FALSE, STATUS_SUCCESS);
+    }
+
     CHK_ERR(NULL != (pHeader = (PALLOCATION_HEADER) pHybridHeap->vramLock(vramHandle)), STATUS_HEAP_VRAM_MAP_FAILED, "Failed to map VRAM handle %08x",
             vramHandle);
 
@@ -450,11 +477,11 @@ DEFINE_HEAP_SET_ALLOC_SIZE(hybridHeapSetAllocSize)
 
     CHK_STATUS(hybridHeapAlloc(pHeap, newSize, &newAllocationHandle));
     CHK(IS_VALID_ALLOCATION_HANDLE(newAllocationHandle), STATUS_NOT_ENOUGH_MEMORY);
-    CHK_STATUS(hybridHeapMap(pHeap, existingAllocationHandle, &pExistingBuffer, &size));
-    CHK_STATUS(hybridHeapMap(pHeap, newAllocationHandle, &pNewBuffer, &newSize));
+    CHK_STATUS(hybridHeapMap(pHeap, existingAllocationHandle, &pExistingBuffer, &size, TRUE));
+    CHK_STATUS(hybridHeapMap(pHeap, newAllocationHandle, &pNewBuffer, &newSize, FALSE));
     MEMCPY(pNewBuffer, pExistingBuffer, MIN(size, newSize));
-    CHK_STATUS(hybridHeapUnmap(pHeap, pExistingBuffer));
-    CHK_STATUS(hybridHeapUnmap(pHeap, pNewBuffer));
+    CHK_STATUS(hybridHeapUnmap(pHeap, pExistingBuffer, TRUE));
+    CHK_STATUS(hybridHeapUnmap(pHeap, pNewBuffer, FALSE));
     CHK_STATUS(hybridHeapFree(pHeap, existingAllocationHandle));
 
     // Set the return
@@ -487,12 +514,12 @@ DEFINE_HEAP_MAP(hybridHeapMap)
     UINT32 vramHandle;
 
     // Call the base class to ensure the params are ok and set the default ret values
-    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize));
+    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize, readOnly));
 
     // In case it's a direct allocation handle use the encapsulated direct memory heap
     if (IS_DIRECT_ALLOCATION_HANDLE(handle)) {
         DLOGS("Direct allocation 0x%016" PRIx64, handle);
-        CHK_STATUS(pHybridHeap->pMemHeap->heapMapFn((PHeap) pHybridHeap->pMemHeap, handle, ppAllocation, pSize));
+        CHK_STATUS(pHybridHeap->pMemHeap->heapMapFn((PHeap) pHybridHeap->pMemHeap, handle, ppAllocation, pSize, readOnly));
 
         // Exit on success
         CHK(FALSE, STATUS_SUCCESS);
@@ -502,8 +529,13 @@ DEFINE_HEAP_MAP(hybridHeapMap)
     vramHandle = TO_VRAM_HANDLE(handle);
     DLOGS("VRAM allocation. Handle 0x%016" PRIx64 " VRAM handle 0x%08x", handle, vramHandle);
 
-    CHK_ERR(NULL != (pHeader = (PALLOCATION_HEADER) pHybridHeap->vramLock(vramHandle)), STATUS_HEAP_VRAM_MAP_FAILED, "Failed to map VRAM handle %08x",
-            vramHandle);
+    if (readOnly) {
+        // Read-only maps are served from the cached lock of the region
+        CHK_STATUS(hybridHeapMapVramReadOnly(pHybridHeap, vramHandle, &pHeader));
+    } else {
+        CHK_ERR(NULL != (pHeader = (PALLOCATION_HEADER) pHybridHeap->vramLock(vramHandle)), STATUS_HEAP_VRAM_MAP_FAILED,
+                "Failed to map VRAM handle %08x", vramHandle);
+    }
 
     // Set the values and return
     *ppAllocation = pHeader + 1;
@@ -523,23 +555,33 @@ DEFINE_HEAP_UNMAP(hybridHeapUnmap)
     STATUS retStatus = STATUS_SUCCESS;
     PHybridHeap pHybridHeap = (PHybridHeap) pHeap;
     PALLOCATION_HEADER pHeader = (PALLOCATION_HEADER) pAllocation - 1;
+    PHybridHeapVramMapping pMapping;
     UINT32 ret;
 
     // Call the base class to ensure the params are ok
-    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation));
+    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation, readOnly));
 
     // Check if this is a direct allocation by examining the type
     if (VRAM_ALLOCATION_TYPE != pHeader->type) {
         DLOGS("Direct allocation");
 
         // This is a direct allocation - call the encapsulated heap
-        CHK_STATUS(pHybridHeap->pMemHeap->heapUnmapFn((PHeap) pHybridHeap->pMemHeap, pAllocation));
+        CHK_STATUS(pHybridHeap->pMemHeap->heapUnmapFn((PHeap) pHybridHeap->pMemHeap, pAllocation, readOnly));
 
         // Exit on success
         CHK(FALSE, STATUS_SUCCESS);
     }
 
     DLOGS("Indirect allocation");
+
+    // Read-only maps only release the cached mapping which stays locked until evicted
+    if (readOnly && NULL != (pMapping = hybridHeapFindVramMapping(pHybridHeap, pHeader->vramHandle)) && pMapping->refCount != 0) {
+        pMapping->refCount--;
+
+        // Exit on success
+        CHK(FALSE, STATUS_SUCCESS);
+    }
+
     // Un-map from the vram
     CHK_ERR(0 == (ret = pHybridHeap->vramUnlock(pHeader->vramHandle)), STATUS_HEAP_VRAM_UNMAP_FAILED,
             "Failed to un-map handle 0x%08x. Error returned %u", pHeader->vramHandle, ret);
@@ -549,6 +591,94 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Maps the VRAM region for reading, reusing the cached lock of the region when present.
+ * A new lock takes an unused cache entry or evicts the least recently used idle one.
+ * The region is mapped without caching when all of the entries are in use.
+ */
+STATUS hybridHeapMapVramReadOnly(PHybridHeap pHybridHeap, UINT32 vramHandle, PALLOCATION_HEADER* ppHeader)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PHybridHeapVramMapping pMapping, pSlot = NULL;
+    PALLOCATION_HEADER pHeader;
+    UINT32 i;
+
+    for (i = 0; i < HYBRID_HEAP_VRAM_MAPPING_CACHE_SIZE; i++) {
+        pMapping = &pHybridHeap->vramMappings[i];
+        if (pMapping->vramHandle == vramHandle) {
+            pMapping->refCount++;
+            pMapping->useStamp = ++pHybridHeap->vramMappingStamp;
+            *ppHeader = pMapping->pHeader;
+
+            // Exit on success
+            CHK(FALSE, STATUS_SUCCESS);
+        }
+
+        // Prefer an unused entry over the least recently used idle one
+        if (pMapping->vramHandle == INVALID_VRAM_HANDLE) {
+            if (pSlot == NULL || pSlot->vramHandle != INVALID_VRAM_HANDLE) {
+                pSlot = pMapping;
+            }
+        } else if (pMapping->refCount == 0 && (pSlot == NULL || (pSlot->vramHandle != INVALID_VRAM_HANDLE && pMapping->useStamp < pSlot->useStamp))) {
+            pSlot = pMapping;
+        }
+    }
+
+    CHK_ERR(NULL != (pHeader = (PALLOCATION_HEADER) pHybridHeap->vramLock(vramHandle)), STATUS_HEAP_VRAM_MAP_FAILED, "Failed to map VRAM handle %08x",
+            vramHandle);
+
+    if (pSlot != NULL) {
+        if (pSlot->vramHandle != INVALID_VRAM_HANDLE) {
+            hybridHeapEvictVramMapping(pHybridHeap, pSlot);
+        }
+
+        pSlot->vramHandle = vramHandle;
+        pSlot->refCount = 1;
+        pSlot->useStamp = ++pHybridHeap->vramMappingStamp;
+        pSlot->pHeader = pHeader;
+    }
+
+    *ppHeader = pHeader;
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Returns the cached read-only mapping of the VRAM handle or NULL if not cached
+ */
+PHybridHeapVramMapping hybridHeapFindVramMapping(PHybridHeap pHybridHeap, UINT32 vramHandle)
+{
+    UINT32 i;
+
+    for (i = 0; i < HYBRID_HEAP_VRAM_MAPPING_CACHE_SIZE; i++) {
+        if (pHybridHeap->vramMappings[i].vramHandle == vramHandle) {
+            return &pHybridHeap->vramMappings[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Unlocks the cached mapping and releases its entry
+ */
+VOID hybridHeapEvictVramMapping(PHybridHeap pHybridHeap, PHybridHeapVramMapping pMapping)
+{
+    if (pMapping->refCount != 0) {
+        DLOGW("Evicting VRAM handle 0x%08x with %u outstanding read-only maps", pMapping->vramHandle, pMapping->refCount);
+    }
+
+    if (0 != pHybridHeap->vramUnlock(pMapping->vramHandle)) {
+        // Shouldn't fail here
+        DLOGW("Failed to unmap 0x%08x", pMapping->vramHandle);
+    }
+
+    MEMSET(pMapping, 0x00, SIZEOF(HybridHeapVramMapping));
+}
+
 DEFINE_HEADER_SIZE(hybridGetAllocationHeaderSize)
 {
     return VRAM_ALLOCATION_HEADER_SIZE;
@@ -569,6 +699,7 @@ DEFINE_ALLOC_SIZE(hybridGetAllocationSize)
     PHybridHeap pHybridHeap = (PHybridHeap) pHeap;
     UINT32 vramHandle;
     PALLOCATION_HEADER pAllocation;
+    PHybridHeapVramMapping pMapping;
     UINT64 memSizes, vramSizes, memHeapAllocationSize;
 
     CHECK_EXT(pHeap != NULL, "Internal error with VRAM heap being null");
@@ -585,6 +716,11 @@ DEFINE_ALLOC_SIZE(hybridGetAllocationSize)
     // In case of VRAM allocation we need to map the memory first to access the size info
     vramHandle = TO_VRAM_HANDLE(handle);
 
+    // The cached read-only mapping is already locked
+    if (NULL != (pMapping = hybridHeapFindVramMapping(pHybridHeap, vramHandle))) {
+        return VRAM_ALLOCATION_HEADER_SIZE + pMapping->pHeader->size + VRAM_ALLOCATION_FOOTER_SIZE;
+    }
+
     // Map the allocation
     if (NULL == (pAllocation = (PALLOCATION_HEADER) pHybridHeap->vramLock(vramHandle))) {
         // This is the failure sentinel
@@ -45,6 +45,36 @@ typedef UINT32 (*VramGetMax)(VOID);
 #define FROM_VRAM_HANDLE(h)            (ALLOCATION_HANDLE)(((UINT64) (h) << 32) | ALIGNMENT_BITS)
 #define IS_DIRECT_ALLOCATION_HANDLE(h) (((UINT64) (h) &ALIGNMENT_BITS) == (UINT64) 0x00)
 
+/**
+ * Number of read-only VRAM mappings kept locked between the map calls
+ */
+#define HYBRID_HEAP_VRAM_MAPPING_CACHE_SIZE 16
+
+/**
+ * Cached read-only VRAM mapping
+ */
+typedef struct {
+    /**
+     * VRAM handle of the locked region or INVALID_VRAM_HANDLE if the entry is unused
+     */
+    UINT32 vramHandle;
+
+    /**
+     * Number of outstanding read-only maps of the region. The idle entries stay locked until evicted.
+     */
+    UINT32 refCount;
+
+    /**
+     * Stamp of the last map used for the least recently used eviction
+     */
+    UINT64 useStamp;
+
+    /**
+     * Locked region
+     */
+    PALLOCATION_HEADER pHeader;
+} HybridHeapVramMapping, *PHybridHeapVramMapping;
+
 /**
  * Hybrid heap struct
  */
@@ -84,12 +114,21 @@ typedef struct {
      * The direct memory allocation based heap
      */
     PBaseHeap pMemHeap;
+
+    /**
+     * Read-only VRAM mappings and the running use stamp
+     */
+    HybridHeapVramMapping vramMappings[HYBRID_HEAP_VRAM_MAPPING_CACHE_SIZE];
+    UINT64 vramMappingStamp;
 } HybridHeap, *PHybridHeap;
 
 /**
  * Hybrid heap internal functions
  */
 STATUS hybridCreateHeap(PHeap, UINT32, UINT32, PHybridHeap*);
+STATUS hybridHeapMapVramReadOnly(PHybridHeap, UINT32, PALLOCATION_HEADER*);
+PHybridHeapVramMapping hybridHeapFindVramMapping(PHybridHeap, UINT32);
+VOID hybridHeapEvictVramMapping(PHybridHeap, PHybridHeapVramMapping);
 
 /**
  * Allocate a buffer from the heap
@@ -56,14 +56,31 @@ typedef STATUS (*HeapSetAllocSizeFunc)(PHeap, PALLOCATION_HANDLE, UINT64, UINT64
 typedef STATUS (*HeapAllocFunc)(PHeap, UINT64, PALLOCATION_HANDLE);
 
 /**
- * Maps the allocated handle and retrieves a memory address
+ * Maps the allocated handle and retrieves a memory address.
+ * The last param specifies whether the mapping is read-only so the heap can avoid persisting the content on un-map
  */
-typedef STATUS (*HeapMapFunc)(PHeap, ALLOCATION_HANDLE, PVOID*, PUINT64);
+typedef STATUS (*HeapMapFunc)(PHeap, ALLOCATION_HANDLE, PVOID*, PUINT64, BOOL);
 
 /**
- * Un-maps the previously mapped memory
+ * Un-maps the previously mapped memory. The last param should match the read-only intent specified on mapping
  */
-typedef STATUS (*HeapUnmapFunc)(PHeap, PVOID);
+typedef STATUS (*HeapUnmapFunc)(PHeap, PVOID, BOOL);
+
+/**
+ * Demotes the allocation to the slower storage tier if the fast tier usage is at or above the watermark percentage.
+ * NOTE: The handle is IN/OUT param and will be updated on demotion.
+ */
+typedef STATUS (*HeapDemoteFunc)(PHeap, PALLOCATION_HANDLE, UINT32, PBOOL);
+
+/**
+ * Checks whether the allocation is stored in a persistent storage tier which survives the heap release
+ */
+typedef STATUS (*HeapCheckPersistedFunc)(PHeap, ALLOCATION_HANDLE, PBOOL);
+
+/**
+ * Releases the recovered persisted allocations which are not in the claimed handle array
+ */
+typedef STATUS (*HeapReleaseUnclaimedFunc)(PHeap, PALLOCATION_HANDLE, UINT32);
 
 /**
  * Debug validates/outputs information about the heap
@@ -111,8 +128,11 @@ typedef VOID (*GetHeapLimitsFunc)(PUINT64, PUINT64);
 #define DEFINE_HEAP_FREE(name)           STATUS name(PHeap pHeap, ALLOCATION_HANDLE handle)
 #define DEFINE_HEAP_GET_ALLOC_SIZE(name) STATUS name(PHeap pHeap, ALLOCATION_HANDLE handle, PUINT64 pAllocSize)
 #define DEFINE_HEAP_SET_ALLOC_SIZE(name) STATUS name(PHeap pHeap, PALLOCATION_HANDLE pHandle, UINT64 size, UINT64 newSize)
-#define DEFINE_HEAP_MAP(name)            STATUS name(PHeap pHeap, ALLOCATION_HANDLE handle, PVOID* ppAllocation, PUINT64 pSize)
-#define DEFINE_HEAP_UNMAP(name)          STATUS name(PHeap pHeap, PVOID pAllocation)
+#define DEFINE_HEAP_MAP(name)            STATUS name(PHeap pHeap, ALLOCATION_HANDLE handle, PVOID* ppAllocation, PUINT64 pSize, BOOL readOnly)
+#define DEFINE_HEAP_UNMAP(name)          STATUS name(PHeap pHeap, PVOID pAllocation, BOOL readOnly)
+#define DEFINE_HEAP_DEMOTE(name)         STATUS name(PHeap pHeap, PALLOCATION_HANDLE pHandle, UINT32 watermark, PBOOL pDemoted)
+#define DEFINE_HEAP_CHECK_PERSISTED(name) STATUS name(PHeap pHeap, ALLOCATION_HANDLE handle, PBOOL pPersisted)
+#define DEFINE_HEAP_RELEASE_UNCLAIMED(name) STATUS name(PHeap pHeap, PALLOCATION_HANDLE pClaimed, UINT32 claimedCount)
 #define DEFINE_HEAP_CHK(name)            STATUS name(PHeap pHeap, BOOL dump)
 #define DEFINE_ALLOC_SIZE(name)          UINT64 name(PHeap pHeap, ALLOCATION_HANDLE handle)
 #define DEFINE_HEADER_SIZE(name)         UINT64 name()
@@ -138,6 +158,9 @@ typedef struct {
     HeapAllocFunc heapAllocFn;
     HeapMapFunc heapMapFn;
     HeapUnmapFunc heapUnmapFn;
+    HeapDemoteFunc heapDemoteFn;
+    HeapCheckPersistedFunc heapCheckPersistedFn;
+    HeapReleaseUnclaimedFunc heapReleaseUnclaimedFn;
     HeapDebugCheckAllocatorFunc heapDebugCheckAllocatorFn;
     GetAllocationSizeFunc getAllocationSizeFn;
     GetAllocationHeaderSizeFunc getAllocationHeaderSizeFn;
@@ -152,6 +175,7 @@ typedef struct {
 #include "Common.h"
 #include "SystemHeap.h"
 #include "AivHeap.h"
+#include "RingHeap.h"
 #include "HybridHeap.h"
 #include "HybridFileHeap.h"
 
@@ -0,0 +1,623 @@
+/**
+ * Implementation of a FIFO ring buffer heap
+ */
+
+#define LOG_CLASS "RingHeap"
+#include "Include_i.h"
+
+#ifdef HEAP_DEBUG
+RING_ALLOCATION_HEADER gRingHeader = {0, {0, RING_ALLOCATION_TYPE, {ALLOCATION_FLAGS_ALLOC}, ALLOCATION_HEADER_MAGIC}};
+#else
+RING_ALLOCATION_HEADER gRingHeader = {0, {0, RING_ALLOCATION_TYPE, {ALLOCATION_FLAGS_ALLOC}}};
+#endif
+
+#define RING_ALLOCATION_HEADER_SIZE SIZEOF(gRingHeader)
+
+/**
+ * Debug print analytics information
+ */
+DEFINE_HEAP_CHK(ringHeapDebugCheckAllocator)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRING_ALLOCATION_HEADER pBlock = NULL;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+    UINT64 offset, i;
+
+    // Call the base heap functionality
+    CHK_STATUS(commonHeapDebugCheckAllocator(pHeap, dump));
+
+    if (dump) {
+        DLOGV("Head offset: \t\t\t\t%" PRIu64, pRingHeap->headOffset);
+        DLOGV("Tail offset: \t\t\t\t%" PRIu64, pRingHeap->tailOffset);
+        DLOGV("Block count: \t\t\t\t%" PRIu64, pRingHeap->blockCount);
+        DLOGV("*******************************************");
+    }
+
+    // Walk the blocks from the oldest to the newest
+    offset = pRingHeap->tailOffset;
+    for (i = 0; i < pRingHeap->blockCount; i++) {
+        pBlock = GET_RING_BLOCK(pRingHeap, offset);
+
+        if (dump) {
+            DLOGV("Block:\t%p\t\trequested size:\t%" PRIu64 "\t\tsize:\t%" PRIu64 "\t\tflags:\t%u", pBlock, pBlock->allocSize, pBlock->header.size,
+                  pBlock->header.flags);
+        }
+
+        if (pBlock->header.type != RING_ALLOCATION_TYPE) {
+            DLOGE("Block %p has an invalid allocation type 0x%08x", pBlock, pBlock->header.type);
+            retStatus = STATUS_HEAP_CORRUPTED;
+            break;
+        }
+
+        if (pBlock->header.flags != ALLOCATION_FLAGS_ALLOC && pBlock->header.flags != ALLOCATION_FLAGS_FREE) {
+            DLOGE("Block %p has invalid flags %u", pBlock, pBlock->header.flags);
+            retStatus = STATUS_HEAP_CORRUPTED;
+        }
+
+        if (pBlock->header.flags == ALLOCATION_FLAGS_ALLOC && pBlock->allocSize > pBlock->header.size) {
+            DLOGE("Block %p has a requested size of %" PRIu64 " which is greater than the entire allocation size %" PRIu64, pBlock, pBlock->allocSize,
+                  pBlock->header.size);
+            retStatus = STATUS_HEAP_CORRUPTED;
+        }
+
+        if (offset + GET_RING_BLOCK_SIZE(pBlock) > pHeap->heapLimit) {
+            DLOGE("Block %p spills over the end of the heap", pBlock);
+            retStatus = STATUS_HEAP_CORRUPTED;
+            break;
+        }
+
+#ifdef HEAP_DEBUG
+        // Check the allocation 'guard band' in debug mode
+        if (0 != MEMCMP(pBlock->header.magic, ALLOCATION_HEADER_MAGIC, SIZEOF(ALLOCATION_HEADER_MAGIC))) {
+            DLOGE("Invalid header for allocation %p", pBlock);
+            retStatus = STATUS_HEAP_CORRUPTED;
+        }
+#endif
+        offset = normalizeRingOffset(pRingHeap, offset + GET_RING_BLOCK_SIZE(pBlock));
+    }
+
+    if (STATUS_SUCCEEDED(retStatus) && offset != normalizeRingOffset(pRingHeap, pRingHeap->headOffset)) {
+        DLOGE("Block chain ends at offset %" PRIu64 " instead of the head offset %" PRIu64, offset, pRingHeap->headOffset);
+        retStatus = STATUS_HEAP_CORRUPTED;
+    }
+
+    if (dump) {
+        DLOGV("*******************************************");
+    }
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Creates the heap
+ */
+DEFINE_CREATE_HEAP(ringHeapCreate)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PBaseHeap pBaseHeap = NULL;
+
+    CHK_STATUS(commonHeapCreate(ppHeap, SIZEOF(RingHeap)));
+
+    // Set the function pointers
+    pBaseHeap = (PBaseHeap) *ppHeap;
+    pBaseHeap->heapInitializeFn = ringHeapInit;
+    pBaseHeap->heapReleaseFn = ringHeapRelease;
+    pBaseHeap->heapGetSizeFn = commonHeapGetSize; // Use the common heap functionality
+    pBaseHeap->heapAllocFn = ringHeapAlloc;
+    pBaseHeap->heapFreeFn = ringHeapFree;
+    pBaseHeap->heapGetAllocSizeFn = ringHeapGetAllocSize;
+    pBaseHeap->heapSetAllocSizeFn = ringHeapSetAllocSize;
+    pBaseHeap->heapMapFn = ringHeapMap;
+    pBaseHeap->heapUnmapFn = ringHeapUnmap;
+    pBaseHeap->heapDemoteFn = commonHeapDemote; // Single tier heap
+    pBaseHeap->heapCheckPersistedFn = commonHeapCheckPersisted;
+    pBaseHeap->heapReleaseUnclaimedFn = commonHeapReleaseUnclaimed;
+    pBaseHeap->heapDebugCheckAllocatorFn = ringHeapDebugCheckAllocator;
+    pBaseHeap->getAllocationSizeFn = ringGetAllocationSize;
+    pBaseHeap->getAllocationHeaderSizeFn = ringGetAllocationHeaderSize;
+    pBaseHeap->getAllocationFooterSizeFn = ringGetAllocationFooterSize;
+    pBaseHeap->getAllocationAlignedSizeFn = ringGetAllocationAlignedSize;
+    pBaseHeap->getHeapLimitsFn = ringGetHeapLimits;
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Initialize the heap
+ */
+DEFINE_INIT_HEAP(ringHeapInit)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+
+    CHK(pRingHeap != NULL, STATUS_NULL_ARG);
+
+    // Set the initial values in case the base init fails
+    pRingHeap->pAllocation = NULL;
+    pRingHeap->headOffset = 0;
+    pRingHeap->tailOffset = 0;
+    pRingHeap->blockCount = 0;
+
+    // We will align heap limit down to ensure the block headers are always aligned
+    heapLimit = RING_PACKED_LIMIT(heapLimit);
+
+    // Call the base functionality
+    CHK_STATUS(commonHeapInit(pHeap, heapLimit));
+
+    // Allocate the entire heap backed by the process default heap.
+    pRingHeap->pAllocation = (PBYTE) MEMALLOC((SIZE_T) heapLimit);
+    CHK_ERR(pRingHeap->pAllocation != NULL, STATUS_NOT_ENOUGH_MEMORY, "Failed to allocate heap with limit size %" PRIu64, heapLimit);
+
+#ifdef HEAP_DEBUG
+    // Null the memory in debug mode
+    MEMSET(pRingHeap->pAllocation, 0x00, (SIZE_T) heapLimit);
+#endif
+
+CleanUp:
+
+    // Clean-up on error
+    if (STATUS_FAILED(retStatus) && pRingHeap != NULL) {
+        if (pRingHeap->pAllocation != NULL) {
+            MEMFREE(pRingHeap->pAllocation);
+            pRingHeap->pAllocation = NULL;
+        }
+
+        // Re-set everything
+        pHeap->heapLimit = 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Free the ring heap
+ */
+DEFINE_RELEASE_HEAP(ringHeapRelease)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+
+    // The call should be idempotent
+    CHK(pHeap != NULL, STATUS_SUCCESS);
+
+    // Regardless of the status (heap might be corrupted) we still want to free the memory
+    retStatus = commonHeapRelease(pHeap);
+
+    // Release the entire heap regardless of the status that's returned earlier
+    if (pRingHeap->pAllocation != NULL) {
+        MEMFREE(pRingHeap->pAllocation);
+    }
+
+    // Free the object itself
+    MEMFREE(pHeap);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Allocate from the heap
+ */
+DEFINE_HEAP_ALLOC(ringHeapAlloc)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRING_ALLOCATION_HEADER pBlock = NULL;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+    UINT64 blockSize;
+
+    // Call the common heap function
+    retStatus = commonHeapAlloc(pHeap, size, pHandle);
+    CHK(retStatus == STATUS_NOT_ENOUGH_MEMORY || retStatus == STATUS_SUCCESS, retStatus);
+    if (retStatus == STATUS_NOT_ENOUGH_MEMORY) {
+        // If we are out of memory then we don't need to return a failure - just
+        // Early return with success
+        CHK(FALSE, STATUS_SUCCESS);
+    }
+
+    blockSize = RING_ALLOCATION_HEADER_SIZE + RING_PACKED_SIZE(size);
+    pBlock = reserveRingBlock(pRingHeap, blockSize);
+
+    // We might hit this when the oldest allocations are still held at the tail
+    // IMPORTANT! We will return success without setting the handle
+    if (NULL == pBlock) {
+        // Make sure we decrement the counters by calling decrement
+        decrementUsage(pHeap, blockSize);
+
+        CHK(FALSE, STATUS_SUCCESS);
+    }
+
+    pBlock->allocSize = size;
+
+    // IMPORTANT!!! We are not returning the actual address but rather the offset
+    // from the heap base so we can later differentiate between direct memory
+    // allocations and hybrid heap allocation
+    *pHandle = TO_RING_HANDLE(pRingHeap, pBlock + 1);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Free the allocation
+ */
+DEFINE_HEAP_FREE(ringHeapFree)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRING_ALLOCATION_HEADER pBlock = NULL;
+    PVOID pAllocation;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+    UINT64 offset;
+
+    CHK(pRingHeap != NULL, STATUS_NULL_ARG);
+
+    // IMPORTANT.. The handle is the offset so we need to convert to the pointer
+    pAllocation = FROM_RING_HANDLE(pRingHeap, handle);
+    CHK_RING_ALLOCATION(pRingHeap, pAllocation);
+
+    pBlock = GET_RING_ALLOCATION_HEADER(pAllocation);
+    CHK_ERR(pBlock->header.flags == ALLOCATION_FLAGS_ALLOC && pBlock->allocSize != 0, STATUS_INVALID_HANDLE_ERROR,
+            "Invalid block of memory passed to free.");
+
+    // Call the common heap function
+    CHK_STATUS(commonHeapFree(pHeap, handle));
+
+    // Mark the block as free. It will be reclaimed once the tail reaches it.
+    pBlock->header.flags = ALLOCATION_FLAGS_FREE;
+    pBlock->allocSize = 0;
+
+    // Roll back the head if we are freeing the newest block
+    offset = (PBYTE) pBlock - pRingHeap->pAllocation;
+    if (offset != pRingHeap->tailOffset && offset + GET_RING_BLOCK_SIZE(pBlock) == pRingHeap->headOffset) {
+        pRingHeap->headOffset = offset;
+        pRingHeap->blockCount--;
+    }
+
+    reclaimRingBlocks(pRingHeap);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Gets the allocation size
+ */
+DEFINE_HEAP_GET_ALLOC_SIZE(ringHeapGetAllocSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRING_ALLOCATION_HEADER pHeader;
+    PVOID pAllocation;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+
+    CHK(pRingHeap != NULL, STATUS_NULL_ARG);
+
+    // IMPORTANT.. The handle is the offset so we need to convert to the pointer
+    pAllocation = FROM_RING_HANDLE(pRingHeap, handle);
+    CHK_RING_ALLOCATION(pRingHeap, pAllocation);
+
+    // Call the common heap function
+    CHK_STATUS(commonHeapGetAllocSize(pHeap, handle, pAllocSize));
+
+    pHeader = GET_RING_ALLOCATION_HEADER(pAllocation);
+
+    // Check for the validity of the allocation
+    CHK_ERR(pHeader->header.flags == ALLOCATION_FLAGS_ALLOC && pHeader->allocSize != 0, STATUS_INVALID_HANDLE_ERROR,
+            "Invalid handle or previously freed.");
+
+    *pAllocSize = pHeader->allocSize;
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Map the allocation handle
+ */
+DEFINE_HEAP_MAP(ringHeapMap)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRING_ALLOCATION_HEADER pHeader;
+    PVOID pAllocation;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+
+    CHK(pRingHeap != NULL, STATUS_NULL_ARG);
+
+    // This heap implementation uses a direct memory allocation so no
+    // mapping really needed - just conversion from a handle to memory pointer.
+    // IMPORTANT.. The handle is the offset so we need to convert to the pointer
+    pAllocation = FROM_RING_HANDLE(pRingHeap, handle);
+    CHK_RING_ALLOCATION(pRingHeap, pAllocation);
+
+    // Call the common heap function
+    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize, readOnly));
+
+    pHeader = GET_RING_ALLOCATION_HEADER(pAllocation);
+
+    // Check for the validity of the allocation
+    CHK_ERR(pHeader->header.flags == ALLOCATION_FLAGS_ALLOC && pHeader->allocSize != 0, STATUS_INVALID_HANDLE_ERROR,
+            "Invalid handle or previously freed.");
+
+    *ppAllocation = pAllocation;
+    *pSize = pHeader->allocSize;
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Un-Maps the allocation handle. In this implementation it doesn't do anything
+ */
+DEFINE_HEAP_UNMAP(ringHeapUnmap)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Delegate the call directly
+    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation, readOnly));
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+DEFINE_HEADER_SIZE(ringGetAllocationHeaderSize)
+{
+    return RING_ALLOCATION_HEADER_SIZE;
+}
+
+DEFINE_FOOTER_SIZE(ringGetAllocationFooterSize)
+{
+    return 0;
+}
+
+DEFINE_ALIGNED_SIZE(ringGetAllocationAlignedSize)
+{
+    return RING_PACKED_SIZE(size);
+}
+
+DEFINE_ALLOC_SIZE(ringGetAllocationSize)
+{
+    // This is a direct allocation
+    PVOID pAllocation = FROM_RING_HANDLE((PRingHeap) pHeap, handle);
+    PRING_ALLOCATION_HEADER pHeader = GET_RING_ALLOCATION_HEADER(pAllocation);
+
+#ifdef HEAP_DEBUG
+    // Check the allocation 'guard band' in debug mode
+    if (0 != MEMCMP(pHeader->header.magic, ALLOCATION_HEADER_MAGIC, SIZEOF(ALLOCATION_HEADER_MAGIC))) {
+        DLOGE("Invalid header for allocation %p", pAllocation);
+        return INVALID_ALLOCATION_VALUE;
+    }
+
+    // Check the type
+    if (RING_ALLOCATION_TYPE != pHeader->header.type) {
+        DLOGE("Invalid allocation type 0x%08x", pHeader->header.type);
+        return INVALID_ALLOCATION_VALUE;
+    }
+
+    // Check the allocation size against the overall allocation for the block
+    if (pHeader->allocSize > pHeader->header.size) {
+        DLOGE("Block %p has a requested size of %" PRIu64 " which is greater than the allocation size %" PRIu64, pHeader, pHeader->allocSize,
+              pHeader->header.size);
+        return INVALID_ALLOCATION_VALUE;
+    }
+#endif
+
+    return GET_RING_BLOCK_SIZE(pHeader);
+}
+
+/**
+ * Sets the allocation size
+ */
+DEFINE_HEAP_SET_ALLOC_SIZE(ringHeapSetAllocSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRING_ALLOCATION_HEADER pExistingHeader, pRemainder;
+    PVOID pAllocation = NULL;
+    PRingHeap pRingHeap = (PRingHeap) pHeap;
+    UINT64 offset, blockSize, newBlockSize;
+    ALLOCATION_HANDLE existingAllocationHandle, newAllocationHandle = INVALID_ALLOCATION_HANDLE_VALUE;
+    PVOID pExistingBuffer = NULL, pNewBuffer = NULL;
+
+    // Call the common heap function
+    CHK_STATUS(commonHeapSetAllocSize(pHeap, pHandle, size, newSize));
+
+    // The ring heap accounts for the actual block footprint rather than the raw size difference
+    // so we undo the common accounting and account for the actual change below.
+    if (newSize > size) {
+        pHeap->heapSize -= newSize - size;
+    } else {
+        pHeap->heapSize += size - newSize;
+    }
+
+    existingAllocationHandle = *pHandle;
+
+    // This heap implementation uses a direct memory allocation so no mapping really needed - just conversion from a handle to memory pointer
+    pAllocation = FROM_RING_HANDLE(pRingHeap, existingAllocationHandle);
+    CHK_RING_ALLOCATION(pRingHeap, pAllocation);
+
+    pExistingHeader = GET_RING_ALLOCATION_HEADER(pAllocation);
+    CHK_ERR(pExistingHeader->header.flags == ALLOCATION_FLAGS_ALLOC && pExistingHeader->allocSize != 0, STATUS_INVALID_HANDLE_ERROR,
+            "Invalid handle or previously freed.");
+
+    offset = (PBYTE) pExistingHeader - pRingHeap->pAllocation;
+    blockSize = GET_RING_BLOCK_SIZE(pExistingHeader);
+    newBlockSize = RING_ALLOCATION_HEADER_SIZE + RING_PACKED_SIZE(newSize);
+
+    // Check if the new size fits into the existing block
+    if (newBlockSize <= blockSize) {
+        if (offset + blockSize == pRingHeap->headOffset) {
+            // This is the newest block so we can simply roll back the head
+            pRingHeap->headOffset = offset + newBlockSize;
+        } else if (blockSize - newBlockSize >= RING_ALLOCATION_HEADER_SIZE) {
+            // Split off the remainder as a free block which will be reclaimed by the tail
+            pRemainder = GET_RING_BLOCK(pRingHeap, offset + newBlockSize);
+            MEMCPY(pRemainder, &gRingHeader, RING_ALLOCATION_HEADER_SIZE);
+            pRemainder->header.size = blockSize - newBlockSize - RING_ALLOCATION_HEADER_SIZE;
+            pRemainder->header.flags = ALLOCATION_FLAGS_FREE;
+            pRingHeap->blockCount++;
+        } else {
+            // Keep the existing block size as the remainder is too small to be tracked
+            newBlockSize = blockSize;
+        }
+
+        pExistingHeader->header.size = newBlockSize - RING_ALLOCATION_HEADER_SIZE;
+        pExistingHeader->allocSize = newSize;
+        pHeap->heapSize -= blockSize - newBlockSize;
+
+        // Early exit
+        CHK(FALSE, retStatus);
+    }
+
+    // Check if this is the newest block and we can grow it in place
+    if (offset + blockSize == pRingHeap->headOffset && newBlockSize - blockSize <= getRingContiguousSpace(pRingHeap) &&
+        newBlockSize - blockSize + pHeap->heapSize <= pHeap->heapLimit) {
+        pRingHeap->headOffset = offset + newBlockSize;
+        pExistingHeader->header.size = newBlockSize - RING_ALLOCATION_HEADER_SIZE;
+        pExistingHeader->allocSize = newSize;
+        pHeap->heapSize += newBlockSize - blockSize;
+
+        // Early exit
+        CHK(FALSE, retStatus);
+    }
+
+    // Otherwise, allocate a new block at the head, copy the data over and free the existing block
+    DLOGS("Sets new allocation size %" PRIu64 " for handle 0x%016" PRIx64, newSize, existingAllocationHandle);
+
+    CHK_STATUS(ringHeapAlloc(pHeap, newSize, &newAllocationHandle));
+    CHK(IS_VALID_ALLOCATION_HANDLE(newAllocationHandle), STATUS_NOT_ENOUGH_MEMORY);
+    CHK_STATUS(ringHeapMap(pHeap, existingAllocationHandle, &pExistingBuffer, &size, TRUE));
+    CHK_STATUS(ringHeapMap(pHeap, newAllocationHandle, &pNewBuffer, &newSize, FALSE));
+    MEMCPY(pNewBuffer, pExistingBuffer, MIN(size, newSize));
+    CHK_STATUS(ringHeapUnmap(pHeap, pExistingBuffer, TRUE));
+    CHK_STATUS(ringHeapUnmap(pHeap, pNewBuffer, FALSE));
+    CHK_STATUS(ringHeapFree(pHeap, existingAllocationHandle));
+
+    // Set the return
+    *pHandle = newAllocationHandle;
+
+CleanUp:
+
+    // Clean-up in case of failure
+    if (STATUS_FAILED(retStatus) && IS_VALID_ALLOCATION_HANDLE(newAllocationHandle)) {
+        // Free the allocation before returning
+        ringHeapFree(pHeap, newAllocationHandle);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+DEFINE_HEAP_LIMITS(ringGetHeapLimits)
+{
+    *pMinHeapSize = MIN_HEAP_SIZE;
+    *pMaxHeapSize = MAX_HEAP_SIZE;
+}
+
+/**
+ * Reserves a block at the head of the ring wrapping around if needed. Returns NULL if the block doesn't fit.
+ */
+PRING_ALLOCATION_HEADER reserveRingBlock(PRingHeap pRingHeap, UINT64 blockSize)
+{
+    PRING_ALLOCATION_HEADER pBlock;
+    UINT64 heapLimit = ((PHeap) pRingHeap)->heapLimit;
+
+    if (pRingHeap->blockCount == 0) {
+        // Start from the beginning when empty to maximize the contiguous space
+        pRingHeap->headOffset = pRingHeap->tailOffset = 0;
+    } else if (pRingHeap->headOffset < pRingHeap->tailOffset) {
+        // Wrapped around - the free space is between the head and the tail
+        if (pRingHeap->tailOffset - pRingHeap->headOffset < blockSize) {
+            return NULL;
+        }
+    } else if (pRingHeap->headOffset == pRingHeap->tailOffset) {
+        // The head has caught up with the tail - the heap is full
+        return NULL;
+    } else if (heapLimit - pRingHeap->headOffset < blockSize) {
+        // Not enough space at the end of the heap - check if it fits before the tail
+        if (pRingHeap->tailOffset < blockSize) {
+            return NULL;
+        }
+
+        // Mark the rest of the heap as a free block if a header fits so the tail can skip over it
+        if (heapLimit - pRingHeap->headOffset >= RING_ALLOCATION_HEADER_SIZE) {
+            pBlock = GET_RING_BLOCK(pRingHeap, pRingHeap->headOffset);
+            MEMCPY(pBlock, &gRingHeader, RING_ALLOCATION_HEADER_SIZE);
+            pBlock->header.size = heapLimit - pRingHeap->headOffset - RING_ALLOCATION_HEADER_SIZE;
+            pBlock->header.flags = ALLOCATION_FLAGS_FREE;
+            pRingHeap->blockCount++;
+        }
+
+        pRingHeap->headOffset = 0;
+    }
+
+    pBlock = GET_RING_BLOCK(pRingHeap, pRingHeap->headOffset);
+    MEMCPY(pBlock, &gRingHeader, RING_ALLOCATION_HEADER_SIZE);
+    pBlock->header.size = blockSize - RING_ALLOCATION_HEADER_SIZE;
+
+    pRingHeap->headOffset += blockSize;
+    pRingHeap->blockCount++;
+
+    return pBlock;
+}
+
+/**
+ * Returns the contiguous space available right after the head
+ */
+UINT64 getRingContiguousSpace(PRingHeap pRingHeap)
+{
+    if (pRingHeap->blockCount == 0) {
+        return ((PHeap) pRingHeap)->heapLimit;
+    } else if (pRingHeap->headOffset > pRingHeap->tailOffset) {
+        return ((PHeap) pRingHeap)->heapLimit - pRingHeap->headOffset;
+    } else {
+        return pRingHeap->tailOffset - pRingHeap->headOffset;
+    }
+}
+
+/**
+ * Advances the tail over the freed blocks
+ */
+VOID reclaimRingBlocks(PRingHeap pRingHeap)
+{
+    PRING_ALLOCATION_HEADER pBlock;
+
+    while (pRingHeap->blockCount != 0) {
+        pBlock = GET_RING_BLOCK(pRingHeap, pRingHeap->tailOffset);
+        if (pBlock->header.flags != ALLOCATION_FLAGS_FREE) {
+            break;
+        }
+
+        pRingHeap->tailOffset = normalizeRingOffset(pRingHeap, pRingHeap->tailOffset + GET_RING_BLOCK_SIZE(pBlock));
+        pRingHeap->blockCount--;
+    }
+
+    if (pRingHeap->blockCount == 0) {
+        pRingHeap->headOffset = pRingHeap->tailOffset = 0;
+    }
+}
+
+/**
+ * Wraps the offset around if there is no space for a block header till the end of the heap
+ */
+UINT64 normalizeRingOffset(PRingHeap pRingHeap, UINT64 offset)
+{
+    return ((PHeap) pRingHeap)->heapLimit - offset < RING_ALLOCATION_HEADER_SIZE ? 0 : offset;
+}
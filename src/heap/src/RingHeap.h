@@ -0,0 +1,170 @@
+/**
+ * Ring heap definitions
+ */
+
+#ifndef __RING_HEAP_H__
+#define __RING_HEAP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RING_ALLOCATION_TYPE 5
+
+/**
+ * Ring heap allocations are always 8 byte aligned to keep the headers aligned
+ */
+#define RING_HEAP_ALIGNMENT        8
+#define RING_PACKED_SIZE(size)     ROUND_UP((size), RING_HEAP_ALIGNMENT)
+#define RING_PACKED_LIMIT(size)    ROUND_DOWN((size), RING_HEAP_ALIGNMENT)
+
+/**
+ * Allocation header for the ring heap implementation. The allocation size is stored in front so the
+ * base header immediately precedes the allocation which allows the hybrid heaps to check the type.
+ *
+ * IMPORTANT!!! Make sure the structure is tightly packed without the tight packing directives
+ */
+typedef struct {
+    // The allocation size specified by the caller without alignment or padding
+    UINT64 allocSize;
+
+    // Base structure
+    ALLOCATION_HEADER header;
+} RING_ALLOCATION_HEADER, *PRING_ALLOCATION_HEADER;
+
+// Macros to convert to and from handle
+#define RING_HANDLE_SHIFT_BITS     2
+#define TO_RING_HANDLE(pRing, p)   (ALLOCATION_HANDLE)((UINT64) (((PBYTE) (p) - (pRing)->pAllocation)) << RING_HANDLE_SHIFT_BITS)
+#define FROM_RING_HANDLE(pRing, h) ((PBYTE) ((pRing)->pAllocation) + ((UINT64) (h) >> RING_HANDLE_SHIFT_BITS))
+
+/**
+ * Gets the allocation header
+ */
+#define GET_RING_ALLOCATION_HEADER(p) ((PRING_ALLOCATION_HEADER) (p) -1)
+
+/**
+ * Gets the overall block size including the header
+ */
+#define GET_RING_BLOCK_SIZE(pBlock) (SIZEOF(RING_ALLOCATION_HEADER) + (pBlock)->header.size)
+
+/**
+ * Gets the block at the given offset
+ */
+#define GET_RING_BLOCK(pRing, offset) ((PRING_ALLOCATION_HEADER) ((pRing)->pAllocation + (offset)))
+
+/**
+ * Ring heap struct.
+ *
+ * The heap is a circular bump allocator. The allocations are carved out at the head and are reclaimed
+ * from the tail as the oldest allocations are freed. Allocations freed out of order are marked as free
+ * and are reclaimed once the tail reaches them.
+ */
+typedef struct {
+    /**
+     * Base Heap struct encapsulation
+     */
+    BaseHeap heap;
+
+    /**
+     * The large allocation to be used as a heap
+     */
+    PBYTE pAllocation;
+
+    /**
+     * Offset of the next allocation
+     */
+    UINT64 headOffset;
+
+    /**
+     * Offset of the oldest block that hasn't been reclaimed yet
+     */
+    UINT64 tailOffset;
+
+    /**
+     * Number of blocks between the tail and the head including the freed but not yet reclaimed blocks
+     */
+    UINT64 blockCount;
+} RingHeap, *PRingHeap;
+
+/**
+ * Validates the allocation by checking the range
+ */
+#define CHK_RING_ALLOCATION(pRing, pAlloc)                                                                                                           \
+    do {                                                                                                                                             \
+        CHK_ERR((PBYTE) (pAlloc) != NULL && (PBYTE) (pAlloc) >= ((PRingHeap) (pRing))->pAllocation + SIZEOF(RING_ALLOCATION_HEADER) &&               \
+                    (PBYTE) (pAlloc) < ((PRingHeap) (pRing))->pAllocation + ((PHeap) (pRing))->heapLimit,                                            \
+                STATUS_INVALID_HANDLE_ERROR, "Invalid handle value.");                                                                               \
+    } while (FALSE)
+
+/**
+ * Creates the heap
+ */
+DEFINE_CREATE_HEAP(ringHeapCreate);
+
+/**
+ * Allocate a buffer from the heap
+ */
+DEFINE_HEAP_ALLOC(ringHeapAlloc);
+
+/**
+ * Free the previously allocated buffer handle
+ */
+DEFINE_HEAP_FREE(ringHeapFree);
+
+/**
+ * Gets the allocation size
+ */
+DEFINE_HEAP_GET_ALLOC_SIZE(ringHeapGetAllocSize);
+
+/**
+ * Sets the allocation size
+ */
+DEFINE_HEAP_SET_ALLOC_SIZE(ringHeapSetAllocSize);
+
+/**
+ * Maps the allocation handle to memory
+ */
+DEFINE_HEAP_MAP(ringHeapMap);
+
+/**
+ * Un-maps the previously mapped buffer
+ */
+DEFINE_HEAP_UNMAP(ringHeapUnmap);
+
+/**
+ * Release the entire heap
+ */
+DEFINE_RELEASE_HEAP(ringHeapRelease);
+
+/**
+ * Initialize the heap with a given limit
+ */
+DEFINE_INIT_HEAP(ringHeapInit);
+
+/**
+ * Debug/check heap
+ */
+DEFINE_HEAP_CHK(ringHeapDebugCheckAllocator);
+
+/**
+ * Dealing with the allocation sizes
+ */
+DEFINE_HEADER_SIZE(ringGetAllocationHeaderSize);
+DEFINE_FOOTER_SIZE(ringGetAllocationFooterSize);
+DEFINE_ALIGNED_SIZE(ringGetAllocationAlignedSize);
+DEFINE_ALLOC_SIZE(ringGetAllocationSize);
+DEFINE_HEAP_LIMITS(ringGetHeapLimits);
+
+/**
+ * Ring heap specific functions
+ */
+PRING_ALLOCATION_HEADER reserveRingBlock(PRingHeap, UINT64);
+UINT64 getRingContiguousSpace(PRingHeap);
+VOID reclaimRingBlocks(PRingHeap);
+UINT64 normalizeRingOffset(PRingHeap, UINT64);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RING_HEAP_H__
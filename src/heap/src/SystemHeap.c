@@ -58,6 +58,9 @@ DEFINE_CREATE_HEAP(sysHeapCreate)
     pBaseHeap->heapSetAllocSizeFn = sysHeapSetAllocSize;
     pBaseHeap->heapMapFn = sysHeapMap;
     pBaseHeap->heapUnmapFn = sysHeapUnmap;
+    pBaseHeap->heapDemoteFn = commonHeapDemote; // Single tier heap
+    pBaseHeap->heapCheckPersistedFn = commonHeapCheckPersisted;
+    pBaseHeap->heapReleaseUnclaimedFn = commonHeapReleaseUnclaimed;
     pBaseHeap->heapDebugCheckAllocatorFn = sysHeapDebugCheckAllocator;
     pBaseHeap->getAllocationSizeFn = sysGetAllocationSize;
     pBaseHeap->getAllocationHeaderSizeFn = sysGetAllocationHeaderSize;
@@ -229,7 +232,7 @@ DEFINE_HEAP_SET_ALLOC_SIZE(sysHeapSetAllocSize)
     CHK_STATUS(commonHeapSetAllocSize(pHeap, pHandle, size, newSize));
 
     // overall allocation size
-    overallSize = SYS_ALLOCATION_HEADER_SIZE + size + SYS_ALLOCATION_FOOTER_SIZE;
+    overallSize = SYS_ALLOCATION_HEADER_SIZE + newSize + SYS_ALLOCATION_FOOTER_SIZE;
 
     // This heap implementation uses a direct memory allocation so no mapping really needed - just conversion from a handle to memory pointer
     pAllocation = (PVOID) HANDLE_TO_POINTER(*pHandle);
@@ -283,7 +286,7 @@ DEFINE_HEAP_MAP(sysHeapMap)
     PVOID pAllocation = (PVOID) HANDLE_TO_POINTER(handle);
 
     // Call the common heap function
-    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize));
+    CHK_STATUS(commonHeapMap(pHeap, handle, ppAllocation, pSize, readOnly));
 
     *ppAllocation = pAllocation;
     pHeader = (PALLOCATION_HEADER) pAllocation - 1;
@@ -305,7 +308,7 @@ DEFINE_HEAP_UNMAP(sysHeapUnmap)
     STATUS retStatus = STATUS_SUCCESS;
 
     // Delegate the call directly
-    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation));
+    CHK_STATUS(commonHeapUnmap(pHeap, pAllocation, readOnly));
 
 CleanUp:
     LEAVES();
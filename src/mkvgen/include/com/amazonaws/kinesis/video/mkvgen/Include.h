@@ -68,6 +68,8 @@ extern "C" {
 #define STATUS_MKV_MISSING_SPS_FROM_H264_CPD                STATUS_MKVGEN_BASE + 0x0000002b
 #define STATUS_MKV_MISSING_PPS_FROM_H264_CPD                STATUS_MKVGEN_BASE + 0x0000002c
 #define STATUS_MKV_INVALID_PARENT_TYPE                      STATUS_MKVGEN_BASE + 0x0000002d
+#define STATUS_MKV_IN_PLACE_ANNEXB_ADAPTATION               STATUS_MKVGEN_BASE + 0x0000002e
+#define STATUS_MKV_INVALID_LACED_FRAMES                     STATUS_MKVGEN_BASE + 0x0000002f
 
 ////////////////////////////////////////////////////
 // Main structure declarations
@@ -103,6 +105,11 @@ extern "C" {
  */
 #define MKV_MAX_TAG_VALUE_LEN 256
 
+/**
+ * Max number of frames laced into a single block - the lace count is stored in a byte as count - 1
+ */
+#define MKV_MAX_LACED_FRAME_COUNT 256
+
 /**
  * Minimal and Maximal cluster durations sanity values
  */
@@ -381,6 +388,27 @@ typedef struct {
     // ------------------------------- V0 compat ----------------------
 } TrackInfo, *PTrackInfo;
 
+/**
+ * Number of the slots in the track index map as a power of 2.
+ * The map is built only if the track count is not over half of the slots.
+ */
+#define MKV_TRACK_INDEX_MAP_SLOT_BITS  4
+#define MKV_TRACK_INDEX_MAP_SLOT_COUNT (1 << MKV_TRACK_INDEX_MAP_SLOT_BITS)
+
+/**
+ * Track id to track index map for the constant time track lookups
+ */
+typedef struct {
+    // Whether the map has been built for the track info array
+    BOOL built;
+
+    // Track ids of the occupied slots
+    UINT64 trackIds[MKV_TRACK_INDEX_MAP_SLOT_COUNT];
+
+    // Track index + 1 for the occupied slots and 0 for the empty ones
+    UINT8 trackIndexes[MKV_TRACK_INDEX_MAP_SLOT_COUNT];
+} TrackIndexMap, *PTrackIndexMap;
+
 /**
  * The representation of the packaged frame information
  */
@@ -566,6 +594,10 @@ PUBLIC_API STATUS mkvgenIncreaseTagsTagSize(PBYTE, UINT32);
 /**
  * Packages a frame into an MKV fragment
  *
+ * NOTE: The frame data can already reside in the buffer at the offset of the packaged frame payload,
+ * in which case only the MKV bits are produced in front of it and the payload is not copied.
+ * In-place packaging is not supported with the Annex-B NALs adaptation.
+ *
  * @PMkvGenerator - The generator object
  * @PFrame - Frame to package
  * @PTrackInfo - IN - The track info object the frame belongs to
@@ -577,6 +609,45 @@ PUBLIC_API STATUS mkvgenIncreaseTagsTagSize(PBYTE, UINT32);
  */
 PUBLIC_API STATUS mkvgenPackageFrame(PMkvGenerator, PFrame, PTrackInfo, PBYTE, PUINT32, PEncodedFrameInfo);
 
+/**
+ * Packages consecutive audio frames of the same track into a single laced MKV block.
+ *
+ * The block is timestamped and flagged by the first frame and spans the duration of all of the frames.
+ * Fixed-size lacing is used when the frames are of the same size and EBML lacing otherwise.
+ * Packaging a single frame is equivalent to mkvgenPackageFrame.
+ *
+ * @PMkvGenerator - The generator object
+ * @PFrame - Array of the frames to package
+ * @UINT32 - Number of the frames in the array
+ * @PTrackInfo - IN - The track info object the frames belong to
+ * @PBYTE - Buffer to hold the packaged bits
+ * @PUINT32 - IN/OUT - Size of the produced packaged bits
+ * @PEncodedFrameInfo - OUT OPT - Information about the encoded block - optional.
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS mkvgenPackageLacedFrames(PMkvGenerator, PFrame, UINT32, PTrackInfo, PBYTE, PUINT32, PEncodedFrameInfo);
+
+/**
+ * Packages the frames as mkvgenPackageLacedFrames does leaving a gap between the MKV header and the cluster.
+ *
+ * The gap starts at the data offset returned in the encoded frame info and is left for the caller to fill in
+ * with the bits packaged separately, such as the tags, so the packaged frames don't need to be moved.
+ * The gap is only allowed when the frames start a cluster.
+ *
+ * @PMkvGenerator - The generator object
+ * @PFrame - Array of the frames to package
+ * @UINT32 - Number of the frames in the array
+ * @PTrackInfo - IN - The track info object the frames belong to
+ * @UINT32 - Size of the gap
+ * @PBYTE - Buffer to hold the packaged bits
+ * @PUINT32 - IN/OUT - Size of the produced packaged bits including the gap
+ * @PEncodedFrameInfo - OUT OPT - Information about the encoded block - optional.
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS mkvgenPackageFramesWithGap(PMkvGenerator, PFrame, UINT32, PTrackInfo, UINT32, PBYTE, PUINT32, PEncodedFrameInfo);
+
 /**
  * Converts an MKV timecode to a timestamp
  *
@@ -636,6 +707,33 @@ PUBLIC_API STATUS mkvgenSetCodecPrivateData(PMkvGenerator, UINT64, UINT32, PBYTE
  */
 PUBLIC_API STATUS mkvgenGetTrackInfo(PTrackInfo, UINT32, UINT64, PTrackInfo*, PUINT32);
 
+/**
+ * Builds the track id to index map for the track info array.
+ *
+ * NOTE: The map is not built for a large number of tracks in which case the lookups fall back to the search.
+ *
+ * @PTrackInfo - IN - Track info array
+ * @UINT32 - IN - Track info count
+ * @PTrackIndexMap - OUT - Track index map to build
+ *
+ * @return Status of the operation
+ */
+PUBLIC_API STATUS mkvgenBuildTrackIndexMap(PTrackInfo, UINT32, PTrackIndexMap);
+
+/**
+ * Gets the track info for a specified track id using the track index map
+ *
+ * @PTrackIndexMap - IN - Track index map built for the track info array
+ * @PTrackInfo - IN - Track info array
+ * @UINT32 - IN - Track info count
+ * @UINT64 - IN - Track ID
+ * @PTrackInfo* - OUT/OPT - Track info object matching the track id
+ * @PUINT32 - OUT/OPT - Track index
+ *
+ * @return Status of the operation
+ */
+PUBLIC_API STATUS mkvgenGetTrackInfoFromMap(PTrackIndexMap, PTrackInfo, UINT32, UINT64, PTrackInfo*, PUINT32);
+
 /**
  * Generate AAC audio cpd
  *
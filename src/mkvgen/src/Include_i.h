@@ -260,6 +260,12 @@ extern UINT32 gMkvTagStringBitsSize;
 #define MKV_SIMPLE_BLOCK_INVISIBLE_FLAG   0x08
 #define MKV_SIMPLE_BLOCK_DISCARDABLE_FLAG 0x01
 
+/**
+ * MKV simple block lacing flags
+ */
+#define MKV_SIMPLE_BLOCK_FIXED_SIZE_LACING 0x04
+#define MKV_SIMPLE_BLOCK_EBML_LACING       0x06
+
 /**
  * MKV wave format code
  */
@@ -297,6 +303,11 @@ extern UINT32 gMkvTagStringBitsSize;
  */
 #define MKV_VERSION_STRING_DELIMITER ' '
 
+/**
+ * Fibonacci hashing of the track id into the track index map slot
+ */
+#define MKV_TRACK_INDEX_MAP_SLOT(trackId) ((UINT32) (((UINT64) (trackId) *0x9E3779B97F4A7C15ULL) >> (64 - MKV_TRACK_INDEX_MAP_SLOT_BITS)))
+
 /**
  * The rest of the internal include files
  */
@@ -389,6 +400,22 @@ typedef struct {
     // Whether to adapt CPD NALs from Annex-B to Avcc format.
     BOOL adaptCpdNals;
 
+    // Annex-B NALu index built by the size calculation call and re-used by the packaging call of the same frame
+    NalIndex nalIndex;
+
+    // Encoded EBML header, segment header, segment info and track info copied at the stream starts
+    PBYTE pHeaderBits;
+
+    // Allocation size of the encoded header bits
+    UINT32 headerBitsAllocationSize;
+
+    // Sizes of the encoded segment info and track info in the header bits
+    UINT32 segmentInfoBitsSize;
+    UINT32 trackInfoBitsSize;
+
+    // Whether the header bits reflect the current segment and track info
+    BOOL headerBitsValid;
+
     // Video height and width - Only for video
     UINT16 videoWidth;
     UINT16 videoHeight;
@@ -402,6 +429,9 @@ typedef struct {
     // Number of TrackInfo object in trackInfoList
     UINT32 trackInfoCount;
 
+    // Track id to index map of trackInfoList
+    TrackIndexMap trackIndexMap;
+
     // Version string to package with the MKV header
     // IMPORTANT!!! the combined string should be less than 127 chars
     CHAR version[MAX_MKV_CLIENT_ID_STRING_LEN + SIZEOF(MKV_GENERATOR_CURRENT_VERSION_STRING) + 1];
@@ -449,6 +479,7 @@ UINT32 mkvgenGetFrameOverhead(PStreamMkvGenerator, MKV_STREAM_STATE);
  * @return - STATUS code of the execution
  **/
 STATUS mkvgenValidateFrame(PStreamMkvGenerator, PFrame, PTrackInfo, PUINT64, PUINT64, PUINT64, PMKV_STREAM_STATE);
+STATUS mkvgenValidateLacedFrames(PStreamMkvGenerator, PFrame, UINT32, UINT64, PUINT32, PUINT64);
 
 /**
  * Returns the MKV content type from the provided content type string by tokenizing and matching the string
@@ -479,6 +510,16 @@ MKV_CONTENT_TYPE mkvgenGetContentTypeFromContentTypeTokenString(PCHAR, UINT32);
  */
 STATUS mkvgenEbmlEncodeNumber(UINT64, PBYTE, UINT32, PUINT32);
 
+/**
+ * EBML encodes a signed number as used by the EBML lacing and stores in the buffer
+ *
+ * @INT64 - the number to encode
+ * @PBYTE - the buffer to store the number in
+ * @UINT32 - the size of the buffer
+ * @PUINT32 - the returned encoded length in bytes
+ */
+STATUS mkvgenEbmlEncodeSignedNumber(INT64, PBYTE, UINT32, PUINT32);
+
 /**
  * Stores a number in the buffer in a big-endian way
  *
@@ -527,6 +568,14 @@ STATUS mkvgenEbmlEncodeSegmentInfo(PStreamMkvGenerator, PBYTE, UINT32, PUINT32);
  */
 STATUS mkvgenEbmlEncodeTrackInfo(PBYTE, UINT32, PStreamMkvGenerator, PUINT32);
 
+/**
+ * Encodes the EBML header, segment header, segment info and track info into the header bits of the generator
+ * unless the header bits are still valid
+ *
+ * @PStreamMkvGenerator - The MKV generator
+ */
+STATUS mkvgenEncodeHeaderBits(PStreamMkvGenerator);
+
 /**
  * EBML encodes a cluster header and stores in the buffer
  *
@@ -551,6 +600,43 @@ STATUS mkvgenEbmlEncodeClusterInfo(PBYTE, UINT32, UINT64, PUINT32);
  */
 STATUS mkvgenEbmlEncodeSimpleBlock(PBYTE, UINT32, INT16, PFrame, MKV_NALS_ADAPTATION, UINT32, PStreamMkvGenerator, PUINT32);
 
+/**
+ * EBML encodes a simple block with the frames laced into it and stores in the buffer
+ *
+ * @PBYTE - the buffer to store the encoded info in
+ * @UINT32 - the size of the buffer
+ * @INT16 - block timestamp
+ * @PFrame - the frames to encode
+ * @UINT32 - the number of the frames
+ * @UINT32 - the size of the block payload including the lace header
+ * @PStreamMkvGenerator - The MKV generator
+ * @PUINT32 - the returned encoded length of the number in bytes
+ */
+STATUS mkvgenEbmlEncodeLacedSimpleBlock(PBYTE, UINT32, INT16, PFrame, UINT32, UINT32, PStreamMkvGenerator, PUINT32);
+
+/**
+ * Fixes up the simple block header bits for the payload of the specified size
+ *
+ * @PBYTE - the buffer with the simple block header bits
+ * @INT16 - block timestamp
+ * @PFrame - the frame the block is flagged by
+ * @UINT32 - the size of the block payload
+ * @PStreamMkvGenerator - The MKV generator
+ */
+STATUS mkvgenFixupSimpleBlockHeader(PBYTE, INT16, PFrame, UINT32, PStreamMkvGenerator);
+
+/**
+ * Encodes the lace header of the frames laced into a block
+ *
+ * @PFrame - the laced frames
+ * @UINT32 - the number of the frames
+ * @PBYTE - OPT the buffer to store the lace header in
+ * @UINT32 - the size of the buffer
+ * @PUINT32 - the returned encoded length in bytes
+ * @PBYTE - the returned simple block lacing flags
+ */
+STATUS mkvgenEncodeLaceHeader(PFrame, UINT32, PBYTE, UINT32, PUINT32, PBYTE);
+
 /**
  * Gets the size of a single mkv TrackEntry
  * @PTrackInfo - the TrackInfo object
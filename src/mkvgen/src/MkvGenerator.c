@@ -105,6 +105,7 @@ STATUS createMkvGenerator(PCHAR contentType, UINT32 behaviorFlags, UINT64 timeco
     // Copy TrackInfoList to the end of MkvGenerator struct
     pMkvGenerator->trackInfoList = (PTrackInfo) (pMkvGenerator + 1);
     MEMCPY(pMkvGenerator->trackInfoList, trackInfoList, SIZEOF(TrackInfo) * trackInfoCount);
+    CHK_STATUS(mkvgenBuildTrackIndexMap(pMkvGenerator->trackInfoList, trackInfoCount, &pMkvGenerator->trackIndexMap));
 
     if (adaptAnnexB) {
         pMkvGenerator->nalsAdaptation = MKV_NALS_ADAPT_ANNEXB;
@@ -171,6 +172,8 @@ STATUS freeMkvGenerator(PMkvGenerator pMkvGenerator)
         pStreamMkvGenerator->trackInfoList[i].codecPrivateDataSize = 0;
     }
 
+    SAFE_MEMFREE(pStreamMkvGenerator->pHeaderBits);
+
     // Release the object
     MEMFREE(pMkvGenerator);
 
@@ -202,6 +205,9 @@ STATUS mkvgenResetGenerator(PMkvGenerator pMkvGenerator)
     // Set the start timestamp to not stored
     pStreamMkvGenerator->streamStartTimestampStored = FALSE;
 
+    // Re-encode the header on the next stream start
+    pStreamMkvGenerator->headerBitsValid = FALSE;
+
 CleanUp:
 
     LEAVES();
@@ -213,6 +219,24 @@ CleanUp:
  */
 STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo pTrackInfo, PBYTE pBuffer, PUINT32 pSize,
                           PEncodedFrameInfo pEncodedFrameInfo)
+{
+    return mkvgenPackageLacedFrames(pMkvGenerator, pFrame, 1, pTrackInfo, pBuffer, pSize, pEncodedFrameInfo);
+}
+
+/**
+ * Package the frames in MKV format. The frames following the first one are laced into its block.
+ */
+STATUS mkvgenPackageLacedFrames(PMkvGenerator pMkvGenerator, PFrame pFrames, UINT32 frameCount, PTrackInfo pTrackInfo, PBYTE pBuffer,
+                                PUINT32 pSize, PEncodedFrameInfo pEncodedFrameInfo)
+{
+    return mkvgenPackageFramesWithGap(pMkvGenerator, pFrames, frameCount, pTrackInfo, 0, pBuffer, pSize, pEncodedFrameInfo);
+}
+
+/**
+ * Package the frames in MKV format leaving a gap at the data offset for the bits packaged separately
+ */
+STATUS mkvgenPackageFramesWithGap(PMkvGenerator pMkvGenerator, PFrame pFrames, UINT32 frameCount, PTrackInfo pTrackInfo, UINT32 gapSize,
+                                  PBYTE pBuffer, PUINT32 pSize, PEncodedFrameInfo pEncodedFrameInfo)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
@@ -226,11 +250,15 @@ STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo
 
     // Check the input params
     CHK(pSize != NULL && pMkvGenerator != NULL && pTrackInfo != NULL, STATUS_NULL_ARG);
+    CHK(frameCount != 0 && frameCount <= MKV_MAX_LACED_FRAME_COUNT, STATUS_INVALID_ARG);
 
     pStreamMkvGenerator = (PStreamMkvGenerator) pMkvGenerator;
 
-    // Validate and extract the timestamp
-    CHK_STATUS(mkvgenValidateFrame(pStreamMkvGenerator, pFrame, pTrackInfo, &pts, &dts, &duration, &streamState));
+    // Validate and extract the timestamp of the first frame which the block is timestamped with
+    CHK_STATUS(mkvgenValidateFrame(pStreamMkvGenerator, pFrames, pTrackInfo, &pts, &dts, &duration, &streamState));
+
+    // The gap can only precede a cluster
+    CHK(gapSize == 0 || streamState != MKV_STATE_START_BLOCK, STATUS_INVALID_ARG);
 
     // Check to see if we can extract the CPD first.
     // Currently, we will process only if all of these conditions hold:
@@ -240,9 +268,9 @@ STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo
     // * We have a key frame
     // * The content type is either H264 or H265
     if (pStreamMkvGenerator->nalsAdaptation == MKV_NALS_ADAPT_ANNEXB && pTrackInfo->codecPrivateDataSize == 0 &&
-        pTrackInfo->trackType == MKV_TRACK_INFO_TYPE_VIDEO && CHECK_FRAME_FLAG_KEY_FRAME(pFrame->flags) &&
+        pTrackInfo->trackType == MKV_TRACK_INFO_TYPE_VIDEO && CHECK_FRAME_FLAG_KEY_FRAME(pFrames->flags) &&
         (pStreamMkvGenerator->contentType & MKV_CONTENT_TYPE_H264_H265) != MKV_CONTENT_TYPE_NONE) {
-        if (STATUS_FAILED(mkvgenExtractCpdFromAnnexBFrame(pStreamMkvGenerator, pFrame, pTrackInfo))) {
+        if (STATUS_FAILED(mkvgenExtractCpdFromAnnexBFrame(pStreamMkvGenerator, pFrames, pTrackInfo))) {
             DLOGW("Warning: Failed auto-extracting the CPD from the key frame.");
         }
     }
@@ -255,9 +283,21 @@ STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo
     // NAL adaptation should only be done for video frames
     nalsAdaptation = pTrackInfo->trackType == MKV_TRACK_INFO_TYPE_VIDEO ? pStreamMkvGenerator->nalsAdaptation : MKV_NALS_ADAPT_NONE;
 
-    // Get the adapted size of the frame and add to the overall size
-    CHK_STATUS(getAdaptedFrameSize(pFrame, nalsAdaptation, &adaptedFrameSize));
-    packagedSize = overheadSize + adaptedFrameSize;
+    // The size calculation call re-indexes the NALus as the frame data might have changed since the last packaging
+    if (pBuffer == NULL) {
+        pStreamMkvGenerator->nalIndex.pFrameData = NULL;
+    }
+
+    if (frameCount == 1) {
+        // Get the adapted size of the frame and add to the overall size
+        CHK_STATUS(getAdaptedFrameSize(pFrames, nalsAdaptation, &pStreamMkvGenerator->nalIndex, &adaptedFrameSize));
+    } else {
+        // Get the size of the laced frames and the duration of the block
+        CHK(nalsAdaptation == MKV_NALS_ADAPT_NONE, STATUS_MKV_INVALID_LACED_FRAMES);
+        CHK_STATUS(mkvgenValidateLacedFrames(pStreamMkvGenerator, pFrames, frameCount, pts, &adaptedFrameSize, &duration));
+    }
+
+    packagedSize = overheadSize + gapSize + adaptedFrameSize;
 
     // Check if we are asked for size only and early return if so
     CHK(pBuffer != NULL, STATUS_SUCCESS);
@@ -271,13 +311,13 @@ STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo
     // Generate the actual data
     switch (streamState) {
         case MKV_STATE_START_STREAM:
-            if (pStreamMkvGenerator->generatorState == MKV_GENERATOR_STATE_START) {
-                // Encode in sequence and subtract the size
-                CHK_STATUS(mkvgenEbmlEncodeHeader(pCurrentPnt, bufferSize, &encodedLen));
-                bufferSize -= encodedLen;
-                pCurrentPnt += encodedLen;
+            // The headers are copied from the encoded header bits
+            CHK_STATUS(mkvgenEncodeHeaderBits(pStreamMkvGenerator));
 
-                CHK_STATUS(mkvgenEbmlEncodeSegmentHeader(pCurrentPnt, bufferSize, &encodedLen));
+            if (pStreamMkvGenerator->generatorState == MKV_GENERATOR_STATE_START) {
+                // Copy the EBML and the segment header and subtract the size
+                encodedLen = MKV_EBML_SEGMENT_SIZE;
+                MEMCPY(pCurrentPnt, pStreamMkvGenerator->pHeaderBits, encodedLen);
                 bufferSize -= encodedLen;
                 pCurrentPnt += encodedLen;
 
@@ -285,11 +325,9 @@ STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo
             }
 
             if (pStreamMkvGenerator->generatorState == MKV_GENERATOR_STATE_SEGMENT_HEADER) {
-                CHK_STATUS(mkvgenEbmlEncodeSegmentInfo(pStreamMkvGenerator, pCurrentPnt, bufferSize, &encodedLen));
-                bufferSize -= encodedLen;
-                pCurrentPnt += encodedLen;
-
-                CHK_STATUS(mkvgenEbmlEncodeTrackInfo(pCurrentPnt, bufferSize, pStreamMkvGenerator, &encodedLen));
+                // Copy the segment info and the track info
+                encodedLen = pStreamMkvGenerator->segmentInfoBitsSize + pStreamMkvGenerator->trackInfoBitsSize;
+                MEMCPY(pCurrentPnt, pStreamMkvGenerator->pHeaderBits + MKV_EBML_SEGMENT_SIZE, encodedLen);
                 bufferSize -= encodedLen;
                 pCurrentPnt += encodedLen;
 
@@ -301,13 +339,15 @@ STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo
 
             // Fall-through
         case MKV_STATE_START_CLUSTER:
+            // Skip over the gap which is filled in by the caller
+            bufferSize -= gapSize;
+            pCurrentPnt += gapSize;
+
             // If we just added tags then we need to add the segment and track info
             if (pStreamMkvGenerator->generatorState == MKV_GENERATOR_STATE_SEGMENT_HEADER) {
-                CHK_STATUS(mkvgenEbmlEncodeSegmentInfo(pStreamMkvGenerator, pCurrentPnt, bufferSize, &encodedLen));
-                bufferSize -= encodedLen;
-                pCurrentPnt += encodedLen;
-
-                CHK_STATUS(mkvgenEbmlEncodeTrackInfo(pCurrentPnt, bufferSize, pStreamMkvGenerator, &encodedLen));
+                CHK_STATUS(mkvgenEncodeHeaderBits(pStreamMkvGenerator));
+                encodedLen = pStreamMkvGenerator->segmentInfoBitsSize + pStreamMkvGenerator->trackInfoBitsSize;
+                MEMCPY(pCurrentPnt, pStreamMkvGenerator->pHeaderBits + MKV_EBML_SEGMENT_SIZE, encodedLen);
                 bufferSize -= encodedLen;
                 pCurrentPnt += encodedLen;
 
@@ -354,8 +394,13 @@ STATUS mkvgenPackageFrame(PMkvGenerator pMkvGenerator, PFrame pFrame, PTrackInfo
             CHK(pts <= MAX_INT16, STATUS_MKV_LARGE_FRAME_TIMECODE);
 
             // Adjust the timestamp to the start of the cluster
-            CHK_STATUS(mkvgenEbmlEncodeSimpleBlock(pCurrentPnt, bufferSize, (INT16) pts, pFrame, nalsAdaptation, adaptedFrameSize,
-                                                   pStreamMkvGenerator, &encodedLen));
+            if (frameCount == 1) {
+                CHK_STATUS(mkvgenEbmlEncodeSimpleBlock(pCurrentPnt, bufferSize, (INT16) pts, pFrames, nalsAdaptation, adaptedFrameSize,
+                                                       pStreamMkvGenerator, &encodedLen));
+            } else {
+                CHK_STATUS(mkvgenEbmlEncodeLacedSimpleBlock(pCurrentPnt, bufferSize, (INT16) pts, pFrames, frameCount, adaptedFrameSize,
+                                                            pStreamMkvGenerator, &encodedLen));
+            }
             bufferSize -= encodedLen;
             pCurrentPnt += encodedLen;
 
@@ -386,6 +431,11 @@ CleanUp:
         }
     }
 
+    // The NALu index is consumed by the packaging call
+    if (pBuffer != NULL && pStreamMkvGenerator != NULL) {
+        pStreamMkvGenerator->nalIndex.pFrameData = NULL;
+    }
+
     LEAVES();
     return retStatus;
 }
@@ -407,7 +457,11 @@ STATUS mkvgenSetCodecPrivateData(PMkvGenerator pMkvGenerator, UINT64 trackId, UI
     CHK(codecPrivateDataSize == 0 || codecPrivateData != NULL, STATUS_MKV_CODEC_PRIVATE_NULL);
 
     // Find the right track
-    CHK_STATUS(mkvgenGetTrackInfo(pStreamMkvGenerator->trackInfoList, pStreamMkvGenerator->trackInfoCount, trackId, &pTrackInfo, &trackIndex));
+    CHK_STATUS(mkvgenGetTrackInfoFromMap(&pStreamMkvGenerator->trackIndexMap, pStreamMkvGenerator->trackInfoList,
+                                         pStreamMkvGenerator->trackInfoCount, trackId, &pTrackInfo, &trackIndex));
+
+    // The track info is changing so the header needs re-encoding
+    pStreamMkvGenerator->headerBitsValid = FALSE;
 
     // Free the CPD if any
     if (pTrackInfo->codecPrivateData != NULL) {
@@ -458,21 +512,11 @@ STATUS mkvgenGenerateHeader(PMkvGenerator pMkvGenerator, PBYTE pBuffer, PUINT32
     // Start with the full buffer
     bufferSize = *pSize;
 
-    // Generate the actual data
-    CHK_STATUS(mkvgenEbmlEncodeHeader(pCurrentPnt, bufferSize, &encodedLen));
-    bufferSize -= encodedLen;
-    pCurrentPnt += encodedLen;
-
-    CHK_STATUS(mkvgenEbmlEncodeSegmentHeader(pCurrentPnt, bufferSize, &encodedLen));
-    bufferSize -= encodedLen;
-    pCurrentPnt += encodedLen;
-
-    CHK_STATUS(mkvgenEbmlEncodeSegmentInfo(pStreamMkvGenerator, pCurrentPnt, bufferSize, &encodedLen));
-    bufferSize -= encodedLen;
-    pCurrentPnt += encodedLen;
-
-    CHK_STATUS(mkvgenEbmlEncodeTrackInfo(pCurrentPnt, bufferSize, pStreamMkvGenerator, &encodedLen));
-    bufferSize -= encodedLen;
+    // Copy the encoded header bits
+    CHK_STATUS(mkvgenEncodeHeaderBits(pStreamMkvGenerator));
+    encodedLen = MKV_EBML_SEGMENT_SIZE + pStreamMkvGenerator->segmentInfoBitsSize + pStreamMkvGenerator->trackInfoBitsSize;
+    CHK(bufferSize >= encodedLen, STATUS_NOT_ENOUGH_MEMORY);
+    MEMCPY(pCurrentPnt, pStreamMkvGenerator->pHeaderBits, encodedLen);
     pCurrentPnt += encodedLen;
 
     // Validate the size
@@ -906,6 +950,54 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Validates the frames to be laced into the block of the first frame and returns the size of the block payload
+ * including the lace header and the duration of the block spanning all of the frames
+ */
+STATUS mkvgenValidateLacedFrames(PStreamMkvGenerator pStreamMkvGenerator, PFrame pFrames, UINT32 frameCount, UINT64 pts, PUINT32 pPayloadSize,
+                                 PUINT64 pDuration)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 payloadSize = 0, duration = 0, endTs;
+    UINT32 i, laceHeaderSize;
+    BYTE lacing;
+
+    CHK(pStreamMkvGenerator != NULL && pFrames != NULL && pPayloadSize != NULL && pDuration != NULL, STATUS_NULL_ARG);
+
+    for (i = 0; i < frameCount; i++) {
+        CHK(pFrames[i].size > 0 && pFrames[i].frameData != NULL && pFrames[i].trackId == pFrames[0].trackId, STATUS_MKV_INVALID_LACED_FRAMES);
+        CHK(pFrames[i].duration <= MAX_TIMESTAMP_VALUE, STATUS_MKV_MAX_FRAME_TIMECODE);
+
+        // The laced frames are expected to be consecutive
+        CHK(!pStreamMkvGenerator->streamTimestamps || i == 0 || pFrames[i].presentationTs >= pFrames[i - 1].presentationTs,
+            STATUS_MKV_INVALID_LACED_FRAMES);
+
+        payloadSize += pFrames[i].size;
+        duration += pFrames[i].duration;
+    }
+
+    CHK_STATUS(mkvgenEncodeLaceHeader(pFrames, frameCount, NULL, 0, &laceHeaderSize, &lacing));
+    payloadSize += laceHeaderSize;
+    CHK(payloadSize <= MAX_UINT32 - MKV_SIMPLE_BLOCK_BITS_SIZE, STATUS_MKV_INVALID_LACED_FRAMES);
+
+    if (pStreamMkvGenerator->streamTimestamps) {
+        // The block spans from the first frame to the end of the last one
+        endTs = pFrames[frameCount - 1].presentationTs + pFrames[frameCount - 1].duration;
+        CHK(endTs <= MAX_TIMESTAMP_VALUE, STATUS_MKV_MAX_FRAME_TIMECODE);
+        duration = TIMESTAMP_TO_MKV_TIMECODE(endTs, pStreamMkvGenerator->timecodeScale) - pts;
+    } else {
+        CHK(duration <= MAX_TIMESTAMP_VALUE, STATUS_MKV_MAX_FRAME_TIMECODE);
+        duration = TIMESTAMP_TO_MKV_TIMECODE(duration, pStreamMkvGenerator->timecodeScale);
+    }
+
+    *pPayloadSize = (UINT32) payloadSize;
+    *pDuration = duration;
+
+CleanUp:
+
+    return retStatus;
+}
+
 STATUS mkvgenHasStreamStarted(PMkvGenerator pMkvGenerator, PBOOL pBool)
 {
     PStreamMkvGenerator pStreamMkvGenerator = NULL;
@@ -1119,6 +1211,92 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * EBML encodes a signed number stored biased by the half of the range of the encoded length
+ */
+STATUS mkvgenEbmlEncodeSignedNumber(INT64 number, PBYTE pBuffer, UINT32 bufferSize, PUINT32 pEncodedLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 encoded = 0, bias = 0;
+    UINT32 byteLen;
+    UINT32 i;
+
+    CHK(pEncodedLen != NULL, STATUS_NULL_ARG);
+
+    // Find the shortest length which can hold the number
+    for (byteLen = 1; byteLen <= 8; byteLen++) {
+        bias = (1ULL << (7 * byteLen - 1)) - 1;
+        if (number >= -(INT64) bias && number <= (INT64) bias) {
+            break;
+        }
+    }
+
+    CHK(byteLen <= 8, STATUS_MKV_NUMBER_TOO_BIG);
+    encoded = (1ULL << (7 * byteLen)) | (UINT64) (number + (INT64) bias);
+
+    // Store the byte len first if asked
+    *pEncodedLen = byteLen;
+
+    // Check if we have a buffer and if not - early exit
+    CHK(pBuffer != NULL, retStatus);
+
+    // Ensure we have enough buffer left
+    CHK(bufferSize >= byteLen, STATUS_NOT_ENOUGH_MEMORY);
+    for (i = byteLen; i > 0; i--) {
+        *(pBuffer + i - 1) = (BYTE) encoded;
+        encoded >>= 8;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Encodes the lace count and the lace sizes of the frames laced into a block and returns the lacing flags.
+ * The frames of the same size are fixed-size laced, otherwise the sizes but the last one are EBML laced.
+ */
+STATUS mkvgenEncodeLaceHeader(PFrame pFrames, UINT32 frameCount, PBYTE pBuffer, UINT32 bufferSize, PUINT32 pEncodedLen, PBYTE pLacing)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, encodedLen = 0, len;
+    BOOL fixedSize = TRUE;
+
+    CHK(pFrames != NULL && pEncodedLen != NULL && pLacing != NULL, STATUS_NULL_ARG);
+    CHK(frameCount > 1 && frameCount <= MKV_MAX_LACED_FRAME_COUNT, STATUS_MKV_INVALID_LACED_FRAMES);
+
+    for (i = 1; i < frameCount && fixedSize; i++) {
+        fixedSize = pFrames[i].size == pFrames[0].size;
+    }
+
+    // The lace count is stored as the number of frames minus one
+    if (pBuffer != NULL) {
+        CHK(bufferSize >= 1, STATUS_NOT_ENOUGH_MEMORY);
+        *pBuffer = (BYTE) (frameCount - 1);
+    }
+
+    encodedLen = 1;
+
+    if (!fixedSize) {
+        // The first size is stored as is and the following ones as differences to the previous ones
+        CHK_STATUS(mkvgenEbmlEncodeNumber(pFrames[0].size, pBuffer == NULL ? NULL : pBuffer + encodedLen, bufferSize - encodedLen, &len));
+        encodedLen += len;
+
+        for (i = 1; i < frameCount - 1; i++) {
+            CHK_STATUS(mkvgenEbmlEncodeSignedNumber((INT64) pFrames[i].size - (INT64) pFrames[i - 1].size,
+                                                    pBuffer == NULL ? NULL : pBuffer + encodedLen, bufferSize - encodedLen, &len));
+            encodedLen += len;
+        }
+    }
+
+    *pEncodedLen = encodedLen;
+    *pLacing = fixedSize ? MKV_SIMPLE_BLOCK_FIXED_SIZE_LACING : MKV_SIMPLE_BLOCK_EBML_LACING;
+
+CleanUp:
+
+    return retStatus;
+}
+
 /**
  * Stores a big-endian number
  */
@@ -1473,6 +1651,56 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Encodes the header bits which are then copied at the stream starts
+ */
+STATUS mkvgenEncodeHeaderBits(PStreamMkvGenerator pStreamMkvGenerator)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 segmentInfoSize, trackInfoSize, headerSize, encodedLen;
+    PBYTE pCurrentPnt;
+
+    CHK(pStreamMkvGenerator != NULL, STATUS_NULL_ARG);
+
+    // Quick return if nothing has changed since the last encoding
+    CHK(!pStreamMkvGenerator->headerBitsValid, retStatus);
+
+    CHK_STATUS(mkvgenEbmlEncodeSegmentInfo(pStreamMkvGenerator, NULL, 0, &segmentInfoSize));
+    CHK_STATUS(mkvgenEbmlEncodeTrackInfo(NULL, 0, pStreamMkvGenerator, &trackInfoSize));
+    headerSize = MKV_EBML_SEGMENT_SIZE + segmentInfoSize + trackInfoSize;
+
+    // Grow the buffer if needed
+    if (headerSize > pStreamMkvGenerator->headerBitsAllocationSize) {
+        SAFE_MEMFREE(pStreamMkvGenerator->pHeaderBits);
+        pStreamMkvGenerator->headerBitsAllocationSize = 0;
+
+        pStreamMkvGenerator->pHeaderBits = (PBYTE) MEMALLOC(headerSize);
+        CHK(pStreamMkvGenerator->pHeaderBits != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pStreamMkvGenerator->headerBitsAllocationSize = headerSize;
+    }
+
+    // Encode in sequence
+    pCurrentPnt = pStreamMkvGenerator->pHeaderBits;
+    CHK_STATUS(mkvgenEbmlEncodeHeader(pCurrentPnt, headerSize, &encodedLen));
+    pCurrentPnt += encodedLen;
+
+    CHK_STATUS(mkvgenEbmlEncodeSegmentHeader(pCurrentPnt, headerSize - MKV_HEADER_BITS_SIZE, &encodedLen));
+    pCurrentPnt += encodedLen;
+
+    CHK_STATUS(mkvgenEbmlEncodeSegmentInfo(pStreamMkvGenerator, pCurrentPnt, segmentInfoSize + trackInfoSize, &encodedLen));
+    pCurrentPnt += encodedLen;
+
+    CHK_STATUS(mkvgenEbmlEncodeTrackInfo(pCurrentPnt, trackInfoSize, pStreamMkvGenerator, &encodedLen));
+
+    pStreamMkvGenerator->segmentInfoBitsSize = segmentInfoSize;
+    pStreamMkvGenerator->trackInfoBitsSize = trackInfoSize;
+    pStreamMkvGenerator->headerBitsValid = TRUE;
+
+CleanUp:
+
+    return retStatus;
+}
+
 /**
  * EBML encodes a cluster
  */
@@ -1507,9 +1735,8 @@ STATUS mkvgenEbmlEncodeSimpleBlock(PBYTE pBuffer, UINT32 bufferSize, INT16 times
                                    UINT32 adaptedFrameSize, PStreamMkvGenerator pStreamMkvGenerator, PUINT32 pEncodedLen)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    UINT64 encodedLength;
-    BYTE flags;
-    UINT32 size, trackIndex;
+    UINT32 size;
+    BOOL inPlace;
 
     CHK(pEncodedLen != NULL && pFrame != NULL, STATUS_NULL_ARG);
 
@@ -1522,38 +1749,113 @@ STATUS mkvgenEbmlEncodeSimpleBlock(PBYTE pBuffer, UINT32 bufferSize, INT16 times
 
     // Check the buffer size
     CHK(bufferSize >= size, STATUS_NOT_ENOUGH_MEMORY);
+
+    // The frame data might have been produced directly in the buffer in which case the payload is not copied
+    inPlace = pFrame->frameData == pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE;
+
     // Copy the header and the frame data
     MEMCPY(pBuffer, MKV_SIMPLE_BLOCK_BITS, MKV_SIMPLE_BLOCK_BITS_SIZE);
 
     switch (nalsAdaptation) {
         case MKV_NALS_ADAPT_NONE:
             // Just copy the bits
-            MEMCPY(pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, pFrame->frameData, adaptedFrameSize);
+            if (!inPlace) {
+                MEMCPY(pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, pFrame->frameData, adaptedFrameSize);
+            }
+
             break;
 
         case MKV_NALS_ADAPT_AVCC:
             // Copy the bits first
-            MEMCPY(pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, pFrame->frameData, adaptedFrameSize);
+            if (!inPlace) {
+                MEMCPY(pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, pFrame->frameData, adaptedFrameSize);
+            }
 
             // Adapt from Avcc to Annex-B nals
             CHK_STATUS(adaptFrameNalsFromAvccToAnnexB(pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, adaptedFrameSize));
             break;
 
         case MKV_NALS_ADAPT_ANNEXB:
-            // Adapt from Annex-B to Avcc nals. NOTE: The conversion is not 'in-place'
-            CHK_STATUS(
-                adaptFrameNalsFromAnnexBToAvcc(pFrame->frameData, pFrame->size, FALSE, pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, &adaptedFrameSize));
+            // Adapt from Annex-B to Avcc nals re-using the NALu index from the size calculation.
+            // NOTE: The conversion is not 'in-place'
+            CHK(!inPlace, STATUS_MKV_IN_PLACE_ANNEXB_ADAPTATION);
+            CHK_STATUS(adaptIndexedFrameNalsFromAnnexBToAvcc(pFrame->frameData, pFrame->size, &pStreamMkvGenerator->nalIndex,
+                                                             pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, &adaptedFrameSize));
+    }
+
+    CHK_STATUS(mkvgenFixupSimpleBlockHeader(pBuffer, timestamp, pFrame, adaptedFrameSize, pStreamMkvGenerator));
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * EBML encodes a simple block with the frames laced into it
+ */
+STATUS mkvgenEbmlEncodeLacedSimpleBlock(PBYTE pBuffer, UINT32 bufferSize, INT16 timestamp, PFrame pFrames, UINT32 frameCount, UINT32 payloadSize,
+                                        PStreamMkvGenerator pStreamMkvGenerator, PUINT32 pEncodedLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 size, encodedLen, i;
+    BYTE lacing;
+    PBYTE pCurrentPnt;
+
+    CHK(pEncodedLen != NULL && pFrames != NULL, STATUS_NULL_ARG);
+
+    // Set the size first
+    size = MKV_SIMPLE_BLOCK_BITS_SIZE + payloadSize;
+    *pEncodedLen = size;
+
+    // Quick return if we just need to calculate the size
+    CHK(pBuffer != NULL, retStatus);
+
+    // Check the buffer size
+    CHK(bufferSize >= size, STATUS_NOT_ENOUGH_MEMORY);
+
+    // Copy the header followed by the lace sizes and the frame data
+    MEMCPY(pBuffer, MKV_SIMPLE_BLOCK_BITS, MKV_SIMPLE_BLOCK_BITS_SIZE);
+    pCurrentPnt = pBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE;
+
+    CHK_STATUS(mkvgenEncodeLaceHeader(pFrames, frameCount, pCurrentPnt, payloadSize, &encodedLen, &lacing));
+    pCurrentPnt += encodedLen;
+
+    for (i = 0; i < frameCount; i++) {
+        MEMCPY(pCurrentPnt, pFrames[i].frameData, pFrames[i].size);
+        pCurrentPnt += pFrames[i].size;
     }
 
+    CHK(pCurrentPnt - pBuffer == size, STATUS_INTERNAL_ERROR);
+
+    // The block is flagged by the first frame
+    CHK_STATUS(mkvgenFixupSimpleBlockHeader(pBuffer, timestamp, pFrames, payloadSize, pStreamMkvGenerator));
+    *(pBuffer + MKV_SIMPLE_BLOCK_FLAGS_OFFSET) |= lacing;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Fixes up the size, the timecode, the track number and the flags of the simple block
+ */
+STATUS mkvgenFixupSimpleBlockHeader(PBYTE pBuffer, INT16 timestamp, PFrame pFrame, UINT32 payloadSize, PStreamMkvGenerator pStreamMkvGenerator)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 encodedLength;
+    BYTE flags;
+    UINT32 trackIndex;
+
     // Encode and fix-up the size - encode 8 bytes
-    encodedLength = 0x100000000000000ULL | (UINT64) (adaptedFrameSize + MKV_SIMPLE_BLOCK_PAYLOAD_HEADER_SIZE);
+    encodedLength = 0x100000000000000ULL | (UINT64) (payloadSize + MKV_SIMPLE_BLOCK_PAYLOAD_HEADER_SIZE);
     PUT_UNALIGNED_BIG_ENDIAN((PINT64) (pBuffer + MKV_SIMPLE_BLOCK_SIZE_OFFSET), encodedLength);
 
     // Fix up the timecode
     PUT_UNALIGNED_BIG_ENDIAN((PINT16) (pBuffer + MKV_SIMPLE_BLOCK_TIMECODE_OFFSET), timestamp);
 
     // track must exist because we already checked in putKinesisVideoFrame
-    CHK_STATUS(mkvgenGetTrackInfo(pStreamMkvGenerator->trackInfoList, pStreamMkvGenerator->trackInfoCount, pFrame->trackId, NULL, &trackIndex));
+    CHK_STATUS(mkvgenGetTrackInfoFromMap(&pStreamMkvGenerator->trackIndexMap, pStreamMkvGenerator->trackInfoList,
+                                         pStreamMkvGenerator->trackInfoCount, pFrame->trackId, NULL, &trackIndex));
 
     // fix up track number for each block
     *(pBuffer + MKV_SIMPLE_BLOCK_TRACK_NUMBER_OFFSET) = (UINT8) (0x80 | (UINT8) (trackIndex + 1));
@@ -1579,7 +1881,7 @@ CleanUp:
     return retStatus;
 }
 
-STATUS getAdaptedFrameSize(PFrame pFrame, MKV_NALS_ADAPTATION nalsAdaptation, PUINT32 pAdaptedFrameSize)
+STATUS getAdaptedFrameSize(PFrame pFrame, MKV_NALS_ADAPTATION nalsAdaptation, PNalIndex pNalIndex, PUINT32 pAdaptedFrameSize)
 {
     STATUS retStatus = STATUS_SUCCESS;
     UINT32 adaptedFrameSize = 0;
@@ -1595,8 +1897,17 @@ STATUS getAdaptedFrameSize(PFrame pFrame, MKV_NALS_ADAPTATION nalsAdaptation, PU
             adaptedFrameSize = pFrame->size;
             break;
         case MKV_NALS_ADAPT_ANNEXB:
-            // Get the size after conversion
-            CHK_STATUS(adaptFrameNalsFromAnnexBToAvcc(pFrame->frameData, pFrame->size, FALSE, NULL, &adaptedFrameSize));
+            // Get the size after conversion indexing the NALus if the index is not built for the frame yet
+            if (pNalIndex == NULL) {
+                CHK_STATUS(adaptFrameNalsFromAnnexBToAvcc(pFrame->frameData, pFrame->size, FALSE, NULL, &adaptedFrameSize));
+            } else {
+                if (pNalIndex->pFrameData != pFrame->frameData || pNalIndex->frameDataSize != pFrame->size) {
+                    CHK_STATUS(indexFrameNalsFromAnnexB(pFrame->frameData, pFrame->size, pNalIndex));
+                }
+
+                adaptedFrameSize = pNalIndex->adaptedSize;
+            }
+
             break;
     }
 
@@ -1654,6 +1965,12 @@ UINT32 mkvgenGetMkvTrackHeaderSize(PTrackInfo trackInfoList, UINT32 trackInfoCou
 UINT32 mkvgenGetMkvSegmentTrackHeaderSize(PStreamMkvGenerator pStreamMkvGenerator)
 {
     UINT32 segmentInfoLen;
+
+    // Use the sizes of the encoded header bits if possible
+    if (STATUS_SUCCEEDED(mkvgenEncodeHeaderBits(pStreamMkvGenerator))) {
+        return pStreamMkvGenerator->segmentInfoBitsSize + pStreamMkvGenerator->trackInfoBitsSize;
+    }
+
     mkvgenEbmlEncodeSegmentInfo(pStreamMkvGenerator, NULL, 0, &segmentInfoLen);
     return segmentInfoLen + mkvgenGetMkvTrackHeaderSize(pStreamMkvGenerator->trackInfoList, pStreamMkvGenerator->trackInfoCount);
 }
@@ -2006,6 +2323,88 @@ CleanUp:
     return retStatus;
 }
 
+STATUS mkvgenBuildTrackIndexMap(PTrackInfo pTrackInfos, UINT32 trackInfoCount, PTrackIndexMap pTrackIndexMap)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, slot;
+
+    CHK(pTrackIndexMap != NULL && (pTrackInfos != NULL || trackInfoCount == 0), STATUS_NULL_ARG);
+
+    MEMSET(pTrackIndexMap, 0x00, SIZEOF(TrackIndexMap));
+
+    // Too many tracks for the map - the lookups will search the array
+    CHK(trackInfoCount <= MKV_TRACK_INDEX_MAP_SLOT_COUNT / 2, retStatus);
+
+    for (i = 0; i < trackInfoCount; i++) {
+        // Linear probing from the hashed slot. The first track wins on duplicate ids same as with the search.
+        slot = MKV_TRACK_INDEX_MAP_SLOT(pTrackInfos[i].trackId);
+        while (pTrackIndexMap->trackIndexes[slot] != 0 && pTrackIndexMap->trackIds[slot] != pTrackInfos[i].trackId) {
+            slot = (slot + 1) & (MKV_TRACK_INDEX_MAP_SLOT_COUNT - 1);
+        }
+
+        if (pTrackIndexMap->trackIndexes[slot] == 0) {
+            pTrackIndexMap->trackIds[slot] = pTrackInfos[i].trackId;
+            pTrackIndexMap->trackIndexes[slot] = (UINT8) (i + 1);
+        }
+    }
+
+    pTrackIndexMap->built = TRUE;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS mkvgenGetTrackInfoFromMap(PTrackIndexMap pTrackIndexMap, PTrackInfo pTrackInfos, UINT32 trackInfoCount, UINT64 trackId,
+                                 PTrackInfo* ppTrackInfo, PUINT32 pIndex)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 slot, index = 0;
+
+    CHK(pTrackIndexMap != NULL, STATUS_NULL_ARG);
+
+    if (!pTrackIndexMap->built) {
+        CHK_STATUS(mkvgenGetTrackInfo(pTrackInfos, trackInfoCount, trackId, ppTrackInfo, pIndex));
+        CHK(FALSE, retStatus);
+    }
+
+    // Probe until the track or an empty slot is found. The map is never full.
+    slot = MKV_TRACK_INDEX_MAP_SLOT(trackId);
+    while (pTrackIndexMap->trackIndexes[slot] != 0 && pTrackIndexMap->trackIds[slot] != trackId) {
+        slot = (slot + 1) & (MKV_TRACK_INDEX_MAP_SLOT_COUNT - 1);
+    }
+
+    // The index is stored with 1 added
+    index = pTrackIndexMap->trackIndexes[slot];
+    CHK(index != 0, STATUS_MKV_TRACK_INFO_NOT_FOUND);
+    index--;
+
+    if (ppTrackInfo != NULL) {
+        *ppTrackInfo = &pTrackInfos[index];
+    }
+
+    if (pIndex != NULL) {
+        *pIndex = index;
+    }
+
+CleanUp:
+
+    if (retStatus == STATUS_MKV_TRACK_INFO_NOT_FOUND && pTrackIndexMap != NULL && pTrackIndexMap->built) {
+        // Same as the search returns when the track is not found
+        if (ppTrackInfo != NULL) {
+            *ppTrackInfo = NULL;
+        }
+
+        if (pIndex != NULL) {
+            *pIndex = trackInfoCount;
+        }
+    }
+
+    return retStatus;
+}
+
 STATUS mkvgenExtractCpdFromAnnexBFrame(PStreamMkvGenerator pStreamMkvGenerator, PFrame pFrame, PTrackInfo pTrackInfo)
 {
     ENTERS();
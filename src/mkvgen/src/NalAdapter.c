@@ -152,6 +152,133 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Indexes the Annex-B NALUs in the frame data.
+ *
+ * NOTE: The validation and the resulting size match the adaptation without EPB removal.
+ */
+STATUS indexFrameNalsFromAnnexB(PBYTE pFrameData, UINT32 frameDataSize, PNalIndex pNalIndex)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, zeroCount = 0, runStart = 0, runEnd, skipSize, adaptedSize = 0;
+    BOOL runStarted = FALSE;
+    PBYTE pCurPnt = pFrameData;
+    FindAnnexBZeroPairFunc findFn = getFindAnnexBZeroPairFn();
+
+    CHK(pFrameData != NULL && pNalIndex != NULL, STATUS_NULL_ARG);
+
+    // Invalidate the index until the frame data has been fully scanned
+    pNalIndex->pFrameData = NULL;
+    pNalIndex->leadingSize = 0;
+    pNalIndex->runCount = 0;
+    pNalIndex->overflow = FALSE;
+
+    for (i = 0; i < frameDataSize; i++, pCurPnt++) {
+        if (zeroCount == 0) {
+            // Only a run of zeros can start a start code so skip straight to the next zero pair
+            skipSize = findFn(pCurPnt, frameDataSize - i);
+            i += skipSize;
+            pCurPnt += skipSize;
+            if (i == frameDataSize) {
+                break;
+            }
+        }
+
+        if (*pCurPnt == 0x00) {
+            zeroCount++;
+        } else if (zeroCount > MAX_ANNEX_B_ZERO_COUNT) {
+            // Same validation as the adaptation
+            CHK(FALSE, STATUS_MKV_INVALID_ANNEXB_NALU_IN_FRAME_DATA);
+        } else if (*pCurPnt == 0x01 && zeroCount >= 2) {
+            // Found the Annex-B start code - the zeros belong to it and close the previous run
+            runEnd = i - zeroCount;
+            if (!runStarted) {
+                pNalIndex->leadingSize = runEnd;
+                adaptedSize += runEnd;
+                runStarted = TRUE;
+            } else {
+                if (pNalIndex->runCount < MAX_NAL_INDEX_RUN_COUNT) {
+                    pNalIndex->runs[pNalIndex->runCount].offset = runStart;
+                    pNalIndex->runs[pNalIndex->runCount].size = runEnd - runStart;
+                    pNalIndex->runCount++;
+                } else {
+                    pNalIndex->overflow = TRUE;
+                }
+
+                adaptedSize += SIZEOF(UINT32) + runEnd - runStart;
+            }
+
+            runStart = i + 1;
+            zeroCount = 0;
+        } else {
+            zeroCount = 0;
+        }
+    }
+
+    // Close the last run which includes any trailing zeros
+    if (!runStarted) {
+        pNalIndex->leadingSize = frameDataSize;
+        adaptedSize += frameDataSize;
+    } else {
+        if (pNalIndex->runCount < MAX_NAL_INDEX_RUN_COUNT) {
+            pNalIndex->runs[pNalIndex->runCount].offset = runStart;
+            pNalIndex->runs[pNalIndex->runCount].size = frameDataSize - runStart;
+            pNalIndex->runCount++;
+        } else {
+            pNalIndex->overflow = TRUE;
+        }
+
+        adaptedSize += SIZEOF(UINT32) + frameDataSize - runStart;
+    }
+
+    pNalIndex->adaptedSize = adaptedSize;
+    pNalIndex->frameDataSize = frameDataSize;
+    pNalIndex->pFrameData = pFrameData;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * NALU adaptation from Annex-B to AVCC format using the NALU index
+ */
+STATUS adaptIndexedFrameNalsFromAnnexBToAvcc(PBYTE pFrameData, UINT32 frameDataSize, PNalIndex pNalIndex, PBYTE pAdaptedFrameData,
+                                             PUINT32 pAdaptedFrameDataSize)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i;
+    PBYTE pAdaptedCurPnt = pAdaptedFrameData;
+    PNalRun pRun;
+
+    CHK(pFrameData != NULL && pNalIndex != NULL && pAdaptedFrameData != NULL && pAdaptedFrameDataSize != NULL, STATUS_NULL_ARG);
+
+    // Re-scan if the index is not for this frame data or it couldn't hold all the runs
+    if (pNalIndex->pFrameData != pFrameData || pNalIndex->frameDataSize != frameDataSize || pNalIndex->overflow) {
+        CHK_STATUS(adaptFrameNalsFromAnnexBToAvcc(pFrameData, frameDataSize, FALSE, pAdaptedFrameData, pAdaptedFrameDataSize));
+        CHK(FALSE, retStatus);
+    }
+
+    // Copy any data preceding the first start code as is
+    MEMCPY(pAdaptedCurPnt, pFrameData, pNalIndex->leadingSize);
+    pAdaptedCurPnt += pNalIndex->leadingSize;
+
+    // Replace the start codes with the Big-Endian run sizes and bulk copy the runs
+    for (i = 0, pRun = pNalIndex->runs; i < pNalIndex->runCount; i++, pRun++) {
+        PUT_UNALIGNED_BIG_ENDIAN((PINT32) pAdaptedCurPnt, pRun->size);
+        pAdaptedCurPnt += SIZEOF(UINT32);
+
+        MEMCPY(pAdaptedCurPnt, pFrameData + pRun->offset, pRun->size);
+        pAdaptedCurPnt += pRun->size;
+    }
+
+    *pAdaptedFrameDataSize = (UINT32) (pAdaptedCurPnt - pAdaptedFrameData);
+
+CleanUp:
+
+    return retStatus;
+}
+
 /**
  * NALU adaptation from AVCC to Annex-B format
  *
@@ -148,6 +148,75 @@ typedef enum {
 } MKV_NALS_ADAPTATION,
     *PMKV_NALS_ADAPTATION;
 
+/**
+ * Vectorized Annex-B scanners available for the target. AVX2 is compiled in with GCC/Clang and selected at runtime.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define NAL_SCANNER_SSE2
+#define NAL_SCANNER_AVX2
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define NAL_SCANNER_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define NAL_SCANNER_NEON
+#endif
+
+/**
+ * Finds the first two consecutive zero bytes which prefix both the Annex-B start codes and the emulation prevention sequences.
+ *
+ * @PBYTE - Data to scan
+ * @UINT32 - Size of the data
+ *
+ * @return - Offset of the first zero pair or the size of the data if none found
+ */
+typedef UINT32 (*FindAnnexBZeroPairFunc)(PBYTE, UINT32);
+
+/**
+ * Scanner selected for the CPU on the first use. Holds the FindAnnexBZeroPairFunc accessed atomically. 0 until selected.
+ */
+extern volatile SIZE_T gFindAnnexBZeroPairFn;
+
+/**
+ * Max number of the NALu runs recorded in the NALu index. Frames with more NALus fall back to the non-indexed adaptation
+ */
+#define MAX_NAL_INDEX_RUN_COUNT 64
+
+/**
+ * A run of the NALu payload bytes in the Annex-B frame data
+ */
+typedef struct {
+    // Offset of the run from the beginning of the frame data
+    UINT32 offset;
+
+    // Size of the run excluding the start code
+    UINT32 size;
+} NalRun, *PNalRun;
+
+/**
+ * Index of the Annex-B NALus in a frame used to adapt the frame to AVCC without re-scanning the frame data
+ */
+typedef struct {
+    // Frame data the index has been built for or NULL if the index is not valid
+    PBYTE pFrameData;
+
+    // Frame data size the index has been built for
+    UINT32 frameDataSize;
+
+    // Size of the frame data after adaptation
+    UINT32 adaptedSize;
+
+    // Size of the data preceding the first start code
+    UINT32 leadingSize;
+
+    // Number of the runs following the start codes in the frame data
+    UINT32 runCount;
+
+    // Whether the frame has more runs than the index can hold
+    BOOL overflow;
+
+    // The runs following the start codes
+    NalRun runs[MAX_NAL_INDEX_RUN_COUNT];
+} NalIndex, *PNalIndex;
+
 ////////////////////////////////////////////////////
 // Internal functionality
 ////////////////////////////////////////////////////
@@ -164,6 +233,54 @@ typedef enum {
  */
 STATUS adaptFrameNalsFromAnnexBToAvcc(PBYTE, UINT32, BOOL, PBYTE, PUINT32);
 
+/**
+ * Scans the frame data Annex-B NALUs and records the runs and the adapted size in the index
+ *
+ * @PBYTE - Frame data buffer
+ * @UINT32 - Frame data buffer size
+ * @PNalIndex - OUT - NALu index to build
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS indexFrameNalsFromAnnexB(PBYTE, UINT32, PNalIndex);
+
+/**
+ * Adapts the frame data Annex-B NALUs to AVCC copying the indexed runs.
+ *
+ * NOTE: Falls back to the non-indexed adaptation if the index has not been built for the frame data.
+ *
+ * @PBYTE - Frame data buffer
+ * @UINT32 - Frame data buffer size
+ * @PNalIndex - NALu index of the frame data
+ * @PBYTE - OUT - Adapted frame data buffer
+ * @PUINT32 - OUT - Adapted frame data size
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS adaptIndexedFrameNalsFromAnnexBToAvcc(PBYTE, UINT32, PNalIndex, PBYTE, PUINT32);
+
+/**
+ * Annex-B zero pair scanners. The scalar version is the reference for the vectorized ones.
+ */
+UINT32 findAnnexBZeroPairScalar(PBYTE, UINT32);
+UINT32 findAnnexBZeroPairDispatch(PBYTE, UINT32);
+
+/**
+ * Returns the scanner selected for the CPU selecting it on the first call
+ *
+ * @return - The widest scanner supported by the CPU
+ */
+FindAnnexBZeroPairFunc getFindAnnexBZeroPairFn(VOID);
+#if defined(NAL_SCANNER_SSE2)
+UINT32 findAnnexBZeroPairSse2(PBYTE, UINT32);
+#endif
+#if defined(NAL_SCANNER_AVX2)
+UINT32 findAnnexBZeroPairAvx2(PBYTE, UINT32);
+#endif
+#if defined(NAL_SCANNER_NEON)
+UINT32 findAnnexBZeroPairNeon(PBYTE, UINT32);
+#endif
+
 /**
  * Adapts the CPD Annex-B NALUs to AVCC for H264
  *
@@ -207,11 +324,12 @@ STATUS adaptFrameNalsFromAvccToAnnexB(PBYTE, UINT32);
  *
  * @PFrame - IN - Frame to get the packaged size for
  * @MKV_NALS_ADAPTATION - the nals adaptation mode
+ * @PNalIndex - IN/OUT - OPTIONAL - NALu index to re-use or build for the Annex-B frame
  * @PUINT32 - Packaged size of the frame
  *
  * @return - STATUS code of the execution
  */
-STATUS getAdaptedFrameSize(PFrame, MKV_NALS_ADAPTATION, PUINT32);
+STATUS getAdaptedFrameSize(PFrame, MKV_NALS_ADAPTATION, PNalIndex, PUINT32);
 
 /**
  * @PBYTE - CPD buffer
@@ -0,0 +1,162 @@
+/**
+ * Vectorized scanning for the Annex-B start code and emulation prevention candidates
+ */
+
+#define LOG_CLASS "NalScanner"
+
+#include "Include_i.h"
+
+#if defined(NAL_SCANNER_SSE2) || defined(NAL_SCANNER_AVX2)
+#if defined _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(NAL_SCANNER_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Scanner selected on the first use
+ */
+volatile SIZE_T gFindAnnexBZeroPairFn = 0;
+
+#if defined(NAL_SCANNER_SSE2) || defined(NAL_SCANNER_AVX2)
+/**
+ * Index of the lowest set bit of a non-zero mask
+ */
+static INLINE UINT32 lowestSetBitIndex(UINT32 mask)
+{
+#if defined _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (UINT32) index;
+#else
+    return (UINT32) __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/**
+ * Reference scanner looking at a byte at a time
+ */
+UINT32 findAnnexBZeroPairScalar(PBYTE pData, UINT32 size)
+{
+    UINT32 i;
+
+    for (i = 0; i + 1 < size; i++) {
+        if (pData[i + 1] != 0x00) {
+            // Neither this nor the next position can start a pair
+            i++;
+        } else if (pData[i] == 0x00) {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+#if defined(NAL_SCANNER_SSE2)
+/**
+ * Compares 16 positions at a time by matching the data against itself shifted by a byte
+ */
+UINT32 findAnnexBZeroPairSse2(PBYTE pData, UINT32 size)
+{
+    UINT32 i, mask;
+    __m128i zero = _mm_setzero_si128(), cur, next;
+
+    for (i = 0; i + 17 <= size; i += 16) {
+        cur = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pData + i)), zero);
+        next = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pData + i + 1)), zero);
+        mask = (UINT32) _mm_movemask_epi8(_mm_and_si128(cur, next));
+        if (mask != 0) {
+            return i + lowestSetBitIndex(mask);
+        }
+    }
+
+    return i + findAnnexBZeroPairScalar(pData + i, size - i);
+}
+#endif
+
+#if defined(NAL_SCANNER_AVX2)
+/**
+ * Compares 32 positions at a time. Compiled for AVX2 and selected only when the CPU supports it
+ */
+__attribute__((target("avx2"))) UINT32 findAnnexBZeroPairAvx2(PBYTE pData, UINT32 size)
+{
+    UINT32 i, mask;
+    __m256i zero = _mm256_setzero_si256(), cur, next;
+
+    for (i = 0; i + 33 <= size; i += 32) {
+        cur = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (pData + i)), zero);
+        next = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (pData + i + 1)), zero);
+        mask = (UINT32) _mm256_movemask_epi8(_mm256_and_si256(cur, next));
+        if (mask != 0) {
+            return i + lowestSetBitIndex(mask);
+        }
+    }
+
+    return i + findAnnexBZeroPairScalar(pData + i, size - i);
+}
+#endif
+
+#if defined(NAL_SCANNER_NEON)
+/**
+ * Compares 16 positions at a time and locates the pair within the matching block with the reference scanner
+ */
+UINT32 findAnnexBZeroPairNeon(PBYTE pData, UINT32 size)
+{
+    UINT32 i;
+    uint8x16_t match;
+
+    for (i = 0; i + 17 <= size; i += 16) {
+        match = vandq_u8(vceqzq_u8(vld1q_u8(pData + i)), vceqzq_u8(vld1q_u8(pData + i + 1)));
+        if (vmaxvq_u8(match) != 0) {
+            return i + findAnnexBZeroPairScalar(pData + i, 17);
+        }
+    }
+
+    return i + findAnnexBZeroPairScalar(pData + i, size - i);
+}
+#endif
+
+/**
+ * Scans with the widest scanner supported by the CPU
+ */
+UINT32 findAnnexBZeroPairDispatch(PBYTE pData, UINT32 size)
+{
+    return getFindAnnexBZeroPairFn()(pData, size);
+}
+
+FindAnnexBZeroPairFunc getFindAnnexBZeroPairFn(VOID)
+{
+    FindAnnexBZeroPairFunc findFn = (FindAnnexBZeroPairFunc) ATOMIC_LOAD(&gFindAnnexBZeroPairFn);
+
+    if (findFn != NULL) {
+        return findFn;
+    }
+
+    findFn = findAnnexBZeroPairScalar;
+
+#if defined(NAL_SCANNER_SSE2)
+    findFn = findAnnexBZeroPairSse2;
+#endif
+
+#if defined(NAL_SCANNER_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        findFn = findAnnexBZeroPairAvx2;
+    }
+#endif
+
+#if defined(NAL_SCANNER_NEON)
+    findFn = findAnnexBZeroPairNeon;
+#endif
+
+    // Racing threads would store the same value
+    ATOMIC_STORE(&gFindAnnexBZeroPairFn, (SIZE_T) findFn);
+
+    return findFn;
+}
@@ -63,6 +63,7 @@ extern "C" {
 #define ITEM_FLAG_FRAGMENT_END       (0x1 << 4)
 #define ITEM_FLAG_PERSISTED_ACK      (0x1 << 5)
 #define ITEM_FLAG_SKIP_ITEM          (0x1 << 6)
+#define ITEM_FLAG_FRAGMENT_EXTENT    (0x1 << 7)
 #define ITEM_FLAG_STREAM_START_DEBUG (0x1 << 15)
 
 /**
@@ -75,6 +76,7 @@ extern "C" {
 #define CHECK_ITEM_FRAGMENT_END(f)       (((f) &ITEM_FLAG_FRAGMENT_END) != ITEM_FLAG_NONE)
 #define CHECK_ITEM_PERSISTED_ACK(f)      (((f) &ITEM_FLAG_PERSISTED_ACK) != ITEM_FLAG_NONE)
 #define CHECK_ITEM_SKIP_ITEM(f)          (((f) &ITEM_FLAG_SKIP_ITEM) != ITEM_FLAG_NONE)
+#define CHECK_ITEM_FRAGMENT_EXTENT(f)    (((f) &ITEM_FLAG_FRAGMENT_EXTENT) != ITEM_FLAG_NONE)
 #define CHECK_ITEM_STREAM_START_DEBUG(f) (((f) &ITEM_FLAG_STREAM_START_DEBUG) != ITEM_FLAG_NONE)
 
 #define SET_ITEM_FRAGMENT_START(f)     ((f) |= ITEM_FLAG_FRAGMENT_START)
@@ -84,6 +86,7 @@ extern "C" {
 #define SET_ITEM_FRAGMENT_END(f)       ((f) |= ITEM_FLAG_FRAGMENT_END)
 #define SET_ITEM_PERSISTED_ACK(f)      ((f) |= ITEM_FLAG_PERSISTED_ACK)
 #define SET_ITEM_SKIP_ITEM(f)          ((f) |= ITEM_FLAG_SKIP_ITEM)
+#define SET_ITEM_FRAGMENT_EXTENT(f)    ((f) |= ITEM_FLAG_FRAGMENT_EXTENT)
 #define SET_ITEM_STREAM_START_DEBUG(f) ((f) |= ITEM_FLAG_STREAM_START_DEBUG)
 
 #define CLEAR_ITEM_FRAGMENT_START(f)     ((f) &= ~ITEM_FLAG_FRAGMENT_START)
@@ -93,6 +96,7 @@ extern "C" {
 #define CLEAR_ITEM_FRAGMENT_END(f)       ((f) &= ~ITEM_FLAG_FRAGMENT_END)
 #define CLEAR_ITEM_PERSISTED_ACK(f)      ((f) &= ~ITEM_FLAG_PERSISTED_ACK)
 #define CLEAR_ITEM_SKIP_ITEM(f)          ((f) &= ~ITEM_FLAG_SKIP_ITEM)
+#define CLEAR_ITEM_FRAGMENT_EXTENT(f)    ((f) &= ~ITEM_FLAG_FRAGMENT_EXTENT)
 #define CLEAR_ITEM_STREAM_START_DEBUG(f) ((f) &= ~ITEM_FLAG_STREAM_START_DEBUG)
 
 #define GET_ITEM_DATA_OFFSET(f)    ((UINT16) ((f) >> 16))
@@ -232,6 +236,16 @@ PUBLIC_API STATUS contentViewTimestampInRange(PContentView, UINT64, BOOL, PBOOL)
  */
 PUBLIC_API STATUS contentViewGetNext(PContentView, PViewItem*);
 
+/**
+ * Gets the next fragment start or fragment end item from the current index skipping the errored items
+ * and advances the index past it. The index is advanced to the head if there is no such item.
+ *
+ * PContentView - Content view
+ * PViewItem* - The boundary item pointer
+ *
+ */
+PUBLIC_API STATUS contentViewGetNextBoundary(PContentView, PViewItem*);
+
 /**
  * Gets an item from the given index. Current remains untouched.
  *
@@ -363,6 +377,16 @@ PUBLIC_API STATUS contentViewGetWindowItemCount(PContentView, PUINT64, PUINT64);
  */
 PUBLIC_API STATUS contentViewGetWindowAllocationSize(PContentView, PUINT64, PUINT64);
 
+/**
+ * Sets the data length of an existing item keeping the window allocation sizes consistent
+ *
+ * PContentView - Content view
+ * UINT64 - the index of the item
+ * UINT32 - new size of the data in bytes
+ *
+ */
+PUBLIC_API STATUS contentViewSetItemLength(PContentView, UINT64, UINT32);
+
 /**
  * Trims the tail till the given item. The remove callbacks will be fired and the current shifted if needed.
  *
@@ -17,7 +17,6 @@ STATUS createContentView(UINT32 maxItemCount, UINT64 bufferDuration, ContentView
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PRollingContentView pContentView = NULL;
-    UINT32 allocationSize;
 
     // Check the input params
     CHK(ppContentView != NULL, STATUS_NULL_ARG);
@@ -26,23 +25,20 @@ STATUS createContentView(UINT32 maxItemCount, UINT64 bufferDuration, ContentView
 
     // Allocate the main struct
     // NOTE: The calloc will Zero the fields
-    // NOTE: The actual rolling buffer follows the structure
-    allocationSize = SIZEOF(RollingContentView) + SIZEOF(ViewItem) * maxItemCount;
-    pContentView = (PRollingContentView) MEMCALLOC(1, allocationSize);
+    pContentView = (PRollingContentView) MEMCALLOC(1, SIZEOF(RollingContentView));
     CHK(pContentView != NULL, STATUS_NOT_ENOUGH_MEMORY);
 
-    // Set the pointer
-    pContentView->itemBuffer = (PViewItem) (pContentView + 1);
-
     // Set the values
     pContentView->contentView.version = CONTENT_VIEW_CURRENT_VERSION;
-    pContentView->allocationSize = allocationSize;
     pContentView->customData = customData;
     pContentView->removeCallbackFunc = removeCallbackFunc;
-    pContentView->itemBufferCount = maxItemCount;
+    pContentView->maxItemCount = maxItemCount;
     pContentView->bufferDuration = bufferDuration;
     pContentView->bufferOverflowStrategy = overflowStrategy;
 
+    // Start small and grow the buffer with the actual number of the items in the window
+    CHK_STATUS(resizeContentView(pContentView, MIN(maxItemCount, CONTENT_VIEW_INITIAL_ITEM_COUNT)));
+
     // Assign the created object
     *ppContentView = (PContentView) pContentView;
 
@@ -70,7 +66,8 @@ STATUS freeContentView(PContentView pContentView)
     // Purge the content view if we have any items
     contentViewRemoveAll(pContentView);
 
-    // Release the object
+    // Release the buffer and the object
+    SAFE_MEMFREE(((PRollingContentView) pContentView)->itemBuffer);
     MEMFREE(pContentView);
 
 CleanUp:
@@ -159,6 +156,7 @@ STATUS contentViewGetNext(PContentView pContentView, PViewItem* ppItem)
         // reset the index, and return error
         DLOGI("Current index overflow state discovered! Resetting");
         pRollingView->current = pRollingView->tail;
+        pRollingView->currentAllocationSize = pRollingView->windowAllocationSize;
         CHK(FALSE, STATUS_CONTENT_VIEW_INVALID_INDEX);
     }
 
@@ -167,6 +165,7 @@ STATUS contentViewGetNext(PContentView pContentView, PViewItem* ppItem)
 
     // Increment the current
     pRollingView->current++;
+    pRollingView->currentAllocationSize -= pCurrent->length;
 
     *ppItem = pCurrent;
 
@@ -176,6 +175,46 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Gets the next fragment boundary item from the current and advances the index past it
+ */
+STATUS contentViewGetNextBoundary(PContentView pContentView, PViewItem* ppItem)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRollingContentView pRollingView = (PRollingContentView) pContentView;
+    PViewItem pBoundary = NULL;
+    UINT64 position, prevIndex = 0;
+
+    // Check the input params
+    CHK(pContentView != NULL && ppItem != NULL, STATUS_NULL_ARG);
+
+    // Quick check if any items exist - early return
+    CHK((pRollingView->head != pRollingView->tail) && (pRollingView->current < pRollingView->head), STATUS_CONTENT_VIEW_NO_MORE_ITEMS);
+
+    // Skip over the errored boundary items
+    prevIndex = pRollingView->current;
+    for (position = findViewBoundaryPosition(pRollingView, prevIndex); position < pRollingView->boundaryCount && pBoundary == NULL; position++) {
+        pBoundary = GET_VIEW_ITEM_FROM_INDEX(pRollingView, GET_VIEW_BOUNDARY_INDEX(pRollingView, position));
+        if (CHECK_ITEM_SKIP_ITEM(pBoundary->flags)) {
+            pBoundary = NULL;
+        }
+    }
+
+    // The items are consumed till the boundary or the head if there is none
+    pRollingView->current = (pBoundary == NULL) ? pRollingView->head : pBoundary->index + 1;
+    updateCurrentAllocationSize(pRollingView, prevIndex);
+
+    CHK(pBoundary != NULL, STATUS_CONTENT_VIEW_NO_MORE_ITEMS);
+
+    *ppItem = pBoundary;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
 /**
  * Gets an item from the given index. Current remains untouched.
  */
@@ -251,12 +290,15 @@ STATUS contentViewSetCurrentIndex(PContentView pContentView, UINT64 index)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PRollingContentView pRollingView = (PRollingContentView) pContentView;
+    UINT64 curIndex;
 
     // Check the input params
     CHK(pContentView != NULL, STATUS_NULL_ARG);
     CHK(index >= pRollingView->tail && index <= pRollingView->head, STATUS_CONTENT_VIEW_INVALID_INDEX);
 
+    curIndex = pRollingView->current;
     pRollingView->current = index;
+    updateCurrentAllocationSize(pRollingView, curIndex);
 
 CleanUp:
 
@@ -273,7 +315,7 @@ STATUS contentViewRollbackCurrent(PContentView pContentView, UINT64 duration, BO
     STATUS retStatus = STATUS_SUCCESS;
     PViewItem pCurrent = NULL;
     UINT64 timestamp;
-    UINT64 curIndex, lastIndex;
+    UINT64 curIndex, lastIndex, prevIndex = 0, position;
     PRollingContentView pRollingView = (PRollingContentView) pContentView;
 
     // Check the input params
@@ -283,11 +325,18 @@ STATUS contentViewRollbackCurrent(PContentView pContentView, UINT64 duration, BO
     CHK(pRollingView->current != pRollingView->tail && duration != 0, STATUS_SUCCESS);
 
     // Get the timestamp of the current
-    curIndex = lastIndex = pRollingView->current;
+    curIndex = lastIndex = prevIndex = pRollingView->current;
     pCurrent = GET_VIEW_ITEM_FROM_INDEX(pRollingView, curIndex);
     timestamp = pCurrent->ackTimestamp;
 
-    while (TRUE) {
+    // Only the fragment starts need to be visited when rolling back to a key frame
+    position = keyFrame ? findViewBoundaryPosition(pRollingView, curIndex + 1) : 0;
+
+    while (!keyFrame || position != 0) {
+        if (keyFrame) {
+            curIndex = GET_VIEW_BOUNDARY_INDEX(pRollingView, --position);
+        }
+
         pCurrent = GET_VIEW_ITEM_FROM_INDEX(pRollingView, curIndex);
 
         // If we don't need a key frame or we need a key frame and the current is a fragment start
@@ -319,7 +368,9 @@ STATUS contentViewRollbackCurrent(PContentView pContentView, UINT64 duration, BO
         }
 
         // Iterate backwards
-        curIndex--;
+        if (!keyFrame) {
+            curIndex--;
+        }
     }
 
     // Roll forward until we have "good" frame
@@ -343,6 +394,8 @@ STATUS contentViewRollbackCurrent(PContentView pContentView, UINT64 duration, BO
         pRollingView->current = curIndex;
     }
 
+    updateCurrentAllocationSize(pRollingView, prevIndex);
+
 CleanUp:
 
     LEAVES();
@@ -363,6 +416,7 @@ STATUS contentViewResetCurrent(PContentView pContentView)
 
     // Start from the current and iterate
     pRollingView->current = pRollingView->tail;
+    pRollingView->currentAllocationSize = pRollingView->windowAllocationSize;
 
 CleanUp:
 
@@ -471,6 +525,11 @@ STATUS contentViewAddItem(PContentView pContentView, UINT64 timestamp, UINT64 ac
         }
     }
 
+    // Grow the buffer if it's full
+    if (pRollingView->head - pRollingView->tail >= pRollingView->itemBufferCount) {
+        CHK_STATUS(resizeContentView(pRollingView, MIN(pRollingView->itemBufferCount * 2, pRollingView->maxItemCount)));
+    }
+
     // Append the new item and increment the head
     pHead = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->head);
     pHead->timestamp = timestamp;
@@ -482,7 +541,15 @@ STATUS contentViewAddItem(PContentView pContentView, UINT64 timestamp, UINT64 ac
     pHead->index = pRollingView->head;
     SET_ITEM_DATA_OFFSET(pHead->flags, offset);
 
+    // Index the fragment boundaries
+    if (CHECK_ITEM_BOUNDARY(flags)) {
+        GET_VIEW_BOUNDARY_INDEX(pRollingView, pRollingView->boundaryCount) = pRollingView->head;
+        pRollingView->boundaryCount++;
+    }
+
     pRollingView->head++;
+    pRollingView->windowAllocationSize += length;
+    pRollingView->currentAllocationSize += length;
 
 CleanUp:
 
@@ -507,7 +574,7 @@ STATUS contentViewCheckAvailability(PContentView pContentView, PBOOL pWindowAvai
         pTail = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->tail);
 
         // Check for the item count and duration limits
-        if (pRollingView->head - pRollingView->tail >= pRollingView->itemBufferCount ||
+        if (pRollingView->head - pRollingView->tail >= pRollingView->maxItemCount ||
             pHead->ackTimestamp + pHead->duration - pTail->ackTimestamp >= pRollingView->bufferDuration) {
             windowAvailability = FALSE;
         }
@@ -539,6 +606,7 @@ STATUS contentViewRemoveAll(PContentView pContentView)
 
     while (pRollingView->tail != pRollingView->head) {
         pTail = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->tail);
+        removeViewItemLength(pRollingView, pTail, pRollingView->current);
 
         // Move the tail first
         pRollingView->tail++;
@@ -558,6 +626,9 @@ STATUS contentViewRemoveAll(PContentView pContentView)
         }
     }
 
+    trimViewBoundaries(pRollingView);
+    shrinkContentView(pRollingView);
+
 CleanUp:
 
     LEAVES();
@@ -578,6 +649,7 @@ STATUS contentViewTrimTail(PContentView pContentView, UINT64 itemIndex)
 
     while (pRollingView->tail != itemIndex) {
         pTail = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->tail);
+        removeViewItemLength(pRollingView, pTail, pRollingView->current);
 
         // Move the tail first
         pRollingView->tail++;
@@ -597,6 +669,9 @@ STATUS contentViewTrimTail(PContentView pContentView, UINT64 itemIndex)
         }
     }
 
+    trimViewBoundaries(pRollingView);
+    shrinkContentView(pRollingView);
+
 CleanUp:
 
     LEAVES();
@@ -610,13 +685,15 @@ STATUS contentViewTrimTailItems(PContentView pContentView)
     PRollingContentView pRollingView = (PRollingContentView) pContentView;
     PViewItem pTail = NULL, pCurrentViewItem = NULL;
     BOOL viewItemDropped = FALSE;
-    UINT64 currentStreamingItem = MAX_UINT64;
+    UINT64 currentStreamingItem = MAX_UINT64, curIndex, nextIndex, position;
     UINT32 dropFrameCount = 0;
 
     // Check the input params
     CHK(pContentView != NULL, STATUS_NULL_ARG);
 
     pTail = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->tail);
+    curIndex = pRollingView->current;
+
     // if current is greater than tail, it means the application has consumed a view item by calling contentViewGetNext
     if (pRollingView->current > pRollingView->tail) {
         currentStreamingItem = pRollingView->current - 1;
@@ -630,10 +707,13 @@ STATUS contentViewTrimTailItems(PContentView pContentView)
 
             // if tail is the currentStreamingItem, dont drop tail, drop the view item after tail.
             if (pRollingView->tail == currentStreamingItem) {
+                removeViewItemLength(pRollingView, pTail, curIndex);
                 pRollingView->tail++;
                 pTail = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->tail);
             }
 
+            removeViewItemLength(pRollingView, pTail, curIndex);
+
             // Callback if it's specified, also dont drop currently streaming item to avoid corrupting data.
             if (pRollingView->removeCallbackFunc != NULL) {
                 // NOTE: The call is prompt - shouldn't block
@@ -646,32 +726,48 @@ STATUS contentViewTrimTailItems(PContentView pContentView)
         case CONTENT_VIEW_OVERFLOW_POLICY_DROP_UNTIL_FRAGMENT_START:
 
             do {
-                // Callback if it's specified
-                if (pRollingView->removeCallbackFunc != NULL) {
-                    // also dont drop currently streaming item to avoid corrupting data.
-                    if (pRollingView->tail != currentStreamingItem) {
-                        // NOTE: The call is prompt - shouldn't block
-                        pRollingView->removeCallbackFunc(pContentView, pRollingView->customData, pTail, viewItemDropped);
-                        dropFrameCount++;
-                    } else {
-                        // we have passed the current streaming item. View items dropped beyond this point
-                        // were never sent.
-                        viewItemDropped = TRUE;
+                // Find the next fragment start after the tail or the head if there is none
+                nextIndex = pRollingView->head;
+                for (position = findViewBoundaryPosition(pRollingView, pRollingView->tail + 1); position < pRollingView->boundaryCount;
+                     position++) {
+                    if (CHECK_ITEM_FRAGMENT_START(GET_VIEW_ITEM_FROM_INDEX(pRollingView, GET_VIEW_BOUNDARY_INDEX(pRollingView, position))->flags)) {
+                        nextIndex = GET_VIEW_BOUNDARY_INDEX(pRollingView, position);
+                        break;
                     }
                 }
-                pRollingView->tail++;
-                pTail = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->tail);
+
+                while (pRollingView->tail != nextIndex) {
+                    // Callback if it's specified
+                    if (pRollingView->removeCallbackFunc != NULL) {
+                        // also dont drop currently streaming item to avoid corrupting data.
+                        if (pRollingView->tail != currentStreamingItem) {
+                            // NOTE: The call is prompt - shouldn't block
+                            pRollingView->removeCallbackFunc(pContentView, pRollingView->customData, pTail, viewItemDropped);
+                            dropFrameCount++;
+                        } else {
+                            // we have passed the current streaming item. View items dropped beyond this point
+                            // were never sent.
+                            viewItemDropped = TRUE;
+                        }
+                    }
+
+                    removeViewItemLength(pRollingView, pTail, curIndex);
+                    pRollingView->tail++;
+                    pTail = GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->tail);
+                }
 
                 // Stop looping when
                 // - pRollingView->tail == pRollingView->head which means there is no more view item
                 // - when a new fragment start is reached AND some frames have been dropped.
-            } while (pRollingView->tail != pRollingView->head && (dropFrameCount == 0 || !CHECK_ITEM_FRAGMENT_START(pTail->flags)));
+            } while (pRollingView->tail != pRollingView->head && dropFrameCount == 0);
             if (pRollingView->tail == pRollingView->head) {
                 DLOGW("ContentView is not big enough to contain a single fragment.");
             }
             break;
     }
 
+    trimViewBoundaries(pRollingView);
+
     // If tail rolled pass current, then reset current to tail.
     if (pRollingView->current <= pRollingView->tail) {
         pRollingView->current = pRollingView->tail;
@@ -690,9 +786,19 @@ STATUS contentViewTrimTailItems(PContentView pContentView)
             pTail->handle = pCurrentViewItem->handle;
             pTail->length = pCurrentViewItem->length;
             pTail->index = pRollingView->tail;
+            pRollingView->windowAllocationSize += pTail->length;
+
+            // The new tail precedes all of the indexed boundaries
+            if (CHECK_ITEM_BOUNDARY(pTail->flags)) {
+                pRollingView->boundaryStart = (pRollingView->boundaryStart + pRollingView->itemBufferCount - 1) % pRollingView->itemBufferCount;
+                pRollingView->boundaryCount++;
+                GET_VIEW_BOUNDARY_INDEX(pRollingView, 0) = pRollingView->tail;
+            }
         }
     }
 
+    shrinkContentView(pRollingView);
+
 CleanUp:
 
     LEAVES();
@@ -785,9 +891,7 @@ STATUS contentViewGetWindowAllocationSize(PContentView pContentView, PUINT64 pCu
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PRollingContentView pRollingView = (PRollingContentView) pContentView;
-    PViewItem pCurrent;
     UINT64 currentAllocationSize = 0, windowAllocationSize = 0;
-    UINT64 curIndex;
 
     // Check the input params
     CHK(pContentView != NULL && pCurrentAllocationSize != NULL, STATUS_NULL_ARG);
@@ -795,50 +899,177 @@ STATUS contentViewGetWindowAllocationSize(PContentView pContentView, PUINT64 pCu
     // Quick check if any items exist - early return
     CHK(pRollingView->head != pRollingView->tail, STATUS_SUCCESS);
 
-    // Quick check if we need to calculate the current and the current is at the head and no overall window size is specified
-    CHK(pRollingView->head != pRollingView->current || pWindowAllocationSize != NULL, STATUS_SUCCESS);
+    // The sizes are maintained as the items are added, removed and consumed
+    windowAllocationSize = pRollingView->windowAllocationSize;
+    currentAllocationSize = pRollingView->currentAllocationSize;
 
-    curIndex = pRollingView->head - 1;
-    while (TRUE) {
-        pCurrent = GET_VIEW_ITEM_FROM_INDEX(pRollingView, curIndex);
+CleanUp:
 
-        if (curIndex >= pRollingView->current && pRollingView->head != pRollingView->current) {
-            // Add to the current window size
-            currentAllocationSize += pCurrent->length;
-        }
+    // Set the values
+    if (pCurrentAllocationSize != NULL) {
+        *pCurrentAllocationSize = currentAllocationSize;
+    }
 
-        // Add to the overall window size
-        windowAllocationSize += pCurrent->length;
+    if (pWindowAllocationSize != NULL) {
+        *pWindowAllocationSize = windowAllocationSize;
+    }
 
-        // Check if we need to terminate after the current if the whole window is not specified
-        if (curIndex == pRollingView->current && pWindowAllocationSize == NULL) {
-            break;
-        }
+    LEAVES();
+    return retStatus;
+}
 
-        // Terminate the loop if we reached the tail
-        if (curIndex == pRollingView->tail) {
-            break;
-        }
+/**
+ * Sets the data length of an item
+ */
+STATUS contentViewSetItemLength(PContentView pContentView, UINT64 itemIndex, UINT32 length)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRollingContentView pRollingView = (PRollingContentView) pContentView;
+    PViewItem pViewItem;
 
-        // Iterate backwards
-        curIndex--;
+    // Check the input params
+    CHK(pContentView != NULL, STATUS_NULL_ARG);
+    CHK(length > 0, STATUS_INVALID_CONTENT_VIEW_LENGTH);
+    CHK_STATUS(contentViewGetItemAt(pContentView, itemIndex, &pViewItem));
+
+    pRollingView->windowAllocationSize = pRollingView->windowAllocationSize - pViewItem->length + length;
+    if (itemIndex >= pRollingView->current) {
+        pRollingView->currentAllocationSize = pRollingView->currentAllocationSize - pViewItem->length + length;
     }
 
+    pViewItem->length = length;
+
 CleanUp:
 
-    // Set the values
-    if (pCurrentAllocationSize != NULL) {
-        *pCurrentAllocationSize = currentAllocationSize;
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Gets the overall length of the items in the [start, end) index range
+ */
+UINT64 getViewItemsLength(PRollingContentView pRollingView, UINT64 start, UINT64 end)
+{
+    UINT64 length = 0;
+
+    for (; start < end; start++) {
+        length += GET_VIEW_ITEM_FROM_INDEX(pRollingView, start)->length;
     }
 
-    if (pWindowAllocationSize != NULL) {
-        *pWindowAllocationSize = windowAllocationSize;
+    return length;
+}
+
+/**
+ * Adjusts the current to head allocation size after the current has moved from the specified index
+ */
+VOID updateCurrentAllocationSize(PRollingContentView pRollingView, UINT64 prevIndex)
+{
+    if (pRollingView->current > prevIndex) {
+        pRollingView->currentAllocationSize -= getViewItemsLength(pRollingView, prevIndex, pRollingView->current);
+    } else {
+        pRollingView->currentAllocationSize += getViewItemsLength(pRollingView, pRollingView->current, prevIndex);
     }
+}
+
+/**
+ * Accounts for the item leaving the window given the current index before the removal
+ */
+VOID removeViewItemLength(PRollingContentView pRollingView, PViewItem pViewItem, UINT64 curIndex)
+{
+    pRollingView->windowAllocationSize -= pViewItem->length;
+    if (pViewItem->index >= curIndex) {
+        pRollingView->currentAllocationSize -= pViewItem->length;
+    }
+}
+
+/**
+ * Finds the position of the first boundary with the index not less than the specified index using binary search method.
+ * Returns the boundary count if there is none.
+ */
+UINT64 findViewBoundaryPosition(PRollingContentView pRollingView, UINT64 index)
+{
+    UINT64 low = 0, high = pRollingView->boundaryCount, mid;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (GET_VIEW_BOUNDARY_INDEX(pRollingView, mid) < index) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Drops the boundaries which have fallen off the tail
+ */
+VOID trimViewBoundaries(PRollingContentView pRollingView)
+{
+    UINT64 position = findViewBoundaryPosition(pRollingView, pRollingView->tail);
+
+    pRollingView->boundaryStart = (pRollingView->boundaryStart + position) % pRollingView->itemBufferCount;
+    pRollingView->boundaryCount -= position;
+}
+
+/**
+ * Re-allocates the item and the boundary buffers with the specified capacity preserving the indexes
+ */
+STATUS resizeContentView(PRollingContentView pRollingView, UINT64 itemBufferCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PViewItem pItemBuffer = NULL;
+    PUINT64 pBoundaryBuffer;
+    UINT64 index, position;
+
+    CHK(itemBufferCount >= pRollingView->head - pRollingView->tail && itemBufferCount != pRollingView->itemBufferCount, retStatus);
+
+    // NOTE: The boundary buffer follows the item buffer
+    pItemBuffer = (PViewItem) MEMCALLOC(1, (SIZEOF(ViewItem) + SIZEOF(UINT64)) * itemBufferCount);
+    CHK(pItemBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pBoundaryBuffer = (PUINT64) (pItemBuffer + itemBufferCount);
+
+    // Move the items to their new locations
+    for (index = pRollingView->tail; index < pRollingView->head; index++) {
+        pItemBuffer[(index == 0) ? 0 : (index % itemBufferCount)] = *GET_VIEW_ITEM_FROM_INDEX(pRollingView, index);
+    }
+
+    for (position = 0; position < pRollingView->boundaryCount; position++) {
+        pBoundaryBuffer[position] = GET_VIEW_BOUNDARY_INDEX(pRollingView, position);
+    }
+
+    SAFE_MEMFREE(pRollingView->itemBuffer);
+    pRollingView->itemBuffer = pItemBuffer;
+    pRollingView->boundaryBuffer = pBoundaryBuffer;
+    pRollingView->boundaryStart = 0;
+    pRollingView->itemBufferCount = itemBufferCount;
+    pRollingView->allocationSize = (UINT32) (SIZEOF(RollingContentView) + (SIZEOF(ViewItem) + SIZEOF(UINT64)) * itemBufferCount);
+
+CleanUp:
 
-    LEAVES();
     return retStatus;
 }
 
+/**
+ * Halves the buffer while the window occupies only a small fraction of it
+ */
+VOID shrinkContentView(PRollingContentView pRollingView)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 itemBufferCount = pRollingView->itemBufferCount;
+
+    while (itemBufferCount > CONTENT_VIEW_INITIAL_ITEM_COUNT && (pRollingView->head - pRollingView->tail) * CONTENT_VIEW_SHRINK_RATIO < itemBufferCount) {
+        itemBufferCount = MAX(itemBufferCount / 2, CONTENT_VIEW_INITIAL_ITEM_COUNT);
+    }
+
+    // Failing to shrink is not fatal as the existing buffer remains intact
+    if (itemBufferCount != pRollingView->itemBufferCount && STATUS_FAILED(retStatus = resizeContentView(pRollingView, itemBufferCount))) {
+        DLOGW("Failed to shrink the content view with 0x%08x", retStatus);
+    }
+}
+
 /**
  * Finds an element with a timestamp using binary search method.
  */
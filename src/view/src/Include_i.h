@@ -19,11 +19,31 @@ extern "C" {
 // General defines and data structures
 ////////////////////////////////////////////////////
 
+/**
+ * Initial number of the items the item buffer is allocated for. The buffer grows up to the max item count.
+ */
+#define CONTENT_VIEW_INITIAL_ITEM_COUNT 64
+
+/**
+ * The item buffer is shrunk when the number of the items in the window falls below this fraction of the capacity
+ */
+#define CONTENT_VIEW_SHRINK_RATIO 4
+
 /**
  * Gets the item pointer from the item buffer
  */
 #define GET_VIEW_ITEM_FROM_INDEX(view, index) (&(view)->itemBuffer[((index) == 0) ? 0 : ((index) % (view)->itemBufferCount)])
 
+/**
+ * Gets the item index of the boundary at the given position counting from the oldest boundary
+ */
+#define GET_VIEW_BOUNDARY_INDEX(view, position) ((view)->boundaryBuffer[((view)->boundaryStart + (position)) % (view)->itemBufferCount])
+
+/**
+ * Whether the item is a fragment boundary
+ */
+#define CHECK_ITEM_BOUNDARY(flags) (CHECK_ITEM_FRAGMENT_START(flags) || CHECK_ITEM_FRAGMENT_END(flags))
+
 /**
  * ContentView internal structure
  *
@@ -60,17 +80,38 @@ typedef struct {
     // Ensure the struct is 64 bit packed. If a UINT32 field need to be added in the future this variable can be used.
     UINT32 reserved;
 
-    // The size of the buffer
+    // The current capacity of the buffer
     UINT64 itemBufferCount;
 
-    // The actual buffer which follows immediately after the structure
+    // The max number of the items the buffer can grow to
+    UINT64 maxItemCount;
+
+    // Running totals of the item lengths in the entire window and from the current to the head
+    UINT64 windowAllocationSize;
+    UINT64 currentAllocationSize;
+
+    // The position of the oldest entry in the boundary buffer and the number of the entries
+    UINT64 boundaryStart;
+    UINT64 boundaryCount;
+
+    // The actual buffer which is re-allocated as the view grows or shrinks
     PViewItem itemBuffer;
+
+    // Ascending indexes of the fragment start and end items in the window which follows the item buffer
+    PUINT64 boundaryBuffer;
 } RollingContentView, *PRollingContentView;
 
 ////////////////////////////////////////////////////
 // Internal functionality
 ////////////////////////////////////////////////////
 PViewItem findViewItemWithTimestamp(PRollingContentView, PViewItem, PViewItem, UINT64, BOOL);
+UINT64 getViewItemsLength(PRollingContentView, UINT64, UINT64);
+VOID updateCurrentAllocationSize(PRollingContentView, UINT64);
+VOID removeViewItemLength(PRollingContentView, PViewItem, UINT64);
+UINT64 findViewBoundaryPosition(PRollingContentView, UINT64);
+VOID trimViewBoundaries(PRollingContentView);
+STATUS resizeContentView(PRollingContentView, UINT64);
+VOID shrinkContentView(PRollingContentView);
 
 #ifdef __cplusplus
 }
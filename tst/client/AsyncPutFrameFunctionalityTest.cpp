@@ -0,0 +1,592 @@
+#include "ClientTestFixture.h"
+
+#define TEST_PUT_FRAME_RING_SIZE 8
+#define TEST_PUT_FRAME_WORKER_COUNT 4
+#define TEST_PUT_FRAME_RING_BUFFER_SIZE 4096
+
+class AsyncPutFrameFunctionalityTest : public ClientTestBase {
+  public:
+    AsyncPutFrameFunctionalityTest() : mPutFrameWorkerCount(0), mPutFrameRingBufferSize(0), mFixtureMemoryUsage(0)
+    {
+    }
+
+  protected:
+    BYTE mFrameBuffer[1000];
+    Frame mFrame;
+    UINT32 mPutFrameWorkerCount;
+    UINT64 mPutFrameRingBufferSize;
+    UINT64 mFixtureMemoryUsage;
+
+    void SetUp()
+    {
+        ClientTestBase::SetUpWithoutClientCreation();
+        mFixtureMemoryUsage = gTotalClientMemoryUsage;
+        mDeviceInfo.clientInfo.putFrameRingSize = TEST_PUT_FRAME_RING_SIZE;
+        mDeviceInfo.clientInfo.putFrameRingBufferSize = mPutFrameRingBufferSize;
+        mDeviceInfo.clientInfo.putFrameWorkerCount = mPutFrameWorkerCount;
+        if (mPutFrameWorkerCount != 0) {
+            // The streams are created by the test
+            mClientSyncMode = TRUE;
+            mSubmitServiceCallResultMode = STOP_AT_PUT_STREAM;
+            ASSERT_EQ(STATUS_SUCCESS, CreateClient());
+        } else {
+            ASSERT_EQ(STATUS_SUCCESS, CreateClient());
+            ReadyStream();
+        }
+
+        mFrame.index = 0;
+        mFrame.duration = TEST_FRAME_DURATION;
+        mFrame.decodingTs = mFrame.presentationTs = 0;
+        mFrame.size = SIZEOF(mFrameBuffer);
+        mFrame.frameData = mFrameBuffer;
+        mFrame.trackId = TEST_TRACKID;
+        mFrame.flags = FRAME_FLAG_KEY_FRAME;
+    }
+
+    void TearDown()
+    {
+        UINT64 memoryUsage = 0;
+
+        // The pool threads are detached and release their thread data after the pool is freed
+        if (IS_VALID_CLIENT_HANDLE(mClientHandle)) {
+            freeKinesisVideoClient(&mClientHandle);
+        }
+
+        mStreamingSession.clearSessions();
+        for (UINT32 i = 0; i < 200; i++) {
+            MUTEX_LOCK(gClientMemMutex);
+            memoryUsage = gTotalClientMemoryUsage;
+            MUTEX_UNLOCK(gClientMemMutex);
+            if (memoryUsage <= mFixtureMemoryUsage) {
+                break;
+            }
+
+            THREAD_SLEEP(5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        }
+
+        ClientTestBase::TearDown();
+    }
+
+    STATUS putNextFrame()
+    {
+        STATUS retStatus = putKinesisVideoFrame(mStreamHandle, &mFrame);
+        if (STATUS_SUCCEEDED(retStatus)) {
+            mFrame.index++;
+            mFrame.decodingTs += mFrame.duration;
+            mFrame.presentationTs += mFrame.duration;
+            mFrame.flags = FRAME_FLAG_NONE;
+        }
+
+        return retStatus;
+    }
+
+    BOOL waitForRingDrained()
+    {
+        return waitForRingDrained(mStreamHandle);
+    }
+
+    BOOL waitForRingDrained(STREAM_HANDLE streamHandle)
+    {
+        PKinesisVideoStream pKinesisVideoStream = FROM_STREAM_HANDLE(streamHandle);
+        for (UINT32 i = 0; i < 200 && !putFrameRingIsEmpty(pKinesisVideoStream); i++) {
+            THREAD_SLEEP(5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        }
+
+        return putFrameRingIsEmpty(pKinesisVideoStream);
+    }
+
+    // The consumer lock is recursive so the test thread can still drain the ring while holding it
+    VOID lockWorker()
+    {
+        PKinesisVideoClient pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+        pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                         FROM_STREAM_HANDLE(mStreamHandle)->pPutFrameRing->consumerLock);
+    }
+
+    VOID unlockWorker()
+    {
+        PKinesisVideoClient pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+        pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData,
+                                                           FROM_STREAM_HANDLE(mStreamHandle)->pPutFrameRing->consumerLock);
+    }
+};
+
+class AsyncPutFramePoolFunctionalityTest : public AsyncPutFrameFunctionalityTest {
+  public:
+    AsyncPutFramePoolFunctionalityTest()
+    {
+        mPutFrameWorkerCount = TEST_PUT_FRAME_WORKER_COUNT;
+    }
+};
+
+class AsyncPutFrameSmallBufferFunctionalityTest : public AsyncPutFrameFunctionalityTest {
+  public:
+    AsyncPutFrameSmallBufferFunctionalityTest()
+    {
+        mPutFrameRingBufferSize = TEST_PUT_FRAME_RING_BUFFER_SIZE;
+    }
+};
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_FramesPutByWorker)
+{
+    StreamMetrics streamMetrics;
+    UINT32 i;
+
+    EXPECT_NE((PPutFrameRing) NULL, FROM_STREAM_HANDLE(mStreamHandle)->pPutFrameRing);
+
+    for (i = 0; i < TEST_PUT_FRAME_RING_SIZE / 2; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+
+    EXPECT_TRUE(waitForRingDrained());
+
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(mStreamHandle, &streamMetrics));
+    EXPECT_LT(TEST_PUT_FRAME_RING_SIZE / 2 * SIZEOF(mFrameBuffer), streamMetrics.overallViewSize);
+    EXPECT_EQ(0, streamMetrics.putFrameRingHighWaterMarks);
+    EXPECT_EQ(0, streamMetrics.putFrameRingFullRejections);
+    EXPECT_EQ(0, ATOMIC_LOAD(&mDroppedFrameReportFuncCount));
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_RingFullBackpressure)
+{
+    StreamMetrics streamMetrics;
+    UINT32 i;
+
+    // Keep the worker from draining the ring
+    lockWorker();
+
+    for (i = 0; i < TEST_PUT_FRAME_RING_SIZE; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+
+    EXPECT_EQ(STATUS_PUT_FRAME_RING_FULL, putNextFrame());
+    EXPECT_EQ(STATUS_PUT_FRAME_RING_FULL, putNextFrame());
+
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(mStreamHandle, &streamMetrics));
+    EXPECT_EQ(1, streamMetrics.putFrameRingHighWaterMarks);
+    EXPECT_EQ(2, streamMetrics.putFrameRingFullRejections);
+
+    unlockWorker();
+    EXPECT_TRUE(waitForRingDrained());
+
+    // The rejected frame is accepted after the ring is drained and the high-water mark can be hit again
+    lockWorker();
+    for (i = 0; i < TEST_PUT_FRAME_RING_SIZE * PUT_FRAME_RING_HIGH_WATER_MARK / 100; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+    unlockWorker();
+    EXPECT_TRUE(waitForRingDrained());
+
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(mStreamHandle, &streamMetrics));
+    EXPECT_EQ(2, streamMetrics.putFrameRingHighWaterMarks);
+    EXPECT_EQ(2, streamMetrics.putFrameRingFullRejections);
+    EXPECT_EQ(0, ATOMIC_LOAD(&mDroppedFrameReportFuncCount));
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_EnqueueDoesNotAllocate)
+{
+    UINT64 memoryUsage;
+    UINT32 i;
+
+    // Prime the lazily allocated state with a frame put by the worker
+    EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    EXPECT_TRUE(waitForRingDrained());
+
+    lockWorker();
+    MUTEX_LOCK(gClientMemMutex);
+    memoryUsage = gTotalClientMemoryUsage;
+    MUTEX_UNLOCK(gClientMemMutex);
+
+    for (i = 0; i < TEST_PUT_FRAME_RING_SIZE; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+
+    MUTEX_LOCK(gClientMemMutex);
+    EXPECT_EQ(memoryUsage, gTotalClientMemoryUsage);
+    MUTEX_UNLOCK(gClientMemMutex);
+
+    unlockWorker();
+    EXPECT_TRUE(waitForRingDrained());
+    EXPECT_EQ(0, ATOMIC_LOAD(&mDroppedFrameReportFuncCount));
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_ConcurrentProducerRejected)
+{
+    PPutFrameRing pPutFrameRing = FROM_STREAM_HANDLE(mStreamHandle)->pPutFrameRing;
+    StreamMetrics streamMetrics;
+
+    // Emulate another producer in the middle of the enqueue
+    ATOMIC_STORE_BOOL(&pPutFrameRing->producing, TRUE);
+    EXPECT_EQ(STATUS_PUT_FRAME_RING_CONCURRENT_PRODUCER, putNextFrame());
+    EXPECT_TRUE(putFrameRingIsEmpty(FROM_STREAM_HANDLE(mStreamHandle)));
+
+    // The role is not taken away from the other producer
+    EXPECT_TRUE(ATOMIC_LOAD_BOOL(&pPutFrameRing->producing));
+    ATOMIC_STORE_BOOL(&pPutFrameRing->producing, FALSE);
+
+    EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    EXPECT_FALSE(ATOMIC_LOAD_BOOL(&pPutFrameRing->producing));
+    EXPECT_TRUE(waitForRingDrained());
+
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(mStreamHandle, &streamMetrics));
+    EXPECT_EQ(0, streamMetrics.putFrameRingFullRejections);
+}
+
+TEST_F(AsyncPutFrameSmallBufferFunctionalityTest, asyncPutFrame_BufferFullBackpressure)
+{
+    StreamMetrics streamMetrics;
+    UINT32 i, frameCount = TEST_PUT_FRAME_RING_BUFFER_SIZE / SIZEOF(mFrameBuffer);
+
+    // The buffer runs out before the slots do
+    ASSERT_GT(TEST_PUT_FRAME_RING_SIZE, frameCount);
+    lockWorker();
+
+    for (i = 0; i < frameCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+
+    EXPECT_EQ(STATUS_PUT_FRAME_RING_FULL, putNextFrame());
+
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(mStreamHandle, &streamMetrics));
+    EXPECT_EQ(1, streamMetrics.putFrameRingFullRejections);
+
+    unlockWorker();
+    EXPECT_TRUE(waitForRingDrained());
+
+    // The frame bits wrap around to the start of the drained buffer
+    lockWorker();
+    for (i = 0; i < frameCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+    unlockWorker();
+    EXPECT_TRUE(waitForRingDrained());
+
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(mStreamHandle, &streamMetrics));
+    EXPECT_LT(2 * frameCount * SIZEOF(mFrameBuffer), streamMetrics.overallViewSize);
+    EXPECT_EQ(1, streamMetrics.putFrameRingFullRejections);
+    EXPECT_EQ(0, ATOMIC_LOAD(&mDroppedFrameReportFuncCount));
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_FailedFrameReportedDropped)
+{
+    EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+
+    // The unknown track fails only when the worker puts the frame
+    mFrame.trackId = TEST_TRACKID + 100;
+    EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+
+    EXPECT_TRUE(waitForRingDrained());
+    EXPECT_EQ(1, ATOMIC_LOAD(&mDroppedFrameReportFuncCount));
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_StopDrainsAndClosesRing)
+{
+    StreamMetrics streamMetrics;
+    UINT32 i;
+
+    // The stop puts the pending frames itself
+    lockWorker();
+    for (i = 0; i < TEST_PUT_FRAME_RING_SIZE; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStream(mStreamHandle));
+    EXPECT_TRUE(putFrameRingIsEmpty(FROM_STREAM_HANDLE(mStreamHandle)));
+    unlockWorker();
+
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(mStreamHandle, &streamMetrics));
+    EXPECT_LT(TEST_PUT_FRAME_RING_SIZE * SIZEOF(mFrameBuffer), streamMetrics.overallViewSize);
+
+    EXPECT_EQ(STATUS_PUT_FRAME_RING_CLOSED, putNextFrame());
+}
+
+static volatile ATOMIC_BOOL gInFlightFramePublished;
+
+static PVOID publishInFlightFrameRoutine(PVOID args)
+{
+    PPutFrameRing pPutFrameRing = (PPutFrameRing) args;
+
+    THREAD_SLEEP(50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    ATOMIC_STORE_BOOL(&gInFlightFramePublished, TRUE);
+    ATOMIC_STORE_BOOL(&pPutFrameRing->producing, FALSE);
+
+    return NULL;
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_CloseWaitsForInFlightFrame)
+{
+    PPutFrameRing pPutFrameRing = FROM_STREAM_HANDLE(mStreamHandle)->pPutFrameRing;
+    TID threadId;
+
+    // Emulate the producer which has passed the closed check but has yet to publish the frame
+    ATOMIC_STORE_BOOL(&gInFlightFramePublished, FALSE);
+    ATOMIC_STORE_BOOL(&pPutFrameRing->producing, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, THREAD_CREATE(&threadId, publishInFlightFrameRoutine, (PVOID) pPutFrameRing));
+
+    EXPECT_EQ(STATUS_SUCCESS, putFrameRingClose(FROM_STREAM_HANDLE(mStreamHandle)));
+    EXPECT_TRUE(ATOMIC_LOAD_BOOL(&gInFlightFramePublished));
+    EXPECT_EQ(STATUS_SUCCESS, THREAD_JOIN(threadId, NULL));
+
+    EXPECT_EQ(STATUS_PUT_FRAME_RING_CLOSED, putNextFrame());
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_InvalidRingSize)
+{
+    CLIENT_HANDLE clientHandle = INVALID_CLIENT_HANDLE_VALUE;
+
+    mDeviceInfo.clientInfo.putFrameRingSize = 3;
+    EXPECT_EQ(STATUS_INVALID_PUT_FRAME_RING_SIZE, createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle));
+
+    mDeviceInfo.clientInfo.putFrameRingSize = MAX_PUT_FRAME_RING_SIZE * 2;
+    EXPECT_EQ(STATUS_INVALID_PUT_FRAME_RING_SIZE, createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle));
+    EXPECT_FALSE(IS_VALID_CLIENT_HANDLE(clientHandle));
+
+    mDeviceInfo.clientInfo.putFrameRingSize = TEST_PUT_FRAME_RING_SIZE;
+    mDeviceInfo.clientInfo.putFrameRingBufferSize = MAX_PUT_FRAME_RING_BUFFER_SIZE + 1;
+    EXPECT_EQ(STATUS_INVALID_PUT_FRAME_RING_BUFFER_SIZE, createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle));
+    EXPECT_FALSE(IS_VALID_CLIENT_HANDLE(clientHandle));
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_InvalidWorkerCount)
+{
+    CLIENT_HANDLE clientHandle = INVALID_CLIENT_HANDLE_VALUE;
+
+    mDeviceInfo.clientInfo.putFrameWorkerCount = MAX_PUT_FRAME_WORKER_COUNT + 1;
+    EXPECT_EQ(STATUS_INVALID_PUT_FRAME_WORKER_COUNT, createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle));
+    EXPECT_FALSE(IS_VALID_CLIENT_HANDLE(clientHandle));
+}
+
+TEST_F(AsyncPutFrameFunctionalityTest, asyncPutFrame_DefaultWorkerCount)
+{
+    PKinesisVideoClient pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+    UINT32 threadCount;
+
+    EXPECT_EQ(DEFAULT_PUT_FRAME_WORKER_COUNT, pKinesisVideoClient->putFrameWorkerCount);
+    EXPECT_EQ(STATUS_SUCCESS, threadpoolTotalThreadCount(pKinesisVideoClient->pPutFrameThreadpool, &threadCount));
+    EXPECT_EQ(DEFAULT_PUT_FRAME_WORKER_COUNT, threadCount);
+}
+
+static MUTEX gArenaLock;
+static TID gTestThreadId;
+static LockMutexFunc gLockMutexFn;
+static UnlockMutexFunc gUnlockMutexFn;
+static GetCurrentTimeFunc gGetCurrentTimeFn;
+static thread_local UINT32 gArenaLockDepth = 0;
+static volatile SIZE_T gPackagingInFlight;
+static volatile SIZE_T gMaxPackagingInFlight;
+static volatile SIZE_T gPackagingUnderArenaLock;
+
+static VOID trackingLockMutex(UINT64 customData, MUTEX mutex)
+{
+    gLockMutexFn(customData, mutex);
+    if (mutex == gArenaLock) {
+        gArenaLockDepth++;
+    }
+}
+
+static VOID trackingUnlockMutex(UINT64 customData, MUTEX mutex)
+{
+    if (mutex == gArenaLock) {
+        gArenaLockDepth--;
+    }
+    gUnlockMutexFn(customData, mutex);
+}
+
+// The generator samples the time while packaging the frames of the streams without the frame timecodes
+static UINT64 trackingGetCurrentTime(UINT64 customData)
+{
+    SIZE_T inFlight, maxInFlight;
+
+    if (GETTID() != gTestThreadId) {
+        if (gArenaLockDepth != 0) {
+            ATOMIC_INCREMENT(&gPackagingUnderArenaLock);
+        } else {
+            // Hold the worker for a while for the workers of the other streams to catch up
+            inFlight = ATOMIC_INCREMENT(&gPackagingInFlight) + 1;
+            do {
+                maxInFlight = ATOMIC_LOAD(&gMaxPackagingInFlight);
+            } while (inFlight > maxInFlight && !ATOMIC_COMPARE_EXCHANGE(&gMaxPackagingInFlight, &maxInFlight, inFlight));
+
+            THREAD_SLEEP(2 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+            ATOMIC_DECREMENT(&gPackagingInFlight);
+        }
+    }
+
+    return gGetCurrentTimeFn(customData);
+}
+
+TEST_F(AsyncPutFramePoolFunctionalityTest, asyncPutFrame_StreamsPackagedInParallel)
+{
+    PKinesisVideoClient pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+    PPutFrameRing pBlockedRing;
+    STREAM_HANDLE streams[TEST_PUT_FRAME_WORKER_COUNT * 2];
+    StreamMetrics streamMetrics;
+    UINT32 i, j, threadCount;
+
+    EXPECT_EQ(TEST_PUT_FRAME_WORKER_COUNT, pKinesisVideoClient->putFrameWorkerCount);
+    EXPECT_EQ(STATUS_SUCCESS, threadpoolTotalThreadCount(pKinesisVideoClient->pPutFrameThreadpool, &threadCount));
+    EXPECT_EQ(TEST_PUT_FRAME_WORKER_COUNT, threadCount);
+
+    // The streams share the single store arena. Track whether the workers package holding it.
+    EXPECT_EQ(1, pKinesisVideoClient->storeArenaCount);
+    gArenaLock = pKinesisVideoClient->storeArenas[0].lock;
+    gTestThreadId = GETTID();
+    ATOMIC_STORE(&gPackagingInFlight, 0);
+    ATOMIC_STORE(&gMaxPackagingInFlight, 0);
+    ATOMIC_STORE(&gPackagingUnderArenaLock, 0);
+    gLockMutexFn = pKinesisVideoClient->clientCallbacks.lockMutexFn;
+    gUnlockMutexFn = pKinesisVideoClient->clientCallbacks.unlockMutexFn;
+    gGetCurrentTimeFn = pKinesisVideoClient->clientCallbacks.getCurrentTimeFn;
+    pKinesisVideoClient->clientCallbacks.lockMutexFn = trackingLockMutex;
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn = trackingUnlockMutex;
+    pKinesisVideoClient->clientCallbacks.getCurrentTimeFn = trackingGetCurrentTime;
+
+    mStreamInfo.streamCaps.frameTimecodes = FALSE;
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        SNPRINTF(mStreamInfo.name, MAX_STREAM_NAME_LEN + 1, "TestStream_%d", i);
+        EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &streams[i]));
+        EXPECT_EQ(i, FROM_STREAM_HANDLE(streams[i])->streamId);
+    }
+
+    // Only the packagers of the streams keep sampling the time through the tracking function
+    pKinesisVideoClient->clientCallbacks.getCurrentTimeFn = gGetCurrentTimeFn;
+
+    // Stall the first worker on the ring of the first stream
+    pBlockedRing = FROM_STREAM_HANDLE(streams[0])->pPutFrameRing;
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pBlockedRing->consumerLock);
+
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        mStreamHandle = streams[i];
+        mFrame.index = 0;
+        mFrame.decodingTs = mFrame.presentationTs = 0;
+        mFrame.flags = FRAME_FLAG_KEY_FRAME;
+        for (j = 0; j < TEST_PUT_FRAME_RING_SIZE / 2; j++) {
+            EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+        }
+    }
+
+    // The streams affined to the other workers are packaged while the first worker is stalled
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        if (i % TEST_PUT_FRAME_WORKER_COUNT != 0) {
+            EXPECT_TRUE(waitForRingDrained(streams[i]));
+        }
+    }
+
+    EXPECT_FALSE(putFrameRingIsEmpty(FROM_STREAM_HANDLE(streams[0])));
+    EXPECT_FALSE(putFrameRingIsEmpty(FROM_STREAM_HANDLE(streams[TEST_PUT_FRAME_WORKER_COUNT])));
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pBlockedRing->consumerLock);
+
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        EXPECT_TRUE(waitForRingDrained(streams[i]));
+        EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(streams[i], &streamMetrics));
+        EXPECT_LT(TEST_PUT_FRAME_RING_SIZE / 2 * SIZEOF(mFrameBuffer), streamMetrics.overallViewSize);
+    }
+
+    EXPECT_EQ(0, ATOMIC_LOAD(&mDroppedFrameReportFuncCount));
+
+    // The workers have packaged the frames with the arena unlocked and at the same time
+    EXPECT_EQ(0, ATOMIC_LOAD(&gPackagingUnderArenaLock));
+    EXPECT_LE(2, ATOMIC_LOAD(&gMaxPackagingInFlight));
+
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streams[i]));
+    }
+
+    pKinesisVideoClient->clientCallbacks.lockMutexFn = gLockMutexFn;
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn = gUnlockMutexFn;
+    mStreamHandle = INVALID_STREAM_HANDLE_VALUE;
+}
+
+TEST_F(AsyncPutFramePoolFunctionalityTest, asyncPutFrame_OfflineStreamDoesNotStallWorker)
+{
+    STREAM_HANDLE streams[TEST_PUT_FRAME_WORKER_COUNT + 1];
+    StreamInfo streamInfo = mStreamInfo;
+    std::vector<UPLOAD_HANDLE> uploadHandles;
+    FragmentAck fragmentAck;
+    UINT64 itemCount, windowItemCount, timeout;
+    UINT32 i;
+    STATUS retStatus;
+
+    // The OFFLINE stream buffer fits ten frames of two fragments
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        mStreamInfo = streamInfo;
+        if (i == 0) {
+            mStreamInfo.retention = 10 * HUNDREDS_OF_NANOS_IN_AN_HOUR;
+            mStreamInfo.streamCaps.streamingType = STREAMING_TYPE_OFFLINE;
+            mStreamInfo.streamCaps.bufferDuration = 10 * TEST_LONG_FRAME_DURATION;
+        }
+
+        SNPRINTF(mStreamInfo.name, MAX_STREAM_NAME_LEN + 1, "TestStream_%d", i);
+        EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &streams[i]));
+    }
+
+    // The last stream shares the worker with the OFFLINE stream
+    EXPECT_EQ(FROM_STREAM_HANDLE(streams[0])->streamId % TEST_PUT_FRAME_WORKER_COUNT,
+              FROM_STREAM_HANDLE(streams[TEST_PUT_FRAME_WORKER_COUNT])->streamId % TEST_PUT_FRAME_WORKER_COUNT);
+
+    // The first frame starts the streaming
+    mStreamHandle = streams[0];
+    mFrame.duration = TEST_LONG_FRAME_DURATION;
+    EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    EXPECT_TRUE(waitForRingDrained());
+    mStreamingSession.getActiveUploadHandles(uploadHandles);
+    EXPECT_EQ(1, uploadHandles.size());
+
+    // The last two frames don't fit until the first fragment is persisted
+    timeout = GETTIME() + HUNDREDS_OF_NANOS_IN_A_SECOND;
+    while (mFrame.index < 12 && GETTIME() < timeout) {
+        mFrame.flags = mFrame.index % 5 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        retStatus = putNextFrame();
+        if (retStatus == STATUS_PUT_FRAME_RING_FULL) {
+            THREAD_SLEEP(5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        } else {
+            EXPECT_EQ(STATUS_SUCCESS, retStatus);
+        }
+    }
+
+    EXPECT_EQ(12, mFrame.index);
+    do {
+        THREAD_SLEEP(5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(FROM_STREAM_HANDLE(streams[0])->pView, &itemCount, &windowItemCount));
+    } while (windowItemCount < 10 && GETTIME() < timeout);
+
+    EXPECT_EQ(10, windowItemCount);
+
+    // The frames of the stream sharing the worker are put while the OFFLINE stream is out of space
+    mStreamHandle = streams[TEST_PUT_FRAME_WORKER_COUNT];
+    mFrame.index = 0;
+    mFrame.decodingTs = mFrame.presentationTs = 0;
+    mFrame.flags = FRAME_FLAG_KEY_FRAME;
+    for (i = 0; i < TEST_PUT_FRAME_RING_SIZE / 2; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, putNextFrame());
+    }
+
+    EXPECT_TRUE(waitForRingDrained());
+    EXPECT_FALSE(putFrameRingIsEmpty(FROM_STREAM_HANDLE(streams[0])));
+
+    // Persisting the first fragment frees up the space for the frames left in the ring
+    fragmentAck.version = FRAGMENT_ACK_CURRENT_VERSION;
+    fragmentAck.ackType = FRAGMENT_ACK_TYPE_PERSISTED;
+    fragmentAck.result = SERVICE_CALL_RESULT_OK;
+    STRCPY(fragmentAck.sequenceNumber, "SequenceNumber");
+    fragmentAck.timestamp = 0;
+    EXPECT_EQ(STATUS_SUCCESS, kinesisVideoStreamFragmentAck(streams[0], uploadHandles[0], &fragmentAck));
+
+    EXPECT_TRUE(waitForRingDrained(streams[0]));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(FROM_STREAM_HANDLE(streams[0])->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(12 - 5, windowItemCount);
+    EXPECT_EQ(0, ATOMIC_LOAD(&mDroppedFrameReportFuncCount));
+
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streams[i]));
+    }
+
+    mStreamHandle = INVALID_STREAM_HANDLE_VALUE;
+}
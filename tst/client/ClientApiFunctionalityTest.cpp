@@ -225,3 +225,171 @@ TEST_F(ClientApiFunctionalityTest, createClientCreateStream_Iterate)
         mStreamHandle = INVALID_STREAM_HANDLE_VALUE;
     }
 }
+
+TEST_F(ClientApiFunctionalityTest, createClientCreateStream_StoreArenas)
+{
+    mClientSyncMode = TRUE;
+    mSubmitServiceCallResultMode = STOP_AT_PUT_STREAM;
+    STREAM_HANDLE streams[10];
+    PKinesisVideoClient pKinesisVideoClient;
+    PKinesisVideoStream pKinesisVideoStream;
+    ClientMetrics clientMetrics;
+    BYTE tempBuffer[1000];
+    Frame frame;
+    UINT64 heapSize, totalSize = 0;
+    UINT32 i;
+
+    // Re-create the client with the content store split into arenas
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    mDeviceInfo.storageInfo.storeArenaCount = 4;
+    CreateClient();
+
+    pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+    EXPECT_EQ(4, pKinesisVideoClient->storeArenaCount);
+    EXPECT_EQ(pKinesisVideoClient->storeArenas[0].pHeap, pKinesisVideoClient->pHeap);
+
+    frame.duration = TEST_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.frameData = tempBuffer;
+    frame.trackId = TEST_TRACKID;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    frame.index = 0;
+    frame.decodingTs = frame.presentationTs = TEST_FRAME_DURATION;
+
+    // The streams are assigned to the least loaded arena
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        SNPRINTF(mStreamInfo.name, MAX_STREAM_NAME_LEN + 1, "TestStream_%d", i);
+        EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &streams[i]));
+        pKinesisVideoStream = FROM_STREAM_HANDLE(streams[i]);
+        EXPECT_EQ(&pKinesisVideoClient->storeArenas[i % 4], pKinesisVideoStream->pStoreArena);
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(streams[i], &frame));
+    }
+
+    // Each arena gets an equal share of the storage and holds the frames of its own streams
+    for (i = 0; i < pKinesisVideoClient->storeArenaCount; i++) {
+        EXPECT_EQ(TEST_DEVICE_STORAGE_SIZE / 4, pKinesisVideoClient->storeArenas[i].storageSize);
+        EXPECT_EQ(i < 2 ? 3 : 2, pKinesisVideoClient->storeArenas[i].streamCount);
+        EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pKinesisVideoClient->storeArenas[i].pHeap, &heapSize));
+        EXPECT_LT(SIZEOF(tempBuffer), heapSize);
+        totalSize += heapSize;
+    }
+
+    clientMetrics.version = CLIENT_METRICS_CURRENT_VERSION;
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoMetrics(mClientHandle, &clientMetrics));
+    EXPECT_EQ(TEST_DEVICE_STORAGE_SIZE, clientMetrics.contentStoreSize);
+    EXPECT_EQ(totalSize, clientMetrics.contentStoreAllocatedSize);
+
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streams[i]));
+    }
+
+    for (i = 0; i < pKinesisVideoClient->storeArenaCount; i++) {
+        EXPECT_EQ(0, pKinesisVideoClient->storeArenas[i].streamCount);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+
+    // Only the in-memory storage types can be partitioned
+    mDeviceInfo.storageInfo.storageType = DEVICE_STORAGE_TYPE_HYBRID_FILE;
+    mDeviceInfo.storageInfo.spillRatio = 50;
+    CreateClient();
+    EXPECT_EQ(1, FROM_CLIENT_HANDLE(mClientHandle)->storeArenaCount);
+}
+
+STATUS countStreamVisitor(PKinesisVideoStream pKinesisVideoStream, UINT64 customData)
+{
+    UNUSED_PARAM(pKinesisVideoStream);
+    (*(PUINT32) customData)++;
+    return STATUS_SUCCESS;
+}
+
+TEST_F(ClientApiFunctionalityTest, createClientCreateStream_StaleHandle)
+{
+    mClientSyncMode = TRUE;
+    mSubmitServiceCallResultMode = STOP_AT_PUT_STREAM;
+    STREAM_HANDLE streams[MAX_TEST_STREAM_COUNT], staleHandle, streamHandle;
+    PKinesisVideoStream pKinesisVideoStream;
+    StreamMetrics streamMetrics;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    CreateClient();
+
+    EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &staleHandle));
+    pKinesisVideoStream = FROM_STREAM_HANDLE(staleHandle);
+    EXPECT_EQ(0, pKinesisVideoStream->streamId);
+    EXPECT_EQ(staleHandle, TO_STREAM_HANDLE(pKinesisVideoStream));
+    EXPECT_EQ(0, staleHandle & STREAM_HANDLE_GENERATION_MASK);
+
+    streams[0] = staleHandle;
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streams[0]));
+    EXPECT_EQ((PKinesisVideoStream) NULL, FROM_STREAM_HANDLE(staleHandle));
+
+    // The vacated slot is reused last
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        SNPRINTF(mStreamInfo.name, MAX_STREAM_NAME_LEN + 1, "TestStream_%d", i);
+        EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &streams[i]));
+        EXPECT_EQ((i + 1) % MAX_TEST_STREAM_COUNT, FROM_STREAM_HANDLE(streams[i])->streamId);
+    }
+
+    // The stale handle of the slot does not resolve to the new stream
+    EXPECT_NE(staleHandle, streams[ARRAY_SIZE(streams) - 1]);
+    EXPECT_EQ(1, streams[ARRAY_SIZE(streams) - 1] & STREAM_HANDLE_GENERATION_MASK);
+    EXPECT_EQ((PKinesisVideoStream) NULL, FROM_STREAM_HANDLE(staleHandle));
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    EXPECT_NE(STATUS_SUCCESS, getKinesisVideoStreamMetrics(staleHandle, &streamMetrics));
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamMetrics(streams[ARRAY_SIZE(streams) - 1], &streamMetrics));
+
+    // The names are still unique
+    EXPECT_EQ(STATUS_MAX_STREAM_COUNT, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streams[0]));
+    EXPECT_EQ(STATUS_DUPLICATE_STREAM_NAME, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &streamHandle));
+
+    for (i = 1; i < ARRAY_SIZE(streams); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streams[i]));
+    }
+}
+
+TEST_F(ClientApiFunctionalityTest, createClientCreateStream_VisitStreams)
+{
+    mClientSyncMode = TRUE;
+    mSubmitServiceCallResultMode = STOP_AT_PUT_STREAM;
+    STREAM_HANDLE streams[MAX_TEST_STREAM_COUNT / 2];
+    PKinesisVideoClient pKinesisVideoClient;
+    UINT32 i, count;
+
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    CreateClient();
+    pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        SNPRINTF(mStreamInfo.name, MAX_STREAM_NAME_LEN + 1, "TestStream_%d", i);
+        EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(mClientHandle, &mStreamInfo, &streams[i]));
+    }
+
+    count = 0;
+    EXPECT_EQ(STATUS_SUCCESS, streamTableVisit(pKinesisVideoClient, 0, 1, countStreamVisitor, (UINT64) &count));
+    EXPECT_EQ(ARRAY_SIZE(streams), count);
+
+    // Visit the slots with the odd indices only
+    count = 0;
+    EXPECT_EQ(STATUS_SUCCESS, streamTableVisit(pKinesisVideoClient, 1, 2, countStreamVisitor, (UINT64) &count));
+    EXPECT_EQ(ARRAY_SIZE(streams) / 2, count);
+
+    // The stream being shut down is skipped
+    semaphoreLock(FROM_STREAM_HANDLE(streams[0])->base.shutdownSemaphore);
+    count = 0;
+    EXPECT_EQ(STATUS_SUCCESS, streamTableVisit(pKinesisVideoClient, 0, 1, countStreamVisitor, (UINT64) &count));
+    EXPECT_EQ(ARRAY_SIZE(streams) - 1, count);
+    semaphoreUnlock(FROM_STREAM_HANDLE(streams[0])->base.shutdownSemaphore);
+
+    EXPECT_EQ(STATUS_INVALID_ARG, streamTableVisit(pKinesisVideoClient, 0, 0, countStreamVisitor, (UINT64) &count));
+
+    for (i = 0; i < ARRAY_SIZE(streams); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streams[i]));
+    }
+
+    count = 0;
+    EXPECT_EQ(STATUS_SUCCESS, streamTableVisit(pKinesisVideoClient, 0, 1, countStreamVisitor, (UINT64) &count));
+    EXPECT_EQ(0, count);
+}
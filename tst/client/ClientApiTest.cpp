@@ -200,6 +200,14 @@ TEST_F(ClientApiTest, createKinesisVideoClient_ValidateDeviceInfo)
     EXPECT_TRUE(STATUS_FAILED(createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle)));
     mDeviceInfo.storageInfo.spillRatio = 0;
 
+    mDeviceInfo.storageInfo.storeArenaCount = MAX_STORE_ARENA_COUNT + 1;
+    EXPECT_EQ(STATUS_INVALID_STORE_ARENA_COUNT, createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle));
+    mDeviceInfo.storageInfo.storeArenaCount = 2;
+    mDeviceInfo.storageInfo.storageSize = MIN_STORAGE_ALLOCATION_SIZE + 1;
+    EXPECT_EQ(STATUS_INVALID_STORE_ARENA_COUNT, createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle));
+    mDeviceInfo.storageInfo.storageSize = TEST_DEVICE_STORAGE_SIZE;
+    mDeviceInfo.storageInfo.storeArenaCount = 0;
+
     MEMSET(mDeviceInfo.storageInfo.rootDirectory, 'a', (MAX_PATH_LEN + 1) * SIZEOF(CHAR));
     EXPECT_TRUE(STATUS_FAILED(createKinesisVideoClient(&mDeviceInfo, &mClientCallbacks, &clientHandle)));
     mDeviceInfo.storageInfo.rootDirectory[0] = '\0';
@@ -564,4 +564,5 @@ TEST_P(ClientFunctionalityTest, StreamFormatChangedGeneratedAacAudioDirectCpdPas
 INSTANTIATE_TEST_SUITE_P(PermutatedStreamInfo, ClientFunctionalityTest,
                          Combine(Values(STREAMING_TYPE_REALTIME, STREAMING_TYPE_OFFLINE), Values(0, 10 * HUNDREDS_OF_NANOS_IN_AN_HOUR), Bool(),
                                  Values(0, TEST_REPLAY_DURATION),
-                                 Values(DEVICE_STORAGE_TYPE_IN_MEM, DEVICE_STORAGE_TYPE_IN_MEM_CONTENT_STORE_ALLOC)));
\ No newline at end of file
+                                 Values(DEVICE_STORAGE_TYPE_IN_MEM, DEVICE_STORAGE_TYPE_IN_MEM_CONTENT_STORE_ALLOC,
+                                        DEVICE_STORAGE_TYPE_IN_MEM_RING_BUFFER)));
\ No newline at end of file
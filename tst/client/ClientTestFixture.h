@@ -170,6 +170,25 @@ INLINE VOID instrumentedClientMemFree(PVOID ptr)
     free(pAlloc);
 }
 
+INLINE PVOID instrumentedClientMemRealloc(PVOID ptr, SIZE_T size)
+{
+    PBYTE pAlloc = ptr == NULL ? NULL : (PBYTE) ptr - SIZEOF(SIZE_T);
+    SIZE_T existingSize = pAlloc == NULL ? 0 : *(PSIZE_T) pAlloc;
+    DLOGS("Test realloc %llu bytes", (UINT64) size);
+
+    pAlloc = (PBYTE) realloc(pAlloc, size + SIZEOF(SIZE_T));
+    if (pAlloc == NULL) {
+        return NULL;
+    }
+
+    MUTEX_LOCK(gClientMemMutex);
+    gTotalClientMemoryUsage += size - existingSize;
+    MUTEX_UNLOCK(gClientMemMutex);
+    *(PSIZE_T) pAlloc = size;
+
+    return pAlloc + SIZEOF(SIZE_T);
+}
+
 //
 // Set the allocators to the instrumented equivalents
 //
@@ -177,6 +196,7 @@ extern memAlloc globalMemAlloc;
 extern memAlignAlloc globalMemAlignAlloc;
 extern memCalloc globalMemCalloc;
 extern memFree globalMemFree;
+extern memRealloc globalMemRealloc;
 
 typedef enum {
     DISABLE_AUTO_SUBMIT = 0,
@@ -255,6 +275,7 @@ class ClientTestBase : public ::testing::Test {
         storedMemAlignAlloc = globalMemAlignAlloc;
         storedMemCalloc = globalMemCalloc;
         storedMemFree = globalMemFree;
+        storedMemRealloc = globalMemRealloc;
 
         // Create the mutex for the synchronization for the instrumentation
         gClientMemMutex = MUTEX_CREATE(FALSE);
@@ -263,6 +284,7 @@ class ClientTestBase : public ::testing::Test {
         globalMemAlignAlloc = instrumentedClientMemAlignAlloc;
         globalMemCalloc = instrumentedClientMemCalloc;
         globalMemFree = instrumentedClientMemFree;
+        globalMemRealloc = instrumentedClientMemRealloc;
 
         // Set the magic number for verification later
         ATOMIC_STORE(&mMagic, TEST_CLIENT_MAGIC_NUMBER);
@@ -408,6 +430,7 @@ class ClientTestBase : public ::testing::Test {
         mDeviceInfo.storageInfo.spillRatio = 0;
         mDeviceInfo.storageInfo.storageType = DEVICE_STORAGE_TYPE_IN_MEM;
         mDeviceInfo.storageInfo.storageSize = TEST_DEVICE_STORAGE_SIZE;
+        mDeviceInfo.storageInfo.storeArenaCount = 0;
         mDeviceInfo.clientInfo.version = CLIENT_INFO_CURRENT_VERSION;
         mDeviceInfo.clientInfo.createClientTimeout = TEST_DEFAULT_CREATE_CLIENT_TIMEOUT;
         mDeviceInfo.clientInfo.createStreamTimeout = TEST_DEFAULT_CREATE_STREAM_TIMEOUT;
@@ -418,6 +441,9 @@ class ClientTestBase : public ::testing::Test {
         mDeviceInfo.clientInfo.metricLoggingPeriod = 1 * HUNDREDS_OF_NANOS_IN_A_MINUTE;
         mDeviceInfo.clientInfo.automaticStreamingFlags = AUTOMATIC_STREAMING_INTERMITTENT_PRODUCER;
         mDeviceInfo.clientInfo.reservedCallbackPeriod = INTERMITTENT_PRODUCER_PERIOD_DEFAULT;
+        mDeviceInfo.clientInfo.putFrameRingSize = 0;
+        mDeviceInfo.clientInfo.putFrameRingBufferSize = 0;
+        mDeviceInfo.clientInfo.putFrameWorkerCount = 0;
 
         mDeviceInfo.clientInfo.kvsRetryStrategyCallbacks.createRetryStrategyFn = createRetryStrategyFn;
         mDeviceInfo.clientInfo.kvsRetryStrategyCallbacks.getCurrentRetryAttemptNumberFn = getCurrentRetryAttemptNumberFn;
@@ -453,6 +479,8 @@ class ClientTestBase : public ::testing::Test {
         mStreamInfo.streamCaps.storePressurePolicy = CONTENT_STORE_PRESSURE_POLICY_OOM;
         mStreamInfo.streamCaps.viewOverflowPolicy = CONTENT_VIEW_OVERFLOW_POLICY_DROP_TAIL_VIEW_ITEM;
         mStreamInfo.streamCaps.allowStreamCreation = TRUE;
+        mStreamInfo.streamCaps.audioLacingDuration = 0;
+        mStreamInfo.streamCaps.fragmentExtentSize = 0;
         mTrackInfo.trackId = TEST_TRACKID;
         mTrackInfo.codecPrivateDataSize = 0;
         mTrackInfo.codecPrivateData = NULL;
@@ -960,6 +988,7 @@ class ClientTestBase : public ::testing::Test {
         globalMemAlignAlloc = storedMemAlignAlloc;
         globalMemCalloc = storedMemCalloc;
         globalMemFree = storedMemFree;
+        globalMemRealloc = storedMemRealloc;
         MUTEX_FREE(gClientMemMutex);
     };
 
@@ -999,6 +1028,7 @@ class ClientTestBase : public ::testing::Test {
     memAlignAlloc storedMemAlignAlloc;
     memCalloc storedMemCalloc;
     memFree storedMemFree;
+    memRealloc storedMemRealloc;
 
     //////////////////////////////////////////////////////////////////////////////////////
     // Static callbacks definitions
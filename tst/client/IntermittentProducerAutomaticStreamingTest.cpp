@@ -76,6 +76,136 @@ STATUS timerCallbackPreHook(UINT64 hookCustomData)
     return retStatus;
 };
 
+STATUS timerCallbackSkipPreHook(UINT64 hookCustomData)
+{
+    IntermittentProducerAutomaticStreamingTest* pTest = (IntermittentProducerAutomaticStreamingTest*) hookCustomData;
+    CHECK(pTest != NULL);
+    ATOMIC_INCREMENT(&pTest->mTimerCallbackFuncCount);
+
+    // Keep the timer from expiring the deadlines so the test drives the wheel
+    return STATUS_INVALID_OPERATION;
+};
+
+STATUS countExpiredStream(PKinesisVideoStream pKinesisVideoStream, UINT64 customData)
+{
+    UNUSED_PARAM(pKinesisVideoStream);
+    ATOMIC_INCREMENT((volatile SIZE_T*) customData);
+    return STATUS_SUCCESS;
+}
+
+TEST_P(IntermittentProducerAutomaticStreamingTest, ValidateOnlyExpiredDeadlinesChecked)
+{
+    volatile SIZE_T expiredCount = 0;
+
+    // Create new client so param value of callbackPeriod can be applied
+    ASSERT_EQ(STATUS_SUCCESS, CreateClient());
+
+    PKinesisVideoClient client = FROM_CLIENT_HANDLE(mClientHandle);
+    // Lock client before setting hook custom data and callback because PIC reads these values
+    client->clientCallbacks.lockMutexFn(client->clientCallbacks.customData, client->base.lock);
+    client->hookCustomData = (UINT64) this;
+    client->timerCallbackPreHookFunc = timerCallbackSkipPreHook;
+    client->clientCallbacks.unlockMutexFn(client->clientCallbacks.customData, client->base.lock);
+
+    // Create synchronously
+    CreateStreamSync();
+    PKinesisVideoStream stream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    // The stream is not armed until it gets a frame
+    EXPECT_FALSE(stream->eofrTimerArmed);
+    EXPECT_EQ(STATUS_SUCCESS, expireEofrTimers(client, GETTIME(), countExpiredStream, (UINT64) &expiredCount));
+    EXPECT_EQ(0, ATOMIC_LOAD(&expiredCount));
+
+    // Produce a frame
+    BYTE temp[100];
+    Frame frame;
+    frame.trackId = 1;
+    frame.size = SIZEOF(temp);
+    frame.duration = TEST_FRAME_DURATION;
+    frame.index = 0;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    frame.presentationTs = 0;
+    frame.decodingTs = 0;
+    frame.frameData = temp;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    EXPECT_TRUE(stream->eofrTimerArmed);
+
+    // The deadline has not been reached yet
+    UINT64 deadline = stream->lastPutFrameTimestamp + INTERMITTENT_PRODUCER_MAX_TIMEOUT;
+    EXPECT_EQ(STATUS_SUCCESS,
+              expireEofrTimers(client, deadline - 2 * mDeviceInfo.clientInfo.reservedCallbackPeriod, countExpiredStream, (UINT64) &expiredCount));
+    EXPECT_EQ(0, ATOMIC_LOAD(&expiredCount));
+    EXPECT_TRUE(stream->eofrTimerArmed);
+
+    // The stream is disarmed once its deadline expires
+    UINT64 expiryTime = deadline + mDeviceInfo.clientInfo.reservedCallbackPeriod;
+    EXPECT_EQ(STATUS_SUCCESS, expireEofrTimers(client, expiryTime, countExpiredStream, (UINT64) &expiredCount));
+    EXPECT_EQ(1, ATOMIC_LOAD(&expiredCount));
+    EXPECT_FALSE(stream->eofrTimerArmed);
+
+    // The expired stream which got no frames since is not re-armed by the repeated expiry
+    EXPECT_EQ(STATUS_SUCCESS,
+              expireEofrTimers(client, expiryTime + INTERMITTENT_PRODUCER_MAX_TIMEOUT, countExpiredStream, (UINT64) &expiredCount));
+    EXPECT_EQ(1, ATOMIC_LOAD(&expiredCount));
+}
+
+TEST_P(IntermittentProducerAutomaticStreamingTest, ValidateExpiredDeadlinePutsEofrAndRearms)
+{
+    // Create new client so param value of callbackPeriod can be applied
+    ASSERT_EQ(STATUS_SUCCESS, CreateClient());
+
+    PKinesisVideoClient client = FROM_CLIENT_HANDLE(mClientHandle);
+    // Lock client before setting hook custom data and callback because PIC reads these values
+    client->clientCallbacks.lockMutexFn(client->clientCallbacks.customData, client->base.lock);
+    client->hookCustomData = (UINT64) this;
+    client->timerCallbackPreHookFunc = timerCallbackSkipPreHook;
+    client->clientCallbacks.unlockMutexFn(client->clientCallbacks.customData, client->base.lock);
+
+    // Create synchronously
+    CreateStreamSync();
+    PKinesisVideoStream stream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    // Produce a frame
+    BYTE temp[100];
+    Frame frame;
+    frame.trackId = 1;
+    frame.size = SIZEOF(temp);
+    frame.duration = TEST_FRAME_DURATION;
+    frame.index = 0;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    frame.presentationTs = 0;
+    frame.decodingTs = 0;
+    frame.frameData = temp;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+    // The stream which got a frame after the deadline was armed is re-armed instead of getting the EoFR
+    UINT64 firstDeadline = stream->lastPutFrameTimestamp + INTERMITTENT_PRODUCER_MAX_TIMEOUT;
+    frame.index = 1;
+    frame.flags = FRAME_FLAG_NONE;
+    frame.presentationTs = frame.decodingTs = TEST_FRAME_DURATION;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    UINT64 lastPutFrameTimestamp = stream->lastPutFrameTimestamp;
+    EXPECT_TRUE(IS_VALID_TIMESTAMP(lastPutFrameTimestamp));
+
+    EXPECT_EQ(STATUS_SUCCESS, expireEofrTimers(client, firstDeadline, checkIntermittentProducerStream, firstDeadline));
+    EXPECT_FALSE(stream->eofrFrame);
+    EXPECT_TRUE(stream->eofrTimerArmed);
+
+    // The expired stream gets the EoFR and stays disarmed until the next frame
+    UINT64 expiryTime = lastPutFrameTimestamp + INTERMITTENT_PRODUCER_MAX_TIMEOUT + mDeviceInfo.clientInfo.reservedCallbackPeriod;
+    EXPECT_EQ(STATUS_SUCCESS, expireEofrTimers(client, expiryTime, checkIntermittentProducerStream, expiryTime));
+    EXPECT_TRUE(stream->eofrFrame);
+    EXPECT_FALSE(IS_VALID_TIMESTAMP(stream->lastPutFrameTimestamp));
+    EXPECT_FALSE(stream->eofrTimerArmed);
+
+    frame.index = 2;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    frame.presentationTs = frame.decodingTs = 2 * TEST_FRAME_DURATION;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    EXPECT_TRUE(stream->eofrTimerArmed);
+    EXPECT_EQ(0, ATOMIC_LOAD(&mStreamErrorReportFuncCount));
+}
+
 #ifdef ALIGNED_MEMORY_MODEL
 
 TEST_P(IntermittentProducerAutomaticStreamingTest, ValidateTimerInvokedBeforeTime)
@@ -704,7 +834,7 @@ TEST_P(IntermittentProducerAutomaticStreamingTest, ValidateMultiStream)
     }
 }
 
+#endif
+
 INSTANTIATE_TEST_SUITE_P(PermutatedStreamInfo, IntermittentProducerAutomaticStreamingTest,
                          Combine(Values(1000, 2000, 3000), Values(0, CLIENT_INFO_CURRENT_VERSION)));
-
-#endif
\ No newline at end of file
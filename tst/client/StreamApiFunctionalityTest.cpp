@@ -1790,6 +1790,979 @@ TEST_F(StreamApiFunctionalityTest, PutGet_ConnectionStaleNotification)
 
 #endif
 
+TEST_F(StreamApiFunctionalityTest, putFrame_PutGetSegments)
+{
+    UINT32 i, j, filledSize, segmentCount, offset;
+    BYTE tempBuffer[10000];
+    BYTE getDataBuffer[20000];
+    StreamDataSegment segments[MAX_STREAM_DATA_SEGMENT_COUNT];
+    UINT64 timestamp;
+    Frame frame;
+    PKinesisVideoStream pKinesisVideoStream;
+
+    // Create and ready a stream
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    for (i = 0, timestamp = 0; timestamp < TEST_BUFFER_DURATION; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        frame.duration = TEST_LONG_FRAME_DURATION;
+        frame.size = SIZEOF(tempBuffer);
+        frame.trackId = TEST_TRACKID;
+        *(PUINT32) &tempBuffer = i;
+        frame.frameData = tempBuffer;
+
+        // Key frame every 10th
+        frame.flags = i % 10 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+        // Return a put stream result on 50th
+        if (i == 50) {
+            EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+        }
+    }
+
+    // Retrieve the data without copying and gather it
+    EXPECT_EQ(STATUS_SUCCESS,
+              getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, SIZEOF(getDataBuffer), segments, ARRAY_SIZE(segments),
+                                                &segmentCount, &filledSize));
+    EXPECT_EQ(SIZEOF(getDataBuffer), filledSize);
+    EXPECT_LT(1, segmentCount);
+    for (j = 0, offset = 0; j < segmentCount; offset += segments[j].size, j++) {
+        MEMCPY(getDataBuffer + offset, segments[j].pData, segments[j].size);
+    }
+
+    EXPECT_EQ(filledSize, offset);
+
+    // No more data can be retrieved until the segments are released
+    EXPECT_EQ(STATUS_STREAM_DATA_SEGMENTS_OUTSTANDING,
+              getKinesisVideoStreamData(mStreamHandle, TEST_UPLOAD_HANDLE, getDataBuffer, SIZEOF(getDataBuffer), &filledSize));
+    EXPECT_EQ(STATUS_STREAM_DATA_SEGMENTS_OUTSTANDING,
+              getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, SIZEOF(getDataBuffer), segments, ARRAY_SIZE(segments),
+                                                &segmentCount, &filledSize));
+
+    // Roll the items backing the segments out of the window
+    for (; timestamp < 2 * TEST_BUFFER_DURATION; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        frame.flags = i % 10 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        *(PUINT32) &tempBuffer = i;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    // The pinned content should remain intact although the items have been removed
+    EXPECT_LT(0, pKinesisVideoStream->pinnedAllocationCount);
+    EXPECT_TRUE(pKinesisVideoStream->pinnedAllocations[0].removed);
+    for (j = 0, offset = 0; j < segmentCount; offset += segments[j].size, j++) {
+        EXPECT_EQ(0, MEMCMP(getDataBuffer + offset, segments[j].pData, segments[j].size));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, releaseKinesisVideoStreamDataSegments(mStreamHandle));
+    EXPECT_EQ(STATUS_STREAM_DATA_SEGMENTS_NOT_OUTSTANDING, releaseKinesisVideoStreamDataSegments(mStreamHandle));
+
+    // The data can be retrieved again
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamData(mStreamHandle, TEST_UPLOAD_HANDLE, getDataBuffer, SIZEOF(getDataBuffer), &filledSize));
+    EXPECT_EQ(SIZEOF(getDataBuffer), filledSize);
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrame_PutGetSegmentsMetadataReplacedWhileOutstanding)
+{
+    UINT32 i, j, filledSize, segmentCount, metadataSize = 0;
+    BYTE tempBuffer[1000];
+    BYTE metadataBuffer[1000];
+    StreamDataSegment segments[MAX_STREAM_DATA_SEGMENT_COUNT];
+    UINT64 timestamp;
+    Frame frame;
+    PBYTE pMetadata = NULL, pPackagedMetadata;
+    PKinesisVideoStream pKinesisVideoStream;
+    STATUS retStatus;
+
+    // Create and ready a stream
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.frameData = tempBuffer;
+    for (i = 0, timestamp = 0; i < 20; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        frame.flags = i % 10 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+        if (i == 0) {
+            EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+        }
+    }
+
+    // The metadata put after the last fragment is packaged on stop and sent ahead of the EoS
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFragmentMetadata(mStreamHandle, (PCHAR) "StopName", (PCHAR) "StopValue", FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStream(mStreamHandle));
+    pPackagedMetadata = pKinesisVideoStream->metadataTracker.data;
+    EXPECT_TRUE(pPackagedMetadata != NULL);
+
+    // Consume the data until the packaged metadata is handed out in a segment
+    do {
+        retStatus = getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, SIZEOF(tempBuffer), segments, ARRAY_SIZE(segments),
+                                                      &segmentCount, &filledSize);
+        for (j = 0; j < segmentCount && pMetadata == NULL; j++) {
+            if (segments[j].pData >= pPackagedMetadata && segments[j].pData < pPackagedMetadata + pKinesisVideoStream->metadataTracker.size) {
+                pMetadata = segments[j].pData;
+                metadataSize = segments[j].size;
+            }
+        }
+
+        if (pMetadata == NULL && segmentCount != 0) {
+            EXPECT_EQ(STATUS_SUCCESS, releaseKinesisVideoStreamDataSegments(mStreamHandle));
+        }
+    } while (pMetadata == NULL && STATUS_SUCCEEDED(retStatus));
+
+    ASSERT_TRUE(pMetadata != NULL);
+    MEMCPY(metadataBuffer, pMetadata, metadataSize);
+
+    // Reset and reconnect the stream and package new metadata on stop while the segments are outstanding
+    // NOTE: The reset fails to step the state machine out of the stopped state as no service call result is set
+    kinesisVideoStreamResetStream(mStreamHandle);
+    EXPECT_EQ(pPackagedMetadata, pKinesisVideoStream->pRetiredMetadata);
+    EXPECT_EQ(STATUS_SUCCESS, kinesisVideoStreamResetConnection(mStreamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFragmentMetadata(mStreamHandle, (PCHAR) "ResetName", (PCHAR) "ResetValue", FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStream(mStreamHandle));
+    EXPECT_TRUE(pKinesisVideoStream->metadataTracker.data != NULL);
+    EXPECT_NE(pPackagedMetadata, pKinesisVideoStream->metadataTracker.data);
+
+    // The segment handed out still points to the valid packaged metadata until released
+    EXPECT_EQ(0, MEMCMP(metadataBuffer, pMetadata, metadataSize));
+    EXPECT_EQ(STATUS_SUCCESS, releaseKinesisVideoStreamDataSegments(mStreamHandle));
+    EXPECT_EQ(NULL, pKinesisVideoStream->pRetiredMetadata);
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrame_FragmentExtents)
+{
+    UINT32 i, filledSize, segmentCount, offset, fragmentSize, itemEnds[10];
+    BYTE tempBuffer[1000];
+    BYTE getDataBuffer[100000];
+    StreamDataSegment segments[MAX_STREAM_DATA_SEGMENT_COUNT];
+    UINT64 timestamp, heapSize, currentHeapSize;
+    Frame frame;
+    PKinesisVideoStream pKinesisVideoStream;
+    PKinesisVideoClient pKinesisVideoClient;
+    PViewItem pViewItem;
+    ALLOCATION_HANDLE handles[3];
+
+    // The extent has to grow to fit a fragment
+    mStreamInfo.streamCaps.fragmentExtentSize = 4 * SIZEOF(tempBuffer);
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+    EXPECT_TRUE(pKinesisVideoStream->fragmentExtents.pItemOffsets != NULL);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pKinesisVideoClient->pHeap, &heapSize));
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.frameData = tempBuffer;
+    for (i = 0, timestamp = 0; i < 30; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = frame.presentationTs = timestamp;
+        frame.flags = i % 10 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        *(PUINT32) (tempBuffer + SIZEOF(tempBuffer) - SIZEOF(UINT32)) = i;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    // The items of a fragment are laid out back to back in the extent of the fragment
+    for (i = 0, offset = 0; i < 30; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        EXPECT_TRUE(CHECK_ITEM_FRAGMENT_EXTENT(pViewItem->flags));
+        if (i % 10 == 0) {
+            handles[i / 10] = pViewItem->handle;
+            offset = 0;
+        }
+
+        EXPECT_EQ(handles[i / 10], pViewItem->handle);
+        EXPECT_EQ(offset, getViewItemExtentOffset(pKinesisVideoStream, pViewItem));
+        offset += pViewItem->length;
+        if (i < 10) {
+            itemEnds[i] = fragmentSize = offset;
+        }
+    }
+
+    EXPECT_NE(handles[0], handles[1]);
+    EXPECT_NE(handles[1], handles[2]);
+    EXPECT_EQ(handles[2], pKinesisVideoStream->fragmentExtents.handle);
+
+    // The whole first fragment is returned as a single segment
+    EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+    EXPECT_EQ(STATUS_SUCCESS,
+              getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, fragmentSize, segments, ARRAY_SIZE(segments), &segmentCount,
+                                                &filledSize));
+    EXPECT_EQ(fragmentSize, filledSize);
+    EXPECT_EQ(1, segmentCount);
+    EXPECT_EQ(1, pKinesisVideoStream->pinnedAllocationCount);
+
+    // The frames are in order with the payload at the end of each item tagged with the frame index
+    for (i = 0; i < 10; i++) {
+        EXPECT_EQ(i, *(PUINT32) (segments[0].pData + itemEnds[i] - SIZEOF(UINT32)));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, releaseKinesisVideoStreamDataSegments(mStreamHandle));
+
+    // The following fragment is copied out of its extent
+    for (i = 10, fragmentSize = 0; i < 20; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        fragmentSize += pViewItem->length;
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamData(mStreamHandle, TEST_UPLOAD_HANDLE, getDataBuffer, fragmentSize, &filledSize));
+    EXPECT_EQ(fragmentSize, filledSize);
+    for (i = 10, offset = 0; i < 20; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        offset += pViewItem->length;
+        EXPECT_EQ(i, *(PUINT32) (getDataBuffer + offset - SIZEOF(UINT32)));
+    }
+
+    // The extents are returned to the content store with the stream
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&mStreamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pKinesisVideoClient->pHeap, &currentHeapSize));
+    EXPECT_EQ(heapSize, currentHeapSize);
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrame_AcquireCommitFrameBuffer)
+{
+#define TEST_ACQUIRED_FRAME_SIZE 1000
+    UINT32 i, bufferSize, filledSize, offset;
+    BYTE tempBuffer[TEST_ACQUIRED_FRAME_SIZE];
+    BYTE getDataBuffer[100000];
+    PBYTE pBuffer, pCur;
+    UINT64 timestamp;
+    Frame frame;
+    STATUS retStatus;
+    BOOL found;
+    PCHAR metadataValues[] = {(PCHAR) "AcquiredValue", (PCHAR) "RelocatedValue"};
+
+    // Create and ready a stream
+    ReadyStream();
+
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.trackId = TEST_TRACKID;
+    for (i = 1, timestamp = 0; i <= 40; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        frame.flags = i % 10 == 1 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+
+        if (i == 21) {
+            EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFragmentMetadata(mStreamHandle, (PCHAR) "AcquiredName", metadataValues[0], FALSE));
+        }
+
+        if (i % 2 == 0) {
+            // Regular put frame
+            MEMSET(tempBuffer, (BYTE) i, SIZEOF(tempBuffer));
+            frame.frameData = tempBuffer;
+            frame.size = SIZEOF(tempBuffer);
+            EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+            continue;
+        }
+
+        // The max frame size has not been seen for the first frame so it needs to be specified
+        frame.frameData = NULL;
+        frame.size = i == 1 ? TEST_ACQUIRED_FRAME_SIZE : 0;
+        EXPECT_EQ(STATUS_SUCCESS, acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, &pBuffer, &bufferSize));
+        EXPECT_LE(TEST_ACQUIRED_FRAME_SIZE, bufferSize);
+        EXPECT_EQ(STATUS_FRAME_BUFFER_ALREADY_ACQUIRED, acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, &pBuffer, &bufferSize));
+
+        // Metadata added after the acquisition changes the header size and the payload is relocated
+        if (i == 31) {
+            EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFragmentMetadata(mStreamHandle, (PCHAR) "RelocatedName", metadataValues[1], FALSE));
+        }
+
+        MEMSET(pBuffer, (BYTE) i, TEST_ACQUIRED_FRAME_SIZE);
+        frame.size = TEST_ACQUIRED_FRAME_SIZE;
+
+        // The frame has to point to the acquired buffer
+        frame.frameData = tempBuffer;
+        EXPECT_EQ(STATUS_INVALID_ARG, commitKinesisVideoFrame(mStreamHandle, &frame));
+
+        frame.frameData = pBuffer;
+        EXPECT_EQ(STATUS_SUCCESS, commitKinesisVideoFrame(mStreamHandle, &frame));
+        EXPECT_EQ(STATUS_FRAME_BUFFER_NOT_ACQUIRED, commitKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    // Discarded buffer doesn't produce a frame
+    frame.size = 0;
+    EXPECT_EQ(STATUS_SUCCESS, acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, &pBuffer, &bufferSize));
+    EXPECT_EQ(STATUS_SUCCESS, discardKinesisVideoFrameBuffer(mStreamHandle));
+    EXPECT_EQ(STATUS_FRAME_BUFFER_NOT_ACQUIRED, discardKinesisVideoFrameBuffer(mStreamHandle));
+
+    EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+
+    offset = 0;
+    do {
+        retStatus = getKinesisVideoStreamData(mStreamHandle, TEST_UPLOAD_HANDLE, getDataBuffer + offset, SIZEOF(getDataBuffer) - offset, &filledSize);
+        offset += filledSize;
+    } while (retStatus == STATUS_SUCCESS && offset < SIZEOF(getDataBuffer));
+
+    EXPECT_EQ(STATUS_NO_MORE_DATA_AVAILABLE, retStatus);
+
+    // Each frame should be packaged in a simple block in order regardless of how it has been put
+    pCur = getDataBuffer;
+    for (i = 1; i <= 40; i++) {
+        MEMSET(tempBuffer, (BYTE) i, SIZEOF(tempBuffer));
+        found = FALSE;
+        while (!found && pCur + 13 + TEST_ACQUIRED_FRAME_SIZE <= getDataBuffer + offset) {
+            // Simple block id followed by the 8 byte encoded size, track number, timecode, flags and the payload
+            found = pCur[0] == 0xA3 && getUnalignedInt64BigEndian((PINT64) (pCur + 1)) == (0x100000000000000ULL | (TEST_ACQUIRED_FRAME_SIZE + 4)) &&
+                0 == MEMCMP(pCur + 13, tempBuffer, TEST_ACQUIRED_FRAME_SIZE);
+            if (!found) {
+                pCur++;
+            }
+        }
+
+        EXPECT_TRUE(found) << "Frame " << i << " not found";
+        if (found) {
+            EXPECT_EQ(i % 10 == 1 ? 0x80 : 0x00, pCur[12]);
+            pCur += 13 + TEST_ACQUIRED_FRAME_SIZE;
+        }
+    }
+
+    // The metadata should have been packaged too
+    for (i = 0; i < ARRAY_SIZE(metadataValues); i++) {
+        for (found = FALSE, pCur = getDataBuffer; !found && pCur + STRLEN(metadataValues[i]) <= getDataBuffer + offset; pCur++) {
+            found = 0 == MEMCMP(pCur, metadataValues[i], STRLEN(metadataValues[i]));
+        }
+
+        EXPECT_TRUE(found) << "Metadata " << metadataValues[i] << " not found";
+    }
+#undef TEST_ACQUIRED_FRAME_SIZE
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrames_BatchPerFrameStatus)
+{
+#define TEST_BATCH_FRAME_COUNT 10
+    UINT32 i, j;
+    BYTE tempBuffer[1000];
+    Frame frames[TEST_BATCH_FRAME_COUNT];
+    STATUS frameStatuses[TEST_BATCH_FRAME_COUNT];
+    UINT64 timestamp = 0, itemCount, windowItemCount;
+    PKinesisVideoStream pKinesisVideoStream;
+
+    // Create and ready a stream
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    for (j = 0; j < 5; j++) {
+        for (i = 0; i < TEST_BATCH_FRAME_COUNT; i++, timestamp += TEST_LONG_FRAME_DURATION) {
+            frames[i].index = j * TEST_BATCH_FRAME_COUNT + i;
+            frames[i].decodingTs = timestamp;
+            frames[i].presentationTs = timestamp;
+            frames[i].duration = TEST_LONG_FRAME_DURATION;
+            frames[i].size = SIZEOF(tempBuffer);
+            frames[i].trackId = TEST_TRACKID;
+            frames[i].frameData = tempBuffer;
+            frames[i].flags = i == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        }
+
+        ATOMIC_STORE(&mStreamDataAvailableFuncCount, 0);
+        if (j == 2) {
+            // A bad frame in the middle of the batch doesn't prevent the rest of the batch from being put
+            frames[5].trackId = TEST_TRACKID + 1;
+            EXPECT_EQ(STATUS_MKV_TRACK_INFO_NOT_FOUND, putKinesisVideoFrames(mStreamHandle, frames, TEST_BATCH_FRAME_COUNT, frameStatuses));
+        } else {
+            EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrames(mStreamHandle, frames, TEST_BATCH_FRAME_COUNT, frameStatuses));
+        }
+
+        for (i = 0; i < TEST_BATCH_FRAME_COUNT; i++) {
+            EXPECT_EQ(j == 2 && i == 5 ? STATUS_MKV_TRACK_INFO_NOT_FOUND : STATUS_SUCCESS, frameStatuses[i]);
+        }
+
+        if (j == 0) {
+            // The first batch starts the streaming
+            EXPECT_EQ(0, ATOMIC_LOAD(&mStreamDataAvailableFuncCount));
+            EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+        } else {
+            // The data available is notified once per batch
+            EXPECT_EQ(1, ATOMIC_LOAD(&mStreamDataAvailableFuncCount));
+        }
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(5 * TEST_BATCH_FRAME_COUNT - 1, itemCount);
+
+    // The per-frame statuses are optional
+    for (i = 0; i < TEST_BATCH_FRAME_COUNT; i++, timestamp += TEST_LONG_FRAME_DURATION) {
+        frames[i].decodingTs = timestamp;
+        frames[i].presentationTs = timestamp;
+        frames[i].trackId = TEST_TRACKID;
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrames(mStreamHandle, frames, TEST_BATCH_FRAME_COUNT, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(6 * TEST_BATCH_FRAME_COUNT - 1, itemCount);
+#undef TEST_BATCH_FRAME_COUNT
+}
+
+#define TEST_LOCKED_BATCH_FRAME_COUNT 10
+
+static TID gTrackedLockTid;
+static MUTEX gTrackedLocks[2];
+static volatile SIZE_T gTrackedLockDepths[2];
+static volatile SIZE_T gTrackedLockReleaseCounts[2];
+
+static VOID trackingLockMutexFunc(UINT64 customData, MUTEX mutex)
+{
+    UINT32 i;
+
+    UNUSED_PARAM(customData);
+    MUTEX_LOCK(mutex);
+    for (i = 0; i < ARRAY_SIZE(gTrackedLocks); i++) {
+        if (mutex == gTrackedLocks[i] && GETTID() == gTrackedLockTid) {
+            ATOMIC_INCREMENT(&gTrackedLockDepths[i]);
+        }
+    }
+}
+
+static VOID trackingUnlockMutexFunc(UINT64 customData, MUTEX mutex)
+{
+    UINT32 i;
+
+    UNUSED_PARAM(customData);
+    for (i = 0; i < ARRAY_SIZE(gTrackedLocks); i++) {
+        if (mutex == gTrackedLocks[i] && GETTID() == gTrackedLockTid) {
+            ATOMIC_DECREMENT(&gTrackedLockDepths[i]);
+            if (ATOMIC_LOAD(&gTrackedLockDepths[i]) == 0) {
+                ATOMIC_INCREMENT(&gTrackedLockReleaseCounts[i]);
+            }
+        }
+    }
+
+    MUTEX_UNLOCK(mutex);
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrames_BatchHoldsStreamAndStoreLocks)
+{
+    UINT32 i;
+    BYTE tempBuffer[1000];
+    Frame frames[TEST_LOCKED_BATCH_FRAME_COUNT];
+    UINT64 itemCount, windowItemCount;
+    PKinesisVideoStream pKinesisVideoStream;
+    PKinesisVideoClient pKinesisVideoClient;
+    ClientCallbacks clientCallbacks;
+
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+    pKinesisVideoClient = pKinesisVideoStream->pKinesisVideoClient;
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    for (i = 0; i < TEST_LOCKED_BATCH_FRAME_COUNT; i++) {
+        frames[i].version = FRAME_CURRENT_VERSION;
+        frames[i].index = i;
+        frames[i].decodingTs = frames[i].presentationTs = i * TEST_FRAME_DURATION;
+        frames[i].duration = TEST_FRAME_DURATION;
+        frames[i].size = SIZEOF(tempBuffer);
+        frames[i].trackId = TEST_TRACKID;
+        frames[i].frameData = tempBuffer;
+        frames[i].flags = i == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+    }
+
+    // Count the full releases of the stream and the store arena locks by the putting thread
+    gTrackedLockTid = GETTID();
+    gTrackedLocks[0] = pKinesisVideoStream->base.lock;
+    gTrackedLocks[1] = pKinesisVideoStream->pStoreArena->lock;
+    for (i = 0; i < ARRAY_SIZE(gTrackedLocks); i++) {
+        ATOMIC_STORE(&gTrackedLockDepths[i], 0);
+        ATOMIC_STORE(&gTrackedLockReleaseCounts[i], 0);
+    }
+
+    clientCallbacks = pKinesisVideoClient->clientCallbacks;
+    pKinesisVideoClient->clientCallbacks.lockMutexFn = trackingLockMutexFunc;
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn = trackingUnlockMutexFunc;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrames(mStreamHandle, frames, TEST_LOCKED_BATCH_FRAME_COUNT, NULL));
+    pKinesisVideoClient->clientCallbacks = clientCallbacks;
+
+    // The batch holds the locks from the first frame to the last
+    for (i = 0; i < ARRAY_SIZE(gTrackedLocks); i++) {
+        EXPECT_EQ(0, ATOMIC_LOAD(&gTrackedLockDepths[i]));
+        EXPECT_EQ(1, ATOMIC_LOAD(&gTrackedLockReleaseCounts[i]));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(TEST_LOCKED_BATCH_FRAME_COUNT, itemCount);
+}
+
+#undef TEST_LOCKED_BATCH_FRAME_COUNT
+
+#define TEST_OFFLINE_BATCH_FRAME_COUNT 11
+
+typedef struct {
+    STREAM_HANDLE streamHandle;
+    PFrame pFrames;
+    STATUS frameStatuses[TEST_OFFLINE_BATCH_FRAME_COUNT];
+    STATUS retStatus;
+} OfflineBatch, *POfflineBatch;
+
+static PVOID putOfflineBatchRoutine(PVOID args)
+{
+    POfflineBatch pOfflineBatch = (POfflineBatch) args;
+
+    pOfflineBatch->retStatus =
+        putKinesisVideoFrames(pOfflineBatch->streamHandle, pOfflineBatch->pFrames, TEST_OFFLINE_BATCH_FRAME_COUNT, pOfflineBatch->frameStatuses);
+
+    return NULL;
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrames_OfflineBatchWaitsForAvailability)
+{
+    UINT32 i;
+    BYTE tempBuffer[1000];
+    Frame frame, frames[TEST_OFFLINE_BATCH_FRAME_COUNT];
+    FragmentAck fragmentAck;
+    OfflineBatch offlineBatch;
+    UINT64 itemCount, windowItemCount, startTime, timeout;
+    PKinesisVideoStream pKinesisVideoStream;
+    TID threadId;
+
+    // The buffer fits ten frames of two fragments
+    mStreamInfo.retention = 10 * HUNDREDS_OF_NANOS_IN_AN_HOUR;
+    mStreamInfo.streamCaps.streamingType = STREAMING_TYPE_OFFLINE;
+    mStreamInfo.streamCaps.bufferDuration = 10 * TEST_LONG_FRAME_DURATION;
+
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+    timeout = pKinesisVideoStream->pKinesisVideoClient->deviceInfo.clientInfo.offlineBufferAvailabilityTimeout;
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.frameData = tempBuffer;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+
+    // The first frame starts the streaming
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+
+    // The last frame of the batch doesn't fit until the first fragment is persisted
+    for (i = 0; i < TEST_OFFLINE_BATCH_FRAME_COUNT; i++) {
+        frame.index = i + 1;
+        frame.decodingTs = frame.presentationTs = (i + 1) * TEST_LONG_FRAME_DURATION;
+        frame.flags = (i + 1) % 5 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        frames[i] = frame;
+    }
+
+    offlineBatch.streamHandle = mStreamHandle;
+    offlineBatch.pFrames = frames;
+    offlineBatch.retStatus = STATUS_INTERNAL_ERROR;
+    startTime = GETTIME();
+    EXPECT_EQ(STATUS_SUCCESS, THREAD_CREATE(&threadId, putOfflineBatchRoutine, (PVOID) &offlineBatch));
+
+    // Wait for the batch to block on the availability
+    do {
+        THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    } while (windowItemCount < 10 && GETTIME() < startTime + timeout);
+
+    EXPECT_EQ(10, windowItemCount);
+
+    // The blocked batch doesn't hold the stream so the ACK gets through and frees up the first fragment
+    fragmentAck.version = FRAGMENT_ACK_CURRENT_VERSION;
+    fragmentAck.ackType = FRAGMENT_ACK_TYPE_PERSISTED;
+    fragmentAck.result = SERVICE_CALL_RESULT_OK;
+    STRCPY(fragmentAck.sequenceNumber, "SequenceNumber");
+    fragmentAck.timestamp = 0;
+    EXPECT_EQ(STATUS_SUCCESS, kinesisVideoStreamFragmentAck(mStreamHandle, TEST_UPLOAD_HANDLE, &fragmentAck));
+
+    EXPECT_EQ(STATUS_SUCCESS, THREAD_JOIN(threadId, NULL));
+    EXPECT_GT(startTime + timeout, GETTIME());
+    EXPECT_EQ(STATUS_SUCCESS, offlineBatch.retStatus);
+    for (i = 0; i < TEST_OFFLINE_BATCH_FRAME_COUNT; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, offlineBatch.frameStatuses[i]);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(TEST_OFFLINE_BATCH_FRAME_COUNT + 1 - 5, windowItemCount);
+}
+
+#undef TEST_OFFLINE_BATCH_FRAME_COUNT
+
+TEST_F(StreamApiFunctionalityTest, putFrame_LacedAudioFrames)
+{
+    UINT32 i;
+    BYTE tempBuffer[1000];
+    Frame frame;
+    TrackInfo trackInfos[2];
+    UINT64 itemCount, windowItemCount;
+    PKinesisVideoStream pKinesisVideoStream;
+    PViewItem pViewItem;
+
+    // Video track followed by an audio track laced in 100ms windows
+    trackInfos[0] = mTrackInfo;
+    trackInfos[1] = mTrackInfo;
+    trackInfos[1].trackId = TEST_TRACKID + 1;
+    trackInfos[1].trackType = MKV_TRACK_INFO_TYPE_AUDIO;
+    trackInfos[1].trackCustomData.trackAudioConfig.channelConfig = 2;
+    trackInfos[1].trackCustomData.trackAudioConfig.samplingFrequency = 48000;
+    trackInfos[1].trackCustomData.trackAudioConfig.bitDepth = 0;
+    mStreamInfo.streamCaps.trackInfoList = trackInfos;
+    mStreamInfo.streamCaps.trackInfoCount = 2;
+    mStreamInfo.streamCaps.audioLacingDuration = 5 * TEST_FRAME_DURATION;
+
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.duration = TEST_FRAME_DURATION;
+    frame.frameData = tempBuffer;
+
+    // Video key frame
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+    // Two full windows of the audio frames
+    frame.size = 100;
+    frame.trackId = TEST_TRACKID + 1;
+    frame.flags = FRAME_FLAG_NONE;
+    for (i = 0; i < 10; i++) {
+        frame.decodingTs = frame.presentationTs = i * TEST_FRAME_DURATION;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(3, itemCount);
+
+    for (i = 1; i < 3; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        EXPECT_EQ((i - 1) * 5 * TEST_FRAME_DURATION, pViewItem->timestamp);
+        EXPECT_EQ(5 * TEST_FRAME_DURATION, pViewItem->duration);
+        EXPECT_EQ(MKV_SIMPLE_BLOCK_BITS_SIZE + 1 + 5 * 100, pViewItem->length);
+    }
+
+    // The partial window is put ahead of the following video frame
+    for (i = 10; i < 13; i++) {
+        frame.decodingTs = frame.presentationTs = i * TEST_FRAME_DURATION;
+        frame.size = 100 + i;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(3, itemCount);
+
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(5, itemCount);
+
+    // EBML laced with the size of the first frame and the two differences
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, 3, &pViewItem));
+    EXPECT_EQ(10 * TEST_FRAME_DURATION, pViewItem->timestamp);
+    EXPECT_EQ(3 * TEST_FRAME_DURATION, pViewItem->duration);
+    EXPECT_EQ(MKV_SIMPLE_BLOCK_BITS_SIZE + 3 + 110 + 111 + 112, pViewItem->length);
+
+    // The pending lace is put on stop
+    frame.decodingTs = frame.presentationTs = 13 * TEST_FRAME_DURATION;
+    frame.size = 100;
+    frame.trackId = TEST_TRACKID + 1;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(5, itemCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStream(mStreamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, 5, &pViewItem));
+    EXPECT_EQ(13 * TEST_FRAME_DURATION, pViewItem->timestamp);
+    EXPECT_EQ(MKV_SIMPLE_BLOCK_BITS_SIZE + 100, pViewItem->length);
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrame_PartialLacePutOnTimer)
+{
+    UINT32 i, j;
+    BYTE tempBuffer[1000];
+    Frame frame;
+    TrackInfo trackInfos[2];
+    UINT64 itemCount, windowItemCount, startTime;
+    PKinesisVideoStream pKinesisVideoStream;
+    PViewItem pViewItem;
+
+    // Video track followed by an audio track laced in 100ms windows
+    trackInfos[0] = mTrackInfo;
+    trackInfos[1] = mTrackInfo;
+    trackInfos[1].trackId = TEST_TRACKID + 1;
+    trackInfos[1].trackType = MKV_TRACK_INFO_TYPE_AUDIO;
+    trackInfos[1].trackCustomData.trackAudioConfig.channelConfig = 2;
+    trackInfos[1].trackCustomData.trackAudioConfig.samplingFrequency = 48000;
+    trackInfos[1].trackCustomData.trackAudioConfig.bitDepth = 0;
+    mStreamInfo.streamCaps.trackInfoList = trackInfos;
+    mStreamInfo.streamCaps.trackInfoCount = 2;
+    mStreamInfo.streamCaps.audioLacingDuration = 5 * TEST_FRAME_DURATION;
+
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+    EXPECT_TRUE(IS_VALID_MUTEX_VALUE(FROM_CLIENT_HANDLE(mClientHandle)->laceTimers.lock));
+    EXPECT_FALSE(FROM_CLIENT_HANDLE(mClientHandle)->laceTimers.timerStarted);
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.duration = TEST_FRAME_DURATION;
+    frame.frameData = tempBuffer;
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+    frame.size = 100;
+    frame.trackId = TEST_TRACKID + 1;
+    frame.flags = FRAME_FLAG_NONE;
+    for (j = 0; j < 2; j++) {
+        // Two frames of the window and the producer goes idle
+        for (i = 0; i < 2; i++) {
+            frame.decodingTs = frame.presentationTs = (j * 5 + i) * TEST_FRAME_DURATION;
+            EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+        EXPECT_EQ(1 + j, windowItemCount);
+
+        if (j == 0) {
+            // The lace is kept within the lacing duration and put past it
+            EXPECT_EQ(STATUS_SUCCESS, flushExpiredLacedFrames(pKinesisVideoStream, pKinesisVideoStream->lacedFrames.startTime));
+            EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+            EXPECT_EQ(1, windowItemCount);
+
+            EXPECT_EQ(STATUS_SUCCESS,
+                      flushExpiredLacedFrames(pKinesisVideoStream,
+                                              pKinesisVideoStream->lacedFrames.startTime + mStreamInfo.streamCaps.audioLacingDuration));
+        } else {
+            // The timer puts the lace
+            startTime = GETTIME();
+            do {
+                THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+                EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+            } while (windowItemCount < 3 && GETTIME() < startTime + HUNDREDS_OF_NANOS_IN_A_SECOND);
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+        EXPECT_EQ(2 + j, windowItemCount);
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, 1 + j, &pViewItem));
+        EXPECT_EQ(j * 5 * TEST_FRAME_DURATION, pViewItem->timestamp);
+        EXPECT_EQ(2 * TEST_FRAME_DURATION, pViewItem->duration);
+        EXPECT_EQ(MKV_SIMPLE_BLOCK_BITS_SIZE + 1 + 2 * 100, pViewItem->length);
+    }
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrame_LaceTimerStopsWhenNotLacing)
+{
+    UINT32 i, timerCount, clientTimerCount;
+    BYTE tempBuffer[1000];
+    Frame frame;
+    TrackInfo trackInfos[2];
+    UINT64 itemCount, windowItemCount, startTime;
+    PKinesisVideoClient pKinesisVideoClient;
+    PKinesisVideoStream pKinesisVideoStream;
+
+    trackInfos[0] = mTrackInfo;
+    trackInfos[1] = mTrackInfo;
+    trackInfos[1].trackId = TEST_TRACKID + 1;
+    trackInfos[1].trackType = MKV_TRACK_INFO_TYPE_AUDIO;
+    trackInfos[1].trackCustomData.trackAudioConfig.channelConfig = 2;
+    trackInfos[1].trackCustomData.trackAudioConfig.samplingFrequency = 48000;
+    trackInfos[1].trackCustomData.trackAudioConfig.bitDepth = 0;
+    mStreamInfo.streamCaps.trackInfoList = trackInfos;
+    mStreamInfo.streamCaps.trackInfoCount = 2;
+    mStreamInfo.streamCaps.audioLacingDuration = 5 * TEST_FRAME_DURATION;
+
+    ReadyStream();
+    pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+    EXPECT_EQ(STATUS_SUCCESS,
+              timerQueueGetTimersWithCustomData(pKinesisVideoClient->timerQueueHandle, (UINT64) pKinesisVideoClient, &clientTimerCount, NULL));
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.duration = TEST_FRAME_DURATION;
+    frame.frameData = tempBuffer;
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+    // The video frames are not laced so no deadline is armed
+    EXPECT_FALSE(pKinesisVideoStream->laceTimerArmed);
+    EXPECT_FALSE(pKinesisVideoClient->laceTimers.timerStarted);
+
+    // The first laced audio frame arms the deadline and starts the timer
+    frame.size = 100;
+    frame.trackId = TEST_TRACKID + 1;
+    frame.flags = FRAME_FLAG_NONE;
+    for (i = 0; i < 2; i++) {
+        frame.decodingTs = frame.presentationTs = i * TEST_FRAME_DURATION;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+        EXPECT_TRUE(pKinesisVideoStream->laceTimerArmed);
+    }
+
+    EXPECT_TRUE(pKinesisVideoClient->laceTimers.timerStarted);
+    EXPECT_EQ(STATUS_SUCCESS,
+              timerQueueGetTimersWithCustomData(pKinesisVideoClient->timerQueueHandle, (UINT64) pKinesisVideoClient, &timerCount, NULL));
+    EXPECT_EQ(clientTimerCount + 1, timerCount);
+
+    EXPECT_EQ(pKinesisVideoStream->lacedFrames.startTime + mStreamInfo.streamCaps.audioLacingDuration, pKinesisVideoStream->laceDeadline);
+    EXPECT_EQ(pKinesisVideoClient->laceTimers.pHead, pKinesisVideoStream);
+
+    // The timer puts the lace at the deadline and stops as no stream laces any more
+    startTime = GETTIME();
+    do {
+        THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        EXPECT_EQ(STATUS_SUCCESS,
+                  timerQueueGetTimersWithCustomData(pKinesisVideoClient->timerQueueHandle, (UINT64) pKinesisVideoClient, &timerCount, NULL));
+    } while ((timerCount != clientTimerCount || pKinesisVideoClient->laceTimers.timerStarted) &&
+             GETTIME() < startTime + HUNDREDS_OF_NANOS_IN_A_SECOND);
+
+    EXPECT_EQ(clientTimerCount, timerCount);
+    EXPECT_FALSE(pKinesisVideoClient->laceTimers.timerStarted);
+    EXPECT_FALSE(pKinesisVideoStream->laceTimerArmed);
+    EXPECT_TRUE(pKinesisVideoClient->laceTimers.pHead == NULL);
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(2, windowItemCount);
+
+    // The next lace starts the timer again
+    frame.decodingTs = frame.presentationTs = 5 * TEST_FRAME_DURATION;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    EXPECT_TRUE(pKinesisVideoStream->laceTimerArmed);
+    EXPECT_TRUE(pKinesisVideoClient->laceTimers.timerStarted);
+
+    // Stopping puts the lace and disarms the deadline
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStream(mStreamHandle));
+    EXPECT_FALSE(pKinesisVideoStream->laceTimerArmed);
+}
+
+typedef struct {
+    STREAM_HANDLE streamHandle;
+    Frame frame;
+    STATUS retStatus;
+} BlockedPutFrame, *PBlockedPutFrame;
+
+static PVOID putBlockedFrameRoutine(PVOID args)
+{
+    PBlockedPutFrame pBlockedPutFrame = (PBlockedPutFrame) args;
+
+    pBlockedPutFrame->retStatus = putKinesisVideoFrame(pBlockedPutFrame->streamHandle, &pBlockedPutFrame->frame);
+
+    return NULL;
+}
+
+TEST_F(StreamApiFunctionalityTest, putFrame_OfflineLaceFlushWaitsForAvailability)
+{
+    UINT32 i;
+    BYTE tempBuffer[1000];
+    Frame frame;
+    TrackInfo trackInfos[2];
+    FragmentAck fragmentAck;
+    BlockedPutFrame blockedPutFrame;
+    UINT64 itemCount, windowItemCount, startTime, timeout;
+    PKinesisVideoStream pKinesisVideoStream;
+    PViewItem pViewItem;
+    TID threadId;
+
+    // Video track followed by an audio track laced in 100ms windows. The buffer fits ten video frames of two fragments.
+    trackInfos[0] = mTrackInfo;
+    trackInfos[1] = mTrackInfo;
+    trackInfos[1].trackId = TEST_TRACKID + 1;
+    trackInfos[1].trackType = MKV_TRACK_INFO_TYPE_AUDIO;
+    trackInfos[1].trackCustomData.trackAudioConfig.channelConfig = 2;
+    trackInfos[1].trackCustomData.trackAudioConfig.samplingFrequency = 48000;
+    trackInfos[1].trackCustomData.trackAudioConfig.bitDepth = 0;
+    mStreamInfo.streamCaps.trackInfoList = trackInfos;
+    mStreamInfo.streamCaps.trackInfoCount = 2;
+    mStreamInfo.streamCaps.audioLacingDuration = 5 * TEST_FRAME_DURATION;
+    mStreamInfo.retention = 10 * HUNDREDS_OF_NANOS_IN_AN_HOUR;
+    mStreamInfo.streamCaps.streamingType = STREAMING_TYPE_OFFLINE;
+    mStreamInfo.streamCaps.bufferDuration = 10 * TEST_LONG_FRAME_DURATION;
+
+    ReadyStream();
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+    timeout = pKinesisVideoStream->pKinesisVideoClient->deviceInfo.clientInfo.offlineBufferAvailabilityTimeout;
+
+    MEMSET(tempBuffer, 0x5a, SIZEOF(tempBuffer));
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.frameData = tempBuffer;
+
+    // Fill up the buffer with the video frames
+    for (i = 0; i < 10; i++) {
+        frame.decodingTs = frame.presentationTs = i * TEST_LONG_FRAME_DURATION;
+        frame.flags = i % 5 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+        if (i == 0) {
+            EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+        }
+    }
+
+    // The partial lace is pending
+    frame.duration = TEST_FRAME_DURATION;
+    frame.size = 100;
+    frame.trackId = TEST_TRACKID + 1;
+    frame.flags = FRAME_FLAG_NONE;
+    for (i = 0; i < 3; i++) {
+        frame.decodingTs = frame.presentationTs = 10 * TEST_LONG_FRAME_DURATION + i * TEST_FRAME_DURATION;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    // The following video frame puts the lace which blocks on the availability
+    frame.decodingTs = frame.presentationTs = 10 * TEST_LONG_FRAME_DURATION + 3 * TEST_FRAME_DURATION;
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.trackId = TEST_TRACKID;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    blockedPutFrame.streamHandle = mStreamHandle;
+    blockedPutFrame.frame = frame;
+    blockedPutFrame.retStatus = STATUS_INTERNAL_ERROR;
+    startTime = GETTIME();
+    EXPECT_EQ(STATUS_SUCCESS, THREAD_CREATE(&threadId, putBlockedFrameRoutine, (PVOID) &blockedPutFrame));
+    THREAD_SLEEP(50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(10, windowItemCount);
+
+    // The ACK gets through the stream while the lace is waiting and frees up the first fragment
+    fragmentAck.version = FRAGMENT_ACK_CURRENT_VERSION;
+    fragmentAck.ackType = FRAGMENT_ACK_TYPE_PERSISTED;
+    fragmentAck.result = SERVICE_CALL_RESULT_OK;
+    STRCPY(fragmentAck.sequenceNumber, "SequenceNumber");
+    fragmentAck.timestamp = 0;
+    EXPECT_EQ(STATUS_SUCCESS, kinesisVideoStreamFragmentAck(mStreamHandle, TEST_UPLOAD_HANDLE, &fragmentAck));
+
+    EXPECT_EQ(STATUS_SUCCESS, THREAD_JOIN(threadId, NULL));
+    EXPECT_GT(startTime + timeout, GETTIME());
+    EXPECT_EQ(STATUS_SUCCESS, blockedPutFrame.retStatus);
+
+    // The lace is followed by the video frame
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowItemCount(pKinesisVideoStream->pView, &itemCount, &windowItemCount));
+    EXPECT_EQ(7, windowItemCount);
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, 10, &pViewItem));
+    EXPECT_EQ(10 * TEST_LONG_FRAME_DURATION, pViewItem->timestamp);
+    EXPECT_EQ(3 * TEST_FRAME_DURATION, pViewItem->duration);
+}
+
 extern UINT64 gPresetCurrentTime;
 TEST_F(StreamApiFunctionalityTest, streamingTokenJitter_none)
 {
@@ -599,6 +599,96 @@ TEST_F(StreamApiTest, kinesisVideoGetData_NULL_Invalid)
     MEMFREE(pBuffer);
 }
 
+TEST_F(StreamApiTest, kinesisVideoGetDataSegments_NULL_Invalid)
+{
+    STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
+    StreamDataSegment segments[MAX_STREAM_DATA_SEGMENT_COUNT];
+    UINT32 segmentCount, fillSize;
+
+    // Create a stream
+    CreateStream();
+
+    EXPECT_TRUE(
+        STATUS_FAILED(getKinesisVideoStreamDataSegments(streamHandle, TEST_UPLOAD_HANDLE, 1000, segments, ARRAY_SIZE(segments), &segmentCount, &fillSize)));
+    EXPECT_TRUE(STATUS_FAILED(
+        getKinesisVideoStreamDataSegments(mStreamHandle, INVALID_UPLOAD_HANDLE_VALUE, 1000, segments, ARRAY_SIZE(segments), &segmentCount, &fillSize)));
+    EXPECT_TRUE(STATUS_FAILED(getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, 1000, NULL, ARRAY_SIZE(segments), &segmentCount, &fillSize)));
+    EXPECT_TRUE(STATUS_FAILED(getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, 1000, segments, 0, &segmentCount, &fillSize)));
+    EXPECT_TRUE(STATUS_FAILED(getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, 0, segments, ARRAY_SIZE(segments), &segmentCount, &fillSize)));
+    EXPECT_TRUE(STATUS_FAILED(getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, 1000, segments, ARRAY_SIZE(segments), NULL, &fillSize)));
+    EXPECT_TRUE(
+        STATUS_FAILED(getKinesisVideoStreamDataSegments(mStreamHandle, TEST_UPLOAD_HANDLE, 1000, segments, ARRAY_SIZE(segments), &segmentCount, NULL)));
+
+    EXPECT_TRUE(STATUS_FAILED(releaseKinesisVideoStreamDataSegments(streamHandle)));
+    EXPECT_EQ(STATUS_STREAM_DATA_SEGMENTS_NOT_OUTSTANDING, releaseKinesisVideoStreamDataSegments(mStreamHandle));
+}
+
+TEST_F(StreamApiTest, putKinesisVideoFrames_NULL_Invalid)
+{
+    STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
+    Frame frames[2];
+    STATUS frameStatuses[2];
+    BYTE tempBuffer[100];
+
+    // Create a stream
+    CreateStream();
+
+    MEMSET(frames, 0x00, SIZEOF(frames));
+    frames[0].frameData = frames[1].frameData = tempBuffer;
+    frames[0].size = frames[1].size = SIZEOF(tempBuffer);
+    frames[0].trackId = frames[1].trackId = TEST_TRACKID;
+    frames[0].flags = frames[1].flags = FRAME_FLAG_KEY_FRAME;
+    frames[1].decodingTs = frames[1].presentationTs = TEST_FRAME_DURATION;
+
+    EXPECT_TRUE(STATUS_FAILED(putKinesisVideoFrames(streamHandle, frames, ARRAY_SIZE(frames), frameStatuses)));
+    EXPECT_TRUE(STATUS_FAILED(putKinesisVideoFrames(mStreamHandle, NULL, ARRAY_SIZE(frames), frameStatuses)));
+    EXPECT_EQ(STATUS_INVALID_ARG, putKinesisVideoFrames(mStreamHandle, frames, 0, frameStatuses));
+
+    // Stopped stream fails all of the frames
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStream(mStreamHandle));
+    EXPECT_EQ(STATUS_STREAM_HAS_BEEN_STOPPED, putKinesisVideoFrames(mStreamHandle, frames, ARRAY_SIZE(frames), frameStatuses));
+    EXPECT_EQ(STATUS_STREAM_HAS_BEEN_STOPPED, frameStatuses[0]);
+    EXPECT_EQ(STATUS_STREAM_HAS_BEEN_STOPPED, frameStatuses[1]);
+}
+
+TEST_F(StreamApiTest, kinesisVideoAcquireFrameBuffer_NULL_Invalid)
+{
+    STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
+    Frame frame;
+    PBYTE pBuffer;
+    UINT32 bufferSize;
+
+    // Create a stream
+    CreateStream();
+
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.trackId = TEST_TRACKID;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+
+    EXPECT_TRUE(STATUS_FAILED(acquireKinesisVideoFrameBuffer(streamHandle, &frame, &pBuffer, &bufferSize)));
+    EXPECT_TRUE(STATUS_FAILED(acquireKinesisVideoFrameBuffer(mStreamHandle, NULL, &pBuffer, &bufferSize)));
+    EXPECT_TRUE(STATUS_FAILED(acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, NULL, &bufferSize)));
+    EXPECT_TRUE(STATUS_FAILED(acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, &pBuffer, NULL)));
+
+    // No max frame size has been seen yet
+    EXPECT_EQ(STATUS_INVALID_ARG, acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, &pBuffer, &bufferSize));
+
+    frame.size = 1000;
+    frame.trackId = TEST_TRACKID + 1;
+    EXPECT_TRUE(STATUS_FAILED(acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, &pBuffer, &bufferSize)));
+
+    frame.trackId = TEST_TRACKID;
+    frame.flags = FRAME_FLAG_END_OF_FRAGMENT;
+    EXPECT_EQ(STATUS_INVALID_ARG, acquireKinesisVideoFrameBuffer(mStreamHandle, &frame, &pBuffer, &bufferSize));
+
+    EXPECT_TRUE(STATUS_FAILED(commitKinesisVideoFrame(streamHandle, &frame)));
+    EXPECT_TRUE(STATUS_FAILED(commitKinesisVideoFrame(mStreamHandle, NULL)));
+    EXPECT_EQ(STATUS_FRAME_BUFFER_NOT_ACQUIRED, commitKinesisVideoFrame(mStreamHandle, &frame));
+
+    EXPECT_TRUE(STATUS_FAILED(discardKinesisVideoFrameBuffer(streamHandle)));
+    EXPECT_EQ(STATUS_FRAME_BUFFER_NOT_ACQUIRED, discardKinesisVideoFrameBuffer(mStreamHandle));
+}
+
 TEST_F(StreamApiTest, kinesisVideoStreamFormatChanged_NULL_Invalid)
 {
     STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
@@ -1734,4 +1734,280 @@ TEST_F(StreamPutGetTest, putFrame_PutGetPersistentTagsStoreData)
 
     MEMFREE(getDataBuffer);
 }
-#endif
\ No newline at end of file
+#endif
+
+TEST_F(StreamPutGetTest, putFrame_PersistentStorageResumeAfterRestart)
+{
+    UINT32 i, j, filledSize, offset, bufferSize;
+    BOOL validPattern, exists;
+    BYTE tempBuffer[1000];
+    BYTE getDataBuffer[2000];
+    UINT64 timestamp;
+    Frame frame;
+    PHeap pHeap;
+
+    // Re-create the client with the persistent storage
+    freeKinesisVideoClient(&mClientHandle);
+    mDeviceInfo.storageInfo.storageType = DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE;
+    mDeviceInfo.storageInfo.spillRatio = 50;
+    mStreamInfo.streamCaps.absoluteFragmentTimes = TRUE;
+    mStreamInfo.streamCaps.keyFrameFragmentation = TRUE;
+    CreateClient();
+    ReadyStream();
+
+    // Produce frames which are never sent
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.frameData = tempBuffer;
+    frame.trackId = TEST_TRACKID;
+    for (i = 0, timestamp = 0; i < 30; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        MEMSET(frame.frameData, (BYTE) i, SIZEOF(tempBuffer));
+        frame.flags = i % 10 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    // Restart. The in-memory content is moved to the files on the stream teardown
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) "." FPATHSEPARATOR_STR "Test stream name.kvsj", &exists));
+    EXPECT_TRUE(exists);
+
+    ATOMIC_STORE(&mDescribeStreamFuncCount, 0);
+    ATOMIC_STORE(&mGetStreamingEndpointFuncCount, 0);
+    ATOMIC_STORE(&mGetStreamingTokenFuncCount, 0);
+    ATOMIC_STORE(&mPutStreamFuncCount, 0);
+    CreateClient();
+    ReadyStream();
+
+    // The replayed journal replaces the previous one
+    EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) "." FPATHSEPARATOR_STR "Test stream name.kvsj", &exists));
+    EXPECT_TRUE(exists);
+    EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) "." FPATHSEPARATOR_STR "Test stream name.kvsj.tmp", &exists));
+    EXPECT_FALSE(exists);
+
+    // Produce a new frame to kick off the streaming
+    frame.index = i;
+    frame.decodingTs = timestamp;
+    frame.presentationTs = timestamp;
+    MEMSET(frame.frameData, (BYTE) i, SIZEOF(tempBuffer));
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    EXPECT_EQ(1, ATOMIC_LOAD(&mPutStreamFuncCount));
+    EXPECT_EQ(STATUS_SUCCESS, putStreamResultEvent(mCallContext.customData, SERVICE_CALL_RESULT_OK, TEST_UPLOAD_HANDLE));
+
+    // The content of the previous run should be sent first
+    for (i = 0; i < 30; i++) {
+        if (i == 0) {
+            offset = mkvgenGetMkvHeaderOverhead((PStreamMkvGenerator) FROM_STREAM_HANDLE(mStreamHandle)->pMkvGenerator);
+        } else if (i % 10 == 0) {
+            offset = MKV_CLUSTER_OVERHEAD;
+        } else {
+            offset = MKV_SIMPLE_BLOCK_OVERHEAD;
+        }
+
+        bufferSize = SIZEOF(tempBuffer) + offset;
+        EXPECT_EQ(STATUS_SUCCESS, getKinesisVideoStreamData(mStreamHandle, TEST_UPLOAD_HANDLE, getDataBuffer, bufferSize, &filledSize));
+        EXPECT_EQ(bufferSize, filledSize);
+
+        validPattern = TRUE;
+        for (j = 0; j < SIZEOF(tempBuffer); j++) {
+            if (getDataBuffer[offset + j] != i) {
+                validPattern = FALSE;
+                break;
+            }
+        }
+
+        EXPECT_TRUE(validPattern) << "Failed at offset: " << j << " from the beginning of frame: " << i;
+    }
+
+    // Clean up the persisted files
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    EXPECT_EQ(0, FREMOVE("." FPATHSEPARATOR_STR "Test stream name.kvsj"));
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(TEST_DEVICE_STORAGE_SIZE, 50, FILE_BASED_HEAP_FLAGS, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(StreamPutGetTest, putFrame_PersistentStorageReleaseUnjournaledContent)
+{
+    UINT32 i;
+    BYTE tempBuffer[1000];
+    UINT64 timestamp, heapUsage;
+    Frame frame;
+    PHeap pHeap;
+
+    // Re-create the client with the persistent storage
+    freeKinesisVideoClient(&mClientHandle);
+    mDeviceInfo.storageInfo.storageType = DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE;
+    mDeviceInfo.storageInfo.spillRatio = 50;
+    mStreamInfo.streamCaps.absoluteFragmentTimes = TRUE;
+    mStreamInfo.streamCaps.keyFrameFragmentation = TRUE;
+    CreateClient();
+    ReadyStream();
+
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.frameData = tempBuffer;
+    frame.trackId = TEST_TRACKID;
+    for (i = 0, timestamp = 0; i < 30; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        MEMSET(frame.frameData, (BYTE) i, SIZEOF(tempBuffer));
+        frame.flags = i % 10 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    // Lose the journal of the persisted content
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    EXPECT_EQ(0, FREMOVE("." FPATHSEPARATOR_STR "Test stream name.kvsj"));
+
+    // The content nobody re-attaches to is released on the client creation
+    CreateClient();
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(FROM_CLIENT_HANDLE(mClientHandle)->pHeap, &heapUsage));
+    EXPECT_EQ(0, heapUsage);
+
+    // Clean up the persisted files
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(TEST_DEVICE_STORAGE_SIZE, 50, FILE_BASED_HEAP_FLAGS, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(StreamPutGetTest, putFrame_PersistentStorageJournalWrittenOnFragmentBoundaries)
+{
+    UINT32 i;
+    BYTE tempBuffer[1000];
+    UINT64 timestamp, fileSize;
+    Frame frame;
+    PHeap pHeap;
+    PKinesisVideoClient pKinesisVideoClient;
+    PKinesisVideoStream pKinesisVideoStream;
+
+    // Re-create the client with the persistent storage
+    freeKinesisVideoClient(&mClientHandle);
+    mDeviceInfo.storageInfo.storageType = DEVICE_STORAGE_TYPE_PERSISTENT_HYBRID_FILE;
+    mDeviceInfo.storageInfo.spillRatio = 50;
+    mStreamInfo.streamCaps.absoluteFragmentTimes = TRUE;
+    mStreamInfo.streamCaps.keyFrameFragmentation = TRUE;
+    CreateClient();
+    ReadyStream();
+
+    pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    // Hold the stream lock to keep the storage tiering timer from writing the journal
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.frameData = tempBuffer;
+    frame.trackId = TEST_TRACKID;
+    for (i = 0, timestamp = 0; i < 11; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        frame.flags = i % 10 == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+
+        // Only the fragment start record is written until the next fragment starts
+        EXPECT_EQ(STATUS_SUCCESS, getFileLength((PCHAR) "." FPATHSEPARATOR_STR "Test stream name.kvsj", &fileSize));
+        EXPECT_EQ(SIZEOF(StreamJournalHeader) + (i == 10 ? 11 : 1) * SIZEOF(ViewItem), fileSize) << i;
+        EXPECT_EQ(i == 10 ? 0 : i, pKinesisVideoStream->pJournal->dirtyCount) << i;
+    }
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+
+    // Clean up the persisted files
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&mClientHandle));
+    EXPECT_EQ(0, FREMOVE("." FPATHSEPARATOR_STR "Test stream name.kvsj"));
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(TEST_DEVICE_STORAGE_SIZE, 50, FILE_BASED_HEAP_FLAGS, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(StreamPutGetTest, putFrame_HybridFileStorageDemotionResumesFromCursor)
+{
+    const UINT32 FrameCount = 10;
+    UINT32 i;
+    BYTE tempBuffer[1000];
+    UINT64 timestamp;
+    Frame frame;
+    PViewItem pViewItem;
+    ALLOCATION_HANDLE handles[FrameCount], usageHandle;
+    PKinesisVideoClient pKinesisVideoClient;
+    PKinesisVideoStream pKinesisVideoStream;
+
+    // Re-create the client with the hybrid file storage
+    freeKinesisVideoClient(&mClientHandle);
+    mDeviceInfo.storageInfo.storageType = DEVICE_STORAGE_TYPE_HYBRID_FILE;
+    mDeviceInfo.storageInfo.spillRatio = 50;
+    CreateClient();
+    ReadyStream();
+
+    pKinesisVideoClient = FROM_CLIENT_HANDLE(mClientHandle);
+    pKinesisVideoStream = FROM_STREAM_HANDLE(mStreamHandle);
+
+    frame.duration = TEST_LONG_FRAME_DURATION;
+    frame.size = SIZEOF(tempBuffer);
+    frame.frameData = tempBuffer;
+    frame.trackId = TEST_TRACKID;
+    for (i = 0, timestamp = 0; i < FrameCount; timestamp += TEST_LONG_FRAME_DURATION, i++) {
+        frame.index = i;
+        frame.decodingTs = timestamp;
+        frame.presentationTs = timestamp;
+        frame.flags = i == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        EXPECT_EQ(STATUS_SUCCESS, putKinesisVideoFrame(mStreamHandle, &frame));
+    }
+
+    // Hold the locks to keep the storage tiering timer out and treat the first half of the frames as sent
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+    pKinesisVideoClient->clientCallbacks.lockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    EXPECT_EQ(STATUS_SUCCESS, contentViewSetCurrentIndex(pKinesisVideoStream->pView, FrameCount / 2));
+
+    for (i = 0; i < FrameCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        handles[i] = pViewItem->handle;
+    }
+
+    // Nothing is demoted below the watermark and the cursor stays at the first item left in memory
+    EXPECT_EQ(STATUS_SUCCESS, demoteSentViewItems(pKinesisVideoStream, STORAGE_TIERING_MEMORY_WATERMARK));
+    EXPECT_EQ(0, pKinesisVideoStream->demoteIndex);
+    for (i = 0; i < FrameCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        EXPECT_EQ(handles[i], pViewItem->handle) << i;
+    }
+
+    // The items left in memory by the previous pass are demoted once the in-memory tier usage rises above the watermark
+    EXPECT_EQ(STATUS_SUCCESS,
+              heapAlloc(pKinesisVideoStream->pStoreArena->pHeap, TEST_DEVICE_STORAGE_SIZE / 2 * (STORAGE_TIERING_MEMORY_WATERMARK + 5) / 100,
+                        &usageHandle));
+    EXPECT_EQ(STATUS_SUCCESS, demoteSentViewItems(pKinesisVideoStream, STORAGE_TIERING_MEMORY_WATERMARK));
+    EXPECT_EQ(FrameCount / 2, pKinesisVideoStream->demoteIndex);
+    for (i = 0; i < FrameCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        if (i < FrameCount / 2) {
+            EXPECT_NE(handles[i], pViewItem->handle) << i;
+            handles[i] = pViewItem->handle;
+        } else {
+            EXPECT_EQ(handles[i], pViewItem->handle) << i;
+        }
+    }
+
+    // The newly sent items are demoted and the cursor moves up to the current without touching the demoted ones
+    EXPECT_EQ(STATUS_SUCCESS, contentViewSetCurrentIndex(pKinesisVideoStream->pView, FrameCount));
+    EXPECT_EQ(STATUS_SUCCESS, demoteSentViewItems(pKinesisVideoStream, STORAGE_TIERING_MEMORY_WATERMARK));
+    EXPECT_EQ(FrameCount, pKinesisVideoStream->demoteIndex);
+    for (i = 0; i < FrameCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(pKinesisVideoStream->pView, i, &pViewItem));
+        if (i < FrameCount / 2) {
+            EXPECT_EQ(handles[i], pViewItem->handle) << i;
+        } else {
+            EXPECT_NE(handles[i], pViewItem->handle) << i;
+        }
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pKinesisVideoStream->pStoreArena->pHeap, usageHandle));
+
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->pStoreArena->lock);
+    pKinesisVideoClient->clientCallbacks.unlockMutexFn(pKinesisVideoClient->clientCallbacks.customData, pKinesisVideoStream->base.lock);
+}
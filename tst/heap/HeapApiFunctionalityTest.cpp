@@ -53,6 +53,36 @@ VOID multipleMapUnmapByteAlloc(PHeap pHeap)
     EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
 }
 
+VOID mapReadOnlyAlloc(PHeap pHeap)
+{
+    ALLOCATION_HANDLE handle = INVALID_ALLOCATION_HANDLE_VALUE;
+    PVOID pAlloc, pReadOnly;
+    UINT64 size;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(pHeap, 1000, &handle)));
+    EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapMap(pHeap, handle, &pAlloc, &size)));
+    MEMSET(pAlloc, 'r', (SIZE_T) size);
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapUnmap(pHeap, pAlloc)));
+
+    // Read-only mappings should observe the content and can be interleaved with read-write ones
+    for (UINT32 i = 0; i < NUM_ITERATIONS; i++) {
+        EXPECT_TRUE(STATUS_SUCCEEDED(heapMapReadOnly(pHeap, handle, &pReadOnly, &size)));
+        EXPECT_EQ(size, 1000);
+        EXPECT_TRUE(MEMCHK(pReadOnly, 'r', (SIZE_T) size));
+
+        EXPECT_TRUE(STATUS_SUCCEEDED(heapMap(pHeap, handle, &pAlloc, &size)));
+        EXPECT_TRUE(MEMCHK(pAlloc, 'r', (SIZE_T) size));
+        EXPECT_TRUE(STATUS_SUCCEEDED(heapUnmap(pHeap, pAlloc)));
+
+        EXPECT_TRUE(STATUS_SUCCEEDED(heapUnmapReadOnly(pHeap, pReadOnly)));
+    }
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapFree(pHeap, handle)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
+}
+
 VOID multipleLargeAlloc(PHeap pHeap)
 {
     ALLOCATION_HANDLE handle = INVALID_ALLOCATION_HANDLE_VALUE;
@@ -684,3 +714,103 @@ TEST_F(HeapApiFunctionalityTest, MultipleMapUnmapByteAlloc)
     EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_SYSTEM_HEAP, NULL, &pHeap)));
     multipleMapUnmapByteAlloc(pHeap);
 }
+
+TEST_F(HeapApiFunctionalityTest, MapReadOnlyAlloc)
+{
+    PHeap pHeap;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP, NULL, &pHeap)));
+    mapReadOnlyAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_SYSTEM_HEAP, NULL, &pHeap)));
+    mapReadOnlyAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap)));
+    mapReadOnlyAlloc(pHeap);
+}
+
+TEST_F(HeapApiFunctionalityTest, AivHeapSizeClassedAlloc)
+{
+    PHeap pHeap;
+    UINT32 heapFlags = FLAGS_USE_AIV_HEAP | FLAGS_USE_AIV_HEAP_SIZE_CLASSES;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, heapFlags, NULL, &pHeap)));
+    singleByteAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, heapFlags, NULL, &pHeap)));
+    multipleLargeAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, heapFlags, NULL, &pHeap)));
+    minBlockFitAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, heapFlags, NULL, &pHeap)));
+    minBlockFitAllocResize(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, heapFlags, NULL, &pHeap)));
+    blockCoalesceAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, heapFlags, NULL, &pHeap)));
+    defragmentationAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, heapFlags, NULL, &pHeap)));
+    multipleMapUnmapByteAlloc(pHeap);
+}
+
+TEST_F(HeapApiFunctionalityTest, AivHeapSizeClassedRandomAllocFree)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handles[NUM_ITERATIONS];
+    UINT32 i, index;
+    UINT64 size;
+
+    zeroHandleArray(handles, NUM_ITERATIONS);
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP | FLAGS_USE_AIV_HEAP_SIZE_CLASSES, NULL, &pHeap));
+
+    // Randomly allocate, resize and free blocks of various size classes validating the bins along the way
+    for (i = 0; i < NUM_ITERATIONS * 100; i++) {
+        index = RAND() % NUM_ITERATIONS;
+        size = 1 + RAND() % (MIN_HEAP_SIZE / NUM_ITERATIONS / 4);
+
+        if (!IS_VALID_ALLOCATION_HANDLE(handles[index])) {
+            EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handles[index]));
+        } else if (i % 3 == 0) {
+            EXPECT_EQ(STATUS_SUCCESS, heapSetAllocSize(pHeap, &handles[index], size));
+        } else {
+            EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[index]));
+            handles[index] = INVALID_ALLOCATION_HANDLE_VALUE;
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    }
+
+    for (i = 0; i < NUM_ITERATIONS; i++) {
+        if (IS_VALID_ALLOCATION_HANDLE(handles[i])) {
+            EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+        }
+    }
+
+    // Everything should be coalesced back into a single free block
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    EXPECT_EQ(((PAivHeap) pHeap)->freeBinBitmap & (((PAivHeap) pHeap)->freeBinBitmap - 1), 0);
+    EXPECT_TRUE(((PAivHeap) pHeap)->pAlloc == NULL);
+    EXPECT_TRUE(((PAivHeap) pHeap)->freeBins[getFreeBinIndex(MIN_HEAP_SIZE - aivGetAllocationHeaderSize() - aivGetAllocationFooterSize())] != NULL);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(HeapApiFunctionalityTest, RingHeapAlloc)
+{
+    PHeap pHeap;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap)));
+    singleLargeAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap)));
+    singleByteAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap)));
+    multipleLargeAlloc(pHeap);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap)));
+    multipleMapUnmapByteAlloc(pHeap);
+}
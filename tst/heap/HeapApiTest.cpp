@@ -68,6 +68,8 @@ TEST_F(HeapApiTest, InvalidInputHeapInitialize_HeapTypeFlags)
     EXPECT_TRUE(STATUS_FAILED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_HYBRID_VRAM_HEAP | FLAGS_REOPEN_VRAM_LIBRARY, NULL, &pHeap)));
     EXPECT_TRUE(STATUS_FAILED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_HYBRID_FILE_HEAP, NULL, &pHeap)));
     EXPECT_TRUE(STATUS_FAILED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_HYBRID_FILE_HEAP | FLAGS_REOPEN_VRAM_LIBRARY, NULL, &pHeap)));
+    EXPECT_TRUE(STATUS_FAILED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP | FLAGS_USE_RING_HEAP, NULL, &pHeap)));
+    EXPECT_TRUE(STATUS_FAILED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_SYSTEM_HEAP | FLAGS_USE_RING_HEAP, NULL, &pHeap)));
 }
 
 TEST_F(HeapApiTest, IdempotentHeapRelease_NullHeapRelease)
@@ -314,6 +316,76 @@ TEST_F(HeapApiTest, InvalidHeapUnmap_InvalidAllocation)
     EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
 }
 
+TEST_F(HeapApiTest, InvalidHeapMapReadOnly_InvalidParams)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handle;
+    PVOID pAlloc;
+    UINT64 size;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP, NULL, &pHeap)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(pHeap, 1000, &handle)));
+    EXPECT_TRUE(STATUS_FAILED(heapMapReadOnly(NULL, handle, &pAlloc, &size)));
+    EXPECT_TRUE(STATUS_FAILED(heapMapReadOnly(pHeap, INVALID_ALLOCATION_HANDLE_VALUE, &pAlloc, &size)));
+    EXPECT_TRUE(STATUS_FAILED(heapMapReadOnly(pHeap, handle, NULL, &size)));
+    EXPECT_TRUE(STATUS_FAILED(heapMapReadOnly(pHeap, handle, &pAlloc, NULL)));
+    EXPECT_TRUE(STATUS_FAILED(heapUnmapReadOnly(NULL, (PVOID) 12345)));
+    EXPECT_TRUE(STATUS_FAILED(heapUnmapReadOnly(pHeap, NULL)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapFree(pHeap, handle)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
+}
+
+TEST_F(HeapApiTest, InvalidHeapDemote_InvalidParams)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handle, invalidHandle = INVALID_ALLOCATION_HANDLE_VALUE;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP, NULL, &pHeap)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(pHeap, 1000, &handle)));
+    EXPECT_TRUE(STATUS_FAILED(heapDemote(NULL, &handle, 50, NULL)));
+    EXPECT_TRUE(STATUS_FAILED(heapDemote(pHeap, NULL, 50, NULL)));
+    EXPECT_TRUE(STATUS_FAILED(heapDemote(pHeap, &invalidHandle, 50, NULL)));
+    EXPECT_TRUE(STATUS_FAILED(heapDemote(pHeap, &handle, 101, NULL)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapFree(pHeap, handle)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
+}
+
+TEST_F(HeapApiTest, InvalidHeapCheckPersisted_InvalidParams)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handle;
+    BOOL persisted = TRUE;
+
+    // Persistence is only supported by the hybrid file heap
+    EXPECT_EQ(STATUS_HEAP_FLAGS_ERROR, heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP | FLAGS_PERSIST_HYBRID_FILE_HEAP, NULL, &pHeap));
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP, NULL, &pHeap)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(pHeap, 1000, &handle)));
+    EXPECT_TRUE(STATUS_FAILED(heapCheckPersisted(NULL, handle, &persisted)));
+    EXPECT_TRUE(STATUS_FAILED(heapCheckPersisted(pHeap, handle, NULL)));
+    EXPECT_TRUE(STATUS_FAILED(heapCheckPersisted(pHeap, INVALID_ALLOCATION_HANDLE_VALUE, &persisted)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapCheckPersisted(pHeap, handle, &persisted)));
+    EXPECT_FALSE(persisted);
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapFree(pHeap, handle)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
+}
+
+TEST_F(HeapApiTest, InvalidHeapReleaseUnclaimed_InvalidParams)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handle;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_AIV_HEAP, NULL, &pHeap)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(pHeap, 1000, &handle)));
+    EXPECT_TRUE(STATUS_FAILED(heapReleaseUnclaimed(NULL, &handle, 1)));
+    EXPECT_TRUE(STATUS_FAILED(heapReleaseUnclaimed(pHeap, NULL, 1)));
+
+    // The non-persistent heaps don't have any recovered allocations
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapReleaseUnclaimed(pHeap, NULL, 0)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapFree(pHeap, handle)));
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
+}
+
 TEST_F(HeapApiTest, InvalidFileHeapCreate_InvalidParams)
 {
     PHeap pHeap = NULL;
@@ -344,7 +416,9 @@ TEST_F(HeapApiTest, InvalidHeapResize_InvalidValues)
                           FLAGS_USE_AIV_HEAP | FLAGS_USE_HYBRID_VRAM_HEAP,
                           FLAGS_USE_SYSTEM_HEAP | FLAGS_USE_HYBRID_VRAM_HEAP,
                           FLAGS_USE_AIV_HEAP | FLAGS_USE_HYBRID_FILE_HEAP,
-                          FLAGS_USE_SYSTEM_HEAP | FLAGS_USE_HYBRID_FILE_HEAP};
+                          FLAGS_USE_SYSTEM_HEAP | FLAGS_USE_HYBRID_FILE_HEAP,
+                          FLAGS_USE_RING_HEAP,
+                          FLAGS_USE_RING_HEAP | FLAGS_USE_HYBRID_FILE_HEAP};
 
     for (UINT32 heapType = 0; heapType < ARRAY_SIZE(heapTypes); heapType++) {
         EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, heapTypes[heapType], NULL, &pHeap));
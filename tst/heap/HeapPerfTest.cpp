@@ -10,6 +10,14 @@ class HeapPerfTest : public HeapTestBase {};
 #define HEAP_PERF_TEST_ITERATION_COUNT            1000000
 #define HEAP_PERF_TEST_MULTI_VIEW_ITERATION_COUNT 10000000
 #define HEAP_PERF_TEST_SIZE                       256 * 1024 * 1024
+#define HEAP_PERF_TEST_FRAGMENT_HOLE_SIZE         128
+#define HEAP_PERF_TEST_FRAGMENT_PIN_SIZE          16
+#define HEAP_PERF_TEST_FRAGMENTED_VIEW_ITEM_COUNT 300
+#define HEAP_PERF_TEST_FRAGMENTED_FRAME_COUNT     1000000
+#define HEAP_PERF_TEST_AUDIO_FRAME_SIZE           200
+#define HEAP_PERF_TEST_VIDEO_FRAME_SIZE           20000
+#define HEAP_PERF_TEST_KEY_FRAME_SIZE             300000
+#define HEAP_PERF_TEST_KEY_FRAME_RATE             30
 
 VOID randomAllocFree(PHeap pHeap, UINT32 itemCount, UINT32 iterationCount, UINT32 allocSize)
 {
@@ -41,6 +49,66 @@ VOID singleAllocFree(PHeap pHeap)
     }
 }
 
+/**
+ * Leaves the given number of small free fragments in the heap which can't be coalesced
+ * as each of them is surrounded by the allocated 'pins'.
+ */
+VOID fragmentHeap(PHeap pHeap, UINT32 fragmentCount, PALLOCATION_HANDLE pins)
+{
+    PALLOCATION_HANDLE holes = (PALLOCATION_HANDLE) MEMALLOC(fragmentCount * SIZEOF(ALLOCATION_HANDLE) + 1);
+    ASSERT_TRUE(holes != NULL);
+
+    UINT32 i;
+
+    for (i = 0; i < fragmentCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, HEAP_PERF_TEST_FRAGMENT_HOLE_SIZE, &holes[i]));
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, HEAP_PERF_TEST_FRAGMENT_PIN_SIZE, &pins[i]));
+    }
+
+    for (i = 0; i < fragmentCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, holes[i]));
+    }
+
+    MEMFREE(holes);
+}
+
+/**
+ * Simulates a windowed audio/video stream with small audio frames, medium frames and periodic large key frames
+ */
+VOID streamAllocFree(PHeap pHeap, UINT32 itemCount, UINT32 frameCount)
+{
+    PALLOCATION_HANDLE handles = (PALLOCATION_HANDLE) MEMALLOC(itemCount * SIZEOF(ALLOCATION_HANDLE));
+    ASSERT_TRUE(handles != NULL);
+
+    UINT32 i, size;
+
+    for (i = 0; i < frameCount; i++) {
+        if (i % HEAP_PERF_TEST_KEY_FRAME_RATE == 0) {
+            size = HEAP_PERF_TEST_KEY_FRAME_SIZE;
+        } else if (i % 2 == 0) {
+            size = HEAP_PERF_TEST_AUDIO_FRAME_SIZE;
+        } else {
+            size = HEAP_PERF_TEST_VIDEO_FRAME_SIZE;
+        }
+
+        size += RAND() % HEAP_PERF_TEST_ALLOCATION_DELTA;
+
+        if (i >= itemCount) {
+            // Free the oldest allocation first as the content view would do
+            EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i % itemCount]));
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handles[i % itemCount]));
+        EXPECT_NE(INVALID_ALLOCATION_HANDLE_VALUE, handles[i % itemCount]) << "Failed on iteration " << i;
+    }
+
+    for (i = 0; i < MIN(itemCount, frameCount); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+    }
+
+    MEMFREE(handles);
+}
+
 ///////////////////////////////////////////////////////////////
 // Below are the heap perf tests which should not being
 // executed on small footprint devices due to limited
@@ -183,3 +251,51 @@ TEST_F(HeapPerfTest, singleAllocFreePerf)
     // we should be within 20% of the system heap speed at least 50% of the time
     EXPECT_TRUE(successCount >= (totalIteration / 2));
 }
+
+TEST_F(HeapPerfTest, sizeClassedFragmentedAllocFreePerf)
+{
+    PHeap pHeap;
+    UINT64 time, endTime;
+    UINT32 fragmentCounts[] = {0, 10000, 100000};
+    DOUBLE frameDurations[ARRAY_SIZE(fragmentCounts)];
+    PALLOCATION_HANDLE pins = (PALLOCATION_HANDLE) MEMALLOC(fragmentCounts[ARRAY_SIZE(fragmentCounts) - 1] * SIZEOF(ALLOCATION_HANDLE));
+    UINT32 totalIteration = 10, sleepBetweenIteration = 2 * HUNDREDS_OF_NANOS_IN_A_SECOND, successCount = 0, i = 0, j, k;
+
+    ASSERT_TRUE(pins != NULL);
+
+    for (; i < totalIteration; i++) {
+        for (j = 0; j < ARRAY_SIZE(fragmentCounts); j++) {
+            EXPECT_EQ(STATUS_SUCCESS, heapInitialize(HEAP_PERF_TEST_SIZE, 20, FLAGS_USE_AIV_HEAP | FLAGS_USE_AIV_HEAP_SIZE_CLASSES, NULL, &pHeap));
+            fragmentHeap(pHeap, fragmentCounts[j], pins);
+
+            time = GETTIME();
+            streamAllocFree(pHeap, HEAP_PERF_TEST_FRAGMENTED_VIEW_ITEM_COUNT, HEAP_PERF_TEST_FRAGMENTED_FRAME_COUNT);
+            endTime = GETTIME();
+
+            for (k = 0; k < fragmentCounts[j]; k++) {
+                EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, pins[k]));
+            }
+
+            EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+            EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+
+            frameDurations[j] = (DOUBLE) (endTime - time) / HEAP_PERF_TEST_FRAGMENTED_FRAME_COUNT;
+            DLOGI("Size-class allocator with %u free fragments, time per frame: %lf nanos", fragmentCounts[j],
+                  frameDurations[j] * DEFAULT_TIME_UNIT_IN_NANOS);
+        }
+
+        // The time per frame should stay flat regardless of the number of the free fragments
+        if (frameDurations[ARRAY_SIZE(fragmentCounts) - 1] <= frameDurations[0] * 1.5) {
+            successCount++;
+        }
+
+        EXPECT_TRUE(frameDurations[ARRAY_SIZE(fragmentCounts) - 1] <= frameDurations[0] * 3.0);
+
+        THREAD_SLEEP(sleepBetweenIteration);
+    }
+
+    MEMFREE(pins);
+
+    // we should be within 50% of the non-fragmented heap speed at least 50% of the time
+    EXPECT_TRUE(successCount >= (totalIteration / 2));
+}
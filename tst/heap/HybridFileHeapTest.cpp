@@ -1,5 +1,10 @@
 #include "HeapTestFixture.h"
 
+#if defined __linux__
+#include <signal.h>
+#include <sys/resource.h>
+#endif
+
 using ::testing::Bool;
 using ::testing::Combine;
 using ::testing::Values;
@@ -21,6 +26,27 @@ class HybridFileHeapTest : public HeapTestBase, public WithParamInterface<::std:
         mHeapType = primaryHeapType | FLAGS_USE_HYBRID_FILE_HEAP;
     }
 
+    VOID validateSegmentFiles(UINT64 fileHeapLimit)
+    {
+        CHAR filePath[MAX_PATH_LEN + 1];
+        BOOL exist = FALSE;
+        UINT64 fileSize = 0;
+
+        // The file heap limit should be covered by a single segment file
+        SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, FILE_HEAP_DEFAULT_ROOT_DIRECTORY, FPATHSEPARATOR,
+                 FILE_HEAP_STARTING_FILE_INDEX);
+        EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &exist));
+        EXPECT_EQ(TRUE, exist);
+        EXPECT_EQ(STATUS_SUCCESS, getFileLength(filePath, &fileSize));
+        EXPECT_EQ(FILE_HEAP_PACKED_SIZE(fileHeapLimit), fileSize);
+
+        // No per-allocation files should be created
+        SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, FILE_HEAP_DEFAULT_ROOT_DIRECTORY, FPATHSEPARATOR,
+                 FILE_HEAP_STARTING_FILE_INDEX + 1);
+        EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &exist));
+        EXPECT_EQ(FALSE, exist);
+    }
+
     UINT32 mHeapType;
 };
 
@@ -38,15 +64,14 @@ TEST_P(HybridFileHeapTest, hybridFileHeapOperationsAivPrimaryHeap)
     UINT32 spillRatio = 50;
     UINT32 numAlloc = AllocationCount / 2;
     UINT32 i, fileHandleIndex, skip;
-    CHAR filePath[MAX_PATH_LEN + 1];
-    BOOL exist;
-    UINT64 fileSize, allocSize, retAllocSize;
+    UINT64 allocSize, retAllocSize;
     PVOID pAlloc;
 
     // Split the 50% and allocate half from ram and half from file heap
     memHeapLimit = (UINT32) (heapSize * ((DOUBLE) spillRatio / 100));
     fileHeapLimit = heapSize - memHeapLimit;
-    fileAllocSize = fileHeapLimit / numAlloc;
+    // Leave room for the per-block file heap overhead as the file heap is bounded by its own limit
+    fileAllocSize = fileHeapLimit / numAlloc - FILE_HEAP_MIN_FREE_BLOCK_SIZE;
     ramAllocSize = memHeapLimit / numAlloc;
 
     // Set the invalid allocation handles
@@ -77,15 +102,8 @@ TEST_P(HybridFileHeapTest, hybridFileHeapOperationsAivPrimaryHeap)
         handles[fileHandleIndex] = handle;
     }
 
-    // Validate the allocations
-    for (i = 0; i < numAlloc; i++) {
-        SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, FILE_HEAP_DEFAULT_ROOT_DIRECTORY, FPATHSEPARATOR, i + 1);
-        exist = FALSE;
-        EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &exist));
-        EXPECT_EQ(TRUE, exist);
-        EXPECT_EQ(STATUS_SUCCESS, getFileLength(filePath, &fileSize));
-        EXPECT_EQ(fileAllocSize + SIZEOF(ALLOCATION_HEADER), fileSize);
-    }
+    // Validate the allocations are carved out of a single segment file
+    validateSegmentFiles(fileHeapLimit);
 
     // Try to map, read, write, unmap, map again and verify
     for (i = 0; i < AllocationCount - 1; i++) {
@@ -132,17 +150,9 @@ TEST_P(HybridFileHeapTest, hybridFileHeapOperationsAivPrimaryHeap)
         EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
     }
 
-    // Validate the allocations
-    for (i = 0; i < numAlloc; i++) {
-        SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, FILE_HEAP_DEFAULT_ROOT_DIRECTORY, FPATHSEPARATOR, i + 1);
-        exist = FALSE;
-        EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &exist));
-        EXPECT_EQ(TRUE, exist);
-        EXPECT_EQ(STATUS_SUCCESS, getFileLength(filePath, &fileSize));
-
-        // After the modifications, we increased the size by 1 and decreased by 2 so the diff is minus 1
-        EXPECT_EQ(fileAllocSize + SIZEOF(ALLOCATION_HEADER) - 1, fileSize);
-    }
+    // Resizing shouldn't affect the segment files
+    validateSegmentFiles(fileHeapLimit);
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
 
     // Free odd allocations in case of AIV heap and all of the allocations in case of system heap
     skip = (mHeapType & FLAGS_USE_SYSTEM_HEAP) != HEAP_FLAGS_NONE ? 1 : 2;
@@ -156,6 +166,426 @@ TEST_P(HybridFileHeapTest, hybridFileHeapOperationsAivPrimaryHeap)
     EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(pHeap)));
 }
 
+TEST_P(HybridFileHeapTest, hybridFileHeapFreeCoalesce)
+{
+    const UINT32 AllocationCount = 10;
+    PHeap pHeap;
+    PHybridFileHeap pHybridHeap;
+    ALLOCATION_HANDLE handle, handles[AllocationCount];
+    UINT32 heapSize = MIN_HEAP_SIZE * 2;
+    UINT32 fileHeapLimit = heapSize - (UINT32) (heapSize * ((DOUBLE) 50 / 100));
+    UINT32 allocSize = fileHeapLimit / AllocationCount - FILE_HEAP_MIN_FREE_BLOCK_SIZE;
+    UINT32 i;
+    UINT64 retAllocSize;
+    PVOID pAlloc;
+
+    // Spill everything to the file heap by exhausting the memory heap first
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    do {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &handle));
+    } while (IS_DIRECT_ALLOCATION_HANDLE(handle));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handle));
+
+    for (i = 0; i < AllocationCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &handles[i]));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handles[i]));
+        EXPECT_FALSE(IS_DIRECT_ALLOCATION_HANDLE(handles[i]));
+
+        EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handles[i], &pAlloc, &retAllocSize));
+        MEMSET(pAlloc, 'a' + i, retAllocSize);
+        EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
+    }
+
+    // Free every other allocation and make sure the rest of the content is intact
+    for (i = 0; i < AllocationCount; i += 2) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+        handles[i] = INVALID_ALLOCATION_HANDLE_VALUE;
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    // Freed blocks should be reused
+    for (i = 0; i < AllocationCount; i += 2) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize / 2, &handles[i]));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handles[i]));
+    }
+
+    for (i = 1; i < AllocationCount; i += 2) {
+        EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handles[i], &pAlloc, &retAllocSize));
+        EXPECT_EQ(allocSize, retAllocSize);
+        EXPECT_TRUE(MEMCHK(pAlloc, 'a' + i, (SIZE_T) retAllocSize));
+        EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
+    }
+
+    // Free everything - the blocks should coalesce back
+    for (i = 0; i < AllocationCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    pHybridHeap = (PHybridFileHeap) pHeap;
+    EXPECT_EQ(FILE_HEAP_PACKED_SIZE(fileHeapLimit), pHybridHeap->pBlocks[pHybridHeap->freeBlock].size);
+
+    // Invalid handles should be rejected
+    EXPECT_NE(STATUS_SUCCESS, heapFree(pHeap, handles[1]));
+    EXPECT_NE(STATUS_SUCCESS, heapMap(pHeap, FROM_FILE_HANDLE(AllocationCount * 100), &pAlloc, &retAllocSize));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_P(HybridFileHeapTest, hybridFileHeapSegmentMappedOnFirstUse)
+{
+    PHeap pHeap;
+    PHybridFileHeap pHybridHeap;
+    ALLOCATION_HANDLE handle;
+    CHAR filePath[MAX_PATH_LEN + 1];
+    BOOL exist = TRUE;
+    UINT32 heapSize = MIN_HEAP_SIZE * 2;
+    UINT32 fileHeapLimit = heapSize - (UINT32) (heapSize * ((DOUBLE) 50 / 100));
+
+    SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, FILE_HEAP_DEFAULT_ROOT_DIRECTORY, FPATHSEPARATOR,
+             FILE_HEAP_STARTING_FILE_INDEX);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    pHybridHeap = (PHybridFileHeap) pHeap;
+
+    // The segments cover the file heap limit only and nothing is mapped until the memory heap spills
+    EXPECT_EQ(fileHeapLimit, pHybridHeap->fileHeapLimit);
+    EXPECT_EQ(1, pHybridHeap->segmentCount);
+    EXPECT_EQ(NULL, pHybridHeap->pSegmentMappings[0]);
+    EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &exist));
+    EXPECT_FALSE(exist);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, 1000, &handle));
+    EXPECT_TRUE(IS_DIRECT_ALLOCATION_HANDLE(handle));
+    EXPECT_EQ(NULL, pHybridHeap->pSegmentMappings[0]);
+
+    do {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, 1000, &handle));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+    } while (IS_DIRECT_ALLOCATION_HANDLE(handle));
+
+    EXPECT_NE((PBYTE) NULL, pHybridHeap->pSegmentMappings[0]);
+    validateSegmentFiles(fileHeapLimit);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+#if defined __linux__
+TEST_P(HybridFileHeapTest, hybridFileHeapSegmentReservationFailure)
+{
+    PHeap pHeap;
+    PHybridFileHeap pHybridHeap;
+    ALLOCATION_HANDLE handle;
+    struct rlimit limit, savedLimit;
+    struct stat fileStat;
+    CHAR filePath[MAX_PATH_LEN + 1];
+    UINT32 heapSize = MIN_HEAP_SIZE * 2;
+    STATUS retStatus;
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    pHybridHeap = (PHybridFileHeap) pHeap;
+
+    // Emulate the volume being too small to back the segment
+    EXPECT_EQ(0, getrlimit(RLIMIT_FSIZE, &savedLimit));
+    limit = savedLimit;
+    limit.rlim_cur = 4096;
+    signal(SIGXFSZ, SIG_IGN);
+    EXPECT_EQ(0, setrlimit(RLIMIT_FSIZE, &limit));
+
+    // The spilling allocation fails rather than the store into the unbacked mapping later on
+    do {
+        handle = INVALID_ALLOCATION_HANDLE_VALUE;
+        retStatus = heapAlloc(pHeap, 1000, &handle);
+    } while (retStatus == STATUS_SUCCESS && IS_DIRECT_ALLOCATION_HANDLE(handle));
+
+    EXPECT_EQ(STATUS_NOT_ENOUGH_MEMORY, retStatus);
+    EXPECT_FALSE(IS_VALID_ALLOCATION_HANDLE(handle));
+    EXPECT_EQ((PBYTE) NULL, pHybridHeap->pSegmentMappings[0]);
+
+    EXPECT_EQ(0, setrlimit(RLIMIT_FSIZE, &savedLimit));
+    signal(SIGXFSZ, SIG_DFL);
+
+    // The segment is reserved and mapped once the space is available
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, 1000, &handle));
+    EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+    EXPECT_FALSE(IS_DIRECT_ALLOCATION_HANDLE(handle));
+    EXPECT_NE((PBYTE) NULL, pHybridHeap->pSegmentMappings[0]);
+    validateSegmentFiles(pHybridHeap->fileHeapLimit);
+
+    // The segment file is not sparse
+    SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, FILE_HEAP_DEFAULT_ROOT_DIRECTORY, FPATHSEPARATOR,
+             FILE_HEAP_STARTING_FILE_INDEX);
+    EXPECT_EQ(0, stat(filePath, &fileStat));
+    EXPECT_LE(FILE_HEAP_PACKED_SIZE(pHybridHeap->fileHeapLimit), (UINT64) fileStat.st_blocks * 512);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+#endif
+
+TEST_P(HybridFileHeapTest, hybridFileHeapZeroCopyMap)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handle;
+    UINT32 heapSize = MIN_HEAP_SIZE * 2;
+    UINT32 allocSize = 10000;
+    UINT64 retAllocSize;
+    PVOID pAlloc, pAlloc2;
+
+    // Spill to the file heap by exhausting the memory heap first
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    do {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &handle));
+    } while (IS_DIRECT_ALLOCATION_HANDLE(handle));
+
+    EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+
+    // Mapping should return the same pointer into the mapped segment
+    EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handle, &pAlloc, &retAllocSize));
+    EXPECT_EQ(allocSize, retAllocSize);
+    EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handle, &pAlloc2, &retAllocSize));
+    EXPECT_EQ(pAlloc, pAlloc2);
+
+    // The changes should be visible through the other mapping without un-mapping first
+    MEMSET(pAlloc, 'z', allocSize);
+    EXPECT_TRUE(MEMCHK(pAlloc2, 'z', allocSize));
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc2));
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
+
+    // Read-only mapping should point to the same content
+    EXPECT_EQ(STATUS_SUCCESS, heapMapReadOnly(pHeap, handle, &pAlloc2, &retAllocSize));
+    EXPECT_EQ(pAlloc, pAlloc2);
+    EXPECT_TRUE(MEMCHK(pAlloc2, 'z', allocSize));
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmapReadOnly(pHeap, pAlloc2));
+
+    // Shrinking is done in place
+    EXPECT_EQ(STATUS_SUCCESS, heapSetAllocSize(pHeap, &handle, allocSize / 2));
+    EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handle, &pAlloc2, &retAllocSize));
+    EXPECT_EQ(pAlloc, pAlloc2);
+    EXPECT_EQ(allocSize / 2, retAllocSize);
+    EXPECT_TRUE(MEMCHK(pAlloc2, 'z', (SIZE_T) retAllocSize));
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc2));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_P(HybridFileHeapTest, hybridFileHeapDemote)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handle, origHandle;
+    UINT32 heapSize = MIN_HEAP_SIZE * 2;
+    UINT32 allocSize = 10000;
+    UINT64 retAllocSize, heapUsage, demotedHeapUsage;
+    PVOID pAlloc;
+    BOOL demoted;
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &handle));
+    EXPECT_TRUE(IS_DIRECT_ALLOCATION_HANDLE(handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handle, &pAlloc, &retAllocSize));
+    MEMSET(pAlloc, 'd', allocSize);
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapUsage));
+
+    // The memory heap is way below the watermark so the allocation should stay in memory
+    origHandle = handle;
+    EXPECT_EQ(STATUS_SUCCESS, heapDemote(pHeap, &handle, 100, &demoted));
+    EXPECT_EQ(origHandle, handle);
+    EXPECT_FALSE(demoted);
+
+    // Zero watermark forces the demotion with the content and the accounting preserved
+    EXPECT_EQ(STATUS_SUCCESS, heapDemote(pHeap, &handle, 0, &demoted));
+    EXPECT_TRUE(demoted);
+    EXPECT_FALSE(IS_DIRECT_ALLOCATION_HANDLE(handle));
+    EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &demotedHeapUsage));
+    EXPECT_EQ(heapUsage, demotedHeapUsage);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetAllocSize(pHeap, handle, &retAllocSize));
+    EXPECT_EQ(allocSize, retAllocSize);
+    EXPECT_EQ(STATUS_SUCCESS, heapMapReadOnly(pHeap, handle, &pAlloc, &retAllocSize));
+    EXPECT_EQ(allocSize, retAllocSize);
+    EXPECT_TRUE(MEMCHK(pAlloc, 'd', allocSize));
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmapReadOnly(pHeap, pAlloc));
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    // Demoting the file allocation is a no-op reported as demoted
+    origHandle = handle;
+    demoted = FALSE;
+    EXPECT_EQ(STATUS_SUCCESS, heapDemote(pHeap, &handle, 0, &demoted));
+    EXPECT_EQ(origHandle, handle);
+    EXPECT_TRUE(demoted);
+
+    // The memory should be reusable after the demotion
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &origHandle));
+    EXPECT_TRUE(IS_DIRECT_ALLOCATION_HANDLE(origHandle));
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, origHandle));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapUsage));
+    EXPECT_EQ(0, heapUsage);
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_P(HybridFileHeapTest, hybridFileHeapPersistentRecovery)
+{
+    const UINT32 AllocationCount = 100;
+    PHeap pHeap;
+    ALLOCATION_HANDLE handles[AllocationCount], directHandle, handle;
+    UINT32 heapSize = MIN_HEAP_SIZE * 4;
+    UINT32 allocSize = 10000;
+    UINT32 i;
+    UINT64 retAllocSize, heapUsage, recoveredHeapUsage;
+    PVOID pAlloc;
+    BOOL persisted, exist;
+    CHAR filePath[MAX_PATH_LEN + 1];
+
+    // Start with a clean slate
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+
+    // Persist more allocations than the initial descriptor table fits
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType | FLAGS_PERSIST_HYBRID_FILE_HEAP, NULL, &pHeap));
+    for (i = 0; i < AllocationCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize + i, &handles[i]));
+        EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handles[i], &pAlloc, &retAllocSize));
+        MEMSET(pAlloc, (BYTE) i, allocSize + i);
+        EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
+        EXPECT_EQ(STATUS_SUCCESS, heapDemote(pHeap, &handles[i], 0, NULL));
+        EXPECT_EQ(STATUS_SUCCESS, heapCheckPersisted(pHeap, handles[i], &persisted));
+        EXPECT_TRUE(persisted);
+    }
+
+    // Punch holes in the segment
+    for (i = 0; i < AllocationCount; i += 3) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+    }
+
+    // In-memory allocations are not persisted
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &directHandle));
+    EXPECT_TRUE(IS_DIRECT_ALLOCATION_HANDLE(directHandle));
+    EXPECT_EQ(STATUS_SUCCESS, heapCheckPersisted(pHeap, directHandle, &persisted));
+    EXPECT_FALSE(persisted);
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, directHandle));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapUsage));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+
+    // The index file should be retained
+    SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%c%u" FILE_HEAP_FILE_EXTENSION, FILE_HEAP_DEFAULT_ROOT_DIRECTORY, FPATHSEPARATOR,
+             FILE_HEAP_INDEX_FILE_INDEX);
+    EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &exist));
+    EXPECT_TRUE(exist);
+
+    // Re-attach to the surviving allocations
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType | FLAGS_PERSIST_HYBRID_FILE_HEAP, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &recoveredHeapUsage));
+    EXPECT_EQ(heapUsage, recoveredHeapUsage);
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    for (i = 0; i < AllocationCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapCheckPersisted(pHeap, handles[i], &persisted));
+        EXPECT_EQ(i % 3 != 0, persisted);
+        if (persisted) {
+            EXPECT_EQ(STATUS_SUCCESS, heapMapReadOnly(pHeap, handles[i], &pAlloc, &retAllocSize));
+            EXPECT_EQ(allocSize + i, retAllocSize);
+            EXPECT_TRUE(MEMCHK(pAlloc, (BYTE) i, allocSize + i));
+            EXPECT_EQ(STATUS_SUCCESS, heapUnmapReadOnly(pHeap, pAlloc));
+        }
+    }
+
+    // The recovered heap should be fully functional
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapDemote(pHeap, &handle, 0, NULL));
+    EXPECT_FALSE(IS_DIRECT_ALLOCATION_HANDLE(handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handle));
+    for (i = 0; i < AllocationCount; i++) {
+        if (i % 3 != 0) {
+            EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+        }
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapUsage));
+    EXPECT_EQ(0, heapUsage);
+
+    // Keep a single allocation and re-initialize with a different limit which should discard it
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapDemote(pHeap, &handle, 0, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize * 2, 50, mHeapType | FLAGS_PERSIST_HYBRID_FILE_HEAP, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapUsage));
+    EXPECT_EQ(0, heapUsage);
+    EXPECT_EQ(STATUS_SUCCESS, heapCheckPersisted(pHeap, handle, &persisted));
+    EXPECT_FALSE(persisted);
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+
+    // Non-persistent heap removes the files on release
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &exist));
+    EXPECT_FALSE(exist);
+}
+
+TEST_P(HybridFileHeapTest, hybridFileHeapPersistentReleaseUnclaimed)
+{
+    const UINT32 AllocationCount = 10;
+    PHeap pHeap;
+    ALLOCATION_HANDLE handles[AllocationCount], claimed[AllocationCount];
+    UINT32 heapSize = MIN_HEAP_SIZE * 4;
+    UINT32 allocSize = 10000;
+    UINT32 i, claimedCount = 0;
+    UINT64 heapUsage;
+    BOOL persisted;
+
+    // Start with a clean slate
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType | FLAGS_PERSIST_HYBRID_FILE_HEAP, NULL, &pHeap));
+    for (i = 0; i < AllocationCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, allocSize, &handles[i]));
+        EXPECT_EQ(STATUS_SUCCESS, heapDemote(pHeap, &handles[i], 0, NULL));
+        EXPECT_FALSE(IS_DIRECT_ALLOCATION_HANDLE(handles[i]));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+
+    // Claim every other allocation in the reverse order
+    for (i = AllocationCount; i > 0; i--) {
+        if (i % 2 == 0) {
+            claimed[claimedCount++] = handles[i - 1];
+        }
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType | FLAGS_PERSIST_HYBRID_FILE_HEAP, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapReleaseUnclaimed(pHeap, claimed, claimedCount));
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    for (i = 0; i < AllocationCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapCheckPersisted(pHeap, handles[i], &persisted));
+        EXPECT_EQ(i % 2 != 0, persisted);
+    }
+
+    // Nothing is claimed on the next run
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType | FLAGS_PERSIST_HYBRID_FILE_HEAP, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapUsage));
+    EXPECT_NE(0, heapUsage);
+    EXPECT_EQ(STATUS_SUCCESS, heapReleaseUnclaimed(pHeap, NULL, 0));
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapUsage));
+    EXPECT_EQ(0, heapUsage);
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+
+    // Clean up the persisted files
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(heapSize, 50, mHeapType, NULL, &pHeap));
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
 TEST_P(HybridFileHeapTest, hybridFileCreateHeapMemHeapSmall)
 {
     PHeap pHeap;
@@ -164,4 +594,4 @@ TEST_P(HybridFileHeapTest, hybridFileCreateHeapMemHeapSmall)
     EXPECT_TRUE(STATUS_FAILED(heapInitialize(MIN_HEAP_SIZE, 20, mHeapType, NULL, &pHeap)));
 }
 
-INSTANTIATE_TEST_SUITE_P(PermutatedHeapType, HybridFileHeapTest, Values(FLAGS_USE_AIV_HEAP, FLAGS_USE_SYSTEM_HEAP));
+INSTANTIATE_TEST_SUITE_P(PermutatedHeapType, HybridFileHeapTest, Values(FLAGS_USE_AIV_HEAP, FLAGS_USE_SYSTEM_HEAP, FLAGS_USE_RING_HEAP));
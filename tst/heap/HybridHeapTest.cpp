@@ -431,6 +431,152 @@ TEST_P(HybridHeapTest, hybridCreateHeapVRamFreeError)
     EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(mHeap)));
 }
 
+TEST_P(HybridHeapTest, hybridReadOnlyMapReusesVramLock)
+{
+    ALLOCATION_HANDLE handle, vramHandle;
+    UINT64 retSize;
+    PVOID pAlloc;
+    UINT32 memHeapLimit;
+    UINT32 vramHeapLimit;
+    UINT32 vramAllocSize;
+    UINT32 ramAllocSize;
+    UINT32 heapSize = MIN_HEAP_SIZE * 2 + 100000;
+    UINT32 spillRatio = 50;
+    UINT32 numAlloc = AllocationCount / 2;
+    UINT32 lockCount, unlockCount;
+    // Split the 50% and allocate half from ram and half from vram
+    memHeapLimit = (UINT32) (heapSize * ((DOUBLE) spillRatio / 100));
+    vramHeapLimit = heapSize - memHeapLimit;
+    vramAllocSize = vramHeapLimit / numAlloc;
+    ramAllocSize = memHeapLimit / numAlloc;
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(heapSize, spillRatio, mHeapType, NULL, &mHeap)));
+
+    // Allocate from ram - should be 1 less due to service structs
+    for (UINT32 i = 0; i < numAlloc - 1; i++) {
+        EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(mHeap, ramAllocSize, &handle)));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+        mHandles[i] = handle;
+    }
+
+    // The next allocation spills to vram
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(mHeap, vramAllocSize, &vramHandle)));
+    EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(vramHandle));
+    EXPECT_EQ(1, mVramAllocCount);
+    lockCount = mVramLockCount;
+    unlockCount = mVramUnlockCount;
+
+    // Repeated read-only maps lock the region once and keep it locked
+    for (UINT32 i = 0; i < 10; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapMapReadOnly(mHeap, vramHandle, &pAlloc, &retSize));
+        EXPECT_EQ(vramAllocSize, retSize);
+        EXPECT_EQ(mScratchBuf + SIZEOF(ALLOCATION_HEADER), (PBYTE) pAlloc);
+        EXPECT_EQ(STATUS_SUCCESS, heapUnmapReadOnly(mHeap, pAlloc));
+    }
+
+    EXPECT_EQ(lockCount + 1, mVramLockCount);
+    EXPECT_EQ(unlockCount, mVramUnlockCount);
+
+    // Writable maps are not cached
+    EXPECT_EQ(STATUS_SUCCESS, heapMap(mHeap, vramHandle, &pAlloc, &retSize));
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmap(mHeap, pAlloc));
+    EXPECT_EQ(lockCount + 2, mVramLockCount);
+    EXPECT_EQ(unlockCount + 1, mVramUnlockCount);
+
+    // Freeing unlocks the cached mapping before the region is released
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(mHeap, vramHandle));
+    EXPECT_EQ(lockCount + 2, mVramLockCount);
+    EXPECT_EQ(unlockCount + 2, mVramUnlockCount);
+    EXPECT_EQ(1, mVramFreeCount);
+
+    freeAllocations();
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(mHeap)));
+    EXPECT_EQ(unlockCount + 2, mVramUnlockCount);
+}
+
+TEST_P(HybridHeapTest, hybridReadOnlyMapEvictsLeastRecentlyUsedVramLock)
+{
+    ALLOCATION_HANDLE handle;
+    ALLOCATION_HANDLE vramHandles[HYBRID_HEAP_VRAM_MAPPING_CACHE_SIZE + 1];
+    UINT64 retSize;
+    PVOID pAlloc;
+    UINT32 memHeapLimit;
+    UINT32 vramHeapLimit;
+    UINT32 vramAllocSize;
+    UINT32 ramAllocSize;
+    UINT32 heapSize = MIN_HEAP_SIZE * 2 + 100000;
+    UINT32 spillRatio = 50;
+    UINT32 numAlloc = AllocationCount / 2;
+    UINT32 vramCount = HYBRID_HEAP_VRAM_MAPPING_CACHE_SIZE + 1;
+    UINT32 lockCount, unlockCount, stride;
+    // Split the 50% and allocate half from ram and half from vram
+    memHeapLimit = (UINT32) (heapSize * ((DOUBLE) spillRatio / 100));
+    vramHeapLimit = heapSize - memHeapLimit;
+    vramAllocSize = vramHeapLimit / numAlloc;
+    ramAllocSize = memHeapLimit / numAlloc;
+    stride = vramAllocSize + SIZEOF(ALLOCATION_HEADER) + SIZEOF(ALLOCATION_FOOTER);
+    ASSERT_GE(SIZEOF(mScratchBuf), (SIZE_T) stride * vramCount);
+
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapInitialize(heapSize, spillRatio, mHeapType, NULL, &mHeap)));
+
+    // Allocate from ram - should be 1 less due to service structs
+    for (UINT32 i = 0; i < numAlloc - 1; i++) {
+        EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(mHeap, ramAllocSize, &handle)));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+        mHandles[i] = handle;
+    }
+
+    lockCount = mVramLockCount;
+    unlockCount = mVramUnlockCount;
+
+    // Map one more region than the cache holds, each with its own vram handle and backing buffer
+    for (UINT32 i = 0; i < vramCount; i++) {
+        mVramAlloc = i + 1;
+        mVramLock = mScratchBuf + i * stride;
+        EXPECT_TRUE(STATUS_SUCCEEDED(heapAlloc(mHeap, vramAllocSize, &vramHandles[i])));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(vramHandles[i]));
+        EXPECT_EQ(STATUS_SUCCESS, heapMapReadOnly(mHeap, vramHandles[i], &pAlloc, &retSize));
+        EXPECT_EQ(STATUS_SUCCESS, heapUnmapReadOnly(mHeap, pAlloc));
+    }
+
+    // Each allocation locks and unlocks once, each first read-only map locks once and the last one evicts the first region
+    EXPECT_EQ(lockCount + 2 * vramCount, mVramLockCount);
+    EXPECT_EQ(unlockCount + vramCount + 1, mVramUnlockCount);
+    lockCount = mVramLockCount;
+    unlockCount = mVramUnlockCount;
+
+    // The second region is still cached
+    mVramLock = mScratchBuf + stride;
+    EXPECT_EQ(STATUS_SUCCESS, heapMapReadOnly(mHeap, vramHandles[1], &pAlloc, &retSize));
+    EXPECT_EQ(mScratchBuf + stride + SIZEOF(ALLOCATION_HEADER), (PBYTE) pAlloc);
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmapReadOnly(mHeap, pAlloc));
+    EXPECT_EQ(lockCount, mVramLockCount);
+    EXPECT_EQ(unlockCount, mVramUnlockCount);
+
+    // The first region is locked again and evicts the least recently used idle one
+    mVramLock = mScratchBuf;
+    EXPECT_EQ(STATUS_SUCCESS, heapMapReadOnly(mHeap, vramHandles[0], &pAlloc, &retSize));
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmapReadOnly(mHeap, pAlloc));
+    EXPECT_EQ(lockCount + 1, mVramLockCount);
+    EXPECT_EQ(unlockCount + 1, mVramUnlockCount);
+
+    lockCount = mVramLockCount;
+    unlockCount = mVramUnlockCount;
+
+    // Freeing unlocks the cached regions while the evicted one is locked once more for its size
+    for (UINT32 i = 0; i < vramCount; i++) {
+        mVramLock = mScratchBuf + i * stride;
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(mHeap, vramHandles[i]));
+    }
+
+    EXPECT_EQ(lockCount + 1, mVramLockCount);
+    EXPECT_EQ(unlockCount + vramCount, mVramUnlockCount);
+    EXPECT_EQ(vramCount, mVramFreeCount);
+
+    freeAllocations();
+    EXPECT_TRUE(STATUS_SUCCEEDED(heapRelease(mHeap)));
+}
+
 TEST_P(HybridHeapTest, hybridFillResizeAlloc)
 {
     ALLOCATION_HANDLE handle;
@@ -0,0 +1,231 @@
+#include "HeapTestFixture.h"
+
+class RingHeapTest : public HeapTestBase {
+  protected:
+    PRingHeap getRingHeap(PHeap pHeap)
+    {
+        return (PRingHeap) pHeap;
+    }
+};
+
+TEST_F(RingHeapTest, RingHeapInOrderAllocFree)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handles[NUM_ITERATIONS];
+    UINT64 heapSize, size;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap));
+
+    for (i = 0; i < NUM_ITERATIONS; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, 1000 + i, &handles[i]));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handles[i]));
+        EXPECT_EQ(STATUS_SUCCESS, heapGetAllocSize(pHeap, handles[i], &size));
+        EXPECT_EQ(1000 + i, size);
+    }
+
+    // The allocations are carved out contiguously
+    EXPECT_EQ(0, getRingHeap(pHeap)->tailOffset);
+    EXPECT_EQ(NUM_ITERATIONS, getRingHeap(pHeap)->blockCount);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapSize));
+    EXPECT_EQ(getRingHeap(pHeap)->headOffset, heapSize);
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    // Free in FIFO order reclaiming at the tail
+    for (i = 0; i < NUM_ITERATIONS; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+        EXPECT_EQ(NUM_ITERATIONS - i - 1, getRingHeap(pHeap)->blockCount);
+        EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+    }
+
+    EXPECT_EQ(0, getRingHeap(pHeap)->headOffset);
+    EXPECT_EQ(0, getRingHeap(pHeap)->tailOffset);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapSize));
+    EXPECT_EQ(0, heapSize);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(RingHeapTest, RingHeapWrapAround)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handles[NUM_ITERATIONS];
+    UINT64 size = MIN_HEAP_SIZE / NUM_ITERATIONS * 2 + 1, heapSize;
+    UINT32 i, window = NUM_ITERATIONS / 4;
+    BOOL wrapped = FALSE;
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap));
+
+    // Simulate the rolling window - allocate at the head and free the oldest
+    for (i = 0; i < NUM_ITERATIONS; i++) {
+        if (i >= window) {
+            EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i - window]));
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handles[i]));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handles[i])) << "Iteration " << i;
+        EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+        wrapped = wrapped || getRingHeap(pHeap)->headOffset < getRingHeap(pHeap)->tailOffset;
+    }
+
+    EXPECT_TRUE(wrapped);
+
+    for (i = NUM_ITERATIONS - window; i < NUM_ITERATIONS; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+    }
+
+    EXPECT_EQ(0, getRingHeap(pHeap)->blockCount);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapSize));
+    EXPECT_EQ(0, heapSize);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(RingHeapTest, RingHeapOutOfOrderFree)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handles[4];
+    UINT64 tailOffset, headOffset;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap));
+
+    for (i = 0; i < 4; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, 1000, &handles[i]));
+        EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handles[i]));
+    }
+
+    tailOffset = getRingHeap(pHeap)->tailOffset;
+    headOffset = getRingHeap(pHeap)->headOffset;
+
+    // Freeing a block in the middle doesn't reclaim anything until the tail reaches it
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[1]));
+    EXPECT_EQ(tailOffset, getRingHeap(pHeap)->tailOffset);
+    EXPECT_EQ(headOffset, getRingHeap(pHeap)->headOffset);
+    EXPECT_EQ(4, getRingHeap(pHeap)->blockCount);
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    // Double free should fail
+    EXPECT_NE(STATUS_SUCCESS, heapFree(pHeap, handles[1]));
+
+    // Freeing the newest block rolls back the head
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[3]));
+    EXPECT_GT(headOffset, getRingHeap(pHeap)->headOffset);
+    EXPECT_EQ(3, getRingHeap(pHeap)->blockCount);
+
+    // Freeing the oldest block reclaims the previously freed block as well
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[0]));
+    EXPECT_EQ(1, getRingHeap(pHeap)->blockCount);
+    EXPECT_EQ(FROM_RING_HANDLE(getRingHeap(pHeap), handles[2]) - ringGetAllocationHeaderSize(),
+              getRingHeap(pHeap)->pAllocation + getRingHeap(pHeap)->tailOffset);
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[2]));
+    EXPECT_EQ(0, getRingHeap(pHeap)->blockCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(RingHeapTest, RingHeapFullHeldTail)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handles[NUM_ITERATIONS], handle;
+    UINT64 size = MIN_HEAP_SIZE / NUM_ITERATIONS * 2;
+    UINT32 i, count;
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap));
+
+    // Fill up the heap
+    for (count = 0; count < NUM_ITERATIONS; count++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handles[count]));
+        if (!IS_VALID_ALLOCATION_HANDLE(handles[count])) {
+            break;
+        }
+    }
+
+    EXPECT_LT(count, NUM_ITERATIONS);
+
+    // Free everything but the oldest allocation starting from the newest
+    for (i = count - 1; i > 0; i--) {
+        EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[i]));
+    }
+
+    // The newest blocks are rolled back so there is space at the head
+    EXPECT_EQ(1, getRingHeap(pHeap)->blockCount);
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handle));
+    EXPECT_TRUE(IS_VALID_ALLOCATION_HANDLE(handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handle));
+
+    // Free out of order - the oldest allocation is still held so we can't wrap around
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handles[1]));
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handles[2]));
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handles[1]));
+    for (i = 1; i < count; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, size, &handle));
+    }
+
+    EXPECT_FALSE(IS_VALID_ALLOCATION_HANDLE(handle));
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
+
+TEST_F(RingHeapTest, RingHeapResize)
+{
+    PHeap pHeap;
+    ALLOCATION_HANDLE handle1, handle2, storedHandle;
+    UINT64 size, heapSize;
+    PBYTE pAlloc;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, heapInitialize(MIN_HEAP_SIZE, 20, FLAGS_USE_RING_HEAP, NULL, &pHeap));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, 1000, &handle1));
+    EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handle1, (PVOID*) &pAlloc, &size));
+    for (i = 0; i < 1000; i++) {
+        pAlloc[i] = (BYTE) i;
+    }
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
+
+    // Growing the newest block happens in place
+    storedHandle = handle1;
+    EXPECT_EQ(STATUS_SUCCESS, heapSetAllocSize(pHeap, &handle1, 2000));
+    EXPECT_EQ(storedHandle, handle1);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapSize));
+    EXPECT_EQ(ringGetAllocationHeaderSize() + ringGetAllocationAlignedSize(2000), heapSize);
+
+    // Shrinking the newest block happens in place
+    EXPECT_EQ(STATUS_SUCCESS, heapSetAllocSize(pHeap, &handle1, 500));
+    EXPECT_EQ(storedHandle, handle1);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapSize));
+    EXPECT_EQ(ringGetAllocationHeaderSize() + ringGetAllocationAlignedSize(500), heapSize);
+    EXPECT_EQ(ringGetAllocationHeaderSize() + ringGetAllocationAlignedSize(500), getRingHeap(pHeap)->headOffset);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapAlloc(pHeap, 1000, &handle2));
+
+    // Shrinking an older block splits off the remainder
+    EXPECT_EQ(STATUS_SUCCESS, heapSetAllocSize(pHeap, &handle1, 100));
+    EXPECT_EQ(storedHandle, handle1);
+    EXPECT_EQ(3, getRingHeap(pHeap)->blockCount);
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    // Growing an older block moves it to the head
+    EXPECT_EQ(STATUS_SUCCESS, heapSetAllocSize(pHeap, &handle1, 3000));
+    EXPECT_NE(storedHandle, handle1);
+    EXPECT_EQ(STATUS_SUCCESS, heapMap(pHeap, handle1, (PVOID*) &pAlloc, &size));
+    EXPECT_EQ(3000, size);
+    for (i = 0; i < 100; i++) {
+        EXPECT_EQ((BYTE) i, pAlloc[i]);
+    }
+    EXPECT_EQ(STATUS_SUCCESS, heapUnmap(pHeap, pAlloc));
+    EXPECT_EQ(STATUS_SUCCESS, heapDebugCheckAllocator(pHeap, FALSE));
+
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handle2));
+    EXPECT_EQ(STATUS_SUCCESS, heapFree(pHeap, handle1));
+    EXPECT_EQ(0, getRingHeap(pHeap)->blockCount);
+    EXPECT_EQ(STATUS_SUCCESS, heapGetSize(pHeap, &heapSize));
+    EXPECT_EQ(0, heapSize);
+
+    EXPECT_EQ(STATUS_SUCCESS, heapRelease(pHeap));
+}
@@ -0,0 +1,100 @@
+#include "MkvgenTestFixture.h"
+
+class AnnexBNalAdapterPerfTest : public MkvgenTestBase {};
+
+/**
+ * Appends a start code followed by the payload with the emulation prevention applied. Returns the new frame data size
+ */
+static UINT32 appendAnnexBNalu(PBYTE pFrameData, UINT32 frameDataSize, PBYTE pPayload, UINT32 payloadSize)
+{
+    UINT32 i, zeroCount = 0;
+
+    PUT_UNALIGNED_BIG_ENDIAN((PINT32) (pFrameData + frameDataSize), 1);
+    frameDataSize += 4;
+
+    for (i = 0; i < payloadSize; i++) {
+        if (zeroCount == 2 && pPayload[i] <= 0x03) {
+            pFrameData[frameDataSize++] = 0x03;
+            zeroCount = 0;
+        }
+
+        zeroCount = pPayload[i] == 0x00 ? zeroCount + 1 : 0;
+        pFrameData[frameDataSize++] = pPayload[i];
+    }
+
+    // Trailing zero is not allowed in the payload
+    if (zeroCount != 0) {
+        pFrameData[frameDataSize++] = 0x03;
+    }
+
+    return frameDataSize;
+}
+
+TEST_F(AnnexBNalAdapterPerfTest, nalAdapter_ScannerThroughput)
+{
+    UINT32 bufferSize = 16 * 1024 * 1024, frameDataSize = 0, fileIndex = 0, i, scalarSize, adaptedSize;
+    UINT64 fileSize, startTime, scalarTime, vectorTime, referenceTime;
+    PBYTE pFrameData = (PBYTE) MEMALLOC(bufferSize);
+    PBYTE pFileData = (PBYTE) MEMALLOC(bufferSize);
+    CHAR fileName[MAX_PATH_LEN];
+    NalIndex nalIndex;
+    FindAnnexBZeroPairFunc selectedFn;
+
+    ASSERT_TRUE(pFrameData != NULL && pFileData != NULL);
+
+    // Build a large Annex-B frame out of the samples using them as NALu payloads
+    while (TRUE) {
+        SNPRINTF(fileName, MAX_PATH_LEN, (PCHAR) "samples" FPATHSEPARATOR_STR "gif%03d.jpg", fileIndex++ % 17);
+        if (STATUS_FAILED(readFile(fileName, TRUE, NULL, &fileSize)) || 5 + 2 * fileSize > bufferSize - frameDataSize) {
+            break;
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS, readFile(fileName, TRUE, pFileData, &fileSize));
+        frameDataSize = appendAnnexBNalu(pFrameData, frameDataSize, pFileData, (UINT32) fileSize);
+    }
+
+    // Fall back to random payloads if the samples are not reachable
+    if (frameDataSize == 0) {
+        for (i = 0; i < bufferSize / 4; i++) {
+            pFileData[i] = (BYTE) (RAND() % 8);
+        }
+
+        for (i = 0; i < bufferSize / 4; i += 20000) {
+            frameDataSize = appendAnnexBNalu(pFrameData, frameDataSize, pFileData + i, 20000);
+        }
+    }
+
+    // Make sure the selected scanner is resolved before timing it
+    selectedFn = getFindAnnexBZeroPairFn();
+
+    startTime = GETTIME();
+    for (i = 0; i < 10; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, adaptFrameNalsFromAnnexBToAvcc(pFrameData, frameDataSize, FALSE, NULL, &adaptedSize));
+    }
+    referenceTime = GETTIME() - startTime;
+
+    ATOMIC_STORE(&gFindAnnexBZeroPairFn, (SIZE_T) findAnnexBZeroPairScalar);
+    startTime = GETTIME();
+    for (i = 0; i < 10; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, indexFrameNalsFromAnnexB(pFrameData, frameDataSize, &nalIndex));
+    }
+    scalarTime = GETTIME() - startTime;
+    scalarSize = nalIndex.adaptedSize;
+
+    ATOMIC_STORE(&gFindAnnexBZeroPairFn, (SIZE_T) selectedFn);
+    startTime = GETTIME();
+    for (i = 0; i < 10; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, indexFrameNalsFromAnnexB(pFrameData, frameDataSize, &nalIndex));
+    }
+    vectorTime = GETTIME() - startTime;
+
+    EXPECT_EQ(adaptedSize, scalarSize);
+    EXPECT_EQ(adaptedSize, nalIndex.adaptedSize);
+
+    DLOGI("Scanned %u bytes 10 times. Byte-wise adaptation: %lf seconds, scalar scanner: %lf seconds, selected scanner: %lf seconds",
+          frameDataSize, (DOUBLE) referenceTime / HUNDREDS_OF_NANOS_IN_A_SECOND, (DOUBLE) scalarTime / HUNDREDS_OF_NANOS_IN_A_SECOND,
+          (DOUBLE) vectorTime / HUNDREDS_OF_NANOS_IN_A_SECOND);
+
+    MEMFREE(pFrameData);
+    MEMFREE(pFileData);
+}
@@ -418,4 +418,137 @@ TEST_F(AnnexBNalAdapterTest, nalAdapter_badRealLifeEncoderSampleWithFix)
     EXPECT_TRUE(pPps != NULL);
     EXPECT_EQ(4, ppsSize);
 }
-#endif
\ No newline at end of file
+#endif
+TEST_F(AnnexBNalAdapterTest, nalAdapter_IndexedAdaptationMatchesScan)
+{
+    BYTE frame1[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x00, 0x01, 0x68, 0xce, 0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x00};
+    BYTE frame2[] = {0x09, 0x10, 0x00, 0x00, 0x01, 0x41, 0x9a, 0x00, 0x00};
+    BYTE frame3[] = {0x00, 0x00, 0x01, 0x41, 0x00, 0x02, 0x00, 0x00, 0x01};
+    BYTE frame4[] = {0x41, 0x9a, 0x00, 0x03, 0x00};
+    PBYTE frames[] = {frame1, frame2, frame3, frame4};
+    UINT32 frameSizes[] = {SIZEOF(frame1), SIZEOF(frame2), SIZEOF(frame3), SIZEOF(frame4)};
+    BYTE adaptedFrameData[100], indexedFrameData[100];
+    UINT32 adaptedFrameDataSize, indexedFrameDataSize, i;
+    NalIndex nalIndex;
+
+    for (i = 0; i < ARRAY_SIZE(frames); i++) {
+        adaptedFrameDataSize = SIZEOF(adaptedFrameData);
+        EXPECT_EQ(STATUS_SUCCESS, adaptFrameNalsFromAnnexBToAvcc(frames[i], frameSizes[i], FALSE, adaptedFrameData, &adaptedFrameDataSize));
+
+        EXPECT_EQ(STATUS_SUCCESS, indexFrameNalsFromAnnexB(frames[i], frameSizes[i], &nalIndex));
+        EXPECT_EQ(adaptedFrameDataSize, nalIndex.adaptedSize);
+        EXPECT_FALSE(nalIndex.overflow);
+
+        MEMSET(indexedFrameData, 0xff, SIZEOF(indexedFrameData));
+        EXPECT_EQ(STATUS_SUCCESS, adaptIndexedFrameNalsFromAnnexBToAvcc(frames[i], frameSizes[i], &nalIndex, indexedFrameData, &indexedFrameDataSize));
+        EXPECT_EQ(adaptedFrameDataSize, indexedFrameDataSize);
+        EXPECT_EQ(0, MEMCMP(adaptedFrameData, indexedFrameData, adaptedFrameDataSize));
+    }
+
+    // Index built for a different frame data falls back to scanning
+    EXPECT_EQ(STATUS_SUCCESS, indexFrameNalsFromAnnexB(frame1, SIZEOF(frame1), &nalIndex));
+    adaptedFrameDataSize = SIZEOF(adaptedFrameData);
+    EXPECT_EQ(STATUS_SUCCESS, adaptFrameNalsFromAnnexBToAvcc(frame2, SIZEOF(frame2), FALSE, adaptedFrameData, &adaptedFrameDataSize));
+    EXPECT_EQ(STATUS_SUCCESS, adaptIndexedFrameNalsFromAnnexBToAvcc(frame2, SIZEOF(frame2), &nalIndex, indexedFrameData, &indexedFrameDataSize));
+    EXPECT_EQ(adaptedFrameDataSize, indexedFrameDataSize);
+    EXPECT_EQ(0, MEMCMP(adaptedFrameData, indexedFrameData, adaptedFrameDataSize));
+
+    // Invalid frame data fails the indexing and leaves the index invalid
+    BYTE invalidFrame[] = {0x00, 0x00, 0x01, 0x41, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x41};
+    EXPECT_EQ(STATUS_MKV_INVALID_ANNEXB_NALU_IN_FRAME_DATA, indexFrameNalsFromAnnexB(invalidFrame, SIZEOF(invalidFrame), &nalIndex));
+    EXPECT_EQ(NULL, nalIndex.pFrameData);
+}
+
+TEST_F(AnnexBNalAdapterTest, nalAdapter_IndexedAdaptationOverflow)
+{
+    BYTE frameData[(MAX_NAL_INDEX_RUN_COUNT + 2) * 5];
+    PBYTE adaptedFrameData = (PBYTE) MEMALLOC(2 * SIZEOF(frameData));
+    PBYTE indexedFrameData = (PBYTE) MEMALLOC(2 * SIZEOF(frameData));
+    UINT32 adaptedFrameDataSize = 2 * SIZEOF(frameData), indexedFrameDataSize, i;
+    NalIndex nalIndex;
+
+    // More NALus than the index can hold
+    for (i = 0; i < SIZEOF(frameData); i += 5) {
+        frameData[i] = 0x00;
+        frameData[i + 1] = 0x00;
+        frameData[i + 2] = 0x01;
+        frameData[i + 3] = 0x41;
+        frameData[i + 4] = (BYTE) i;
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, adaptFrameNalsFromAnnexBToAvcc(frameData, SIZEOF(frameData), FALSE, adaptedFrameData, &adaptedFrameDataSize));
+    EXPECT_EQ(STATUS_SUCCESS, indexFrameNalsFromAnnexB(frameData, SIZEOF(frameData), &nalIndex));
+    EXPECT_TRUE(nalIndex.overflow);
+    EXPECT_EQ(adaptedFrameDataSize, nalIndex.adaptedSize);
+    EXPECT_EQ(STATUS_SUCCESS, adaptIndexedFrameNalsFromAnnexBToAvcc(frameData, SIZEOF(frameData), &nalIndex, indexedFrameData, &indexedFrameDataSize));
+    EXPECT_EQ(adaptedFrameDataSize, indexedFrameDataSize);
+    EXPECT_EQ(0, MEMCMP(adaptedFrameData, indexedFrameData, adaptedFrameDataSize));
+
+    MEMFREE(adaptedFrameData);
+    MEMFREE(indexedFrameData);
+}
+
+TEST_F(AnnexBNalAdapterTest, nalAdapter_ZeroPairScannersMatchReference)
+{
+    BYTE data[300];
+    UINT32 size, i, iteration, expected;
+    FindAnnexBZeroPairFunc scanners[] = {
+        findAnnexBZeroPairDispatch,
+#if defined(NAL_SCANNER_SSE2)
+        findAnnexBZeroPairSse2,
+#endif
+#if defined(NAL_SCANNER_AVX2)
+        findAnnexBZeroPairAvx2,
+#endif
+#if defined(NAL_SCANNER_NEON)
+        findAnnexBZeroPairNeon,
+#endif
+    };
+
+#if defined(NAL_SCANNER_AVX2)
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2")) {
+        // Run the SSE2 version in place of the AVX2 one
+        scanners[ARRAY_SIZE(scanners) - 1] = findAnnexBZeroPairSse2;
+    }
+#endif
+
+    for (iteration = 0; iteration < 10000; iteration++) {
+        // Vary the size and the density of the zeros
+        size = RAND() % SIZEOF(data);
+        for (i = 0; i < size; i++) {
+            data[i] = (RAND() % (iteration % 8 + 2) == 0) ? 0x00 : (BYTE) (RAND() % 4 + 1);
+        }
+
+        expected = findAnnexBZeroPairScalar(data, size);
+        for (i = 0; i < ARRAY_SIZE(scanners); i++) {
+            EXPECT_EQ(expected, scanners[i](data, size)) << "Scanner " << i << " size " << size;
+        }
+
+        // Scan from an unaligned offset
+        if (size > 1) {
+            expected = findAnnexBZeroPairScalar(data + 1, size - 1);
+            for (i = 0; i < ARRAY_SIZE(scanners); i++) {
+                EXPECT_EQ(expected, scanners[i](data + 1, size - 1)) << "Scanner " << i << " size " << size - 1;
+            }
+        }
+    }
+
+    // No pairs
+    MEMSET(data, 0x01, SIZEOF(data));
+    for (i = 0; i < SIZEOF(data); i += 2) {
+        data[i] = 0x00;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(scanners); i++) {
+        EXPECT_EQ(SIZEOF(data), scanners[i](data, SIZEOF(data)));
+        EXPECT_EQ(0, scanners[i](data, 0));
+    }
+
+    // Pair at the very end
+    data[SIZEOF(data) - 1] = 0x00;
+    data[SIZEOF(data) - 2] = 0x00;
+    for (i = 0; i < ARRAY_SIZE(scanners); i++) {
+        EXPECT_EQ(SIZEOF(data) - 2, scanners[i](data, SIZEOF(data)));
+    }
+}
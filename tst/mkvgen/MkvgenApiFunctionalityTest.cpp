@@ -619,6 +619,60 @@ TEST_F(MkvgenApiFunctionalityTest, mkvgenResetGenerator_Variations)
     EXPECT_EQ(STATUS_SUCCESS, freeMkvGenerator(mkvGenerator));
 }
 
+TEST_F(MkvgenApiFunctionalityTest, mkvgenGenerateHeader_HeaderBitsReencodedOnChange)
+{
+    PMkvGenerator mkvGenerator, cpdMkvGenerator;
+    UINT32 size, headerSize, cpdHeaderSize;
+    BYTE frameBuf[1000], cpd[100], header[1000], cpdHeader[1000];
+    Frame frame = {FRAME_CURRENT_VERSION, 0, FRAME_FLAG_KEY_FRAME, 0, 0, MKV_TEST_FRAME_DURATION, SIZEOF(frameBuf), frameBuf, MKV_TEST_TRACKID};
+    EncodedFrameInfo encodedFrameInfo;
+    TrackInfo trackInfo;
+    trackInfo.trackId = MKV_TEST_TRACKID;
+    MEMSET(cpd, 0x12, SIZEOF(cpd));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              createMkvGenerator(MKV_TEST_CONTENT_TYPE, MKV_TEST_BEHAVIOR_FLAGS, MKV_TEST_TIMECODE_SCALE, MKV_TEST_CLUSTER_DURATION,
+                                 MKV_TEST_SEGMENT_UUID, &mTrackInfo, mTrackInfoCount, MKV_TEST_CLIENT_ID, NULL, 0, &mkvGenerator));
+
+    headerSize = SIZEOF(header);
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenGenerateHeader(mkvGenerator, header, &headerSize, NULL));
+
+    // The stream start copies the same header
+    size = MKV_TEST_BUFFER_SIZE;
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageFrame(mkvGenerator, &frame, &trackInfo, mBuffer, &size, &encodedFrameInfo));
+    EXPECT_EQ(MKV_STATE_START_STREAM, encodedFrameInfo.streamState);
+    EXPECT_EQ(0, MEMCMP(header, mBuffer, headerSize));
+
+    // Setting the CPD changes the header which should match the one of a generator created with the CPD
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenSetCodecPrivateData(mkvGenerator, MKV_TEST_TRACKID, SIZEOF(cpd), cpd));
+    mTrackInfo.codecPrivateData = cpd;
+    mTrackInfo.codecPrivateDataSize = SIZEOF(cpd);
+    EXPECT_EQ(STATUS_SUCCESS,
+              createMkvGenerator(MKV_TEST_CONTENT_TYPE, MKV_TEST_BEHAVIOR_FLAGS, MKV_TEST_TIMECODE_SCALE, MKV_TEST_CLUSTER_DURATION,
+                                 MKV_TEST_SEGMENT_UUID, &mTrackInfo, mTrackInfoCount, MKV_TEST_CLIENT_ID, NULL, 0, &cpdMkvGenerator));
+
+    cpdHeaderSize = SIZEOF(cpdHeader);
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenGenerateHeader(cpdMkvGenerator, cpdHeader, &cpdHeaderSize, NULL));
+    headerSize = SIZEOF(header);
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenGenerateHeader(mkvGenerator, header, &headerSize, NULL));
+    EXPECT_EQ(cpdHeaderSize, headerSize);
+    EXPECT_EQ(0, MEMCMP(header, cpdHeader, headerSize));
+    EXPECT_EQ(headerSize, mkvgenGetMkvHeaderSize((PStreamMkvGenerator) mkvGenerator));
+
+    // Restarting the stream copies the new header
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenResetGenerator(mkvGenerator));
+    frame.decodingTs += MKV_TEST_FRAME_DURATION;
+    frame.presentationTs += MKV_TEST_FRAME_DURATION;
+    size = MKV_TEST_BUFFER_SIZE;
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageFrame(mkvGenerator, &frame, &trackInfo, mBuffer, &size, &encodedFrameInfo));
+    EXPECT_EQ(MKV_STATE_START_STREAM, encodedFrameInfo.streamState);
+    EXPECT_EQ(SIZEOF(frameBuf) + mkvgenGetMkvHeaderOverhead((PStreamMkvGenerator) mkvGenerator), size);
+    EXPECT_EQ(0, MEMCMP(cpdHeader, mBuffer, cpdHeaderSize));
+
+    EXPECT_EQ(STATUS_SUCCESS, freeMkvGenerator(cpdMkvGenerator));
+    EXPECT_EQ(STATUS_SUCCESS, freeMkvGenerator(mkvGenerator));
+}
+
 TEST_F(MkvgenApiFunctionalityTest, mkvgenResetGeneratorWithAvccAdaptation_Variations)
 {
     PMkvGenerator mkvGenerator;
@@ -886,6 +940,181 @@ TEST_F(MkvgenApiFunctionalityTest, mkvgenMkvTracksHeaderWithMultipleTrack)
     EXPECT_EQ(STATUS_SUCCESS, freeMkvGenerator(pMkvGenerator));
 }
 
+TEST_F(MkvgenApiFunctionalityTest, mkvgenPackageLacedFrames_Variations)
+{
+    PMkvGenerator pMkvGenerator;
+    UINT32 size, i, offset, sizes[] = {100, 300, 250, 90};
+    BYTE frameBuf[1000];
+    Frame frames[4];
+    EncodedFrameInfo encodedFrameInfo;
+    TrackInfo trackInfo = mTrackInfo;
+    PBYTE pBlock;
+    BYTE ebmlLaceHeader[] = {0x03, 0xe4, 0x60, 0xc7, 0x8d};
+
+    trackInfo.trackType = MKV_TRACK_INFO_TYPE_AUDIO;
+    trackInfo.trackCustomData.trackAudioConfig.channelConfig = 2;
+    trackInfo.trackCustomData.trackAudioConfig.samplingFrequency = 48000;
+    trackInfo.trackCustomData.trackAudioConfig.bitDepth = 0;
+
+    for (i = 0; i < SIZEOF(frameBuf); i++) {
+        frameBuf[i] = (BYTE) i;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(frames); i++) {
+        frames[i] = {FRAME_CURRENT_VERSION, i, FRAME_FLAG_NONE, (UINT64) i * MKV_TEST_FRAME_DURATION, (UINT64) i * MKV_TEST_FRAME_DURATION,
+                     MKV_TEST_FRAME_DURATION, 200, frameBuf, MKV_TEST_TRACKID};
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              createMkvGenerator(MKV_TEST_CONTENT_TYPE, MKV_TEST_BEHAVIOR_FLAGS, MKV_TEST_TIMECODE_SCALE, MKV_TEST_CLUSTER_DURATION,
+                                 MKV_TEST_SEGMENT_UUID, &trackInfo, 1, MKV_TEST_CLIENT_ID, NULL, 0, &pMkvGenerator));
+
+    size = MKV_TEST_BUFFER_SIZE;
+    EXPECT_EQ(STATUS_INVALID_ARG, mkvgenPackageLacedFrames(pMkvGenerator, frames, 0, &trackInfo, mBuffer, &size, NULL));
+    EXPECT_EQ(STATUS_INVALID_ARG,
+              mkvgenPackageLacedFrames(pMkvGenerator, frames, MKV_MAX_LACED_FRAME_COUNT + 1, &trackInfo, mBuffer, &size, NULL));
+
+    // Frames of the other track can't be laced
+    frames[1].trackId = MKV_TEST_TRACKID + 1;
+    EXPECT_EQ(STATUS_MKV_INVALID_LACED_FRAMES, mkvgenPackageLacedFrames(pMkvGenerator, frames, 3, &trackInfo, mBuffer, &size, NULL));
+    frames[1].trackId = MKV_TEST_TRACKID;
+
+    // Fixed-size lacing of the stream start
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageLacedFrames(pMkvGenerator, frames, 3, &trackInfo, NULL, &size, NULL));
+    EXPECT_EQ(mkvgenGetMkvHeaderOverhead((PStreamMkvGenerator) pMkvGenerator) + 1 + 3 * 200, size);
+    size = MKV_TEST_BUFFER_SIZE;
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageLacedFrames(pMkvGenerator, frames, 3, &trackInfo, mBuffer, &size, &encodedFrameInfo));
+    EXPECT_EQ(MKV_STATE_START_STREAM, encodedFrameInfo.streamState);
+    EXPECT_EQ(3 * MKV_TEST_FRAME_DURATION, encodedFrameInfo.duration);
+
+    pBlock = mBuffer + size - 3 * 200 - 1 - MKV_SIMPLE_BLOCK_BITS_SIZE;
+    EXPECT_EQ(0xa3, pBlock[0]);
+    EXPECT_EQ(MKV_SIMPLE_BLOCK_FIXED_SIZE_LACING, pBlock[MKV_SIMPLE_BLOCK_FLAGS_OFFSET] & 0x06);
+    EXPECT_EQ(2, pBlock[MKV_SIMPLE_BLOCK_BITS_SIZE]);
+    for (i = 0; i < 3; i++) {
+        EXPECT_EQ(0, MEMCMP(pBlock + MKV_SIMPLE_BLOCK_BITS_SIZE + 1 + i * 200, frameBuf, 200));
+    }
+
+    // EBML lacing of the frames of the different sizes following the lace
+    for (i = 0; i < ARRAY_SIZE(frames); i++) {
+        frames[i].decodingTs = frames[i].presentationTs = (3 + i) * MKV_TEST_FRAME_DURATION;
+        frames[i].size = sizes[i];
+        frames[i].frameData = frameBuf + i;
+    }
+
+    size = MKV_TEST_BUFFER_SIZE;
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageLacedFrames(pMkvGenerator, frames, 4, &trackInfo, mBuffer, &size, &encodedFrameInfo));
+    EXPECT_EQ(MKV_STATE_START_BLOCK, encodedFrameInfo.streamState);
+    EXPECT_EQ(MKV_SIMPLE_BLOCK_BITS_SIZE + SIZEOF(ebmlLaceHeader) + 100 + 300 + 250 + 90, size);
+    EXPECT_EQ(3 * MKV_TEST_FRAME_DURATION, encodedFrameInfo.framePts);
+    EXPECT_EQ(4 * MKV_TEST_FRAME_DURATION, encodedFrameInfo.duration);
+    EXPECT_EQ(MKV_SIMPLE_BLOCK_EBML_LACING, mBuffer[MKV_SIMPLE_BLOCK_FLAGS_OFFSET] & 0x06);
+    EXPECT_EQ(0, MEMCMP(mBuffer + MKV_SIMPLE_BLOCK_BITS_SIZE, ebmlLaceHeader, SIZEOF(ebmlLaceHeader)));
+
+    offset = MKV_SIMPLE_BLOCK_BITS_SIZE + SIZEOF(ebmlLaceHeader);
+    for (i = 0; i < ARRAY_SIZE(frames); i++) {
+        EXPECT_EQ(0, MEMCMP(mBuffer + offset, frames[i].frameData, frames[i].size));
+        offset += frames[i].size;
+    }
+
+    // A single frame is not laced
+    size = MKV_TEST_BUFFER_SIZE;
+    frames[0].decodingTs = frames[0].presentationTs = 7 * MKV_TEST_FRAME_DURATION;
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageLacedFrames(pMkvGenerator, frames, 1, &trackInfo, mBuffer, &size, NULL));
+    EXPECT_EQ(MKV_SIMPLE_BLOCK_BITS_SIZE + 100, size);
+    EXPECT_EQ(0, mBuffer[MKV_SIMPLE_BLOCK_FLAGS_OFFSET] & 0x06);
+
+    EXPECT_EQ(STATUS_SUCCESS, freeMkvGenerator(pMkvGenerator));
+}
+
+TEST_F(MkvgenApiFunctionalityTest, mkvgenPackageFramesWithGap_Layout)
+{
+    PMkvGenerator pMkvGenerator, pGapMkvGenerator;
+    UINT32 i, size, gapSize, gap = 37;
+    BYTE frameBuf[300];
+    PBYTE pGapBuffer;
+    Frame frame = {FRAME_CURRENT_VERSION, 0, FRAME_FLAG_KEY_FRAME, 0, 0, MKV_TEST_FRAME_DURATION, SIZEOF(frameBuf), frameBuf, MKV_TEST_TRACKID};
+    EncodedFrameInfo encodedFrameInfo, gapEncodedFrameInfo;
+
+    for (i = 0; i < SIZEOF(frameBuf); i++) {
+        frameBuf[i] = (BYTE) i;
+    }
+
+    pGapBuffer = (PBYTE) MEMALLOC(MKV_TEST_BUFFER_SIZE);
+    ASSERT_TRUE(pGapBuffer != NULL);
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              createMkvGenerator(MKV_TEST_CONTENT_TYPE, MKV_TEST_BEHAVIOR_FLAGS, MKV_TEST_TIMECODE_SCALE, MKV_TEST_CLUSTER_DURATION,
+                                 MKV_TEST_SEGMENT_UUID, &mTrackInfo, 1, MKV_TEST_CLIENT_ID, NULL, 0, &pMkvGenerator));
+    EXPECT_EQ(STATUS_SUCCESS,
+              createMkvGenerator(MKV_TEST_CONTENT_TYPE, MKV_TEST_BEHAVIOR_FLAGS, MKV_TEST_TIMECODE_SCALE, MKV_TEST_CLUSTER_DURATION,
+                                 MKV_TEST_SEGMENT_UUID, &mTrackInfo, 1, MKV_TEST_CLIENT_ID, NULL, 0, &pGapMkvGenerator));
+
+    // The gap is left right before the cluster of the stream start and then of the following cluster start
+    for (i = 0; i < 2; i++) {
+        frame.decodingTs = frame.presentationTs = i * MKV_TEST_CLUSTER_DURATION;
+
+        size = MKV_TEST_BUFFER_SIZE;
+        EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageFrame(pMkvGenerator, &frame, &mTrackInfo, mBuffer, &size, &encodedFrameInfo));
+
+        EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageFramesWithGap(pGapMkvGenerator, &frame, 1, &mTrackInfo, gap, NULL, &gapSize, NULL));
+        EXPECT_EQ(size + gap, gapSize);
+        gapSize = MKV_TEST_BUFFER_SIZE;
+        EXPECT_EQ(STATUS_SUCCESS,
+                  mkvgenPackageFramesWithGap(pGapMkvGenerator, &frame, 1, &mTrackInfo, gap, pGapBuffer, &gapSize, &gapEncodedFrameInfo));
+        EXPECT_EQ(size + gap, gapSize);
+
+        EXPECT_EQ(i == 0 ? MKV_STATE_START_STREAM : MKV_STATE_START_CLUSTER, gapEncodedFrameInfo.streamState);
+        EXPECT_EQ(encodedFrameInfo.streamState, gapEncodedFrameInfo.streamState);
+        EXPECT_EQ(encodedFrameInfo.dataOffset, gapEncodedFrameInfo.dataOffset);
+        EXPECT_EQ(0, MEMCMP(mBuffer, pGapBuffer, encodedFrameInfo.dataOffset));
+        EXPECT_EQ(0, MEMCMP(mBuffer + encodedFrameInfo.dataOffset, pGapBuffer + encodedFrameInfo.dataOffset + gap, size - encodedFrameInfo.dataOffset));
+    }
+
+    // No gap can be left before a block within the cluster
+    frame.flags = FRAME_FLAG_NONE;
+    frame.decodingTs = frame.presentationTs = MKV_TEST_CLUSTER_DURATION + MKV_TEST_FRAME_DURATION;
+    gapSize = MKV_TEST_BUFFER_SIZE;
+    EXPECT_EQ(STATUS_INVALID_ARG, mkvgenPackageFramesWithGap(pGapMkvGenerator, &frame, 1, &mTrackInfo, gap, pGapBuffer, &gapSize, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenPackageFramesWithGap(pGapMkvGenerator, &frame, 1, &mTrackInfo, 0, pGapBuffer, &gapSize, NULL));
+    EXPECT_EQ(MKV_SIMPLE_BLOCK_BITS_SIZE + SIZEOF(frameBuf), gapSize);
+
+    EXPECT_EQ(STATUS_SUCCESS, freeMkvGenerator(pMkvGenerator));
+    EXPECT_EQ(STATUS_SUCCESS, freeMkvGenerator(pGapMkvGenerator));
+    MEMFREE(pGapBuffer);
+}
+
+TEST_F(MkvgenApiFunctionalityTest, mkvgenEbmlEncodeSignedNumber_Ranges)
+{
+    BYTE buffer[8];
+    UINT32 encodedLen;
+
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenEbmlEncodeSignedNumber(0, buffer, SIZEOF(buffer), &encodedLen));
+    EXPECT_EQ(1, encodedLen);
+    EXPECT_EQ(0xbf, buffer[0]);
+
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenEbmlEncodeSignedNumber(-63, buffer, SIZEOF(buffer), &encodedLen));
+    EXPECT_EQ(1, encodedLen);
+    EXPECT_EQ(0x80, buffer[0]);
+
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenEbmlEncodeSignedNumber(63, buffer, SIZEOF(buffer), &encodedLen));
+    EXPECT_EQ(1, encodedLen);
+    EXPECT_EQ(0xfe, buffer[0]);
+
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenEbmlEncodeSignedNumber(64, buffer, SIZEOF(buffer), &encodedLen));
+    EXPECT_EQ(2, encodedLen);
+    EXPECT_EQ(0x60, buffer[0]);
+    EXPECT_EQ(0x3f, buffer[1]);
+
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenEbmlEncodeSignedNumber(-8191, NULL, 0, &encodedLen));
+    EXPECT_EQ(2, encodedLen);
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenEbmlEncodeSignedNumber(-8192, NULL, 0, &encodedLen));
+    EXPECT_EQ(3, encodedLen);
+
+    EXPECT_EQ(STATUS_NOT_ENOUGH_MEMORY, mkvgenEbmlEncodeSignedNumber(64, buffer, 1, &encodedLen));
+    EXPECT_EQ(STATUS_MKV_NUMBER_TOO_BIG, mkvgenEbmlEncodeSignedNumber(MAX_INT64, buffer, SIZEOF(buffer), &encodedLen));
+}
+
 TEST_F(MkvgenApiFunctionalityTest, mkvgenExtractCpd_Variations)
 {
     BYTE frameBuf[10000];
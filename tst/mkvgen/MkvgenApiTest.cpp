@@ -613,3 +613,44 @@ TEST_F(MkvgenApiTest, mkvGenGetAudioConfigFromAmsAcmCpdNegativeCase)
               getAudioConfigFromAmsAcmCpd(NULL, SIZEOF(cpdTooShort), &audioData.trackAudioConfig.samplingFrequency,
                                           &audioData.trackAudioConfig.channelConfig, &audioData.trackAudioConfig.bitDepth));
 }
+
+TEST_F(MkvgenApiTest, mkvgenGetTrackInfoFromMap_MatchesSearch)
+{
+    TrackInfo trackInfos[MKV_TRACK_INDEX_MAP_SLOT_COUNT];
+    TrackIndexMap trackIndexMap;
+    PTrackInfo pTrackInfo, pSearchTrackInfo;
+    UINT32 i, trackCount, index, searchIndex;
+    UINT64 trackId;
+
+    MEMSET(trackInfos, 0x00, SIZEOF(trackInfos));
+    for (i = 0; i < ARRAY_SIZE(trackInfos); i++) {
+        // Ids colliding in the slots as well as the random ones
+        trackInfos[i].trackId = (i % 2 == 0) ? (UINT64) (i + 1) * MKV_TRACK_INDEX_MAP_SLOT_COUNT : (UINT64) RAND() * RAND() + 1;
+    }
+
+    EXPECT_EQ(STATUS_NULL_ARG, mkvgenBuildTrackIndexMap(trackInfos, 1, NULL));
+    EXPECT_EQ(STATUS_NULL_ARG, mkvgenBuildTrackIndexMap(NULL, 1, &trackIndexMap));
+    EXPECT_EQ(STATUS_NULL_ARG, mkvgenGetTrackInfoFromMap(NULL, trackInfos, 1, trackInfos[0].trackId, NULL, NULL));
+
+    // The map is built for up to the half of the slots and falls back to the search for more tracks
+    for (trackCount = 0; trackCount <= ARRAY_SIZE(trackInfos); trackCount++) {
+        EXPECT_EQ(STATUS_SUCCESS, mkvgenBuildTrackIndexMap(trackInfos, trackCount, &trackIndexMap));
+        EXPECT_EQ(trackCount <= MKV_TRACK_INDEX_MAP_SLOT_COUNT / 2, trackIndexMap.built);
+
+        for (i = 0; i <= trackCount; i++) {
+            // Look up the tracks as well as a missing one
+            trackId = i < trackCount ? trackInfos[i].trackId : 0;
+            EXPECT_EQ(mkvgenGetTrackInfo(trackInfos, trackCount, trackId, &pSearchTrackInfo, &searchIndex),
+                      mkvgenGetTrackInfoFromMap(&trackIndexMap, trackInfos, trackCount, trackId, &pTrackInfo, &index));
+            EXPECT_EQ(pSearchTrackInfo, pTrackInfo);
+            EXPECT_EQ(searchIndex, index);
+        }
+    }
+
+    // The first track wins for the duplicate ids
+    trackInfos[2].trackId = trackInfos[1].trackId;
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenBuildTrackIndexMap(trackInfos, 3, &trackIndexMap));
+    EXPECT_EQ(STATUS_SUCCESS, mkvgenGetTrackInfoFromMap(&trackIndexMap, trackInfos, 3, trackInfos[1].trackId, &pTrackInfo, &index));
+    EXPECT_EQ(1, index);
+    EXPECT_EQ(&trackInfos[1], pTrackInfo);
+}
@@ -1447,6 +1447,244 @@ TEST_F(ViewApiFunctionalityTest, contentViewTrimTail)
     EXPECT_EQ(pHead->index, pTail->index);
 }
 
+TEST_F(ViewApiFunctionalityTest, windowAllocationSizeMatchesItems)
+{
+    PRollingContentView pRollingView;
+    PViewItem pViewItem;
+    UINT64 index, timestamp, itemCount, currentAllocationSize, windowAllocationSize, expectedCurrentSize, expectedWindowSize;
+    UINT32 i, policy;
+    CONTENT_VIEW_OVERFLOW_POLICY policies[] = {CONTENT_VIEW_OVERFLOW_POLICY_DROP_TAIL_VIEW_ITEM, CONTENT_VIEW_OVERFLOW_POLICY_DROP_UNTIL_FRAGMENT_START};
+
+    SRAND(12345);
+    for (policy = 0; policy < ARRAY_SIZE(policies); policy++) {
+        CreateContentView(policies[policy]);
+        pRollingView = (PRollingContentView) mContentView;
+
+        for (i = 0, timestamp = 0; i < 20 * MAX_VIEW_ITEM_COUNT; i++, timestamp += VIEW_ITEM_DURATION) {
+            EXPECT_EQ(STATUS_SUCCESS,
+                      contentViewAddItem(mContentView, timestamp, timestamp, VIEW_ITEM_DURATION, INVALID_ALLOCATION_HANDLE_VALUE, 0,
+                                         VIEW_ITEM_ALLOCAITON_SIZE + RAND() % 1000, i % 7 == 0 ? ITEM_FLAG_FRAGMENT_START : ITEM_FLAG_NONE));
+
+            // Consume, move around, resize and trim the items
+            itemCount = pRollingView->head - pRollingView->tail;
+            switch (RAND() % 8) {
+                case 0:
+                case 1:
+                case 2:
+                    contentViewGetNext(mContentView, &pViewItem);
+                    break;
+                case 3:
+                    EXPECT_EQ(STATUS_SUCCESS, contentViewSetCurrentIndex(mContentView, pRollingView->tail + RAND() % (itemCount + 1)));
+                    break;
+                case 4:
+                    EXPECT_EQ(STATUS_SUCCESS, contentViewRollbackCurrent(mContentView, RAND() % 200, RAND() % 2 == 0, FALSE));
+                    break;
+                case 5:
+                    EXPECT_EQ(STATUS_SUCCESS, contentViewTrimTail(mContentView, pRollingView->tail + RAND() % MIN(5, itemCount + 1)));
+                    break;
+                case 6:
+                    if (itemCount != 0) {
+                        EXPECT_EQ(STATUS_SUCCESS,
+                                  contentViewSetItemLength(mContentView, pRollingView->tail + RAND() % itemCount, VIEW_ITEM_ALLOCAITON_SIZE + RAND() % 1000));
+                    }
+                    break;
+                default:
+                    EXPECT_EQ(STATUS_SUCCESS, contentViewResetCurrent(mContentView));
+            }
+
+            // Validate against the items
+            expectedCurrentSize = expectedWindowSize = 0;
+            for (index = pRollingView->tail; index < pRollingView->head; index++) {
+                EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(mContentView, index, &pViewItem));
+                expectedWindowSize += pViewItem->length;
+                if (index >= pRollingView->current) {
+                    expectedCurrentSize += pViewItem->length;
+                }
+            }
+
+            EXPECT_EQ(STATUS_SUCCESS, contentViewGetWindowAllocationSize(mContentView, &currentAllocationSize, &windowAllocationSize));
+            ASSERT_EQ(expectedWindowSize, windowAllocationSize) << "Failed at iteration " << i;
+            ASSERT_EQ(expectedCurrentSize, currentAllocationSize) << "Failed at iteration " << i;
+        }
+
+        freeContentView(mContentView);
+        mContentView = NULL;
+    }
+}
+
+TEST_F(ViewApiFunctionalityTest, boundaryIndexMatchesItems)
+{
+    PRollingContentView pRollingView;
+    PViewItem pViewItem, pBoundary;
+    UINT64 index, timestamp, itemCount, position, duration, curIndex, lastIndex, expectedIndex;
+    UINT32 i, policy, flags;
+    BOOL lastReceivedAck;
+    STATUS retStatus;
+    CONTENT_VIEW_OVERFLOW_POLICY policies[] = {CONTENT_VIEW_OVERFLOW_POLICY_DROP_TAIL_VIEW_ITEM, CONTENT_VIEW_OVERFLOW_POLICY_DROP_UNTIL_FRAGMENT_START};
+
+    SRAND(54321);
+    for (policy = 0; policy < ARRAY_SIZE(policies); policy++) {
+        CreateContentView(policies[policy]);
+        pRollingView = (PRollingContentView) mContentView;
+
+        for (i = 0, timestamp = 0; i < 20 * MAX_VIEW_ITEM_COUNT; i++, timestamp += VIEW_ITEM_DURATION) {
+            flags = ITEM_FLAG_NONE;
+            if (i % 7 == 0 || RAND() % 20 == 0) {
+                flags |= ITEM_FLAG_FRAGMENT_START;
+            } else if (RAND() % 20 == 0) {
+                flags |= ITEM_FLAG_FRAGMENT_END;
+            }
+
+            if (RAND() % 10 == 0) {
+                flags |= ITEM_FLAG_RECEIVED_ACK;
+            }
+
+            if (RAND() % 30 == 0) {
+                flags |= ITEM_FLAG_SKIP_ITEM;
+            }
+
+            EXPECT_EQ(STATUS_SUCCESS,
+                      contentViewAddItem(mContentView, timestamp, timestamp, VIEW_ITEM_DURATION, INVALID_ALLOCATION_HANDLE_VALUE, 0,
+                                         VIEW_ITEM_ALLOCAITON_SIZE, flags));
+
+            itemCount = pRollingView->head - pRollingView->tail;
+            switch (RAND() % 6) {
+                case 0:
+                case 1:
+                    contentViewGetNext(mContentView, &pViewItem);
+                    break;
+                case 2:
+                    // Find the expected boundary with a linear scan
+                    for (index = pRollingView->current; index < pRollingView->head; index++) {
+                        pViewItem = GET_VIEW_ITEM_FROM_INDEX(pRollingView, index);
+                        if (!CHECK_ITEM_SKIP_ITEM(pViewItem->flags) &&
+                            (CHECK_ITEM_FRAGMENT_START(pViewItem->flags) || CHECK_ITEM_FRAGMENT_END(pViewItem->flags))) {
+                            break;
+                        }
+                    }
+
+                    retStatus = contentViewGetNextBoundary(mContentView, &pBoundary);
+                    if (index == pRollingView->head || itemCount == 0) {
+                        EXPECT_EQ(STATUS_CONTENT_VIEW_NO_MORE_ITEMS, retStatus);
+                    } else {
+                        EXPECT_EQ(STATUS_SUCCESS, retStatus);
+                        EXPECT_EQ(index, pBoundary->index);
+                        EXPECT_EQ(index + 1, pRollingView->current);
+                    }
+                    break;
+                case 3:
+                    if (pRollingView->current == pRollingView->tail || pRollingView->current == pRollingView->head) {
+                        break;
+                    }
+
+                    // Find the expected key frame by walking the items backwards
+                    duration = RAND() % 200;
+                    lastReceivedAck = RAND() % 2 == 0;
+                    curIndex = lastIndex = expectedIndex = pRollingView->current;
+                    while (duration != 0) {
+                        pViewItem = GET_VIEW_ITEM_FROM_INDEX(pRollingView, curIndex);
+                        if (CHECK_ITEM_FRAGMENT_START(pViewItem->flags)) {
+                            expectedIndex = curIndex;
+                            if (lastReceivedAck && CHECK_ITEM_RECEIVED_ACK(pViewItem->flags)) {
+                                expectedIndex = lastIndex;
+                                break;
+                            }
+
+                            if (pViewItem->ackTimestamp + duration <= GET_VIEW_ITEM_FROM_INDEX(pRollingView, pRollingView->current)->ackTimestamp) {
+                                break;
+                            }
+
+                            lastIndex = curIndex;
+                        }
+
+                        if (curIndex-- == pRollingView->tail) {
+                            break;
+                        }
+                    }
+
+                    while (expectedIndex != pRollingView->head && CHECK_ITEM_SKIP_ITEM(GET_VIEW_ITEM_FROM_INDEX(pRollingView, expectedIndex)->flags)) {
+                        expectedIndex++;
+                    }
+
+                    EXPECT_EQ(STATUS_SUCCESS, contentViewRollbackCurrent(mContentView, duration, TRUE, lastReceivedAck));
+                    EXPECT_EQ(expectedIndex, pRollingView->current);
+                    break;
+                case 4:
+                    EXPECT_EQ(STATUS_SUCCESS, contentViewTrimTail(mContentView, pRollingView->tail + RAND() % MIN(5, itemCount + 1)));
+                    break;
+                default:
+                    EXPECT_EQ(STATUS_SUCCESS, contentViewResetCurrent(mContentView));
+            }
+
+            // Validate the boundary index against the items
+            position = 0;
+            for (index = pRollingView->tail; index < pRollingView->head; index++) {
+                EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(mContentView, index, &pViewItem));
+                if (CHECK_ITEM_FRAGMENT_START(pViewItem->flags) || CHECK_ITEM_FRAGMENT_END(pViewItem->flags)) {
+                    ASSERT_LT(position, pRollingView->boundaryCount) << "Failed at iteration " << i;
+                    ASSERT_EQ(index, GET_VIEW_BOUNDARY_INDEX(pRollingView, position)) << "Failed at iteration " << i;
+                    position++;
+                }
+            }
+
+            ASSERT_EQ(position, pRollingView->boundaryCount) << "Failed at iteration " << i;
+        }
+
+        freeContentView(mContentView);
+        mContentView = NULL;
+    }
+}
+
+TEST_F(ViewApiFunctionalityTest, itemBufferGrowsAndShrinksWithWindow)
+{
+    PRollingContentView pRollingView;
+    PViewItem pViewItem;
+    UINT64 index, timestamp, currentIndex, maxItemCount = 20 * CONTENT_VIEW_INITIAL_ITEM_COUNT;
+    UINT32 i, allocationSize, initialAllocationSize;
+
+    CreateContentView(CONTENT_VIEW_OVERFLOW_POLICY_DROP_TAIL_VIEW_ITEM, (UINT32) maxItemCount, MAX_UINT64);
+    pRollingView = (PRollingContentView) mContentView;
+    EXPECT_EQ(CONTENT_VIEW_INITIAL_ITEM_COUNT, pRollingView->itemBufferCount);
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetAllocationSize(mContentView, &initialAllocationSize));
+
+    // Fill the view past the max item count consuming some of the items
+    for (i = 0, timestamp = 0; i < 2 * maxItemCount; i++, timestamp += VIEW_ITEM_DURATION) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  contentViewAddItem(mContentView, timestamp, timestamp, VIEW_ITEM_DURATION, INVALID_ALLOCATION_HANDLE_VALUE, 0,
+                                     VIEW_ITEM_ALLOCAITON_SIZE + i, i % 10 == 0 ? ITEM_FLAG_FRAGMENT_START : ITEM_FLAG_NONE));
+        if (i % 3 == 0) {
+            EXPECT_EQ(STATUS_SUCCESS, contentViewGetNext(mContentView, &pViewItem));
+        }
+
+        // The capacity is never exceeded and the buffer is at most doubled from the window size
+        ASSERT_LE(pRollingView->head - pRollingView->tail, pRollingView->itemBufferCount);
+        ASSERT_LE(pRollingView->itemBufferCount, MAX(2 * (pRollingView->head - pRollingView->tail), CONTENT_VIEW_INITIAL_ITEM_COUNT));
+    }
+
+    EXPECT_EQ(maxItemCount, pRollingView->itemBufferCount);
+    EXPECT_EQ(maxItemCount, pRollingView->head - pRollingView->tail);
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetAllocationSize(mContentView, &allocationSize));
+    EXPECT_LT(initialAllocationSize, allocationSize);
+
+    // Trim most of the items and ensure the buffer shrinks preserving the indexes and the current
+    currentIndex = pRollingView->current;
+    EXPECT_EQ(STATUS_SUCCESS, contentViewTrimTail(mContentView, pRollingView->head - 10));
+    EXPECT_EQ(CONTENT_VIEW_INITIAL_ITEM_COUNT, pRollingView->itemBufferCount);
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetAllocationSize(mContentView, &allocationSize));
+    EXPECT_EQ(initialAllocationSize, allocationSize);
+    EXPECT_EQ(MAX(currentIndex, pRollingView->tail), pRollingView->current);
+
+    for (index = pRollingView->tail; index < pRollingView->head; index++) {
+        EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemAt(mContentView, index, &pViewItem));
+        EXPECT_EQ(index, pViewItem->index);
+        EXPECT_EQ(index * VIEW_ITEM_DURATION, pViewItem->timestamp);
+        EXPECT_EQ(VIEW_ITEM_ALLOCAITON_SIZE + index, pViewItem->length);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, contentViewGetItemWithTimestamp(mContentView, (pRollingView->head - 5) * VIEW_ITEM_DURATION + 1, FALSE, &pViewItem));
+    EXPECT_EQ(pRollingView->head - 5, pViewItem->index);
+}
+
 /**
  * NOTE: Disabling this test as it runs for long time to try to simulate a wraparound for 32 bit.
  * We currently use 64 bit indexes so it will not wrap around at 32 bit boundary.
@@ -268,7 +268,7 @@ TEST_F(ViewApiTest, contentViewGetAllocationSize_NullPointer)
 
     // Should succeed
     EXPECT_TRUE(STATUS_SUCCEEDED(contentViewGetAllocationSize(mContentView, &allocationSize)));
-    EXPECT_EQ(SIZEOF(RollingContentView) + SIZEOF(ViewItem) * MAX_VIEW_ITEM_COUNT, allocationSize);
+    EXPECT_EQ(SIZEOF(RollingContentView) + (SIZEOF(ViewItem) + SIZEOF(UINT64)) * MIN(CONTENT_VIEW_INITIAL_ITEM_COUNT, MAX_VIEW_ITEM_COUNT), allocationSize);
 }
 
 TEST_F(ViewApiTest, contentViewAddItem_InvalidTime)
@@ -327,3 +327,28 @@ TEST_F(ViewApiTest, contentViewGetWindowAllocationSize_NullPointer)
     EXPECT_TRUE(STATUS_FAILED(contentViewGetWindowAllocationSize(mContentView, NULL, &windowSize)));
     EXPECT_TRUE(STATUS_SUCCEEDED(contentViewGetWindowAllocationSize(mContentView, &currentSize, NULL)));
 }
+
+TEST_F(ViewApiTest, contentViewSetItemLength_InvalidInput)
+{
+    EXPECT_TRUE(STATUS_FAILED(contentViewSetItemLength(NULL, 0, 10)));
+
+    CreateContentView();
+    EXPECT_EQ(STATUS_CONTENT_VIEW_INVALID_INDEX, contentViewSetItemLength(mContentView, 0, 10));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewAddItem(mContentView, 0, 0, 10, INVALID_ALLOCATION_HANDLE_VALUE, 0, 10, ITEM_FLAG_FRAGMENT_START));
+    EXPECT_EQ(STATUS_INVALID_CONTENT_VIEW_LENGTH, contentViewSetItemLength(mContentView, 0, 0));
+    EXPECT_EQ(STATUS_CONTENT_VIEW_INVALID_INDEX, contentViewSetItemLength(mContentView, 1, 10));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewSetItemLength(mContentView, 0, 20));
+}
+
+TEST_F(ViewApiTest, contentViewGetNextBoundary_InvalidInput)
+{
+    PViewItem pViewItem;
+
+    EXPECT_TRUE(STATUS_FAILED(contentViewGetNextBoundary(NULL, &pViewItem)));
+
+    CreateContentView();
+    EXPECT_TRUE(STATUS_FAILED(contentViewGetNextBoundary(mContentView, NULL)));
+    EXPECT_EQ(STATUS_CONTENT_VIEW_NO_MORE_ITEMS, contentViewGetNextBoundary(mContentView, &pViewItem));
+    EXPECT_EQ(STATUS_SUCCESS, contentViewAddItem(mContentView, 0, 0, 10, INVALID_ALLOCATION_HANDLE_VALUE, 0, 10, ITEM_FLAG_NONE));
+    EXPECT_EQ(STATUS_CONTENT_VIEW_NO_MORE_ITEMS, contentViewGetNextBoundary(mContentView, &pViewItem));
+}